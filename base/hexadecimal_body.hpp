@@ -4,8 +4,20 @@
 #include <cstring>
 
 #include "base/hexadecimal.hpp"
+#include "base/macros.hpp"
 #include "glog/logging.h"
 
+// SSE2 is part of x86-64, and MSVC uses it by default on x86.  AVX2 is detected
+// at run time.
+#if ARCH_CPU_X86_64 || defined(__SSE2__) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PRINCIPIA_HEXADECIMAL_SIMD 1
+#include <immintrin.h>
+#if PRINCIPIA_COMPILER_MSVC
+#include <intrin.h>
+#endif
+#endif
+
 namespace principia {
 namespace base {
 
@@ -35,8 +47,232 @@ static uint8_t const kHexadecimalDigitsToNibble[256] = {
 #undef SKIP_48
 #endif
 
-void HexadecimalEncode(Array<std::uint8_t const> input,
-                       Array<std::uint8_t> output) {
+namespace internal {
+
+#if PRINCIPIA_HEXADECIMAL_SIMD
+
+#if defined(PRINCIPIA_TARGET_AVX2)
+#error PRINCIPIA_TARGET_AVX2 already defined
+#elif PRINCIPIA_COMPILER_MSVC
+#define PRINCIPIA_TARGET_AVX2
+#else
+#define PRINCIPIA_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+// Whether the processor and the operating system support AVX2.
+inline bool HasAVX2() {
+#if PRINCIPIA_COMPILER_MSVC
+  int registers[4];  // EAX, EBX, ECX, EDX.
+  __cpuid(registers, 0);
+  if (registers[0] < 7) {
+    return false;
+  }
+  // The operating system must save the YMM registers.
+  __cpuid(registers, 1);
+  bool const has_osxsave = (registers[2] & (1 << 27)) != 0;
+  if (!has_osxsave || (_xgetbv(0) & 6) != 6) {
+    return false;
+  }
+  __cpuidex(registers, 7, 0);
+  return (registers[1] & (1 << 5)) != 0;
+#else
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx2") != 0;
+#endif
+}
+
+// The following functions encode the largest suffix of |input| whose size is
+// a multiple of their vector size, backward, and return the size of the prefix
+// that remains to be encoded.  They decode the largest prefix of |input| whose
+// size is a multiple of their vector size, forward, and return the size of the
+// prefix that was decoded.  The order guarantees the same overlap properties
+// as the scalar loops, since each vector is loaded before it is stored.
+
+// Maps the nibbles in |nibbles| to upper-case digits.
+inline __m128i NibblesToDigitsSSE2(__m128i const nibbles) {
+  __m128i const letter_offset = _mm_and_si128(
+      _mm_cmpgt_epi8(nibbles, _mm_set1_epi8(9)), _mm_set1_epi8('A' - '0' - 10));
+  return _mm_add_epi8(_mm_add_epi8(nibbles, _mm_set1_epi8('0')),
+                      letter_offset);
+}
+
+// Maps the digits in |digits| to nibbles, and the invalid digits to 0.
+inline __m128i DigitsToNibblesSSE2(__m128i const digits) {
+  __m128i const lower_case = _mm_or_si128(digits, _mm_set1_epi8(0x20));
+  // The comparisons are signed, so the bytes above 0x7F are out of range.
+  __m128i const is_decimal =
+      _mm_and_si128(_mm_cmpgt_epi8(digits, _mm_set1_epi8('0' - 1)),
+                    _mm_cmplt_epi8(digits, _mm_set1_epi8('9' + 1)));
+  __m128i const is_letter =
+      _mm_and_si128(_mm_cmpgt_epi8(lower_case, _mm_set1_epi8('a' - 1)),
+                    _mm_cmplt_epi8(lower_case, _mm_set1_epi8('f' + 1)));
+  return _mm_or_si128(
+      _mm_and_si128(is_decimal, _mm_sub_epi8(digits, _mm_set1_epi8('0'))),
+      _mm_and_si128(is_letter,
+                    _mm_sub_epi8(lower_case, _mm_set1_epi8('a' - 10))));
+}
+
+// Combines the pairs of nibbles in |nibbles| into bytes, one per 16-bit lane.
+inline __m128i NibblesToBytesSSE2(__m128i const nibbles) {
+  __m128i const high = _mm_and_si128(nibbles, _mm_set1_epi16(0x00FF));
+  __m128i const low = _mm_srli_epi16(nibbles, 8);
+  return _mm_or_si128(_mm_slli_epi16(high, 4), low);
+}
+
+inline std::int64_t EncodeSSE2(Array<std::uint8_t const> const input,
+                               Array<std::uint8_t> const output) {
+  std::int64_t remaining = input.size;
+  for (; remaining >= 16; remaining -= 16) {
+    __m128i const bytes = _mm_loadu_si128(
+        reinterpret_cast<__m128i const*>(&input.data[remaining - 16]));
+    __m128i const low_nibble_mask = _mm_set1_epi8(0x0F);
+    __m128i const high = NibblesToDigitsSSE2(
+        _mm_and_si128(_mm_srli_epi16(bytes, 4), low_nibble_mask));
+    __m128i const low =
+        NibblesToDigitsSSE2(_mm_and_si128(bytes, low_nibble_mask));
+    __m128i* const digits =
+        reinterpret_cast<__m128i*>(&output.data[(remaining - 16) << 1]);
+    _mm_storeu_si128(&digits[0], _mm_unpacklo_epi8(high, low));
+    _mm_storeu_si128(&digits[1], _mm_unpackhi_epi8(high, low));
+  }
+  return remaining;
+}
+
+inline std::int64_t DecodeSSE2(Array<std::uint8_t const> const input,
+                               Array<std::uint8_t> const output) {
+  std::int64_t decoded = 0;
+  for (; decoded + 32 <= input.size; decoded += 32) {
+    __m128i const* const digits =
+        reinterpret_cast<__m128i const*>(&input.data[decoded]);
+    __m128i const first =
+        NibblesToBytesSSE2(DigitsToNibblesSSE2(_mm_loadu_si128(&digits[0])));
+    __m128i const second =
+        NibblesToBytesSSE2(DigitsToNibblesSSE2(_mm_loadu_si128(&digits[1])));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(&output.data[decoded / 2]),
+                     _mm_packus_epi16(first, second));
+  }
+  return decoded;
+}
+
+// Same as above, on 256-bit vectors.  The unpacking and packing instructions
+// operate on each 128-bit lane separately, so the lanes must be reordered.
+
+PRINCIPIA_TARGET_AVX2
+inline __m256i NibblesToDigitsAVX2(__m256i const nibbles) {
+  __m256i const letter_offset =
+      _mm256_and_si256(_mm256_cmpgt_epi8(nibbles, _mm256_set1_epi8(9)),
+                       _mm256_set1_epi8('A' - '0' - 10));
+  return _mm256_add_epi8(_mm256_add_epi8(nibbles, _mm256_set1_epi8('0')),
+                         letter_offset);
+}
+
+PRINCIPIA_TARGET_AVX2
+inline __m256i DigitsToNibblesAVX2(__m256i const digits) {
+  __m256i const lower_case = _mm256_or_si256(digits, _mm256_set1_epi8(0x20));
+  __m256i const is_decimal = _mm256_andnot_si256(
+      _mm256_cmpgt_epi8(digits, _mm256_set1_epi8('9')),
+      _mm256_cmpgt_epi8(digits, _mm256_set1_epi8('0' - 1)));
+  __m256i const is_letter = _mm256_andnot_si256(
+      _mm256_cmpgt_epi8(lower_case, _mm256_set1_epi8('f')),
+      _mm256_cmpgt_epi8(lower_case, _mm256_set1_epi8('a' - 1)));
+  return _mm256_or_si256(
+      _mm256_and_si256(is_decimal,
+                       _mm256_sub_epi8(digits, _mm256_set1_epi8('0'))),
+      _mm256_and_si256(is_letter,
+                       _mm256_sub_epi8(lower_case,
+                                       _mm256_set1_epi8('a' - 10))));
+}
+
+PRINCIPIA_TARGET_AVX2
+inline __m256i NibblesToBytesAVX2(__m256i const nibbles) {
+  __m256i const high = _mm256_and_si256(nibbles, _mm256_set1_epi16(0x00FF));
+  __m256i const low = _mm256_srli_epi16(nibbles, 8);
+  return _mm256_or_si256(_mm256_slli_epi16(high, 4), low);
+}
+
+PRINCIPIA_TARGET_AVX2
+inline std::int64_t EncodeAVX2(Array<std::uint8_t const> const input,
+                               Array<std::uint8_t> const output) {
+  std::int64_t remaining = input.size;
+  for (; remaining >= 32; remaining -= 32) {
+    __m256i const bytes = _mm256_loadu_si256(
+        reinterpret_cast<__m256i const*>(&input.data[remaining - 32]));
+    __m256i const low_nibble_mask = _mm256_set1_epi8(0x0F);
+    __m256i const high = NibblesToDigitsAVX2(
+        _mm256_and_si256(_mm256_srli_epi16(bytes, 4), low_nibble_mask));
+    __m256i const low =
+        NibblesToDigitsAVX2(_mm256_and_si256(bytes, low_nibble_mask));
+    // The digits of bytes [0, 8[ and [16, 24[, and of [8, 16[ and [24, 32[.
+    __m256i const unpacked_low = _mm256_unpacklo_epi8(high, low);
+    __m256i const unpacked_high = _mm256_unpackhi_epi8(high, low);
+    __m256i* const digits =
+        reinterpret_cast<__m256i*>(&output.data[(remaining - 32) << 1]);
+    _mm256_storeu_si256(
+        &digits[0],
+        _mm256_permute2x128_si256(unpacked_low, unpacked_high, 0x20));
+    _mm256_storeu_si256(
+        &digits[1],
+        _mm256_permute2x128_si256(unpacked_low, unpacked_high, 0x31));
+  }
+  return remaining;
+}
+
+PRINCIPIA_TARGET_AVX2
+inline std::int64_t DecodeAVX2(Array<std::uint8_t const> const input,
+                               Array<std::uint8_t> const output) {
+  std::int64_t decoded = 0;
+  for (; decoded + 64 <= input.size; decoded += 64) {
+    __m256i const* const digits =
+        reinterpret_cast<__m256i const*>(&input.data[decoded]);
+    __m256i const first = NibblesToBytesAVX2(
+        DigitsToNibblesAVX2(_mm256_loadu_si256(&digits[0])));
+    __m256i const second = NibblesToBytesAVX2(
+        DigitsToNibblesAVX2(_mm256_loadu_si256(&digits[1])));
+    // The packing yields the quadwords 0, 2, 1, 3 of the result.
+    _mm256_storeu_si256(
+        reinterpret_cast<__m256i*>(&output.data[decoded / 2]),
+        _mm256_permute4x64_epi64(_mm256_packus_epi16(first, second),
+                                 0xD8));
+  }
+  return decoded;
+}
+
+#undef PRINCIPIA_TARGET_AVX2
+
+// Encodes a suffix of |input| with the widest available vectors, and returns
+// the size of the prefix that remains to be encoded.
+inline std::int64_t EncodeVectorized(Array<std::uint8_t const> const input,
+                                     Array<std::uint8_t> const output) {
+  static bool const has_avx2 = HasAVX2();
+  return has_avx2 ? EncodeAVX2(input, output) : EncodeSSE2(input, output);
+}
+
+// Decodes a prefix of |input| with the widest available vectors, and returns
+// its size.
+inline std::int64_t DecodeVectorized(Array<std::uint8_t const> const input,
+                                     Array<std::uint8_t> const output) {
+  static bool const has_avx2 = HasAVX2();
+  return has_avx2 ? DecodeAVX2(input, output) : DecodeSSE2(input, output);
+}
+
+#else
+
+inline std::int64_t EncodeVectorized(Array<std::uint8_t const> const input,
+                                     Array<std::uint8_t> const output) {
+  return input.size;
+}
+
+inline std::int64_t DecodeVectorized(Array<std::uint8_t const> const input,
+                                     Array<std::uint8_t> const output) {
+  return 0;
+}
+
+#endif
+
+}  // namespace internal
+
+inline void HexadecimalEncode(Array<std::uint8_t const> input,
+                              Array<std::uint8_t> output) {
   CHECK_NOTNULL(input.data);
   CHECK_NOTNULL(output.data);
   // We iterate backward.
@@ -48,6 +284,9 @@ void HexadecimalEncode(Array<std::uint8_t const> input,
   CHECK(input.data <= &output.data[1] ||
         &output.data[input.size << 1] <= input.data) << "bad overlap";
   CHECK_GE(output.size, input.size << 1) << "output too small";
+  // The vectorized loop encodes the end of the input, and the scalar loop
+  // below does the rest.
+  input.size = internal::EncodeVectorized(input, output);
   // We want the result to start at |output.data[0]|.
   output.data = output.data + ((input.size - 1) << 1);
   input.data = input.data + input.size - 1;
@@ -58,8 +297,8 @@ void HexadecimalEncode(Array<std::uint8_t const> input,
   }
 }
 
-void HexadecimalDecode(Array<std::uint8_t const> input,
-                       Array<std::uint8_t> output) {
+inline void HexadecimalDecode(Array<std::uint8_t const> input,
+                              Array<std::uint8_t> output) {
   CHECK_NOTNULL(input.data);
   CHECK_NOTNULL(output.data);
   input.size &= ~1;
@@ -71,6 +310,12 @@ void HexadecimalDecode(Array<std::uint8_t const> input,
   CHECK(output.data <= &input.data[1] ||
         &input.data[input.size] <= output.data) << "bad overlap";
   CHECK_GE(output.size, input.size / 2) << "output too small";
+  // The vectorized loop decodes the beginning of the input, and the scalar loop
+  // below does the rest.
+  std::int64_t const decoded = internal::DecodeVectorized(input, output);
+  input.data += decoded;
+  input.size -= decoded;
+  output.data += decoded / 2;
   for (uint8_t const* const input_end = input.data + input.size;
        input.data != input_end;
        input.data += 2, ++output.data) {
@@ -1,6 +1,7 @@
 
 #include "base/hexadecimal.hpp"
 
+#include <algorithm>
 #include <memory>
 #include <string>
 #include <vector>
@@ -149,5 +150,60 @@ TEST_F(HexadecimalTest, Invalid) {
   EXPECT_THAT(bytes, ElementsAre('\x0A', '\x0C', '\xDE'));
 }
 
+// Sizes which exercise both the vectorized and scalar loops, in and out of
+// place.
+TEST_F(HexadecimalTest, LongInputs) {
+  for (int size = 1; size < 300; size += size < 70 ? 1 : 37) {
+    std::vector<uint8_t> bytes(size);
+    std::string expected_digits;
+    for (int i = 0; i < size; ++i) {
+      bytes[i] = static_cast<uint8_t>(i * 151 + size);
+      expected_digits += kByteToHexadecimalDigits[bytes[i] << 1];
+      expected_digits += kByteToHexadecimalDigits[(bytes[i] << 1) + 1];
+    }
+    std::vector<uint8_t> digits(2 * size);
+    HexadecimalEncode({bytes.data(), bytes.size()},
+                      {digits.data(), digits.size()});
+    EXPECT_EQ(expected_digits, std::string(digits.begin(), digits.end()));
+    std::vector<uint8_t> decoded(size);
+    HexadecimalDecode({digits.data(), digits.size()},
+                      {decoded.data(), decoded.size()});
+    EXPECT_EQ(bytes, decoded);
+
+    // In place, with the input at the beginning and one byte after the
+    // beginning of the output.
+    for (int offset : {0, 1}) {
+      std::vector<uint8_t> buffer(2 * size + 1);
+      std::copy(bytes.begin(), bytes.end(), buffer.begin() + offset);
+      HexadecimalEncode({&buffer[offset], size}, {&buffer[0], 2 * size});
+      EXPECT_EQ(expected_digits,
+                std::string(buffer.begin(), buffer.begin() + 2 * size));
+      HexadecimalDecode({&buffer[0], 2 * size}, {&buffer[offset], size});
+      EXPECT_EQ(bytes,
+                std::vector<uint8_t>(buffer.begin() + offset,
+                                     buffer.begin() + offset + size));
+    }
+  }
+}
+
+// All the characters, including invalid ones, decode like in the table.
+TEST_F(HexadecimalTest, AllCharacters) {
+  std::vector<uint8_t> digits;
+  std::vector<uint8_t> expected_bytes;
+  for (int high = 0; high < 256; ++high) {
+    for (int low = 0; low < 256; low += 17) {
+      digits.push_back(static_cast<uint8_t>(high));
+      digits.push_back(static_cast<uint8_t>(low));
+      expected_bytes.push_back(static_cast<uint8_t>(
+          (kHexadecimalDigitsToNibble[high] << 4) |
+          kHexadecimalDigitsToNibble[low]));
+    }
+  }
+  std::vector<uint8_t> bytes(expected_bytes.size());
+  HexadecimalDecode({digits.data(), digits.size()},
+                    {bytes.data(), bytes.size()});
+  EXPECT_EQ(expected_bytes, bytes);
+}
+
 }  // namespace base
 }  // namespace principia
@@ -139,6 +139,17 @@ inline void noreturn() { std::exit(0); }
 #  error "What compiler is this?"
 #endif
 
+// Vector instruction sets for which specialized code paths are compiled.
+// SSE2 is part of x86-64, and is enabled on x86 by /arch:SSE2 or -msse2.  AVX
+// must be explicitly enabled by /arch:AVX, /arch:AVX2, -mavx or -mavx2.
+#if defined(__AVX__)
+#  define PRINCIPIA_USE_AVX 1
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#  define PRINCIPIA_USE_SSE2 1
+#endif
+
 // Thread-safety analysis.
 #if PRINCIPIA_COMPILER_CLANG || PRINCIPIA_COMPILER_CLANG_CL
 #  define THREAD_ANNOTATION_ATTRIBUTE__(x) __attribute__((x))
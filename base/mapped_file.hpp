@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "base/macros.hpp"
+
+namespace principia {
+namespace base {
+
+// A memory mapping of a temporary file of fixed capacity in a given directory,
+// to which bytes are appended in place.  The pages of the mapping are backed by
+// the file rather than by the paging file, so the operating system may drop
+// them from the resident set when memory is tight and read them back on access.
+// The file is deleted when the mapping is destroyed, or when the process
+// terminates.
+class MappedFile {
+ public:
+  // Creates a file of |capacity| bytes in |directory| and maps it.  Where the
+  // file system supports sparse files, disk space is only allocated for the
+  // bytes that are appended.
+  MappedFile(std::string const& directory, std::int64_t const capacity);
+  ~MappedFile();
+
+  MappedFile(MappedFile const&) = delete;
+  MappedFile(MappedFile&&) = delete;
+  MappedFile& operator=(MappedFile const&) = delete;
+  MappedFile& operator=(MappedFile&&) = delete;
+
+  // Returns a pointer to the |size| bytes of the mapping that follow those
+  // previously appended, which the caller must fill before reading them.  The
+  // bytes previously appended don't move.  |size| must be at most
+  // |capacity() - size()|.
+  std::uint8_t* Append(std::int64_t const size);
+
+  // The appended bytes, aligned on a page boundary.
+  std::uint8_t const* data() const;
+  std::int64_t size() const;
+  std::int64_t capacity() const;
+
+ private:
+  std::uint8_t* data_ = nullptr;
+  std::int64_t size_ = 0;
+  std::int64_t const capacity_;
+#if OS_WIN
+  void* file_ = nullptr;
+  void* mapping_ = nullptr;
+#endif
+};
+
+}  // namespace base
+}  // namespace principia
+
+#include "base/mapped_file_body.hpp"
@@ -0,0 +1,144 @@
+#pragma once
+
+#include "base/mapped_file.hpp"
+
+#if OS_WIN
+// This header is included wherever trajectories are, so keep the macros of
+// <windows.h> to a minimum.
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOGDI
+#define NOGDI
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <winioctl.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <cerrno>
+#include <cstring>
+#include <vector>
+
+#include "glog/logging.h"
+
+namespace principia {
+namespace base {
+
+#if OS_WIN
+
+inline MappedFile::MappedFile(std::string const& directory,
+                              std::int64_t const capacity)
+    : capacity_(capacity) {
+  CHECK_LT(0, capacity_);
+  char name[MAX_PATH];
+  CHECK_NE(0u, GetTempFileNameA(directory.c_str(), "pcp", 0, name))
+      << "Cannot create a temporary file in " << directory;
+  file_ = CreateFileA(name,
+                      GENERIC_READ | GENERIC_WRITE,
+                      FILE_SHARE_READ | FILE_SHARE_DELETE,
+                      /*lpSecurityAttributes=*/nullptr,
+                      CREATE_ALWAYS,
+                      FILE_ATTRIBUTE_TEMPORARY | FILE_FLAG_DELETE_ON_CLOSE,
+                      /*hTemplateFile=*/nullptr);
+  CHECK_NE(INVALID_HANDLE_VALUE, file_) << "Cannot open " << name;
+  // Without this, the mapping allocates the entire capacity on disk.  Not all
+  // file systems support sparse files, so this may fail harmlessly.
+  DWORD bytes_returned;
+  LOG_IF(WARNING,
+         !DeviceIoControl(file_,
+                          FSCTL_SET_SPARSE,
+                          /*lpInBuffer=*/nullptr,
+                          /*nInBufferSize=*/0,
+                          /*lpOutBuffer=*/nullptr,
+                          /*nOutBufferSize=*/0,
+                          &bytes_returned,
+                          /*lpOverlapped=*/nullptr))
+      << name << " is not sparse";
+  // The mapping extends the file to |capacity_|.
+  mapping_ = CreateFileMappingA(
+                 file_,
+                 /*lpAttributes=*/nullptr,
+                 PAGE_READWRITE,
+                 /*dwMaximumSizeHigh=*/static_cast<DWORD>(capacity_ >> 32),
+                 /*dwMaximumSizeLow=*/static_cast<DWORD>(capacity_),
+                 /*lpName=*/nullptr);
+  CHECK_NOTNULL(mapping_);
+  data_ = static_cast<std::uint8_t*>(
+      MapViewOfFile(mapping_, FILE_MAP_WRITE, 0, 0, 0));
+  CHECK_NOTNULL(data_);
+}
+
+inline MappedFile::~MappedFile() {
+  UnmapViewOfFile(data_);
+  CloseHandle(mapping_);
+  // Deletes the file.
+  CloseHandle(file_);
+}
+
+#else
+
+inline MappedFile::MappedFile(std::string const& directory,
+                              std::int64_t const capacity)
+    : capacity_(capacity) {
+  CHECK_LT(0, capacity_);
+  std::string const pattern = directory + "/principia_XXXXXX";
+  std::vector<char> name(pattern.begin(), pattern.end());
+  name.push_back('\0');
+  int const file = mkstemp(name.data());
+  CHECK_LE(0, file) << "Cannot create a temporary file in " << directory
+                    << ": " << std::strerror(errno);
+  // The file disappears from the directory now, and from the disk when it is
+  // unmapped.
+  CHECK_EQ(0, unlink(name.data())) << name.data();
+  // The file is sparse, the pages are allocated when they are written.
+  CHECK_EQ(0, ftruncate(file, static_cast<off_t>(capacity_)))
+      << "Cannot extend " << name.data() << ": " << std::strerror(errno);
+  void* const data = mmap(/*addr=*/nullptr,
+                          static_cast<std::size_t>(capacity_),
+                          PROT_READ | PROT_WRITE,
+                          MAP_SHARED,
+                          file,
+                          /*offset=*/0);
+  CHECK_NE(MAP_FAILED, data) << "Cannot map " << name.data() << ": "
+                             << std::strerror(errno);
+  data_ = static_cast<std::uint8_t*>(data);
+  // The mapping keeps the file alive.
+  CHECK_EQ(0, close(file));
+}
+
+inline MappedFile::~MappedFile() {
+  munmap(data_, static_cast<std::size_t>(capacity_));
+}
+
+#endif
+
+inline std::uint8_t* MappedFile::Append(std::int64_t const size) {
+  CHECK_LE(0, size);
+  CHECK_LE(size, capacity_ - size_) << "Append beyond the capacity";
+  std::uint8_t* const appended = &data_[size_];
+  size_ += size;
+  return appended;
+}
+
+inline std::uint8_t const* MappedFile::data() const {
+  return data_;
+}
+
+inline std::int64_t MappedFile::size() const {
+  return size_;
+}
+
+inline std::int64_t MappedFile::capacity() const {
+  return capacity_;
+}
+
+}  // namespace base
+}  // namespace principia
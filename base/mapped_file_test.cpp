@@ -0,0 +1,55 @@
+#include "base/mapped_file.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::ElementsAreArray;
+using testing::Eq;
+
+namespace principia {
+namespace base {
+
+using MappedFileDeathTest = testing::Test;
+
+TEST(MappedFileDeathTest, Errors) {
+  EXPECT_DEATH({
+    MappedFile const file("/this/directory/does/not/exist", 1);
+  }, "Cannot create");
+  EXPECT_DEATH({
+    MappedFile const file(".", 0);
+  }, "capacity_");
+  EXPECT_DEATH({
+    MappedFile file(".", 10);
+    file.Append(6);
+    file.Append(6);
+  }, "beyond the capacity");
+}
+
+// The bytes appended in several pieces are contiguous, and the earlier pieces
+// don't move.
+TEST(MappedFileTest, Contents) {
+  std::vector<std::uint8_t> contents;
+  for (int i = 0; i < 100000; ++i) {
+    contents.push_back(static_cast<std::uint8_t>(i * 7));
+  }
+  MappedFile file(".", 200000);
+  EXPECT_THAT(file.size(), Eq(0));
+  EXPECT_THAT(file.capacity(), Eq(200000));
+  std::uint8_t* const first = file.Append(30000);
+  std::memcpy(first, contents.data(), 30000);
+  std::uint8_t* const second = file.Append(70000);
+  std::memcpy(second, &contents[30000], 70000);
+  EXPECT_THAT(first, Eq(file.data()));
+  EXPECT_THAT(second, Eq(&first[30000]));
+  EXPECT_THAT(file.size(), Eq(contents.size()));
+  EXPECT_THAT(std::vector<std::uint8_t>(file.data(),
+                                        file.data() + file.size()),
+              ElementsAreArray(contents));
+}
+
+}  // namespace base
+}  // namespace principia
@@ -48,6 +48,10 @@ class DelegatingArrayOutputStream
 
 }  // namespace internal
 
+// The |compression_level| of a |PullSerializer| that doesn't compress its
+// output.
+int const kNoCompression = 0;
+
 // This class support serialization which is "pulled" by the client.  That is,
 // the client creates a |PullSerializer| object, calls |Start| to start the
 // serialization process, repeatedly calls |Pull| to obtain a chunk of data, and
@@ -60,7 +64,13 @@ class PullSerializer {
   // |chunk_size|.  At most |number_of_chunks| chunks are held in the internal
   // queue.  This class uses at most
   // |number_of_chunks * (chunk_size + O(1)) + O(1)| bytes.
-  PullSerializer(int const chunk_size, int const number_of_chunks);
+  // If |compression_level| is not |kNoCompression|, the data is compressed in
+  // the gzip format with the given zlib level, from 1 (fastest) to 9 (best).
+  // The compressor uses a constant amount of additional memory, independent
+  // of the size of the message.
+  PullSerializer(int const chunk_size,
+                 int const number_of_chunks,
+                 int const compression_level = kNoCompression);
   ~PullSerializer();
 
   // Starts the serializer, which will proceed to serialize |message|.  This
@@ -84,6 +94,7 @@ class PullSerializer {
 
   int const chunk_size_;
   int const number_of_chunks_;
+  int const compression_level_;
 
   // The array supporting the stream and the stream itself.
   std::unique_ptr<std::uint8_t[]> data_;
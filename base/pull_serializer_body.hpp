@@ -4,6 +4,8 @@
 
 #include <algorithm>
 
+#include "google/protobuf/io/gzip_stream.h"
+
 namespace principia {
 
 using std::placeholders::_1;
@@ -64,12 +66,16 @@ inline std::int64_t DelegatingArrayOutputStream::ByteCount() const {
 }  // namespace internal
 
 inline PullSerializer::PullSerializer(int const chunk_size,
-                                      int const number_of_chunks)
+                                      int const number_of_chunks,
+                                      int const compression_level)
     : chunk_size_(chunk_size),
       number_of_chunks_(number_of_chunks),
+      compression_level_(compression_level),
       data_(std::make_unique<std::uint8_t[]>(chunk_size_ * number_of_chunks_)),
       stream_(Bytes(data_.get(), chunk_size_),
               std::bind(&PullSerializer::Push, this, _1)) {
+  CHECK_LE(kNoCompression, compression_level_);
+  CHECK_GE(9, compression_level_);
   // Mark all the chunks as free except the last one which is a sentinel for the
   // |queue_|.  The 0th chunk has been passed to the stream, but it's still free
   // until the first call to |on_full|.
@@ -90,7 +96,18 @@ inline void PullSerializer::Start(
   CHECK(thread_ == nullptr);
   message_.reset(message.release());  // Should std::move but VS is not ready.
   thread_ = std::make_unique<std::thread>([this](){
-    CHECK(message_->SerializeToZeroCopyStream(&stream_));
+    if (compression_level_ == kNoCompression) {
+      CHECK(message_->SerializeToZeroCopyStream(&stream_));
+    } else {
+      google::protobuf::io::GzipOutputStream::Options options;
+      options.format = google::protobuf::io::GzipOutputStream::GZIP;
+      options.compression_level = compression_level_;
+      options.buffer_size = chunk_size_;
+      google::protobuf::io::GzipOutputStream gzip_stream(&stream_, options);
+      CHECK(message_->SerializeToZeroCopyStream(&gzip_stream));
+      // Flushes the compressor and backs up the unused part of the last chunk.
+      CHECK(gzip_stream.Close());
+    }
     // Put a sentinel at the end of the serialized stream so that the client
     // knows that this is the end.
     Bytes bytes;
@@ -6,6 +6,8 @@
 #include <vector>
 
 #include "gmock/gmock.h"
+#include "google/protobuf/io/gzip_stream.h"
+#include "google/protobuf/io/zero_copy_stream_impl_lite.h"
 #include "serialization/physics.pb.h"
 
 namespace principia {
@@ -164,5 +166,35 @@ TEST_F(PullSerializerTest, SerializationThreading) {
   }
 }
 
+TEST_F(PullSerializerTest, Compression) {
+  auto trajectory = BuildTrajectory();
+  std::string const expected_serialized_trajectory =
+      trajectory->SerializeAsString();
+  pull_serializer_ = std::make_unique<PullSerializer>(
+      kChunkSize, kNumberOfChunks, /*compression_level=*/6);
+  pull_serializer_->Start(std::move(trajectory));
+  std::string compressed;
+  for (;;) {
+    Bytes const bytes = pull_serializer_->Pull();
+    if (bytes.size == 0) {
+      break;
+    }
+    EXPECT_GE(kChunkSize, bytes.size);
+    compressed.append(reinterpret_cast<char const*>(bytes.data),
+                      static_cast<size_t>(bytes.size));
+  }
+  EXPECT_EQ('\x1F', compressed[0]);
+  EXPECT_GT(expected_serialized_trajectory.size(), 2 * compressed.size());
+
+  google::protobuf::io::ArrayInputStream array_stream(
+      compressed.data(), static_cast<int>(compressed.size()));
+  google::protobuf::io::GzipInputStream gzip_stream(
+      &array_stream, google::protobuf::io::GzipInputStream::GZIP);
+  Trajectory read_trajectory;
+  EXPECT_TRUE(read_trajectory.ParseFromZeroCopyStream(&gzip_stream));
+  EXPECT_EQ(expected_serialized_trajectory,
+            read_trajectory.SerializeAsString());
+}
+
 }  // namespace base
 }  // namespace principia
@@ -66,7 +66,9 @@ class PushDeserializer {
   // |message|.  This method must be called at most once for each deserializer
   // object.  The |done| callback is called once deserialization has completed
   // (which only happens once the client has called |Push| with a chunk of size
-  // 0).
+  // 0).  The data may be compressed in the gzip format, as produced by a
+  // |PullSerializer| with compression, in which case it is decompressed; this
+  // is detected from the first byte, which cannot start a serialized message.
   void Start(not_null<std::unique_ptr<google::protobuf::Message>> message,
              std::function<void(google::protobuf::Message const&)> done);
 
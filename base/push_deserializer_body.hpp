@@ -5,6 +5,7 @@
 #include <algorithm>
 
 #include "glog/logging.h"
+#include "google/protobuf/io/gzip_stream.h"
 
 namespace principia {
 
@@ -14,6 +15,10 @@ namespace base {
 
 namespace internal {
 
+// The first byte of the gzip format.  It is not a valid protocol buffer tag
+// since it has wire type 7.
+std::uint8_t const kGzipMagic = 0x1F;
+
 inline DelegatingArrayInputStream::DelegatingArrayInputStream(
     std::function<Bytes()> on_empty)
     : on_empty_(std::move(on_empty)),
@@ -99,7 +104,25 @@ inline void PushDeserializer::Start(
   CHECK(thread_ == nullptr);
   message_.reset(message.release());  // Should std::move but VS is not ready.
   thread_ = std::make_unique<std::thread>([this, done](){
-    CHECK(message_->ParseFromZeroCopyStream(&stream_));
+    // Look at the first byte to find out if the data is compressed, and give
+    // it back to the stream.
+    void const* data;
+    int size;
+    if (!stream_.Next(&data, &size)) {
+      // Empty input.  Don't read from the stream again.
+      CHECK(message_->ParseFromArray(nullptr, 0));
+    } else {
+      bool const compressed =
+          *static_cast<std::uint8_t const*>(data) == internal::kGzipMagic;
+      stream_.BackUp(size);
+      if (compressed) {
+        google::protobuf::io::GzipInputStream gzip_stream(
+            &stream_, google::protobuf::io::GzipInputStream::GZIP, chunk_size_);
+        CHECK(message_->ParseFromZeroCopyStream(&gzip_stream));
+      } else {
+        CHECK(message_->ParseFromZeroCopyStream(&stream_));
+      }
+    }
 
     // Run any remainining chunk callback.
     std::unique_lock<std::mutex> l(lock_);
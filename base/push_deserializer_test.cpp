@@ -204,6 +204,43 @@ TEST_F(PushDeserializerTest, SerializationDeserialization) {
   }
 }
 
+// Same as above, but with compression, which the deserializer detects.
+TEST_F(PushDeserializerTest, CompressedSerializationDeserialization) {
+  auto const trajectory = BuildTrajectory();
+  int const byte_size = trajectory->ByteSize();
+  for (int i = 0; i < kRunsPerTest; ++i) {
+    auto read_trajectory = make_not_null_unique<Trajectory>();
+    auto written_trajectory = BuildTrajectory();
+    // The compressed data is smaller than the uncompressed one.
+    auto storage = std::make_unique<std::uint8_t[]>(byte_size);
+    std::uint8_t* data = &storage[0];
+
+    pull_serializer_ = std::make_unique<PullSerializer>(
+        kSerializerChunkSize, kNumberOfChunks, /*compression_level=*/1);
+    push_deserializer_ = std::make_unique<PushDeserializer>(
+        kDeserializerChunkSize, kNumberOfChunks);
+
+    pull_serializer_->Start(std::move(written_trajectory));
+    push_deserializer_->Start(
+        std::move(read_trajectory), PushDeserializerTest::CheckSerialization);
+    for (;;) {
+      Bytes const bytes = pull_serializer_->Pull();
+      CHECK_LE(data + bytes.size, &storage[0] + byte_size);
+      std::memcpy(data, bytes.data, static_cast<size_t>(bytes.size));
+      push_deserializer_->Push(Bytes(data, bytes.size),
+                               std::bind(&PushDeserializerTest::Stomp,
+                                         Bytes(data, bytes.size)));
+      data = &data[bytes.size];
+      if (bytes.size == 0) {
+        break;
+      }
+    }
+
+    pull_serializer_.reset();
+    push_deserializer_.reset();
+  }
+}
+
 // Check that deserialization fails if we stomp on one extra bytes.
 TEST_F(PushDeserializerDeathTest, Stomp) {
   EXPECT_DEATH({
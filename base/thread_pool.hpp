@@ -0,0 +1,69 @@
+#pragma once
+
+#include <condition_variable>  // NOLINT(build/c++11)
+#include <cstddef>
+#include <functional>
+#include <mutex>  // NOLINT(build/c++11)
+#include <queue>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "base/macros.hpp"
+
+namespace principia {
+namespace base {
+
+// A fixed set of threads that execute the iterations of a loop.  The partition
+// of the iteration range among the threads only depends on the size of the
+// range, on the number of threads and on the minimum chunk size, so clients
+// that only write disjoint data in each chunk get results that don't depend on
+// the scheduling.
+class ThreadPool {
+ public:
+  // The pool uses |number_of_threads| threads, including the thread that calls
+  // |ParallelFor|, so it starts |number_of_threads - 1| worker threads.
+  // |number_of_threads| must be at least 1.
+  explicit ThreadPool(int const number_of_threads);
+  ~ThreadPool();
+
+  ThreadPool(ThreadPool const&) = delete;
+  ThreadPool& operator=(ThreadPool const&) = delete;
+
+  int number_of_threads() const;
+
+  // Partitions [begin, end[ into contiguous chunks of at least
+  // |minimum_chunk_size| elements (except if the range is smaller than that)
+  // and calls |f(chunk_begin, chunk_end)| for each chunk, on distinct threads.
+  // There are at most |number_of_threads()| chunks.  Blocks until all the calls
+  // have returned.  Concurrent calls from several threads are serialized.  Must
+  // not be called from |f|.
+  void ParallelFor(
+      std::size_t const begin,
+      std::size_t const end,
+      std::size_t const minimum_chunk_size,
+      std::function<void(std::size_t const chunk_begin,
+                         std::size_t const chunk_end)> const& f);
+
+ private:
+  // The loop executed by the worker threads.
+  void DoWork();
+
+  int const number_of_threads_;
+  std::vector<std::thread> workers_;
+
+  // Held by |ParallelFor| while it uses the workers.
+  std::mutex parallel_for_lock_;
+
+  std::mutex lock_;
+  std::condition_variable has_tasks_;
+  std::condition_variable tasks_done_;
+  std::queue<std::function<void()>> tasks_ GUARDED_BY(lock_);
+  // The number of tasks that have been enqueued and have not completed yet.
+  int pending_tasks_ GUARDED_BY(lock_) = 0;
+  bool shutdown_ GUARDED_BY(lock_) = false;
+};
+
+}  // namespace base
+}  // namespace principia
+
+#include "base/thread_pool_body.hpp"
@@ -0,0 +1,104 @@
+#pragma once
+
+#include "base/thread_pool.hpp"
+
+#include <algorithm>
+
+#include "glog/logging.h"
+
+namespace principia {
+namespace base {
+
+inline ThreadPool::ThreadPool(int const number_of_threads)
+    : number_of_threads_(number_of_threads) {
+  CHECK_LE(1, number_of_threads_);
+  for (int i = 1; i < number_of_threads_; ++i) {
+    workers_.emplace_back(&ThreadPool::DoWork, this);
+  }
+}
+
+inline ThreadPool::~ThreadPool() {
+  {
+    std::unique_lock<std::mutex> l(lock_);
+    shutdown_ = true;
+  }
+  has_tasks_.notify_all();
+  for (auto& worker : workers_) {
+    worker.join();
+  }
+}
+
+inline int ThreadPool::number_of_threads() const {
+  return number_of_threads_;
+}
+
+inline void ThreadPool::ParallelFor(
+    std::size_t const begin,
+    std::size_t const end,
+    std::size_t const minimum_chunk_size,
+    std::function<void(std::size_t const chunk_begin,
+                       std::size_t const chunk_end)> const& f) {
+  CHECK_LE(begin, end);
+  std::size_t const size = end - begin;
+  std::size_t const number_of_chunks =
+      std::max<std::size_t>(
+          1,
+          std::min<std::size_t>(number_of_threads_,
+                                size / std::max<std::size_t>(
+                                           1, minimum_chunk_size)));
+  if (number_of_chunks == 1) {
+    f(begin, end);
+    return;
+  }
+
+  // The first |size % number_of_chunks| chunks have one more element than the
+  // others.  Chunk 0 is processed by the calling thread.
+  std::size_t const quotient = size / number_of_chunks;
+  std::size_t const remainder = size % number_of_chunks;
+  auto const chunk_begin = [begin, quotient, remainder](std::size_t const c) {
+    return begin + c * quotient + std::min(c, remainder);
+  };
+  std::lock_guard<std::mutex> parallel_for_lock(parallel_for_lock_);
+  {
+    std::unique_lock<std::mutex> l(lock_);
+    CHECK_EQ(0, pending_tasks_);
+    for (std::size_t c = 1; c < number_of_chunks; ++c) {
+      std::size_t const b = chunk_begin(c);
+      std::size_t const e = chunk_begin(c + 1);
+      tasks_.emplace([&f, b, e]() { f(b, e); });
+      ++pending_tasks_;
+    }
+  }
+  has_tasks_.notify_all();
+  f(chunk_begin(0), chunk_begin(1));
+  std::unique_lock<std::mutex> l(lock_);
+  tasks_done_.wait(l, [this]() { return pending_tasks_ == 0; });
+}
+
+inline void ThreadPool::DoWork() {
+  for (;;) {
+    std::function<void()> task;
+    {
+      std::unique_lock<std::mutex> l(lock_);
+      has_tasks_.wait(l, [this]() { return shutdown_ || !tasks_.empty(); });
+      if (tasks_.empty()) {
+        // Shutting down.
+        return;
+      }
+      task = std::move(tasks_.front());
+      tasks_.pop();
+    }
+    task();
+    bool done;
+    {
+      std::unique_lock<std::mutex> l(lock_);
+      done = --pending_tasks_ == 0;
+    }
+    if (done) {
+      tasks_done_.notify_all();
+    }
+  }
+}
+
+}  // namespace base
+}  // namespace principia
@@ -0,0 +1,121 @@
+#include "base/thread_pool.hpp"
+
+#include <mutex>  // NOLINT(build/c++11)
+#include <set>
+#include <thread>  // NOLINT(build/c++11)
+#include <utility>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::ElementsAre;
+using testing::Eq;
+
+namespace principia {
+namespace base {
+
+class ThreadPoolTest : public testing::Test {
+ protected:
+  using Chunk = std::pair<std::size_t, std::size_t>;
+  using Chunks = std::set<Chunk>;
+
+  Chunks ParallelForChunks(ThreadPool* const pool,
+                           std::size_t const begin,
+                           std::size_t const end,
+                           std::size_t const minimum_chunk_size) {
+    Chunks chunks;
+    std::mutex lock;
+    pool->ParallelFor(begin, end, minimum_chunk_size,
+                      [&chunks, &lock](std::size_t const chunk_begin,
+                                       std::size_t const chunk_end) {
+      std::unique_lock<std::mutex> l(lock);
+      chunks.emplace(chunk_begin, chunk_end);
+    });
+    return chunks;
+  }
+};
+
+using ThreadPoolDeathTest = ThreadPoolTest;
+
+TEST_F(ThreadPoolDeathTest, Error) {
+  EXPECT_DEATH({
+    ThreadPool pool(0);
+  }, "1 <= number_of_threads_");
+}
+
+TEST_F(ThreadPoolTest, Partition) {
+  ThreadPool pool(3);
+  EXPECT_EQ(3, pool.number_of_threads());
+  EXPECT_THAT(ParallelForChunks(&pool, 10, 20, 1),
+              ElementsAre(Chunk(10, 14),
+                          Chunk(14, 17),
+                          Chunk(17, 20)));
+  EXPECT_THAT(ParallelForChunks(&pool, 10, 20, 4),
+              ElementsAre(Chunk(10, 15),
+                          Chunk(15, 20)));
+  EXPECT_THAT(ParallelForChunks(&pool, 10, 20, 11),
+              ElementsAre(Chunk(10, 20)));
+  EXPECT_THAT(ParallelForChunks(&pool, 10, 12, 1),
+              ElementsAre(Chunk(10, 11),
+                          Chunk(11, 12)));
+  EXPECT_THAT(ParallelForChunks(&pool, 10, 10, 1),
+              ElementsAre(Chunk(10, 10)));
+}
+
+TEST_F(ThreadPoolTest, SingleThread) {
+  ThreadPool pool(1);
+  std::thread::id const caller = std::this_thread::get_id();
+  std::thread::id callee;
+  pool.ParallelFor(0, 1000, 1,
+                   [&callee](std::size_t const chunk_begin,
+                             std::size_t const chunk_end) {
+    EXPECT_EQ(0, chunk_begin);
+    EXPECT_EQ(1000, chunk_end);
+    callee = std::this_thread::get_id();
+  });
+  EXPECT_THAT(callee, Eq(caller));
+}
+
+TEST_F(ThreadPoolTest, Sum) {
+  ThreadPool pool(4);
+  std::vector<int> v(1000);
+  for (int iteration = 0; iteration < 100; ++iteration) {
+    pool.ParallelFor(0, v.size(), 1,
+                     [&v](std::size_t const chunk_begin,
+                          std::size_t const chunk_end) {
+      for (std::size_t i = chunk_begin; i < chunk_end; ++i) {
+        v[i] += static_cast<int>(i);
+      }
+    });
+  }
+  for (std::size_t i = 0; i < v.size(); ++i) {
+    EXPECT_EQ(100 * static_cast<int>(i), v[i]);
+  }
+}
+
+// Calls from several threads are serialized.
+TEST_F(ThreadPoolTest, ConcurrentCalls) {
+  ThreadPool pool(4);
+  std::vector<int> v(1000);
+  auto const add = [&pool, &v](int const sign) {
+    for (int iteration = 0; iteration < 100; ++iteration) {
+      pool.ParallelFor(0, v.size(), 1,
+                       [&v, sign](std::size_t const chunk_begin,
+                                  std::size_t const chunk_end) {
+        for (std::size_t i = chunk_begin; i < chunk_end; ++i) {
+          v[i] += sign * static_cast<int>(i);
+        }
+      });
+    }
+  };
+  std::thread other(add, -1);
+  add(2);
+  other.join();
+  for (std::size_t i = 0; i < v.size(); ++i) {
+    EXPECT_EQ(100 * static_cast<int>(i), v[i]);
+  }
+}
+
+}  // namespace base
+}  // namespace principia
@@ -1,4 +1,4 @@
-
+﻿
 // .\Release\benchmarks.exe --benchmark_min_time=2 --benchmark_repetitions=10 --benchmark_filter=codePi  // NOLINT(whitespace/line_length)
 // Benchmarking on 1 X 2672 MHz CPU
 // 2015/02/14-23:12:32
@@ -93,8 +93,6 @@ static char const kPi500Bytes[] =
     "\xF5\x6C\x16\xAA\x64\xED\x3A\xA6\x23\x63\xF7\x70\x61\xBF\xED\xF7\x24\x29"
     "\xB0\x23\xD3\x7D\x0D\x72\x4D\x00\xA1\x24\x8D\xB0\xFE\xAD";
 
-int const kCopiesOfPi = 10000;
-
 void HexEncode(not_null<benchmark::State*> const state,
               not_null<bool*> const correct,
               std::vector<uint8_t> const& input_bytes,
@@ -109,30 +107,31 @@ void HexEncode(not_null<benchmark::State*> const state,
   state->ResumeTiming();
 }
 
-std::vector<uint8_t> Bytes() {
+std::vector<uint8_t> Bytes(int const copies_of_pi) {
   std::string const pi_bytes(kPi500Bytes, 500);
   std::string bytes_str;
-  bytes_str.reserve(500 * kCopiesOfPi);
-  for (int i = 0; i < kCopiesOfPi; ++i) {
+  bytes_str.reserve(500 * copies_of_pi);
+  for (int i = 0; i < copies_of_pi; ++i) {
     bytes_str += pi_bytes;
   }
   return std::vector<uint8_t>(bytes_str.begin(), bytes_str.end());
 }
 
-std::vector<uint8_t> Digits() {
+std::vector<uint8_t> Digits(int const copies_of_pi) {
   std::string digits_str;
-  digits_str.reserve(1000 * kCopiesOfPi);
-  for (int i = 0; i < kCopiesOfPi; ++i) {
+  digits_str.reserve(1000 * copies_of_pi);
+  for (int i = 0; i < copies_of_pi; ++i) {
     digits_str += kPi1000HexadecimalDigits;
   }
   return std::vector<uint8_t>(digits_str.begin(), digits_str.end());
 }
 
+// The number of copies of the 500 bytes of π is given by |state.range_x()|.
 void BM_EncodePi(benchmark::State& state) {  // NOLINT(runtime/references)
   bool correct = true;
   state.PauseTiming();
-  std::vector<uint8_t> const input_bytes = Bytes();
-  std::vector<uint8_t> const expected_digits = Digits();
+  std::vector<uint8_t> const input_bytes = Bytes(state.range_x());
+  std::vector<uint8_t> const expected_digits = Digits(state.range_x());
   state.ResumeTiming();
   while (state.KeepRunning()) {
     HexEncode(&state, &correct, input_bytes, expected_digits);
@@ -140,9 +139,12 @@ void BM_EncodePi(benchmark::State& state) {  // NOLINT(runtime/references)
   std::stringstream ss;
   ss << correct;
   state.SetLabel(ss.str());
+  state.SetBytesProcessed(state.iterations() * input_bytes.size());
 }
 
-BENCHMARK(BM_EncodePi);
+// From 50 kB to 50 MB of bytes, the latter being representative of the saves
+// with long histories.
+BENCHMARK(BM_EncodePi)->Arg(100)->Arg(10000)->Arg(100000);
 
 void HexDecode(not_null<benchmark::State*> const state,
                not_null<bool*> const correct,
@@ -158,11 +160,12 @@ void HexDecode(not_null<benchmark::State*> const state,
   state->ResumeTiming();
 }
 
+// Same parameter as above.
 void BM_DecodePi(benchmark::State& state) {  // NOLINT(runtime/references)
   bool correct = true;
   state.PauseTiming();
-  std::vector<uint8_t> input_digits = Digits();
-  std::vector<uint8_t> expected_bytes = Bytes();
+  std::vector<uint8_t> input_digits = Digits(state.range_x());
+  std::vector<uint8_t> expected_bytes = Bytes(state.range_x());
   state.ResumeTiming();
   while (state.KeepRunning()) {
     HexDecode(&state, &correct, input_digits, expected_bytes);
@@ -170,9 +173,10 @@ void BM_DecodePi(benchmark::State& state) {  // NOLINT(runtime/references)
   std::stringstream ss;
   ss << correct;
   state.SetLabel(ss.str());
+  state.SetBytesProcessed(state.iterations() * expected_bytes.size());
 }
 
-BENCHMARK(BM_DecodePi);
+BENCHMARK(BM_DecodePi)->Arg(100)->Arg(10000)->Arg(100000);
 
 }  // namespace benchmarks
 }  // namespace principia
@@ -20,11 +20,19 @@
 // BM_SolarSystemAllBodiesAndOblateness_mean   53718672411 53653943933          1                                 +1.00027592630012310e+00 ua  // NOLINT(whitespace/line_length)
 // BM_SolarSystemAllBodiesAndOblateness_stddev   102877237   114872491          0                                 +1.00027592630012310e+00 ua  // NOLINT(whitespace/line_length)
 
+#include <cstdint>
 #include <memory>
+#include <random>
 #include <vector>
 
 #include "base/not_null.hpp"
 #include "benchmarks/n_body_system.hpp"
+#include "geometry/named_quantities.hpp"
+#include "integrators/symplectic_runge_kutta_nystrom_integrator.hpp"
+#include "physics/massless_body.hpp"
+#include "physics/point_mass_accelerations.hpp"
+#include "physics/trajectory.hpp"
+#include "quantities/named_quantities.hpp"
 #include "quantities/quantities.hpp"
 #include "quantities/si.hpp"
 
@@ -34,9 +42,26 @@
 namespace principia {
 
 using base::not_null;
+using geometry::Displacement;
+using geometry::Velocity;
+using integrators::McLachlanAtela1992Order5Optimal;
+using physics::AddPointMassAccelerations;
+using physics::AddPointMassAccelerationsWithoutSIMD;
+using physics::DegreesOfFreedom;
+using physics::MasslessBody;
 using physics::NBodySystem;
+using physics::Trajectory;
+using quantities::Acceleration;
 using quantities::DebugString;
+using quantities::GravitationalParameter;
+using quantities::Length;
+using quantities::SIUnit;
 using si::AstronomicalUnit;
+using si::Day;
+using si::Kilo;
+using si::Metre;
+using si::Minute;
+using si::Second;
 using testing_utilities::ICRFJ2000Ecliptic;
 
 namespace benchmarks {
@@ -64,6 +89,101 @@ void SolarSystemBenchmark(SolarSystem::Accuracy const accuracy,
   }
 }
 
+// Integrates the solar system at the given |accuracy| together with
+// |number_of_vessels| massless bodies in low orbits around the Earth for 30
+// days with a 45 min time step.
+void SolarSystemWithVesselsBenchmark(SolarSystem::Accuracy const accuracy,
+                                     int const number_of_vessels,
+                                     not_null<benchmark::State*> const state) {
+  std::mt19937_64 random(42);
+  std::uniform_real_distribution<> distribution(-1.0, 1.0);
+  // The bodies must be distinct.
+  std::vector<MasslessBody> const vessel_bodies(number_of_vessels);
+  NBodySystem<ICRFJ2000Ecliptic> const n_body_system;
+  while (state->KeepRunning()) {
+    state->PauseTiming();
+    not_null<std::unique_ptr<SolarSystem>> const solar_system =
+        SolarSystem::AtСпутник1Launch(accuracy);
+    auto trajectories = solar_system->trajectories();
+    DegreesOfFreedom<ICRFJ2000Ecliptic> const earth =
+        solar_system->trajectories()[SolarSystem::kEarth]->
+            last().degrees_of_freedom();
+    std::vector<std::unique_ptr<Trajectory<ICRFJ2000Ecliptic>>> vessels;
+    for (int i = 0; i < number_of_vessels; ++i) {
+      vessels.push_back(
+          std::make_unique<Trajectory<ICRFJ2000Ecliptic>>(&vessel_bodies[i]));
+      vessels.back()->Append(
+          solar_system->trajectories().front()->last().time(),
+          DegreesOfFreedom<ICRFJ2000Ecliptic>(
+              earth.position() + Displacement<ICRFJ2000Ecliptic>(
+                  {(7000 + 100 * distribution(random)) * Kilo(Metre),
+                   100 * distribution(random) * Kilo(Metre),
+                   100 * distribution(random) * Kilo(Metre)}),
+              earth.velocity() + Velocity<ICRFJ2000Ecliptic>(
+                  {100 * distribution(random) * Metre / Second,
+                   (7500 + 100 * distribution(random)) * Metre / Second,
+                   100 * distribution(random) * Metre / Second})));
+      trajectories.push_back(vessels.back().get());
+    }
+    state->ResumeTiming();
+    n_body_system.Integrate(McLachlanAtela1992Order5Optimal(),
+                            trajectories.front()->last().time() + 30 * Day,
+                            45 * Minute,
+                            0,      // sampling_period
+                            false,  // tmax_is_exact
+                            trajectories);
+  }
+}
+
+// Measures the computation of the accelerations of |number_of_vessels|
+// massless bodies due to the 17 spherical massive bodies of the solar system
+// with the given |kernel|.
+template<void (*kernel)(std::size_t const,
+                        GravitationalParameter const* const,
+                        Length const* const,
+                        Length const* const,
+                        Length const* const,
+                        std::size_t const,
+                        Length const* const,
+                        Length const* const,
+                        Length const* const,
+                        Acceleration* const,
+                        Acceleration* const,
+                        Acceleration* const)>
+void PointMassAccelerationsBenchmark(int const number_of_vessels,
+                                     not_null<benchmark::State*> const state) {
+  std::size_t const number_of_massive_bodies = 17;
+  std::mt19937_64 random(42);
+  std::uniform_real_distribution<> distribution(-1.0, 1.0);
+  std::vector<GravitationalParameter> μ;
+  std::vector<Length> massive_positions;
+  for (std::size_t i = 0; i < number_of_massive_bodies; ++i) {
+    μ.push_back((1 + distribution(random)) * 1E18 *
+                SIUnit<GravitationalParameter>());
+  }
+  for (std::size_t i = 0; i < 3 * number_of_massive_bodies; ++i) {
+    massive_positions.push_back(distribution(random) * AstronomicalUnit);
+  }
+  std::vector<Length> positions;
+  for (int i = 0; i < 3 * number_of_vessels; ++i) {
+    positions.push_back(distribution(random) * AstronomicalUnit);
+  }
+  std::vector<Acceleration> accelerations(3 * number_of_vessels);
+  Length const* const mx = massive_positions.data();
+  Length const* const x = positions.data();
+  Acceleration* const ax = accelerations.data();
+  std::size_t const m = number_of_massive_bodies;
+  std::size_t const n = number_of_vessels;
+  std::int64_t iterations = 0;
+  while (state->KeepRunning()) {
+    kernel(m, μ.data(), mx, mx + m, mx + 2 * m,
+           n, x, x + n, x + 2 * n,
+           ax, ax + n, ax + 2 * n);
+    ++iterations;
+  }
+  state->SetItemsProcessed(iterations * number_of_vessels);
+}
+
 }  // namespace
 
 void BM_SolarSystemMajorBodiesOnly(
@@ -81,9 +201,34 @@ void BM_SolarSystemAllBodiesAndOblateness(
   SolarSystemBenchmark(SolarSystem::Accuracy::kAllBodiesAndOblateness, &state);
 }
 
+// The number of vessels is given by |state.range_x()|.
+void BM_SolarSystemMinorAndMajorBodiesWithVessels(
+    benchmark::State& state) {  // NOLINT(runtime/references)
+  SolarSystemWithVesselsBenchmark(SolarSystem::Accuracy::kMinorAndMajorBodies,
+                                  state.range_x(),
+                                  &state);
+}
+
+// The number of vessels is given by |state.range_x()|.
+void BM_PointMassAccelerations(
+    benchmark::State& state) {  // NOLINT(runtime/references)
+  PointMassAccelerationsBenchmark<&AddPointMassAccelerations>(state.range_x(),
+                                                              &state);
+}
+
+// The number of vessels is given by |state.range_x()|.
+void BM_PointMassAccelerationsWithoutSIMD(
+    benchmark::State& state) {  // NOLINT(runtime/references)
+  PointMassAccelerationsBenchmark<&AddPointMassAccelerationsWithoutSIMD>(
+      state.range_x(), &state);
+}
+
 BENCHMARK(BM_SolarSystemMajorBodiesOnly);
 BENCHMARK(BM_SolarSystemMinorAndMajorBodies);
+BENCHMARK(BM_SolarSystemMinorAndMajorBodiesWithVessels)->Range(1, 1 << 10);
 BENCHMARK(BM_SolarSystemAllBodiesAndOblateness);
+BENCHMARK(BM_PointMassAccelerations)->Range(1, 1 << 12);
+BENCHMARK(BM_PointMassAccelerationsWithoutSIMD)->Range(1, 1 << 12);
 
 }  // namespace benchmarks
 }  // namespace principia
@@ -0,0 +1,167 @@
+﻿#define GLOG_NO_ABBREVIATED_SEVERITIES
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "base/not_null.hpp"
+#include "base/pull_serializer.hpp"
+#include "base/push_deserializer.hpp"
+#include "geometry/frame.hpp"
+#include "geometry/named_quantities.hpp"
+#include "physics/degrees_of_freedom.hpp"
+#include "physics/massive_body.hpp"
+#include "physics/trajectory.hpp"
+#include "quantities/quantities.hpp"
+#include "quantities/si.hpp"
+#include "serialization/geometry.pb.h"
+#include "serialization/physics.pb.h"
+
+// Must come last to avoid conflicts when defining the CHECK macros.
+#include "benchmark/benchmark.h"
+
+namespace principia {
+
+using base::Bytes;
+using base::make_not_null_unique;
+using base::not_null;
+using base::PullSerializer;
+using base::PushDeserializer;
+using geometry::Displacement;
+using geometry::Frame;
+using geometry::Instant;
+using geometry::Velocity;
+using physics::DegreesOfFreedom;
+using physics::MassiveBody;
+using physics::Trajectory;
+using quantities::Mass;
+using quantities::SIUnit;
+using si::Metre;
+using si::Second;
+
+namespace benchmarks {
+
+namespace {
+
+using World = Frame<serialization::Frame::TestTag,
+                    serialization::Frame::TEST, true>;
+
+int const kNumberOfChunks = 8;
+int const kPoints = 100000;
+
+// The serialization of an inclined circular orbit of radius 1 AU sampled
+// every 10 s, which is representative of the histories of the plugin.
+std::unique_ptr<serialization::Trajectory> OrbitMessage() {
+  MassiveBody const body(1 * SIUnit<Mass>());
+  Trajectory<World> trajectory(&body);
+  Instant const t0;
+  double const r = 1.5e11;
+  double const ω = 2e-7;
+  for (int i = 0; i < kPoints; ++i) {
+    double const t = 10 * i;
+    double const c = std::cos(ω * t);
+    double const s = std::sin(ω * t);
+    trajectory.Append(
+        t0 + t * Second,
+        DegreesOfFreedom<World>(
+            World::origin + Displacement<World>({r * c * Metre,
+                                                 r * s * Metre,
+                                                 0.1 * r * s * Metre}),
+            Velocity<World>({-r * ω * s * Metre / Second,
+                             r * ω * c * Metre / Second,
+                             0.1 * r * ω * c * Metre / Second})));
+  }
+  auto message = std::make_unique<serialization::Trajectory>();
+  trajectory.WriteToMessage(message.get());
+  return message;
+}
+
+// Serializes |message| with the given parameters and returns the chunks,
+// concatenated.
+std::string Serialize(serialization::Trajectory const& message,
+                      int const chunk_size,
+                      int const compression_level) {
+  PullSerializer serializer(chunk_size, kNumberOfChunks, compression_level);
+  serializer.Start(make_not_null_unique<serialization::Trajectory>(message));
+  std::string result;
+  for (;;) {
+    Bytes const bytes = serializer.Pull();
+    if (bytes.size == 0) {
+      break;
+    }
+    result.append(reinterpret_cast<char const*>(bytes.data),
+                  static_cast<std::size_t>(bytes.size));
+  }
+  return result;
+}
+
+void SetLabel(std::int64_t const uncompressed_size,
+              std::int64_t const compressed_size,
+              benchmark::State& state) {  // NOLINT(runtime/references)
+  std::stringstream ss;
+  ss << compressed_size << " bytes, ratio "
+     << static_cast<double>(uncompressed_size) / compressed_size;
+  state.SetLabel(ss.str());
+  state.SetBytesProcessed(state.iterations() * uncompressed_size);
+}
+
+}  // namespace
+
+// The chunk size is given by |state.range_x()|, the compression level by
+// |state.range_y()|.
+void BM_PullSerializer(
+    benchmark::State& state) {  // NOLINT(runtime/references)
+  std::unique_ptr<serialization::Trajectory const> const message =
+      OrbitMessage();
+  std::int64_t compressed_size = 0;
+  while (state.KeepRunning()) {
+    compressed_size =
+        Serialize(*message, state.range_x(), state.range_y()).size();
+  }
+  SetLabel(message->ByteSize(), compressed_size, state);
+}
+BENCHMARK(BM_PullSerializer)
+    ->ArgPair(4 << 10, base::kNoCompression)
+    ->ArgPair(64 << 10, base::kNoCompression)
+    ->ArgPair(4 << 10, 1)
+    ->ArgPair(64 << 10, 1)
+    ->ArgPair(64 << 10, 6)
+    ->ArgPair(64 << 10, 9);
+
+// Same parameters as above.  The data is pushed in chunks of the size that
+// was used to produce it.
+void BM_PushDeserializer(
+    benchmark::State& state) {  // NOLINT(runtime/references)
+  std::unique_ptr<serialization::Trajectory const> const message =
+      OrbitMessage();
+  int const chunk_size = state.range_x();
+  std::string const serialized =
+      Serialize(*message, chunk_size, state.range_y());
+  std::vector<std::uint8_t> data(serialized.begin(), serialized.end());
+  while (state.KeepRunning()) {
+    PushDeserializer deserializer(chunk_size, kNumberOfChunks);
+    deserializer.Start(make_not_null_unique<serialization::Trajectory>(),
+                       nullptr);
+    for (std::size_t i = 0; i < data.size(); i += chunk_size) {
+      deserializer.Push(
+          Bytes(&data[i], std::min<std::int64_t>(chunk_size, data.size() - i)),
+          nullptr);
+    }
+    deserializer.Push(Bytes(), nullptr);
+  }
+  SetLabel(message->ByteSize(), serialized.size(), state);
+}
+BENCHMARK(BM_PushDeserializer)
+    ->ArgPair(4 << 10, base::kNoCompression)
+    ->ArgPair(64 << 10, base::kNoCompression)
+    ->ArgPair(4 << 10, 1)
+    ->ArgPair(64 << 10, 1)
+    ->ArgPair(64 << 10, 6)
+    ->ArgPair(64 << 10, 9);
+
+}  // namespace benchmarks
+}  // namespace principia
@@ -0,0 +1,133 @@
+#define GLOG_NO_ABBREVIATED_SEVERITIES
+
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "base/not_null.hpp"
+#include "geometry/named_quantities.hpp"
+#include "ksp_plugin/interface.hpp"
+#include "ksp_plugin/plugin.hpp"
+#include "quantities/named_quantities.hpp"
+#include "quantities/quantities.hpp"
+#include "quantities/si.hpp"
+
+// Must come last to avoid conflicts when defining the CHECK macros.
+#include "benchmark/benchmark.h"
+
+namespace principia {
+
+using base::not_null;
+using geometry::Displacement;
+using geometry::Instant;
+using geometry::Velocity;
+using ksp_plugin::AliceSun;
+using ksp_plugin::GUID;
+using ksp_plugin::Index;
+using ksp_plugin::LineAndIterator;
+using ksp_plugin::Plugin;
+using ksp_plugin::principia__AtEnd;
+using ksp_plugin::principia__DeleteLineAndIterator;
+using ksp_plugin::principia__FetchAndIncrement;
+using ksp_plugin::principia__FetchVertices;
+using ksp_plugin::principia__RenderedVesselTrajectory;
+using ksp_plugin::RenderingTransforms;
+using ksp_plugin::XYZ;
+using ksp_plugin::XYZSegment;
+using quantities::GravitationalParameter;
+using quantities::SIUnit;
+using si::Metre;
+using si::Radian;
+using si::Second;
+
+namespace benchmarks {
+
+namespace {
+
+GUID const kVessel = "vessel";
+Index const kCelestial = 0;
+XYZ const kSunWorldPosition = {0, 0, 0};
+
+// A plugin with a vessel on a circular orbit of radius 1 km around a body
+// with unit gravitational parameter (a period of about 2.2 days), whose
+// history has |points| points, one every 10 s.
+std::unique_ptr<Plugin> NewPlugin(int const points) {
+  auto plugin = std::make_unique<Plugin>(Instant(),
+                                         kCelestial,
+                                         SIUnit<GravitationalParameter>(),
+                                         0 * Radian);
+  plugin->EndInitialization();
+  plugin->InsertOrKeepVessel(kVessel, kCelestial);
+  plugin->SetVesselStateOffset(
+      kVessel,
+      {Displacement<AliceSun>({1000 * Metre, 0 * Metre, 0 * Metre}),
+       Velocity<AliceSun>({0 * Metre / Second,
+                           0.031622776601683794 * Metre / Second,
+                           0 * Metre / Second})});
+  // The first step synchronizes the vessel, each of the others adds a point to
+  // its history, as if time was advanced by the adapter.
+  for (int i = 0; i <= points; ++i) {
+    plugin->InsertOrKeepVessel(kVessel, kCelestial);
+    plugin->AdvanceTime(Instant((10 * i + 15) * Second), 0 * Radian);
+  }
+  return plugin;
+}
+
+}  // namespace
+
+// The end-to-end rendering of a history, from the plugin to the buffers of the
+// adapter, with one call per segment.  The number of points of the history is
+// given by |state.range_x()|.
+void BM_RenderAndFetchSegments(
+    benchmark::State& state) {  // NOLINT(runtime/references)
+  std::unique_ptr<Plugin> const plugin = NewPlugin(state.range_x());
+  not_null<std::unique_ptr<RenderingTransforms>> const transforms =
+      plugin->NewBodyCentredNonRotatingTransforms(kCelestial);
+  std::vector<XYZSegment> segments;
+  while (state.KeepRunning()) {
+    segments.clear();
+    LineAndIterator* line_and_iterator =
+        principia__RenderedVesselTrajectory(plugin.get(),
+                                            kVessel.c_str(),
+                                            transforms.get(),
+                                            kSunWorldPosition);
+    while (!principia__AtEnd(line_and_iterator)) {
+      segments.push_back(principia__FetchAndIncrement(line_and_iterator));
+    }
+    principia__DeleteLineAndIterator(&line_and_iterator);
+  }
+  std::stringstream ss;
+  ss << segments.size() << " segments";
+  state.SetLabel(ss.str());
+}
+
+// Same as above, with a single call fetching all the vertices.
+void BM_RenderAndFetchVertices(
+    benchmark::State& state) {  // NOLINT(runtime/references)
+  std::unique_ptr<Plugin> const plugin = NewPlugin(state.range_x());
+  not_null<std::unique_ptr<RenderingTransforms>> const transforms =
+      plugin->NewBodyCentredNonRotatingTransforms(kCelestial);
+  std::vector<XYZ> vertices(state.range_x() + 1);
+  int count = 0;
+  while (state.KeepRunning()) {
+    LineAndIterator* line_and_iterator =
+        principia__RenderedVesselTrajectory(plugin.get(),
+                                            kVessel.c_str(),
+                                            transforms.get(),
+                                            kSunWorldPosition);
+    count = principia__FetchVertices(line_and_iterator,
+                                     vertices.data(),
+                                     vertices.size());
+    principia__DeleteLineAndIterator(&line_and_iterator);
+  }
+  std::stringstream ss;
+  ss << count << " vertices";
+  state.SetLabel(ss.str());
+}
+
+BENCHMARK(BM_RenderAndFetchSegments)->Arg(1000)->Arg(10000)->Arg(100000);
+BENCHMARK(BM_RenderAndFetchVertices)->Arg(1000)->Arg(10000)->Arg(100000);
+
+}  // namespace benchmarks
+}  // namespace principia
@@ -132,6 +132,7 @@
 #include <vector>
 
 #include "base/not_null.hpp"
+#include "integrators/static_symplectic_runge_kutta_nystrom_integrator.hpp"
 #include "quantities/elementary_functions.hpp"
 #include "quantities/named_quantities.hpp"
 #include "testing_utilities/numerical_analysis.hpp"
@@ -143,7 +144,9 @@ namespace principia {
 
 using integrators::SPRKIntegrator;
 using integrators::SRKNIntegrator;
+using integrators::StaticSRKNIntegrator;
 using quantities::Abs;
+using quantities::Acceleration;
 using quantities::AngularFrequency;
 using quantities::Cos;
 using quantities::Length;
@@ -152,11 +155,14 @@ using testing_utilities::ComputeHarmonicOscillatorAcceleration;
 
 namespace benchmarks {
 
+// |Integrator| is either an |SRKNIntegrator|, which calls the right-hand side
+// through an |std::function|, or a |StaticSRKNIntegrator|, which may inline it.
+template<typename Integrator>
 void SolveHarmonicOscillatorAndComputeError(
     not_null<benchmark::State*> const state,
     not_null<Length*> const q_error,
     not_null<Speed*> const v_error,
-    SRKNIntegrator const& integrator) {
+    Integrator const& integrator) {
   SRKNIntegrator::Solution<Length, Speed> solution;
   SRKNIntegrator::Parameters<Length, Speed> parameters;
 
@@ -170,8 +176,12 @@ void SolveHarmonicOscillatorAndComputeError(
 #endif
   parameters.Δt = 1.0E-4 * SIUnit<Time>();
   parameters.sampling_period = 1;
-  integrator.SolveTrivialKineticEnergyIncrement<Length>(
-      &ComputeHarmonicOscillatorAcceleration,
+  integrator.template SolveTrivialKineticEnergyIncrement<Length>(
+      [](Time const& t,
+         std::vector<Length> const& q,
+         not_null<std::vector<Acceleration>*> const result) {
+        ComputeHarmonicOscillatorAcceleration(t, q, result);
+      },
       parameters,
       &solution);
 
@@ -207,6 +217,22 @@ void BM_SolveHarmonicOscillator(
   state.SetLabel(ss.str());
 }
 
+// Same as above, with the coefficients of |Method| known at compile time.
+template<typename Method>
+void BM_SolveHarmonicOscillatorStatic(
+    benchmark::State& state) {  // NOLINT(runtime/references)
+  StaticSRKNIntegrator<Method> const integrator;
+  Length q_error;
+  Speed v_error;
+  while (state.KeepRunning()) {
+    SolveHarmonicOscillatorAndComputeError(&state, &q_error, &v_error,
+                                           integrator);
+  }
+  std::stringstream ss;
+  ss << q_error << ", " << v_error;
+  state.SetLabel(ss.str());
+}
+
 BENCHMARK_TEMPLATE2(BM_SolveHarmonicOscillator, SPRKIntegrator,
                     &integrators::Leapfrog);
 BENCHMARK_TEMPLATE2(BM_SolveHarmonicOscillator, SPRKIntegrator,
@@ -227,6 +253,10 @@ BENCHMARK_TEMPLATE2(BM_SolveHarmonicOscillator, SRKNIntegrator,
                     &integrators::McLachlanAtela1992Order4Optimal);
 BENCHMARK_TEMPLATE2(BM_SolveHarmonicOscillator, SRKNIntegrator,
                     &integrators::McLachlanAtela1992Order5Optimal);
+BENCHMARK_TEMPLATE(BM_SolveHarmonicOscillatorStatic,
+                   integrators::methods::McLachlanAtela1992Order4Optimal);
+BENCHMARK_TEMPLATE(BM_SolveHarmonicOscillatorStatic,
+                   integrators::methods::McLachlanAtela1992Order5Optimal);
 BENCHMARK_TEMPLATE2(BM_SolveHarmonicOscillator, SPRKIntegrator,
                     &integrators::Yoshida1990Order6A);
 BENCHMARK_TEMPLATE2(BM_SolveHarmonicOscillator, SPRKIntegrator,
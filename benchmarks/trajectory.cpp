@@ -0,0 +1,196 @@
+﻿#define GLOG_NO_ABBREVIATED_SEVERITIES
+
+#include <cmath>
+#include <memory>
+#include <sstream>
+#include <string>
+
+#include "base/not_null.hpp"
+#include "geometry/frame.hpp"
+#include "geometry/named_quantities.hpp"
+#include "physics/degrees_of_freedom.hpp"
+#include "physics/massive_body.hpp"
+#include "physics/trajectory.hpp"
+#include "quantities/quantities.hpp"
+#include "quantities/si.hpp"
+#include "serialization/geometry.pb.h"
+#include "serialization/physics.pb.h"
+
+// Must come last to avoid conflicts when defining the CHECK macros.
+#include "benchmark/benchmark.h"
+
+namespace principia {
+
+using base::not_null;
+using geometry::Displacement;
+using geometry::Frame;
+using geometry::Instant;
+using geometry::Velocity;
+using physics::DegreesOfFreedom;
+using physics::MassiveBody;
+using physics::Trajectory;
+using quantities::Length;
+using quantities::Mass;
+using quantities::SIUnit;
+using quantities::Speed;
+using si::Metre;
+using si::Second;
+
+namespace benchmarks {
+
+namespace {
+
+using World = Frame<serialization::Frame::TestTag,
+                    serialization::Frame::TEST, true>;
+
+int const kPoints = 100000;
+
+void AppendPoints(not_null<Trajectory<World>*> const trajectory) {
+  Instant const t0;
+  DegreesOfFreedom<World> const degrees_of_freedom(World::origin,
+                                                   Velocity<World>());
+  for (int i = 0; i < kPoints; ++i) {
+    trajectory->Append(t0 + i * Second, degrees_of_freedom);
+  }
+}
+
+// An inclined circular orbit of radius 1 AU sampled every 10 s, which is
+// representative of the histories of the plugin.
+void AppendOrbit(not_null<Trajectory<World>*> const trajectory) {
+  Instant const t0;
+  double const r = 1.5e11;
+  double const ω = 2e-7;
+  for (int i = 0; i < kPoints; ++i) {
+    double const t = 10 * i;
+    double const c = std::cos(ω * t);
+    double const s = std::sin(ω * t);
+    trajectory->Append(
+        t0 + t * Second,
+        DegreesOfFreedom<World>(
+            World::origin + Displacement<World>({r * c * Metre,
+                                                 r * s * Metre,
+                                                 0.1 * r * s * Metre}),
+            Velocity<World>({-r * ω * s * Metre / Second,
+                             r * ω * c * Metre / Second,
+                             0.1 * r * ω * c * Metre / Second})));
+  }
+}
+
+// Writes the points of |trajectory| in |timeline|, which was the only format
+// before |columns| was introduced.
+void WriteLegacyMessage(Trajectory<World> const& trajectory,
+                        not_null<serialization::Trajectory*> const message) {
+  for (auto it = trajectory.first(); !it.at_end(); ++it) {
+    auto* const point = message->add_timeline();
+    it.time().WriteToMessage(point->mutable_instant());
+    it.degrees_of_freedom().WriteToMessage(
+        point->mutable_degrees_of_freedom());
+  }
+}
+
+void SetSizeLabel(serialization::Trajectory const& message,
+                  benchmark::State& state) {  // NOLINT(runtime/references)
+  std::stringstream ss;
+  ss << message.ByteSize() << " bytes";
+  state.SetLabel(ss.str());
+}
+
+}  // namespace
+
+void BM_TrajectoryAppend(
+    benchmark::State& state) {  // NOLINT(runtime/references)
+  MassiveBody const body(1 * SIUnit<Mass>());
+  while (state.KeepRunning()) {
+    Trajectory<World> trajectory(&body);
+    AppendPoints(&trajectory);
+  }
+}
+BENCHMARK(BM_TrajectoryAppend);
+
+void BM_TrajectoryPositions(
+    benchmark::State& state) {  // NOLINT(runtime/references)
+  MassiveBody const body(1 * SIUnit<Mass>());
+  Trajectory<World> trajectory(&body);
+  AppendPoints(&trajectory);
+  // Read the positions through a fork, which is the usual case for the
+  // predictions.
+  not_null<Trajectory<World>*> const fork =
+      trajectory.NewFork(trajectory.last().time());
+  std::size_t size = 0;
+  while (state.KeepRunning()) {
+    size += fork->Positions().size();
+  }
+  std::stringstream ss;
+  ss << size;
+  state.SetLabel(ss.str());
+}
+BENCHMARK(BM_TrajectoryPositions);
+
+void BM_TrajectorySerialization(
+    benchmark::State& state) {  // NOLINT(runtime/references)
+  MassiveBody const body(1 * SIUnit<Mass>());
+  Trajectory<World> trajectory(&body);
+  AppendOrbit(&trajectory);
+  serialization::Trajectory message;
+  std::string bytes;
+  while (state.KeepRunning()) {
+    message.Clear();
+    trajectory.WriteToMessage(&message);
+    message.SerializeToString(&bytes);
+  }
+  SetSizeLabel(message, state);
+}
+BENCHMARK(BM_TrajectorySerialization);
+
+void BM_TrajectoryLegacySerialization(
+    benchmark::State& state) {  // NOLINT(runtime/references)
+  MassiveBody const body(1 * SIUnit<Mass>());
+  Trajectory<World> trajectory(&body);
+  AppendOrbit(&trajectory);
+  serialization::Trajectory message;
+  std::string bytes;
+  while (state.KeepRunning()) {
+    message.Clear();
+    WriteLegacyMessage(trajectory, &message);
+    message.SerializeToString(&bytes);
+  }
+  SetSizeLabel(message, state);
+}
+BENCHMARK(BM_TrajectoryLegacySerialization);
+
+void BM_TrajectoryDeserialization(
+    benchmark::State& state) {  // NOLINT(runtime/references)
+  MassiveBody const body(1 * SIUnit<Mass>());
+  Trajectory<World> trajectory(&body);
+  AppendOrbit(&trajectory);
+  serialization::Trajectory message;
+  trajectory.WriteToMessage(&message);
+  std::string const bytes = message.SerializeAsString();
+  while (state.KeepRunning()) {
+    message.ParseFromString(bytes);
+    std::unique_ptr<Trajectory<World>> const deserialized =
+        Trajectory<World>::ReadFromMessage(message, &body);
+  }
+  SetSizeLabel(message, state);
+}
+BENCHMARK(BM_TrajectoryDeserialization);
+
+void BM_TrajectoryLegacyDeserialization(
+    benchmark::State& state) {  // NOLINT(runtime/references)
+  MassiveBody const body(1 * SIUnit<Mass>());
+  Trajectory<World> trajectory(&body);
+  AppendOrbit(&trajectory);
+  serialization::Trajectory message;
+  WriteLegacyMessage(trajectory, &message);
+  std::string const bytes = message.SerializeAsString();
+  while (state.KeepRunning()) {
+    message.ParseFromString(bytes);
+    std::unique_ptr<Trajectory<World>> const deserialized =
+        Trajectory<World>::ReadFromMessage(message, &body);
+  }
+  SetSizeLabel(message, state);
+}
+BENCHMARK(BM_TrajectoryLegacyDeserialization);
+
+}  // namespace benchmarks
+}  // namespace principia
@@ -21,6 +21,10 @@ class AffineMap {
   AffineMap<ToFrame, FromFrame, Scalar, LinearMap> Inverse() const;
   Point<ToVector> operator()(Point<FromVector> const& point) const;
 
+  // The map between the vector spaces, which is the one applied to the
+  // velocities.
+  LinearMap<FromFrame, ToFrame> const& linear_map() const;
+
   static AffineMap Identity();
 
   void WriteToMessage(not_null<serialization::AffineMap*> const message) const;
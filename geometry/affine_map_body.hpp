@@ -39,6 +39,13 @@ AffineMap<FromFrame, ToFrame, Scalar, LinearMap>::operator()(
           linear_map_(point - from_origin_) + to_origin_);
 }
 
+template<typename FromFrame, typename ToFrame, typename Scalar,
+         template<typename, typename> class LinearMap>
+LinearMap<FromFrame, ToFrame> const&
+AffineMap<FromFrame, ToFrame, Scalar, LinearMap>::linear_map() const {
+  return linear_map_;
+}
+
 template<typename FromFrame, typename ToFrame, typename Scalar,
          template<typename, typename> class LinearMap>
 AffineMap<FromFrame, ToFrame, Scalar, LinearMap>
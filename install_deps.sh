@@ -1,7 +1,7 @@
 #!/bin/bash
 
-echo "apt-get installing: clang git unzip wget libc++-dev binutils make automake libtool curl cmake subversion"
-sudo apt-get install clang git unzip wget libc++-dev binutils make automake libtool curl cmake subversion
+echo "apt-get installing: clang git unzip wget libc++-dev binutils make automake libtool curl cmake subversion zlib1g-dev"
+sudo apt-get install clang git unzip wget libc++-dev binutils make automake libtool curl cmake subversion zlib1g-dev
 
 mkdir -p deps
 cd deps
@@ -11,7 +11,8 @@ pushd protobuf
 git am "../../documentation/Setup Files/protobuf.patch"
 ./autogen.sh
 ./autogen.sh # Makefile.in ends up being missing unless we run this twice??
-./configure CC=clang CXX=clang++ CXXFLAGS='-fPIC -m64 -std=c++11 -stdlib=libc++ -O3 -g' LDFLAGS='-stdlib=libc++'
+# The gzip streams used by the serializers require zlib.
+./configure CC=clang CXX=clang++ CXXFLAGS='-fPIC -m64 -std=c++11 -stdlib=libc++ -O3 -g' LDFLAGS='-stdlib=libc++' --with-zlib
 make -j 8
 
 popd
@@ -0,0 +1,119 @@
+﻿#pragma once
+
+#include <functional>
+#include <vector>
+
+#include "base/not_null.hpp"
+#include "integrators/symplectic_integrator.hpp"
+#include "quantities/named_quantities.hpp"
+
+namespace principia {
+
+using base::not_null;
+using quantities::Difference;
+using quantities::Time;
+using quantities::Variation;
+
+namespace integrators {
+
+// An explicit Runge-Kutta-Nyström method with an embedded method of lower
+// order, for the differential equation q" = f(q, t).  The difference between
+// the two methods estimates the local error of the lower-order one, and is
+// used to choose the step so that the error remains below a given tolerance.
+// The solution is that of the higher-order method (local extrapolation).
+// With the notations of Dormand, El-Mikkawy and Prince (1986), the stages are
+//   Qᵢ = q + cᵢ h q′ + h² Σⱼ aᵢⱼ f(Qⱼ, t + cⱼ h),
+// the solution is
+//   q̂ = q + h q′ + h² Σᵢ b̂ᵢ f(Qᵢ, t + cᵢ h),
+//   q̂′ = q′ + h Σᵢ b̂′ᵢ f(Qᵢ, t + cᵢ h),
+// and the embedded method uses the weights bᵢ and b′ᵢ.  If the last stage is
+// evaluated at the solution (first same as last), it is reused as the first
+// stage of the next step.
+// Unlike those of |SRKNIntegrator|, these methods are not symplectic: they are
+// meant for integrations over a limited interval, e.g., for predictions, where
+// the step must adapt to close approaches.
+class EmbeddedRKNIntegrator {
+ public:
+  // |c| has one element per stage, with |c.front() == 0|.  |a| is strictly
+  // lower triangular: its ith element has i elements.  |lower_order| is the
+  // order of the embedded method, which determines how the step is adapted.
+  EmbeddedRKNIntegrator(std::vector<double> const& c,
+                        std::vector<std::vector<double>> const& a,
+                        std::vector<double> const& b_hat,
+                        std::vector<double> const& b_prime_hat,
+                        std::vector<double> const& b,
+                        std::vector<double> const& b_prime,
+                        int const lower_order);
+
+  EmbeddedRKNIntegrator() = delete;
+  EmbeddedRKNIntegrator(EmbeddedRKNIntegrator const&) = delete;
+  EmbeddedRKNIntegrator(EmbeddedRKNIntegrator&&) = delete;
+  EmbeddedRKNIntegrator& operator=(EmbeddedRKNIntegrator const&) = delete;
+  EmbeddedRKNIntegrator& operator=(EmbeddedRKNIntegrator&&) = delete;
+
+  template<typename Position>
+  using RightHandSideComputation =
+      std::function<
+          void(Time const& t,
+               std::vector<Position> const&,
+               not_null<std::vector<Variation<Variation<Position>>>*> const)>;
+
+  template<typename Position>
+  using SystemState =
+      SymplecticIntegrator::SystemState<Position, Variation<Position>>;
+
+  template<typename Position>
+  using Solution = std::vector<SystemState<Position>>;
+
+  template<typename Position>
+  struct Parameters {
+    // The initial state of the system.
+    SystemState<Position> initial;
+    // The ending time of the resolution.  The time of the last step is exactly
+    // |tmax|.
+    Time tmax;
+    // The length of the first step attempted.  Subsequent steps are chosen by
+    // the integrator.
+    Time first_time_step;
+    // The estimated local errors in position and velocity for each step are
+    // kept below these tolerances, in all the dimensions.
+    Difference<Position> length_tolerance;
+    Variation<Position> speed_tolerance;
+    // The factor by which the optimal step is multiplied to reduce the
+    // probability of a step being rejected.
+    double safety_factor = 0.9;
+  };
+
+  // Integrates from |parameters.initial| to |parameters.tmax|, appending to
+  // |solution| the state at the end of each accepted step.  The functor
+  // |compute_acceleration| computes f(q, t).
+  template<typename Position>
+  void Solve(RightHandSideComputation<Position> compute_acceleration,
+             Parameters<Position> const& parameters,
+             not_null<Solution<Position>*> const solution) const;
+
+ private:
+  int const stages_;
+  int const lower_order_;
+  bool const first_same_as_last_;
+  std::vector<double> const c_;
+  std::vector<std::vector<double>> const a_;
+  std::vector<double> const b_hat_;
+  std::vector<double> const b_prime_hat_;
+  // The differences between the weights of the two methods, used for the
+  // error estimate.
+  std::vector<double> b_hat_minus_b_;
+  std::vector<double> b_prime_hat_minus_b_prime_;
+};
+
+// Fourth order with an embedded third-order method, 4 stages, first same as
+// last, so 3 evaluations per step.
+// Coefficients from Dormand, El-Mikkawy and Prince (1986),
+// Families of Runge-Kutta-Nyström formulae, table 3 (the RKN4(3)4FM pair).
+// https://doi.org/10.1093/imanum/7.2.235.
+EmbeddedRKNIntegrator const& DormandElMikkawyPrince1986RKN434FM();
+
+}  // namespace integrators
+}  // namespace principia
+
+#include "integrators/embedded_runge_kutta_nystrom_integrator_body.hpp"
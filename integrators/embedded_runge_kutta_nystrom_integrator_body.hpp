@@ -0,0 +1,208 @@
+﻿#pragma once
+
+#include "integrators/embedded_runge_kutta_nystrom_integrator.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "glog/logging.h"
+#include "quantities/quantities.hpp"
+
+namespace principia {
+
+using quantities::Abs;
+
+namespace integrators {
+
+namespace {
+
+// Bounds on the ratio between consecutive steps, to avoid wild oscillations
+// when the error estimate is accidentally small or large.
+double const kMinStepRatio = 0.2;
+double const kMaxStepRatio = 5.0;
+
+}  // namespace
+
+inline EmbeddedRKNIntegrator const& DormandElMikkawyPrince1986RKN434FM() {
+  static EmbeddedRKNIntegrator const integrator(
+      {0.0, 1.0 / 4.0, 7.0 / 10.0, 1.0},
+      {{},
+       {1.0 / 32.0},
+       {7.0 / 1000.0, 119.0 / 500.0},
+       {1.0 / 14.0, 8.0 / 27.0, 25.0 / 189.0}},
+      {1.0 / 14.0, 8.0 / 27.0, 25.0 / 189.0, 0.0},
+      {1.0 / 14.0, 32.0 / 81.0, 250.0 / 567.0, 5.0 / 54.0},
+      {-7.0 / 150.0, 67.0 / 150.0, 3.0 / 20.0, -1.0 / 20.0},
+      {13.0 / 21.0, -20.0 / 27.0, 275.0 / 189.0, -1.0 / 3.0},
+      3);
+  return integrator;
+}
+
+inline EmbeddedRKNIntegrator::EmbeddedRKNIntegrator(
+    std::vector<double> const& c,
+    std::vector<std::vector<double>> const& a,
+    std::vector<double> const& b_hat,
+    std::vector<double> const& b_prime_hat,
+    std::vector<double> const& b,
+    std::vector<double> const& b_prime,
+    int const lower_order)
+    : stages_(static_cast<int>(c.size())),
+      lower_order_(lower_order),
+      // The last stage is evaluated at the solution if its node is 1 and its
+      // coefficients are the weights of the solution.
+      first_same_as_last_(
+          c.back() == 1.0 && b_hat.back() == 0.0 &&
+          std::equal(a.back().begin(), a.back().end(), b_hat.begin())),
+      c_(c),
+      a_(a),
+      b_hat_(b_hat),
+      b_prime_hat_(b_prime_hat) {
+  CHECK_LE(1, stages_);
+  CHECK_EQ(0.0, c_.front());
+  CHECK_EQ(stages_, static_cast<int>(a_.size()));
+  CHECK_EQ(stages_, static_cast<int>(b_hat_.size()));
+  CHECK_EQ(stages_, static_cast<int>(b_prime_hat_.size()));
+  CHECK_EQ(stages_, static_cast<int>(b.size()));
+  CHECK_EQ(stages_, static_cast<int>(b_prime.size()));
+  CHECK_LE(1, lower_order_);
+  for (int i = 0; i < stages_; ++i) {
+    CHECK_EQ(i, static_cast<int>(a_[i].size()));
+    b_hat_minus_b_.push_back(b_hat_[i] - b[i]);
+    b_prime_hat_minus_b_prime_.push_back(b_prime_hat_[i] - b_prime[i]);
+  }
+}
+
+template<typename Position>
+void EmbeddedRKNIntegrator::Solve(
+    RightHandSideComputation<Position> compute_acceleration,
+    Parameters<Position> const& parameters,
+    not_null<Solution<Position>*> const solution) const {
+  using Displacement = Difference<Position>;
+  using Velocity = Variation<Position>;
+  using Acceleration = Variation<Velocity>;
+  int const dimension = parameters.initial.positions.size();
+
+  CHECK_LT(Time(), parameters.first_time_step);
+  CHECK_LT(Displacement(), parameters.length_tolerance);
+  CHECK_LT(Velocity(), parameters.speed_tolerance);
+  CHECK_LT(0.0, parameters.safety_factor);
+  CHECK_GE(1.0, parameters.safety_factor);
+  CHECK_LE(parameters.initial.time.value, parameters.tmax);
+
+  std::vector<DoublePrecision<Position>> q(parameters.initial.positions);
+  std::vector<DoublePrecision<Velocity>> v(parameters.initial.momenta);
+  DoublePrecision<Time> t = parameters.initial.time;
+
+  // The accelerations at each stage.
+  std::vector<std::vector<Acceleration>> g(
+      stages_, std::vector<Acceleration>(dimension));
+  std::vector<Position> q_stage(dimension);
+  std::vector<Displacement> Δq(dimension);
+  std::vector<Velocity> Δv(dimension);
+
+  // Whether |g[0]| holds the acceleration at the beginning of the current
+  // step.
+  bool first_stage_is_known = false;
+
+  Time h = parameters.first_time_step;
+  while (t.value < parameters.tmax) {
+    // Do not overshoot |tmax|, and make sure that the last step lands exactly
+    // on it.
+    bool const at_end = parameters.tmax - t.value <= h;
+    if (at_end) {
+      h = (parameters.tmax - t.value) - t.error;
+    }
+
+    // Compute the stages.
+    for (int i = 0; i < stages_; ++i) {
+      if (i == 0 && first_stage_is_known) {
+        continue;
+      }
+      for (int k = 0; k < dimension; ++k) {
+        // Σⱼ aᵢⱼ gⱼ.
+        Acceleration stage_sum;
+        for (int j = 0; j < i; ++j) {
+          stage_sum += a_[i][j] * g[j][k];
+        }
+        q_stage[k] = q[k].value + h * (c_[i] * v[k].value + h * stage_sum);
+      }
+      compute_acceleration(t.value + (t.error + c_[i] * h), q_stage, &g[i]);
+    }
+
+    // Compute the increments of the solution and the error estimate, as a
+    // ratio to the tolerance.
+    double error_ratio = 0.0;
+    for (int k = 0; k < dimension; ++k) {
+      // The sums of the accelerations weighted by the coefficients of the
+      // solution, and by the differences of the coefficients of the two
+      // methods.
+      Acceleration position_sum;
+      Acceleration velocity_sum;
+      Acceleration position_error_sum;
+      Acceleration velocity_error_sum;
+      for (int i = 0; i < stages_; ++i) {
+        position_sum += b_hat_[i] * g[i][k];
+        velocity_sum += b_prime_hat_[i] * g[i][k];
+        position_error_sum += b_hat_minus_b_[i] * g[i][k];
+        velocity_error_sum += b_prime_hat_minus_b_prime_[i] * g[i][k];
+      }
+      Δq[k] = h * (v[k].value + h * position_sum);
+      Δv[k] = h * velocity_sum;
+      error_ratio = std::max(
+          error_ratio,
+          std::max(Abs(h * h * position_error_sum) /
+                       parameters.length_tolerance,
+                   Abs(h * velocity_error_sum) / parameters.speed_tolerance));
+    }
+
+    // The optimal step for the error estimate of the embedded method, which is
+    // O(h^(lower_order + 1)).
+    double const step_ratio =
+        error_ratio == 0.0
+            ? kMaxStepRatio
+            : std::min(kMaxStepRatio,
+                       std::max(kMinStepRatio,
+                                parameters.safety_factor *
+                                    std::pow(1.0 / error_ratio,
+                                             1.0 / (lower_order_ + 1))));
+    if (error_ratio > 1.0) {
+      // Reject the step and try again with a shorter one.  The acceleration at
+      // the beginning of the step is still valid.
+      CHECK_LT(t.value, t.value + h * step_ratio)
+          << "Step size underflow at " << t.value;
+      h *= step_ratio;
+      first_stage_is_known = true;
+      continue;
+    }
+
+    // Accept the step.
+    for (int k = 0; k < dimension; ++k) {
+      q[k].Increment(Δq[k]);
+      v[k].Increment(Δv[k]);
+    }
+    t.Increment(h);
+    if (at_end) {
+      // Ensure that the loop terminates despite the compensated summation.
+      t = parameters.tmax;
+    }
+    solution->emplace_back();
+    SystemState<Position>& state = solution->back();
+    state.positions = q;
+    state.momenta = v;
+    state.time = t;
+
+    if (first_same_as_last_) {
+      std::swap(g.front(), g.back());
+      first_stage_is_known = true;
+    } else {
+      first_stage_is_known = false;
+    }
+    if (!at_end) {
+      h *= step_ratio;
+    }
+  }
+}
+
+}  // namespace integrators
+}  // namespace principia
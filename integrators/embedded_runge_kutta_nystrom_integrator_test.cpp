@@ -0,0 +1,178 @@
+﻿#include "integrators/embedded_runge_kutta_nystrom_integrator.hpp"
+
+#include <cmath>
+#include <vector>
+
+#include "glog/logging.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "integrators/symplectic_runge_kutta_nystrom_integrator.hpp"
+#include "quantities/numbers.hpp"
+#include "quantities/quantities.hpp"
+#include "quantities/named_quantities.hpp"
+#include "quantities/si.hpp"
+#include "testing_utilities/almost_equals.hpp"
+#include "testing_utilities/numerical_analysis.hpp"
+
+namespace principia {
+
+using quantities::Abs;
+using quantities::Acceleration;
+using quantities::Cos;
+using quantities::Length;
+using quantities::Sin;
+using quantities::Speed;
+using quantities::Sqrt;
+using quantities::Time;
+using si::Metre;
+using si::Radian;
+using si::Second;
+using testing_utilities::AlmostEquals;
+using testing_utilities::ComputeHarmonicOscillatorAcceleration;
+using testing_utilities::ComputeKeplerAcceleration;
+using ::testing::Eq;
+using ::testing::Gt;
+using ::testing::Lt;
+
+namespace integrators {
+
+class EmbeddedRKNIntegratorTest : public ::testing::Test {
+ public:
+  static void SetUpTestCase() {
+    google::LogToStderr();
+  }
+
+ protected:
+  EmbeddedRKNIntegratorTest()
+      : integrator_(DormandElMikkawyPrince1986RKN434FM()) {
+    parameters_.initial.time = Time();
+    parameters_.first_time_step = 1 * Second;
+    parameters_.length_tolerance = 1E-6 * Metre;
+    parameters_.speed_tolerance = 1E-6 * Metre / Second;
+  }
+
+  EmbeddedRKNIntegrator const& integrator_;
+  EmbeddedRKNIntegrator::Parameters<Length> parameters_;
+  EmbeddedRKNIntegrator::Solution<Length> solution_;
+};
+
+using EmbeddedRKNIntegratorDeathTest = EmbeddedRKNIntegratorTest;
+
+TEST_F(EmbeddedRKNIntegratorDeathTest, Errors) {
+  parameters_.initial.positions.emplace_back(1 * Metre);
+  parameters_.initial.momenta.emplace_back(0 * Metre / Second);
+  parameters_.tmax = 10 * Second;
+  EXPECT_DEATH({
+    parameters_.length_tolerance = 0 * Metre;
+    integrator_.Solve<Length>(&ComputeHarmonicOscillatorAcceleration,
+                              parameters_, &solution_);
+  }, "length_tolerance");
+  EXPECT_DEATH({
+    parameters_.tmax = -1 * Second;
+    integrator_.Solve<Length>(&ComputeHarmonicOscillatorAcceleration,
+                              parameters_, &solution_);
+  }, "tmax");
+}
+
+// The last step is exactly at |tmax|, and the global error follows the
+// tolerance.
+TEST_F(EmbeddedRKNIntegratorTest, HarmonicOscillator) {
+  parameters_.initial.positions.emplace_back(1 * Metre);
+  parameters_.initial.momenta.emplace_back(0 * Metre / Second);
+  parameters_.tmax = 100 * Second;
+  std::vector<int> evaluations;
+  std::vector<Length> errors;
+  for (double const tolerance : {1E-4, 1E-6, 1E-8, 1E-10}) {
+    parameters_.length_tolerance = tolerance * Metre;
+    parameters_.speed_tolerance = tolerance * Metre / Second;
+    solution_.clear();
+    int evaluation_count = 0;
+    integrator_.Solve<Length>(
+        [&evaluation_count](Time const& t,
+                            std::vector<Length> const& q,
+                            not_null<std::vector<Acceleration>*> const a) {
+          ++evaluation_count;
+          ComputeHarmonicOscillatorAcceleration(t, q, a);
+        },
+        parameters_,
+        &solution_);
+    EXPECT_THAT(solution_.back().time.value, Eq(parameters_.tmax));
+    Length error;
+    for (auto const& state : solution_) {
+      Time const t = state.time.value;
+      error = std::max(error,
+                       Abs(state.positions[0].value -
+                           Cos(t * Radian / Second) * Metre));
+    }
+    evaluations.push_back(evaluation_count);
+    errors.push_back(error);
+  }
+  for (int i = 1; i < static_cast<int>(errors.size()); ++i) {
+    EXPECT_THAT(errors[i], Lt(errors[i - 1]));
+    EXPECT_THAT(evaluations[i], Gt(evaluations[i - 1]));
+  }
+  // The global error is a modest multiple of the local tolerance.
+  EXPECT_THAT(errors.front(), Lt(1E-2 * Metre));
+  EXPECT_THAT(errors.back(), Lt(1E-8 * Metre));
+}
+
+// On an eccentric orbit the adaptive integrator reaches a given accuracy with
+// far fewer evaluations than a fixed-step symplectic integrator, because it
+// takes small steps only near periapsis.
+TEST_F(EmbeddedRKNIntegratorTest, EccentricKeplerOrbit) {
+  double const e = 0.9;
+  // Semimajor axis 1 m, μ = 1 m³ s⁻², so the period is 2π s.
+  Time const period = 2 * π * Second;
+  Length const periapsis = (1 - e) * Metre;
+  Speed const periapsis_speed = std::sqrt((1 + e) / (1 - e)) * Metre / Second;
+  parameters_.initial.positions = {periapsis, 0 * Metre};
+  parameters_.initial.momenta = {0 * Metre / Second, periapsis_speed};
+  parameters_.tmax = period;
+  parameters_.first_time_step = period / 100;
+  parameters_.length_tolerance = 1E-7 * Metre;
+  parameters_.speed_tolerance = 1E-7 * Metre / Second;
+  int adaptive_evaluations = 0;
+  integrator_.Solve<Length>(
+      [&adaptive_evaluations](Time const& t,
+                              std::vector<Length> const& q,
+                              not_null<std::vector<Acceleration>*> const a) {
+        ++adaptive_evaluations;
+        ComputeKeplerAcceleration(t, q, a);
+      },
+      parameters_,
+      &solution_);
+  Length const adaptive_error =
+      std::max(Abs(solution_.back().positions[0].value - periapsis),
+               Abs(solution_.back().positions[1].value));
+
+  SRKNIntegrator::Parameters<Length, Speed> fixed_parameters;
+  SRKNIntegrator::Solution<Length, Speed> fixed_solution;
+  fixed_parameters.initial = parameters_.initial;
+  fixed_parameters.tmax = period;
+  fixed_parameters.Δt = period / 2000;
+  fixed_parameters.sampling_period = 0;
+  fixed_parameters.tmax_is_exact = true;
+  int fixed_evaluations = 0;
+  McLachlanAtela1992Order5Optimal().SolveTrivialKineticEnergyIncrement<Length>(
+      [&fixed_evaluations](Time const& t,
+                           std::vector<Length> const& q,
+                           not_null<std::vector<Acceleration>*> const a) {
+        ++fixed_evaluations;
+        ComputeKeplerAcceleration(t, q, a);
+      },
+      fixed_parameters,
+      &fixed_solution);
+  Length const fixed_error =
+      std::max(Abs(fixed_solution.back().positions[0].value - periapsis),
+               Abs(fixed_solution.back().positions[1].value));
+
+  LOG(INFO) << "Adaptive: " << adaptive_evaluations << " evaluations, error "
+            << adaptive_error;
+  LOG(INFO) << "Fixed: " << fixed_evaluations << " evaluations, error "
+            << fixed_error;
+  EXPECT_THAT(adaptive_error, Lt(fixed_error));
+  EXPECT_THAT(5 * adaptive_evaluations, Lt(fixed_evaluations));
+}
+
+}  // namespace integrators
+}  // namespace principia
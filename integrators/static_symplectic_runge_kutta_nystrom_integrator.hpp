@@ -0,0 +1,88 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <utility>
+
+#include "base/not_null.hpp"
+#include "integrators/symplectic_runge_kutta_nystrom_integrator.hpp"
+#include "quantities/named_quantities.hpp"
+
+namespace principia {
+
+using base::not_null;
+using quantities::Variation;
+
+namespace integrators {
+
+// An |SRKNIntegrator| whose coefficients are those of |Method|, which must have
+// static constexpr functions |a()| and |b()| returning |std::array|s of the
+// same size (see the structs in namespace |methods|).  Through a reference to
+// an |SRKNIntegrator| it behaves exactly like an |SRKNIntegrator| constructed
+// with these coefficients.  Its own |SolveTrivialKineticEnergyIncrement|
+// however uses them as compile-time constants, unrolls the loop over the
+// stages, and takes the right-hand side as a template functor, so that the
+// compiler may inline it and fuse the updates of consecutive stages.  The
+// results are identical.
+template<typename Method>
+class StaticSRKNIntegrator : public SRKNIntegrator {
+ public:
+  StaticSRKNIntegrator();
+
+  // Same as |SRKNIntegrator::SolveTrivialKineticEnergyIncrement|, except that
+  // |compute_acceleration| may be any functor that can be called like an
+  // |SRKNRightHandSideComputation<Position>|.
+  template<typename Position, typename RightHandSideComputation>
+  void SolveTrivialKineticEnergyIncrement(
+      RightHandSideComputation compute_acceleration,
+      Parameters<Position, Variation<Position>> const& parameters,
+      not_null<Solution<Position, Variation<Position>>*> const solution) const;
+  template<typename Position, typename RightHandSideComputation>
+  void SolveTrivialKineticEnergyIncrement(
+      RightHandSideComputation compute_acceleration,
+      Parameters<Position, Variation<Position>> const& parameters,
+      AppendState<Position, Variation<Position>> const& append_state) const;
+
+ private:
+  // The coefficients of |Method|, processed at compile time like the
+  // constructor of |SRKNIntegrator| processes its arguments.  See
+  // |SRKNIntegrator::DynamicCoefficients| for the meaning of the members.
+  class StaticCoefficients {
+   public:
+    static constexpr VanishingCoefficients vanishing_coefficients();
+    static constexpr int stages();
+    // Meaningless if |vanishing_coefficients() == kNone|.
+    static constexpr double first();
+    static constexpr double last();
+
+    template<typename StageFunction>
+    static void ForEachStage(StageFunction& stage);
+
+   private:
+    // The number of coefficients of |Method|, and these coefficients.
+    static constexpr int size();
+    static constexpr double method_a(int const i);
+    static constexpr double method_b(int const i);
+    // Only the const overload of |std::array::operator[]| is constexpr.
+    template<std::size_t n>
+    static constexpr double Element(
+        std::array<double, n> const& coefficients,
+        int const i);
+
+    static constexpr double a(int const i);
+    static constexpr double b(int const i);
+    static constexpr double c(int const i);
+
+    template<typename StageFunction, int... i>
+    static void ForEachStage(StageFunction& stage,
+                             std::integer_sequence<int, i...>);
+
+    template<int i, typename StageFunction>
+    static void Stage(StageFunction& stage);
+  };
+};
+
+}  // namespace integrators
+}  // namespace principia
+
+#include "integrators/static_symplectic_runge_kutta_nystrom_integrator_body.hpp"
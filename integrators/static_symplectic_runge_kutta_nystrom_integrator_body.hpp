@@ -0,0 +1,160 @@
+#pragma once
+
+#include "integrators/static_symplectic_runge_kutta_nystrom_integrator.hpp"
+
+#include <array>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+namespace principia {
+namespace integrators {
+
+template<typename Method>
+StaticSRKNIntegrator<Method>::StaticSRKNIntegrator()
+    : SRKNIntegrator(Method::a(), Method::b()) {
+  CHECK_EQ(StaticCoefficients::vanishing_coefficients(),
+           vanishing_coefficients_);
+  CHECK_EQ(StaticCoefficients::stages(), stages_);
+}
+
+template<typename Method>
+template<typename Position, typename RightHandSideComputation>
+void StaticSRKNIntegrator<Method>::SolveTrivialKineticEnergyIncrement(
+    RightHandSideComputation compute_acceleration,
+    Parameters<Position, Variation<Position>> const& parameters,
+    not_null<Solution<Position, Variation<Position>>*> const solution) const {
+  PrepareSolution(parameters, solution);
+  SolveTrivialKineticEnergyIncrement<Position>(
+      std::move(compute_acceleration),
+      parameters,
+      [solution](SystemState<Position, Variation<Position>> const& state) {
+        solution->push_back(state);
+      });
+}
+
+template<typename Method>
+template<typename Position, typename RightHandSideComputation>
+void StaticSRKNIntegrator<Method>::SolveTrivialKineticEnergyIncrement(
+    RightHandSideComputation compute_acceleration,
+    Parameters<Position, Variation<Position>> const& parameters,
+    AppendState<Position, Variation<Position>> const& append_state) const {
+  IntegrationState<Position> state(parameters.initial);
+  SolveTrivialKineticEnergyIncrementOptimized<
+      StaticCoefficients::vanishing_coefficients(), Position>(
+          StaticCoefficients(),
+          compute_acceleration,
+          parameters,
+          &state,
+          append_state);
+}
+
+template<typename Method>
+constexpr SRKNIntegrator::VanishingCoefficients
+StaticSRKNIntegrator<Method>::StaticCoefficients::vanishing_coefficients() {
+  return method_b(0) == 0.0 ? kFirstBVanishes :
+         method_a(size() - 1) == 0.0 ? kLastAVanishes : kNone;
+}
+
+template<typename Method>
+constexpr int StaticSRKNIntegrator<Method>::StaticCoefficients::stages() {
+  return vanishing_coefficients() == kNone ? size() : size() - 1;
+}
+
+template<typename Method>
+constexpr double StaticSRKNIntegrator<Method>::StaticCoefficients::first() {
+  return vanishing_coefficients() == kFirstBVanishes ? method_a(0) :
+         vanishing_coefficients() == kLastAVanishes ? method_b(0) : 0.0;
+}
+
+template<typename Method>
+constexpr double StaticSRKNIntegrator<Method>::StaticCoefficients::last() {
+  return vanishing_coefficients() == kFirstBVanishes
+             ? method_a(size() - 1) :
+         vanishing_coefficients() == kLastAVanishes
+             ? method_b(size() - 1) : 0.0;
+}
+
+template<typename Method>
+template<typename StageFunction>
+void StaticSRKNIntegrator<Method>::StaticCoefficients::ForEachStage(
+    StageFunction& stage) {
+  ForEachStage(stage, std::make_integer_sequence<int, stages()>());
+}
+
+template<typename Method>
+constexpr int StaticSRKNIntegrator<Method>::StaticCoefficients::size() {
+  return static_cast<int>(Method::a().size());
+}
+
+template<typename Method>
+constexpr double StaticSRKNIntegrator<Method>::StaticCoefficients::method_a(
+    int const i) {
+  return Element(Method::a(), i);
+}
+
+template<typename Method>
+constexpr double StaticSRKNIntegrator<Method>::StaticCoefficients::method_b(
+    int const i) {
+  return Element(Method::b(), i);
+}
+
+template<typename Method>
+template<std::size_t n>
+constexpr double StaticSRKNIntegrator<Method>::StaticCoefficients::Element(
+    std::array<double, n> const& coefficients,
+    int const i) {
+  return coefficients[i];
+}
+
+// The stages of an integrator whose first b vanishes are shifted by one, and
+// the first a is added to the last one.  The last b is added to the first one
+// for an integrator whose last a vanishes.
+template<typename Method>
+constexpr double StaticSRKNIntegrator<Method>::StaticCoefficients::a(
+    int const i) {
+  return vanishing_coefficients() == kFirstBVanishes
+             ? (i == stages() - 1 ? method_a(size() - 1) + method_a(0)
+                                  : method_a(i + 1))
+             : method_a(i);
+}
+
+template<typename Method>
+constexpr double StaticSRKNIntegrator<Method>::StaticCoefficients::b(
+    int const i) {
+  return vanishing_coefficients() == kFirstBVanishes
+             ? method_b(i + 1) :
+         vanishing_coefficients() == kLastAVanishes && i == 0
+             ? method_b(0) + method_b(size() - 1)
+             : method_b(i);
+}
+
+template<typename Method>
+constexpr double StaticSRKNIntegrator<Method>::StaticCoefficients::c(
+    int const i) {
+  return i == 0 ? (vanishing_coefficients() == kFirstBVanishes ? first() : 0.0)
+                : c(i - 1) + a(i - 1);
+}
+
+template<typename Method>
+template<typename StageFunction, int... i>
+void StaticSRKNIntegrator<Method>::StaticCoefficients::ForEachStage(
+    StageFunction& stage,
+    std::integer_sequence<int, i...>) {
+  // The elements of a braced initializer list are evaluated in order.
+  int const unused[] = {(Stage<i>(stage), 0)...};
+  static_cast<void>(unused);
+}
+
+template<typename Method>
+template<int i, typename StageFunction>
+void StaticSRKNIntegrator<Method>::StaticCoefficients::Stage(
+    StageFunction& stage) {
+  constexpr double a_i = a(i);
+  constexpr double b_i = b(i);
+  constexpr double c_i = c(i);
+  stage(std::integral_constant<int, i>(), a_i, b_i, c_i);
+}
+
+}  // namespace integrators
+}  // namespace principia
@@ -0,0 +1,119 @@
+#include "integrators/static_symplectic_runge_kutta_nystrom_integrator.hpp"
+
+#include <vector>
+
+#include "base/not_null.hpp"
+#include "glog/logging.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "quantities/named_quantities.hpp"
+#include "quantities/quantities.hpp"
+#include "quantities/si.hpp"
+#include "testing_utilities/numerical_analysis.hpp"
+
+namespace principia {
+
+using base::not_null;
+using quantities::Acceleration;
+using quantities::Length;
+using quantities::Speed;
+using quantities::Time;
+using si::Metre;
+using si::Second;
+using testing_utilities::ComputeHarmonicOscillatorAcceleration;
+using ::testing::ElementsAreArray;
+using ::testing::Eq;
+
+namespace integrators {
+
+template<typename Method>
+class StaticSRKNIntegratorTest : public ::testing::Test {
+ protected:
+  StaticSRKNIntegratorTest() {
+    parameters_.initial.positions.emplace_back(1 * Metre);
+    parameters_.initial.momenta.emplace_back(0 * Metre / Second);
+    parameters_.initial.time = Time();
+    parameters_.tmax = 10 * Second;
+    parameters_.Δt = 0.03 * Second;
+  }
+
+  // Solves the harmonic oscillator with |integrator_| through the given
+  // |integrator|, and checks that the result and the times at which the
+  // accelerations are computed are the same as with the static integrator.
+  void ExpectSameAsDynamic(SRKNIntegrator const& integrator) {
+    SRKNIntegrator::Solution<Length, Speed> dynamic_solution;
+    std::vector<Time> dynamic_times;
+    integrator.SolveTrivialKineticEnergyIncrement<Length>(
+        [&dynamic_times](Time const& t,
+                         std::vector<Length> const& q,
+                         not_null<std::vector<Acceleration>*> const a) {
+          dynamic_times.push_back(t);
+          ComputeHarmonicOscillatorAcceleration(t, q, a);
+        },
+        parameters_,
+        &dynamic_solution);
+
+    SRKNIntegrator::Solution<Length, Speed> static_solution;
+    std::vector<Time> static_times;
+    integrator_.template SolveTrivialKineticEnergyIncrement<Length>(
+        [&static_times](Time const& t,
+                        std::vector<Length> const& q,
+                        not_null<std::vector<Acceleration>*> const a) {
+          static_times.push_back(t);
+          ComputeHarmonicOscillatorAcceleration(t, q, a);
+        },
+        parameters_,
+        &static_solution);
+
+    EXPECT_THAT(static_times, ElementsAreArray(dynamic_times));
+    ASSERT_THAT(static_solution.size(), Eq(dynamic_solution.size()));
+    for (std::size_t i = 0; i < static_solution.size(); ++i) {
+      auto const& static_state = static_solution[i];
+      auto const& dynamic_state = dynamic_solution[i];
+      EXPECT_THAT(static_state.time.value, Eq(dynamic_state.time.value));
+      EXPECT_THAT(static_state.time.error, Eq(dynamic_state.time.error));
+      EXPECT_THAT(static_state.positions[0].value,
+                  Eq(dynamic_state.positions[0].value)) << i;
+      EXPECT_THAT(static_state.positions[0].error,
+                  Eq(dynamic_state.positions[0].error)) << i;
+      EXPECT_THAT(static_state.momenta[0].value,
+                  Eq(dynamic_state.momenta[0].value)) << i;
+      EXPECT_THAT(static_state.momenta[0].error,
+                  Eq(dynamic_state.momenta[0].error)) << i;
+    }
+  }
+
+  StaticSRKNIntegrator<Method> const integrator_;
+  SRKNIntegrator::Parameters<Length, Speed> parameters_;
+};
+
+using Methods = ::testing::Types<methods::McLachlanAtela1992Order4Optimal,
+                                 methods::McLachlan1995SB3A4,
+                                 methods::McLachlan1995SB3A5,
+                                 methods::BlanesMoan2002SRKN6B,
+                                 methods::McLachlanAtela1992Order5Optimal,
+                                 methods::OkunborSkeel1994Order6Method13,
+                                 methods::BlanesMoan2002SRKN11B,
+                                 methods::BlanesMoan2002SRKN14A>;
+
+TYPED_TEST_CASE(StaticSRKNIntegratorTest, Methods);
+
+// The static integrator computes exactly the same thing as an
+// |SRKNIntegrator| with the same coefficients, including when the
+// first-same-as-last integrators have to synchronize at each step or only at
+// the end, and when the last step is shortened.
+TYPED_TEST(StaticSRKNIntegratorTest, SameAsDynamic) {
+  SRKNIntegrator const dynamic_integrator(TypeParam::a(), TypeParam::b());
+  for (int const sampling_period : {0, 1, 7}) {
+    for (bool const tmax_is_exact : {false, true}) {
+      this->parameters_.sampling_period = sampling_period;
+      this->parameters_.tmax_is_exact = tmax_is_exact;
+      this->ExpectSameAsDynamic(dynamic_integrator);
+      // The static integrator used as an |SRKNIntegrator|.
+      this->ExpectSameAsDynamic(this->integrator_);
+    }
+  }
+}
+
+}  // namespace integrators
+}  // namespace principia
@@ -1,5 +1,6 @@
 ﻿#pragma once
 
+#include <functional>
 #include <vector>
 
 #include "quantities/quantities.hpp"
@@ -47,6 +48,14 @@ class SymplecticIntegrator {
   template<typename Position, typename Momentum>
   using Solution = std::vector<SystemState<Position, Momentum>>;
 
+  // A functor called with each state of the solution, in increasing order of
+  // time, as soon as it has been computed.  This avoids materializing the
+  // |Solution| when the caller merely copies the states elsewhere.  The state
+  // is only valid for the duration of the call.
+  template<typename Position, typename Momentum>
+  using AppendState =
+      std::function<void(SystemState<Position, Momentum> const& state)>;
+
   template<typename Position, typename Momentum>
   struct Parameters {
     // The initial state of the system.
@@ -1,6 +1,8 @@
 ﻿
 #pragma once
 
+#include <array>
+#include <cstddef>
 #include <functional>
 #include <vector>
 
@@ -48,6 +50,9 @@ namespace integrators {
 class SRKNIntegrator : public SymplecticIntegrator {
  public:
   SRKNIntegrator(std::vector<double> const& a, std::vector<double> const& b);
+  template<std::size_t size>
+  SRKNIntegrator(std::array<double, size> const& a,
+                 std::array<double, size> const& b);
 
   virtual ~SRKNIntegrator() = default;
 
@@ -71,6 +76,18 @@ class SRKNIntegrator : public SymplecticIntegrator {
       Parameters<Position, Variation<Position>> const& parameters,
       not_null<Solution<Position, Variation<Position>>*> const solution) const;
 
+  // Same as above, but the states are passed to |append_state| as they are
+  // computed instead of being stored in a |Solution|.
+  template<typename Position>
+  void SolveTrivialKineticEnergyIncrement(
+      SRKNRightHandSideComputation<Position> compute_acceleration,
+      Parameters<Position, Variation<Position>> const& parameters,
+      AppendState<Position, Variation<Position>> const& append_state) const;
+
+  // An integration with a constant step which may be resumed, see below.
+  template<typename Position>
+  class Instance;
+
  protected:
   enum VanishingCoefficients {
     kNone,
@@ -108,14 +125,140 @@ class SRKNIntegrator : public SymplecticIntegrator {
   // |vanishing_coefficients_ == kFirstBVanishes|.
   std::vector<double> c_;
 
- private:
-  template<VanishingCoefficients vanishing_coefficients, typename Position>
-  void SolveTrivialKineticEnergyIncrementOptimized(
-      SRKNRightHandSideComputation<Position> compute_acceleration,
+  // The coefficients above, in the form expected by
+  // |SolveTrivialKineticEnergyIncrementOptimized|.
+  class DynamicCoefficients {
+   public:
+    explicit DynamicCoefficients(SRKNIntegrator const& integrator);
+
+    int stages() const;
+    // The coefficients stored in |first_same_as_last_|.
+    double first() const;
+    double last() const;
+
+    // Calls |stage(i, aᵢ, bᵢ, cᵢ)| for each stage i in increasing order.
+    template<typename StageFunction>
+    void ForEachStage(StageFunction& stage) const;
+
+   private:
+    SRKNIntegrator const& integrator_;
+  };
+
+  // The state of an integration which persists from one step to the next, and
+  // from one call to |SolveTrivialKineticEnergyIncrementOptimized| to the next
+  // if the integration is resumed.
+  template<typename Position>
+  struct IntegrationState {
+    explicit IntegrationState(
+        SystemState<Position, Variation<Position>> const& initial);
+
+    // The state at the end of the last step.  It is passed to |append_state|
+    // without being copied.  If |!q_and_v_are_synchronized|, the positions
+    // (resp. the momenta) have already been advanced by the first stage of the
+    // next step.
+    SystemState<Position, Variation<Position>> last;
+    // Whether position and velocity are synchronized between steps, relevant
+    // for first-same-as-last (FSAL) integrators.  Time is always synchronous
+    // with position.
+    bool q_and_v_are_synchronized = true;
+    // The number of steps since the beginning of the integration.
+    int sampling_phase = 0;
+
+    // The buffers used by the stages, which are not reallocated when the
+    // integration is resumed.
+    std::vector<Difference<Position>> Δqstage0;
+    std::vector<Difference<Position>> Δqstage1;
+    std::vector<Variation<Position>> Δvstage0;
+    std::vector<Variation<Position>> Δvstage1;
+    std::vector<Position> q_stage;
+    std::vector<Variation<Position>> v_stage;
+    std::vector<Variation<Variation<Position>>> a;
+  };
+
+  // Calls |SolveTrivialKineticEnergyIncrementOptimized| with the coefficients
+  // of this object.
+  template<typename Position>
+  void SolveWithDynamicCoefficients(
+      SRKNRightHandSideComputation<Position>& compute_acceleration,
       Parameters<Position, Variation<Position>> const& parameters,
-      not_null<Solution<Position, Variation<Position>>*> const solution) const;
+      not_null<IntegrationState<Position>*> const state,
+      AppendState<Position, Variation<Position>> const& append_state) const;
+
+  // Clears |solution| and reserves enough space for the states produced by an
+  // integration with the given |parameters|.
+  template<typename Position>
+  static void PrepareSolution(
+      Parameters<Position, Variation<Position>> const& parameters,
+      not_null<Solution<Position, Variation<Position>>*> const solution);
+
+  // The integration proper.  |Coefficients| must have the same members as
+  // |DynamicCoefficients|; it may hold coefficients known at compile time, in
+  // which case |ForEachStage| may pass the stage number as an
+  // |std::integral_constant|.  |RightHandSideComputation| may be any functor
+  // which can be called like an |SRKNRightHandSideComputation|.  The
+  // integration starts from |state|, |parameters.initial| is ignored.  At the
+  // end |state| is synchronized if the last state was passed to
+  // |append_state| or if |parameters.tmax_is_exact|.
+  template<VanishingCoefficients vanishing_coefficients,
+           typename Position,
+           typename Coefficients,
+           typename RightHandSideComputation>
+  static void SolveTrivialKineticEnergyIncrementOptimized(
+      Coefficients const& coefficients,
+      RightHandSideComputation& compute_acceleration,
+      Parameters<Position, Variation<Position>> const& parameters,
+      not_null<IntegrationState<Position>*> const state,
+      AppendState<Position, Variation<Position>> const& append_state);
 };
 
+// An integration which keeps its state between successive calls to |Solve|,
+// including the buffers of the stages and, for first-same-as-last methods, the
+// desynchronization of positions and momenta.  Successive calls to |Solve|
+// pass to |append_state| exactly the states that a single call with the last
+// |tmax| would pass, without synchronizing at the end of each call when it is
+// not needed.  The step is always |Δt|, so the integration may not end exactly
+// at |tmax|.  The |integrator| must outlive this object.
+template<typename Position>
+class SRKNIntegrator::Instance {
+ public:
+  // |sampling_period| has the same meaning as in |Parameters|, except that the
+  // steps are counted from |initial| rather than from the beginning of each
+  // call.  If |sampling_period == 0| the last state is passed to
+  // |append_state| at the end of each call.
+  Instance(SRKNIntegrator const& integrator,
+           SRKNRightHandSideComputation<Position> compute_acceleration,
+           SystemState<Position, Variation<Position>> const& initial,
+           Time const& Δt,
+           int const sampling_period);
+
+  // Integrates until the last step that ends at or before |tmax|.
+  void Solve(Time const& tmax,
+             AppendState<Position, Variation<Position>> const& append_state);
+
+  // The time at the end of the last step.
+  Time const& time() const;
+
+ private:
+  SRKNIntegrator const& integrator_;
+  SRKNRightHandSideComputation<Position> compute_acceleration_;
+  // |parameters_.initial| is not used.
+  Parameters<Position, Variation<Position>> parameters_;
+  IntegrationState<Position> state_;
+};
+
+// The coefficients of the methods below, as constexpr functions |a()| and
+// |b()| returning |std::array|s, for use by |StaticSRKNIntegrator|.
+namespace methods {
+struct McLachlanAtela1992Order4Optimal;
+struct McLachlan1995SB3A4;
+struct McLachlan1995SB3A5;
+struct BlanesMoan2002SRKN6B;
+struct McLachlanAtela1992Order5Optimal;
+struct OkunborSkeel1994Order6Method13;
+struct BlanesMoan2002SRKN11B;
+struct BlanesMoan2002SRKN14A;
+}  // namespace methods
+
 // Fourth order, 4 stages.  This method minimizes the error constant.
 // Coefficients from Robert I. McLachlan and Pau Atela (1992),
 // The accuracy of symplectic integrators, table 2.
@@ -3,8 +3,10 @@
 #include "integrators/symplectic_runge_kutta_nystrom_integrator.hpp"
 
 #include <algorithm>
+#include <array>
 #include <cmath>
 #include <ctime>
+#include <utility>
 #include <vector>
 
 #include "glog/logging.h"
@@ -47,164 +49,262 @@ using quantities::Quotient;
 
 namespace integrators {
 
+namespace methods {
+
+// See |integrators::McLachlanAtela1992Order4Optimal()|.
+struct McLachlanAtela1992Order4Optimal {
+  static constexpr std::array<double, 4> a() {
+    return {{ 0.5153528374311229364,
+             -0.085782019412973646,
+              0.4415830236164665242,
+              0.1288461583653841854}};
+  }
+  static constexpr std::array<double, 4> b() {
+    return {{ 0.1344961992774310892,
+             -0.2248198030794208058,
+              0.7563200005156682911,
+              0.3340036032863214255}};
+  }
+};
+
+// See |integrators::McLachlan1995SB3A4()|.
+struct McLachlan1995SB3A4 {
+  static constexpr std::array<double, 5> a() {
+    return {{ 0.18819521776883821787,
+             -0.021528551102171551201,
+              0.66666666666666666667,
+             -0.021528551102171551201,
+              0.18819521776883821787}};
+  }
+  static constexpr std::array<double, 5> b() {
+    return {{ 0.0,
+              1.0,
+             -0.5,
+             -0.5,
+              1.0}};
+  }
+};
+
+// See |integrators::McLachlan1995SB3A5()|.
+struct McLachlan1995SB3A5 {
+  static constexpr std::array<double, 6> a() {
+    return {{ 0.4051886183952522772,
+             -0.2871440408165240890,
+              0.3819554224212718118,
+              0.3819554224212718118,
+             -0.2871440408165240890,
+              0.4051886183952522772}};
+  }
+  static constexpr std::array<double, 6> b() {
+    return {{ 0.0,
+             -0.041095890410958904110,
+              0.28813559322033898305,
+              0.50592059438123984212,
+              0.28813559322033898305,
+             -0.041095890410958904110}};
+  }
+};
+
+// See |integrators::BlanesMoan2002SRKN6B()|.
+struct BlanesMoan2002SRKN6B {
+  static constexpr std::array<double, 7> a() {
+    return {{ 0.24529895718427100,
+              0.60487266571108000,
+             -0.35017162289535100,
+             -0.35017162289535100,
+              0.60487266571108000,
+              0.24529895718427100,
+              0.0}};
+  }
+  static constexpr std::array<double, 7> b() {
+    return {{ 0.082984406417405200,
+              0.39630980149836800,
+             -0.039056304922348600,
+              0.1195241940131508,
+             -0.039056304922348600,
+              0.39630980149836800,
+              0.082984406417405200}};
+  }
+};
+
+// See |integrators::McLachlanAtela1992Order5Optimal()|.
+struct McLachlanAtela1992Order5Optimal {
+  static constexpr std::array<double, 6> a() {
+    return {{ 0.339839625839110000,
+             -0.088601336903027329,
+              0.5858564768259621188,
+             -0.603039356536491888,
+              0.3235807965546976394,
+              0.4423637942197494587}};
+  }
+  static constexpr std::array<double, 6> b() {
+    return {{ 0.1193900292875672758,
+              0.6989273703824752308,
+             -0.1713123582716007754,
+              0.4012695022513534480,
+              0.0107050818482359840,
+             -0.0589796254980311632}};
+  }
+};
+
+// See |integrators::OkunborSkeel1994Order6Method13()|.
+struct OkunborSkeel1994Order6Method13 {
+  static constexpr std::array<double, 8> a() {
+    return {{-1.0130879789171747298,
+              1.1874295737325427070,
+             -0.018335852096460590340,
+              0.34399425728109261313,
+              0.34399425728109261313,
+             -0.018335852096460590340,
+              1.1874295737325427070,
+             -1.0130879789171747298}};
+  }
+  static constexpr std::array<double, 8> b() {
+    return {{ 0.0,
+              0.00016600692650009894,
+             -0.37962421426377360608,
+              0.68913741185181063674,
+              0.38064159097092574080,
+              0.68913741185181063674,
+             -0.37962421426377360608,
+              0.00016600692650009894}};
+  }
+};
+
+// See |integrators::BlanesMoan2002SRKN11B()|.
+struct BlanesMoan2002SRKN11B {
+  static constexpr std::array<double, 12> a() {
+    return {{ 0.12322977594627100,
+              0.29055379779955800,
+             -0.12704921262541700,
+             -0.24633176106207500,
+              0.35720887279592800,
+              0.2047770542914700,
+              0.35720887279592800,
+             -0.24633176106207500,
+             -0.12704921262541700,
+              0.29055379779955800,
+              0.12322977594627100,
+              0.0}};
+  }
+  static constexpr std::array<double, 12> b() {
+    return {{ 0.041464998518262400,
+              0.19812867191806700,
+             -0.040006192104153300,
+              0.075253984301580700,
+             -0.011511387420687900,
+              0.23666992478693110,
+              0.23666992478693110,
+             -0.011511387420687900,
+              0.075253984301580700,
+             -0.040006192104153300,
+              0.19812867191806700,
+              0.041464998518262400}};
+  }
+};
+
+// See |integrators::BlanesMoan2002SRKN14A()|.
+struct BlanesMoan2002SRKN14A {
+  static constexpr std::array<double, 15> a() {
+    return {{ 0.037859319840611600,
+              0.10263563310243500,
+             -0.025867888266558700,
+              0.31424140307144700,
+             -0.13014445951741500,
+              0.10641770036954300,
+             -0.0087942431285105800,
+              0.2073050690568954,
+             -0.0087942431285105800,
+              0.10641770036954300,
+             -0.13014445951741500,
+              0.31424140307144700,
+             -0.025867888266558700,
+              0.10263563310243500,
+              0.037859319840611600}};
+  }
+  static constexpr std::array<double, 15> b() {
+    return {{ 0.0,
+              0.091719152624461650,
+              0.18398317000500600,
+             -0.056534365832888270,
+              0.0049146887747128540,
+              0.14376112716835800,
+              0.32856769374680400,
+             -0.19641146648645423,
+             -0.19641146648645423,
+              0.32856769374680400,
+              0.14376112716835800,
+              0.0049146887747128540,
+             -0.056534365832888270,
+              0.18398317000500600,
+              0.091719152624461650}};
+  }
+};
+
+}  // namespace methods
+
 inline SRKNIntegrator const& McLachlanAtela1992Order4Optimal() {
-  static SRKNIntegrator const integrator({ 0.5153528374311229364,
-                                          -0.085782019412973646,
-                                           0.4415830236164665242,
-                                           0.1288461583653841854},
-                                         { 0.1344961992774310892,
-                                          -0.2248198030794208058,
-                                           0.7563200005156682911,
-                                           0.3340036032863214255});
+  static SRKNIntegrator const integrator(
+      methods::McLachlanAtela1992Order4Optimal::a(),
+      methods::McLachlanAtela1992Order4Optimal::b());
   return integrator;
 }
 
 inline SRKNIntegrator const& McLachlan1995SB3A4() {
-  static SRKNIntegrator const integrator({ 0.18819521776883821787,
-                                          -0.021528551102171551201,
-                                           0.66666666666666666667,
-                                          -0.021528551102171551201,
-                                           0.18819521776883821787},
-                                         { 0.0,
-                                           1.0,
-                                          -0.5,
-                                          -0.5,
-                                           1.0});
+  static SRKNIntegrator const integrator(
+      methods::McLachlan1995SB3A4::a(),
+      methods::McLachlan1995SB3A4::b());
   return integrator;
 }
 
 inline SRKNIntegrator const& McLachlan1995SB3A5() {
-  static SRKNIntegrator const integrator({ 0.4051886183952522772,
-                                          -0.2871440408165240890,
-                                           0.3819554224212718118,
-                                           0.3819554224212718118,
-                                          -0.2871440408165240890,
-                                           0.4051886183952522772},
-                                         { 0.0,
-                                          -0.041095890410958904110,
-                                           0.28813559322033898305,
-                                           0.50592059438123984212,
-                                           0.28813559322033898305,
-                                          -0.041095890410958904110});
+  static SRKNIntegrator const integrator(
+      methods::McLachlan1995SB3A5::a(),
+      methods::McLachlan1995SB3A5::b());
   return integrator;
 }
 
 inline SRKNIntegrator const& BlanesMoan2002SRKN6B() {
-  static SRKNIntegrator const integrator({ 0.24529895718427100,
-                                           0.60487266571108000,
-                                          -0.35017162289535100,
-                                          -0.35017162289535100,
-                                           0.60487266571108000,
-                                           0.24529895718427100,
-                                           0.0},
-                                         { 0.082984406417405200,
-                                           0.39630980149836800,
-                                          -0.039056304922348600,
-                                           0.1195241940131508,
-                                          -0.039056304922348600,
-                                           0.39630980149836800,
-                                           0.082984406417405200});
+  static SRKNIntegrator const integrator(
+      methods::BlanesMoan2002SRKN6B::a(),
+      methods::BlanesMoan2002SRKN6B::b());
   return integrator;
 }
 
 inline SRKNIntegrator const& McLachlanAtela1992Order5Optimal() {
-  static SRKNIntegrator const integrator({ 0.339839625839110000,
-                                          -0.088601336903027329,
-                                           0.5858564768259621188,
-                                          -0.603039356536491888,
-                                           0.3235807965546976394,
-                                           0.4423637942197494587},
-                                         { 0.1193900292875672758,
-                                           0.6989273703824752308,
-                                          -0.1713123582716007754,
-                                           0.4012695022513534480,
-                                           0.0107050818482359840,
-                                          -0.0589796254980311632});
+  static SRKNIntegrator const integrator(
+      methods::McLachlanAtela1992Order5Optimal::a(),
+      methods::McLachlanAtela1992Order5Optimal::b());
   return integrator;
 }
 
 inline SRKNIntegrator const& OkunborSkeel1994Order6Method13() {
-  static SRKNIntegrator const integrator({-1.0130879789171747298,
-                                           1.1874295737325427070,
-                                          -0.018335852096460590340,
-                                           0.34399425728109261313,
-                                           0.34399425728109261313,
-                                          -0.018335852096460590340,
-                                           1.1874295737325427070,
-                                          -1.0130879789171747298},
-                                         { 0.0,
-                                           0.00016600692650009894,
-                                          -0.37962421426377360608,
-                                           0.68913741185181063674,
-                                           0.38064159097092574080,
-                                           0.68913741185181063674,
-                                          -0.37962421426377360608,
-                                           0.00016600692650009894});
+  static SRKNIntegrator const integrator(
+      methods::OkunborSkeel1994Order6Method13::a(),
+      methods::OkunborSkeel1994Order6Method13::b());
   return integrator;
 }
 
 inline SRKNIntegrator const& BlanesMoan2002SRKN11B() {
-  static SRKNIntegrator const integrator({ 0.12322977594627100,
-                                           0.29055379779955800,
-                                          -0.12704921262541700,
-                                          -0.24633176106207500,
-                                           0.35720887279592800,
-                                           0.2047770542914700,
-                                           0.35720887279592800,
-                                          -0.24633176106207500,
-                                          -0.12704921262541700,
-                                           0.29055379779955800,
-                                           0.12322977594627100,
-                                           0.0},
-                                         { 0.041464998518262400,
-                                           0.19812867191806700,
-                                          -0.040006192104153300,
-                                           0.075253984301580700,
-                                          -0.011511387420687900,
-                                           0.23666992478693110,
-                                           0.23666992478693110,
-                                          -0.011511387420687900,
-                                           0.075253984301580700,
-                                          -0.040006192104153300,
-                                           0.19812867191806700,
-                                           0.041464998518262400});
+  static SRKNIntegrator const integrator(
+      methods::BlanesMoan2002SRKN11B::a(),
+      methods::BlanesMoan2002SRKN11B::b());
   return integrator;
 }
 
 inline SRKNIntegrator const& BlanesMoan2002SRKN14A() {
-  static SRKNIntegrator const integrator({ 0.037859319840611600,
-                                           0.10263563310243500,
-                                          -0.025867888266558700,
-                                           0.31424140307144700,
-                                          -0.13014445951741500,
-                                           0.10641770036954300,
-                                          -0.0087942431285105800,
-                                           0.2073050690568954,
-                                          -0.0087942431285105800,
-                                           0.10641770036954300,
-                                          -0.13014445951741500,
-                                           0.31424140307144700,
-                                          -0.025867888266558700,
-                                           0.10263563310243500,
-                                           0.037859319840611600},
-                                         { 0.0,
-                                           0.091719152624461650,
-                                           0.18398317000500600,
-                                          -0.056534365832888270,
-                                           0.0049146887747128540,
-                                           0.14376112716835800,
-                                           0.32856769374680400,
-                                          -0.19641146648645423,
-                                          -0.19641146648645423,
-                                           0.32856769374680400,
-                                           0.14376112716835800,
-                                           0.0049146887747128540,
-                                          -0.056534365832888270,
-                                           0.18398317000500600,
-                                           0.091719152624461650});
+  static SRKNIntegrator const integrator(
+      methods::BlanesMoan2002SRKN14A::a(),
+      methods::BlanesMoan2002SRKN14A::b());
   return integrator;
 }
 
+template<std::size_t size>
+SRKNIntegrator::SRKNIntegrator(std::array<double, size> const& a,
+                               std::array<double, size> const& b)
+    : SRKNIntegrator(std::vector<double>(a.begin(), a.end()),
+                     std::vector<double>(b.begin(), b.end())) {}
+
 inline SRKNIntegrator::SRKNIntegrator(std::vector<double> const& a,
                                       std::vector<double> const& b)
     : a_(a),
@@ -250,58 +350,147 @@ inline SRKNIntegrator::SRKNIntegrator(std::vector<double> const& a,
   }
 }
 
+inline SRKNIntegrator::DynamicCoefficients::DynamicCoefficients(
+    SRKNIntegrator const& integrator)
+    : integrator_(integrator) {}
+
+inline int SRKNIntegrator::DynamicCoefficients::stages() const {
+  return integrator_.stages_;
+}
+
+inline double SRKNIntegrator::DynamicCoefficients::first() const {
+  return integrator_.first_same_as_last_->first;
+}
+
+inline double SRKNIntegrator::DynamicCoefficients::last() const {
+  return integrator_.first_same_as_last_->last;
+}
+
+template<typename StageFunction>
+void SRKNIntegrator::DynamicCoefficients::ForEachStage(
+    StageFunction& stage) const {
+  for (int i = 0; i < integrator_.stages_; ++i) {
+    stage(i, integrator_.a_[i], integrator_.b_[i], integrator_.c_[i]);
+  }
+}
+
 template<typename Position>
 void SRKNIntegrator::SolveTrivialKineticEnergyIncrement(
     SRKNRightHandSideComputation<Position> compute_acceleration,
     Parameters<Position, Variation<Position>> const& parameters,
     not_null<Solution<Position, Variation<Position>>*> const solution) const {
+  PrepareSolution(parameters, solution);
+  SolveTrivialKineticEnergyIncrement<Position>(
+      std::move(compute_acceleration),
+      parameters,
+      [solution](SystemState<Position, Variation<Position>> const& state) {
+        solution->push_back(state);
+      });
+}
+
+template<typename Position>
+void SRKNIntegrator::SolveTrivialKineticEnergyIncrement(
+    SRKNRightHandSideComputation<Position> compute_acceleration,
+    Parameters<Position, Variation<Position>> const& parameters,
+    AppendState<Position, Variation<Position>> const& append_state) const {
+  IntegrationState<Position> state(parameters.initial);
+  SolveWithDynamicCoefficients<Position>(compute_acceleration,
+                                         parameters,
+                                         &state,
+                                         append_state);
+}
+
+template<typename Position>
+SRKNIntegrator::Instance<Position>::Instance(
+    SRKNIntegrator const& integrator,
+    SRKNRightHandSideComputation<Position> compute_acceleration,
+    SystemState<Position, Variation<Position>> const& initial,
+    Time const& Δt,
+    int const sampling_period)
+    : integrator_(integrator),
+      compute_acceleration_(std::move(compute_acceleration)),
+      state_(initial) {
+  CHECK_LT(Time(), Δt);
+  CHECK_LE(0, sampling_period);
+  parameters_.Δt = Δt;
+  parameters_.sampling_period = sampling_period;
+  parameters_.tmax_is_exact = false;
+}
+
+template<typename Position>
+void SRKNIntegrator::Instance<Position>::Solve(
+    Time const& tmax,
+    AppendState<Position, Variation<Position>> const& append_state) {
+  parameters_.tmax = tmax;
+  integrator_.SolveWithDynamicCoefficients<Position>(compute_acceleration_,
+                                                     parameters_,
+                                                     &state_,
+                                                     append_state);
+}
+
+template<typename Position>
+Time const& SRKNIntegrator::Instance<Position>::time() const {
+  return state_.last.time.value;
+}
+
+template<typename Position>
+SRKNIntegrator::IntegrationState<Position>::IntegrationState(
+    SystemState<Position, Variation<Position>> const& initial)
+    : last(initial),
+      Δqstage0(initial.positions.size()),
+      Δqstage1(initial.positions.size()),
+      Δvstage0(initial.positions.size()),
+      Δvstage1(initial.positions.size()),
+      q_stage(initial.positions.size()),
+      v_stage(initial.positions.size()),
+      a(initial.positions.size()) {
+  CHECK_EQ(initial.positions.size(), initial.momenta.size());
+}
+
+template<typename Position>
+void SRKNIntegrator::SolveWithDynamicCoefficients(
+    SRKNRightHandSideComputation<Position>& compute_acceleration,
+    Parameters<Position, Variation<Position>> const& parameters,
+    not_null<IntegrationState<Position>*> const state,
+    AppendState<Position, Variation<Position>> const& append_state) const {
+  DynamicCoefficients const coefficients(*this);
   // NOTE(egg): we need to explicitly give the second template argument here
   // because MSVC doesn't want to deduce it.  Clang-cl deduces it without any
   // issues.
   switch (vanishing_coefficients_) {
     case kNone:
       SolveTrivialKineticEnergyIncrementOptimized<kNone, Position>(
+          coefficients,
           compute_acceleration,
           parameters,
-          solution);
+          state,
+          append_state);
       break;
     case kFirstBVanishes:
       SolveTrivialKineticEnergyIncrementOptimized<kFirstBVanishes, Position>(
+          coefficients,
           compute_acceleration,
           parameters,
-          solution);
+          state,
+          append_state);
       break;
     case kLastAVanishes:
       SolveTrivialKineticEnergyIncrementOptimized<kLastAVanishes, Position>(
+          coefficients,
           compute_acceleration,
           parameters,
-          solution);
+          state,
+          append_state);
       break;
     default:
       LOG(FATAL) << "Invalid vanishing coefficients";
   }
 }
 
-template<SRKNIntegrator::VanishingCoefficients vanishing_coefficients,
-         typename Position>
-void SRKNIntegrator::SolveTrivialKineticEnergyIncrementOptimized(
-    SRKNRightHandSideComputation<Position> compute_acceleration,
+template<typename Position>
+void SRKNIntegrator::PrepareSolution(
     Parameters<Position, Variation<Position>> const& parameters,
-    not_null<Solution<Position, Variation<Position>>*> const solution) const {
-  using Velocity = Variation<Position>;
-  using Displacement = Difference<Position>;
-  int const dimension = parameters.initial.positions.size();
-
-  std::vector<Displacement> Δqstage0(dimension);
-  std::vector<Displacement> Δqstage1(dimension);
-  std::vector<Velocity> Δvstage0(dimension);
-  std::vector<Velocity> Δvstage1(dimension);
-  std::vector<Displacement>* Δqstage_current = &Δqstage1;
-  std::vector<Displacement>* Δqstage_previous = &Δqstage0;
-  std::vector<Velocity>* Δvstage_current = &Δvstage1;
-  std::vector<Velocity>* Δvstage_previous = &Δvstage0;
-
-  // Dimension the result.
+    not_null<Solution<Position, Variation<Position>>*> const solution) {
   int const capacity = parameters.sampling_period == 0 ?
     1 :
     static_cast<int>(
@@ -310,14 +499,37 @@ void SRKNIntegrator::SolveTrivialKineticEnergyIncrementOptimized(
                 parameters.sampling_period)) + 1;
   solution->clear();
   solution->reserve(capacity);
+}
+
+template<SRKNIntegrator::VanishingCoefficients vanishing_coefficients,
+         typename Position,
+         typename Coefficients,
+         typename RightHandSideComputation>
+void SRKNIntegrator::SolveTrivialKineticEnergyIncrementOptimized(
+    Coefficients const& coefficients,
+    RightHandSideComputation& compute_acceleration,
+    Parameters<Position, Variation<Position>> const& parameters,
+    not_null<IntegrationState<Position>*> const state,
+    AppendState<Position, Variation<Position>> const& append_state) {
+  using Velocity = Variation<Position>;
+  using Displacement = Difference<Position>;
+  SystemState<Position, Velocity>& last = state->last;
+  int const dimension = last.positions.size();
+
+  // The contents of these buffers do not carry over from one step to the next.
+  std::vector<Displacement>* Δqstage_current = &state->Δqstage1;
+  std::vector<Displacement>* Δqstage_previous = &state->Δqstage0;
+  std::vector<Velocity>* Δvstage_current = &state->Δvstage1;
+  std::vector<Velocity>* Δvstage_previous = &state->Δvstage0;
 
-  std::vector<DoublePrecision<Position>> q_last(parameters.initial.positions);
-  std::vector<DoublePrecision<Velocity>> v_last(parameters.initial.momenta);
-  int sampling_phase = 0;
+  std::vector<DoublePrecision<Position>>& q_last = last.positions;
+  std::vector<DoublePrecision<Velocity>>& v_last = last.momenta;
+  int& sampling_phase = state->sampling_phase;
 
-  std::vector<Position> q_stage(dimension);
-  std::vector<Velocity> v_stage(dimension);
-  std::vector<Quotient<Velocity, Time>> a(dimension);  // Current accelerations.
+  std::vector<Position>& q_stage = state->q_stage;
+  std::vector<Velocity>& v_stage = state->v_stage;
+  // Current accelerations.
+  std::vector<Quotient<Velocity, Time>>& a = state->a;
 
   // The following quantity is generally equal to |Δt|, but during the last
   // iteration, if |tmax_is_exact|, it may differ significantly from |Δt|.
@@ -326,12 +538,9 @@ void SRKNIntegrator::SolveTrivialKineticEnergyIncrementOptimized(
   // During one iteration of the outer loop below we process the time interval
   // [|tn|, |tn| + |h|[.  |tn| is computed using compensated summation to make
   // sure that we don't have drifts.
-  DoublePrecision<Time> tn = parameters.initial.time;
+  DoublePrecision<Time>& tn = last.time;
 
-  // Whether position and velocity are synchronized between steps, relevant for
-  // first-same-as-last (FSAL) integrators. Time is always synchronous with
-  // position.
-  bool q_and_v_are_synchronized = true;
+  bool& q_and_v_are_synchronized = state->q_and_v_are_synchronized;
   bool should_synchronize = false;
 
   // Integration.  For details see Wolfram Reference,
@@ -369,9 +578,14 @@ void SRKNIntegrator::SolveTrivialKineticEnergyIncrementOptimized(
     }
 
     if (vanishing_coefficients != kNone) {
-      should_synchronize = at_end ||
-                           (parameters.sampling_period != 0 &&
-                            sampling_phase % parameters.sampling_period == 0);
+      // There is no need to synchronize at the end if the last state is not
+      // passed to |append_state|, and if the integration may be resumed with
+      // the same step.
+      should_synchronize =
+          (at_end && (parameters.tmax_is_exact ||
+                      parameters.sampling_period == 0)) ||
+          (parameters.sampling_period != 0 &&
+           sampling_phase % parameters.sampling_period == 0);
     }
 
     if (vanishing_coefficients == kFirstBVanishes &&
@@ -381,10 +595,14 @@ void SRKNIntegrator::SolveTrivialKineticEnergyIncrementOptimized(
       for (int k = 0; k < dimension; ++k) {
         v_stage[k] = v_last[k].value;
       }
-      ADVANCE_ΔQSTAGE(first_same_as_last_->first * h);
+      ADVANCE_ΔQSTAGE(coefficients.first() * h);
       q_and_v_are_synchronized = false;
     }
-    for (int i = 0; i < stages_; ++i) {
+    // |i| is either an |int| or an |std::integral_constant|.
+    auto stage = [&](auto const i,
+                     double const a_i,
+                     double const b_i,
+                     double const c_i) {
       std::swap(Δqstage_current, Δqstage_previous);
       std::swap(Δvstage_current, Δvstage_previous);
 
@@ -395,25 +613,26 @@ void SRKNIntegrator::SolveTrivialKineticEnergyIncrementOptimized(
       // bit more precise.
       if (vanishing_coefficients == kLastAVanishes &&
           q_and_v_are_synchronized && i == 0) {
-        ADVANCE_ΔVSTAGE(first_same_as_last_->first * h,
+        ADVANCE_ΔVSTAGE(coefficients.first() * h,
                         tn.value);
         q_and_v_are_synchronized = false;
       } else {
-        ADVANCE_ΔVSTAGE(b_[i] * h, tn.value + (tn.error + c_[i] * h));
+        ADVANCE_ΔVSTAGE(b_i * h, tn.value + (tn.error + c_i * h));
       }
 
       if (vanishing_coefficients == kFirstBVanishes &&
-          should_synchronize && i == stages_ - 1) {
-        ADVANCE_ΔQSTAGE(first_same_as_last_->last * h);
+          should_synchronize && i == coefficients.stages() - 1) {
+        ADVANCE_ΔQSTAGE(coefficients.last() * h);
         q_and_v_are_synchronized = true;
       } else {
-        ADVANCE_ΔQSTAGE(a_[i] * h);
+        ADVANCE_ΔQSTAGE(a_i * h);
       }
-    }
+    };
+    coefficients.ForEachStage(stage);
     if (vanishing_coefficients == kLastAVanishes && should_synchronize) {
       std::swap(Δvstage_current, Δvstage_previous);
       // TODO(egg): the second parameter below is really just tn.value + h.
-      ADVANCE_ΔVSTAGE(first_same_as_last_->last * h,
+      ADVANCE_ΔVSTAGE(coefficients.last() * h,
                       tn.value + h);
       q_and_v_are_synchronized = true;
     }
@@ -426,33 +645,22 @@ void SRKNIntegrator::SolveTrivialKineticEnergyIncrementOptimized(
       v_stage[k] = v_last[k].value;
     }
     tn.Increment(h);
+    if (at_end && parameters.tmax_is_exact) {
+      // The compensated summation may leave |tn| a few ulps away from |tmax|,
+      // but the last state must be exactly at |tmax|.
+      tn = parameters.tmax;
+    }
 
     if (parameters.sampling_period != 0) {
       if (sampling_phase % parameters.sampling_period == 0) {
-        solution->emplace_back();
-        SystemState<Position, Velocity>* state = &solution->back();
-        state->time = tn;
-        state->positions.reserve(dimension);
-        state->momenta.reserve(dimension);
-        for (int k = 0; k < dimension; ++k) {
-          state->positions.emplace_back(q_last[k]);
-          state->momenta.emplace_back(v_last[k]);
-        }
+        append_state(last);
       }
       ++sampling_phase;
     }
   }
 
   if (parameters.sampling_period == 0) {
-    solution->emplace_back();
-    SystemState<Position, Velocity>* state = &solution->back();
-    state->time = tn;
-    state->positions.reserve(dimension);
-    state->momenta.reserve(dimension);
-    for (int k = 0; k < dimension; ++k) {
-      state->positions.emplace_back(q_last[k]);
-      state->momenta.emplace_back(v_last[k]);
-    }
+    append_state(last);
   }
 }
 
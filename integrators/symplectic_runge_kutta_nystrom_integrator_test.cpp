@@ -211,5 +211,86 @@ TEST_P(SRKNTest, ExactInexactTMax) {
   EXPECT_THAT(solution_.back().time.error, Eq(0.0 * SIUnit<Time>()));
 }
 
+// Check that the states passed to an |AppendState| functor are those that
+// would be stored in a |Solution|.
+TEST_P(SRKNTest, AppendState) {
+  parameters_.initial.positions.emplace_back(SIUnit<Length>());
+  parameters_.initial.momenta.emplace_back(Speed());
+  parameters_.initial.time = Time();
+  parameters_.tmax = 10.0 * SIUnit<Time>();
+  parameters_.Δt = (1.0 / 3.000001) * SIUnit<Time>();
+  for (int const sampling_period : {0, 1, 7}) {
+    for (bool const tmax_is_exact : {false, true}) {
+      parameters_.sampling_period = sampling_period;
+      parameters_.tmax_is_exact = tmax_is_exact;
+      integrator_->SolveTrivialKineticEnergyIncrement<Length>(
+          &ComputeHarmonicOscillatorAcceleration,
+          parameters_,
+          &solution_);
+      std::size_t appended = 0;
+      integrator_->SolveTrivialKineticEnergyIncrement<Length>(
+          &ComputeHarmonicOscillatorAcceleration,
+          parameters_,
+          [this, &appended](
+              SRKNIntegrator::SystemState<Length, Speed> const& state) {
+            ASSERT_LT(appended, solution_.size());
+            auto const& expected = solution_[appended];
+            EXPECT_EQ(expected.time.value, state.time.value);
+            EXPECT_EQ(expected.time.error, state.time.error);
+            EXPECT_EQ(expected.positions[0].value, state.positions[0].value);
+            EXPECT_EQ(expected.positions[0].error, state.positions[0].error);
+            EXPECT_EQ(expected.momenta[0].value, state.momenta[0].value);
+            EXPECT_EQ(expected.momenta[0].error, state.momenta[0].error);
+            ++appended;
+          });
+      EXPECT_EQ(solution_.size(), appended);
+    }
+  }
+}
+
+// Check that an integration resumed several times produces the same states as
+// a single integration.
+TEST_P(SRKNTest, Instance) {
+  parameters_.initial.positions.emplace_back(SIUnit<Length>());
+  parameters_.initial.momenta.emplace_back(Speed());
+  parameters_.initial.time = Time();
+  parameters_.tmax = 10.0 * SIUnit<Time>();
+  parameters_.Δt = (1.0 / 3.000001) * SIUnit<Time>();
+  parameters_.tmax_is_exact = false;
+  for (int const sampling_period : {1, 3}) {
+    parameters_.sampling_period = sampling_period;
+    integrator_->SolveTrivialKineticEnergyIncrement<Length>(
+        &ComputeHarmonicOscillatorAcceleration,
+        parameters_,
+        &solution_);
+
+    SRKNIntegrator::Solution<Length, Speed> resumed_solution;
+    SRKNIntegrator::Instance<Length> instance(
+        *integrator_,
+        &ComputeHarmonicOscillatorAcceleration,
+        parameters_.initial,
+        parameters_.Δt,
+        sampling_period);
+    for (double const tmax : {1.7, 3.0, 3.0, 6.5, 10.0}) {
+      instance.Solve(
+          tmax * SIUnit<Time>(),
+          [&resumed_solution](
+              SRKNIntegrator::SystemState<Length, Speed> const& state) {
+            resumed_solution.push_back(state);
+          });
+      EXPECT_THAT(instance.time(), Lt(tmax * SIUnit<Time>()));
+    }
+
+    ASSERT_EQ(solution_.size(), resumed_solution.size());
+    for (std::size_t i = 0; i < solution_.size(); ++i) {
+      EXPECT_EQ(solution_[i].time.value, resumed_solution[i].time.value);
+      EXPECT_EQ(solution_[i].positions[0].value,
+                resumed_solution[i].positions[0].value);
+      EXPECT_EQ(solution_[i].momenta[0].value,
+                resumed_solution[i].momenta[0].value);
+    }
+  }
+}
+
 }  // namespace integrators
 }  // namespace principia
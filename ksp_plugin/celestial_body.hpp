@@ -100,6 +100,18 @@ inline void Celestial::WriteToMessage(
       message->mutable_history_and_prolongation()->mutable_prolongation());
 }
 
+inline void Celestial::WriteDeltaToMessage(
+    Instant const& since,
+    not_null<serialization::Celestial*> const message) const {
+  CHECK(is_initialized());
+  body_->WriteToMessage(message->mutable_body());
+  history_->WriteTailToMessage(
+      since,
+      message->mutable_history_and_prolongation()->mutable_history());
+  prolongation_->WritePointerToMessage(
+      message->mutable_history_and_prolongation()->mutable_prolongation());
+}
+
 inline std::unique_ptr<Celestial> Celestial::ReadFromMessage(
     serialization::Celestial const& message) {
   auto celestial =
@@ -1,5 +1,8 @@
 #include "ksp_plugin/interface.hpp"
 
+#include <algorithm>
+#include <cstring>
+#include <functional>
 #include <string>
 #include <utility>
 #include <vector>
@@ -42,6 +45,9 @@ namespace {
 
 int const kChunkSize = 64 << 10;
 int const kNumberOfChunks = 8;
+// The fastest level is the best compromise: the higher levels don't compress
+// the histories much better, and they are several times slower.
+int const kCompressionLevel = 1;
 
 // Takes ownership of |**pointer| and returns it to the caller.  Nulls
 // |*pointer|.  |pointer| must not be null.  No transfer of ownership of
@@ -77,6 +83,106 @@ WXYZ ToWXYZ(Quaternion const& quaternion) {
           quaternion.imaginary_part().z};
 }
 
+// Pulls the next chunk of the serialization of |plugin| from |*serializer|,
+// creating and starting the serializer if |*serializer| is null.  The
+// serialization is that of |plugin->WriteToMessage| if |since| is null, and of
+// |plugin->WriteDeltaToMessage(*since, ...)| otherwise.  At the end of the
+// serialization, deletes and nulls |*serializer| and returns an empty object.
+// Otherwise the result is owned by |*serializer| and stays valid until the next
+// call.
+Bytes PullPluginChunk(Plugin const* const plugin,
+                      Instant const* const since,
+                      PullSerializer** const serializer) {
+  CHECK_NOTNULL(plugin);
+  CHECK_NOTNULL(serializer);
+
+  // Create and start a serializer if the caller didn't provide one.
+  if (*serializer == nullptr) {
+    *serializer =
+        new PullSerializer(kChunkSize, kNumberOfChunks, kCompressionLevel);
+    if (since == nullptr) {
+      auto message = make_not_null_unique<serialization::Plugin>();
+      plugin->WriteToMessage(message.get());
+      (*serializer)->Start(std::move(message));
+    } else {
+      auto message = make_not_null_unique<serialization::PluginDelta>();
+      plugin->WriteDeltaToMessage(*since, message.get());
+      (*serializer)->Start(std::move(message));
+    }
+  }
+
+  // Pull a chunk.
+  Bytes const bytes = (*serializer)->Pull();
+
+  // If this is the end of the serialization, delete the serializer.
+  if (bytes.size == 0) {
+    TakeOwnership(serializer);
+  }
+  return bytes;
+}
+
+// Pushes |bytes| to |*deserializer|, creating the deserializer if
+// |*deserializer| is null and starting it on a new |Message|, which is passed
+// to |done| at the end of the deserialization.  |done| may take the contents
+// of the message.  Takes ownership of |bytes.data|, which must have been
+// allocated with |new[]|.  If |bytes| is empty, waits for the end of the
+// deserialization and deletes the deserializer.
+template<typename Message>
+void PushPluginChunk(
+    Bytes const bytes,
+    PushDeserializer** const deserializer,
+    std::function<void(not_null<Message*> const)> const& done) {
+  CHECK_NOTNULL(deserializer);
+
+  // Create and start a deserializer if the caller didn't provide one.
+  if (*deserializer == nullptr) {
+    *deserializer = new PushDeserializer(kChunkSize, kNumberOfChunks);
+    auto message = make_not_null_unique<Message>();
+    not_null<Message*> const unowned_message = message.get();
+    (*deserializer)->Start(
+        std::move(message),
+        [done, unowned_message](google::protobuf::Message const&) {
+          done(unowned_message);
+        });
+  }
+
+  // Push the data, taking ownership of it.
+  std::uint8_t const* const data = bytes.data;
+  (*deserializer)->Push(bytes, [data]() { delete[] data; });
+
+  // If the data was empty, delete the deserializer.  This ensures that |done|
+  // has been called.
+  if (bytes.size == 0) {
+    TakeOwnership(deserializer);
+  }
+}
+
+// Returns a null-terminated hexadecimal representation of |bytes| owned by the
+// caller, or null if |bytes| is empty.
+char const* ToHexadecimal(Bytes const bytes) {
+  if (bytes.size == 0) {
+    return nullptr;
+  }
+  std::int64_t const hexadecimal_size = (bytes.size << 1) + 1;
+  UniqueBytes hexadecimal(hexadecimal_size);
+  HexadecimalEncode(bytes, hexadecimal.get());
+  hexadecimal.data.get()[hexadecimal_size - 1] = '\0';
+  return reinterpret_cast<char const*>(hexadecimal.data.release());
+}
+
+// Decodes the |hexadecimal_size| characters of |hexadecimal|.  The data of the
+// result is allocated with |new[]| and owned by the caller.
+Bytes FromHexadecimal(char const* const hexadecimal,
+                      int const hexadecimal_size) {
+  CHECK_NOTNULL(hexadecimal);
+  int const byte_size = hexadecimal_size >> 1;
+  std::uint8_t* bytes = new std::uint8_t[byte_size];
+  HexadecimalDecode(
+      {reinterpret_cast<std::uint8_t const*>(hexadecimal), hexadecimal_size},
+      {bytes, byte_size});
+  return Bytes(bytes, byte_size);
+}
+
 }  // namespace
 
 void principia__InitGoogleLogging() {
@@ -251,6 +357,13 @@ void principia__ForgetAllHistoriesBefore(Plugin* const plugin,
   CHECK_NOTNULL(plugin)->ForgetAllHistoriesBefore(Instant(t * Second));
 }
 
+void principia__ArchiveAllHistoriesBefore(Plugin* const plugin,
+                                          double const t,
+                                          char const* directory) {
+  CHECK_NOTNULL(plugin)->ArchiveAllHistoriesBefore(Instant(t * Second),
+                                                   directory);
+}
+
 QP principia__VesselFromParent(Plugin const* const plugin,
                                char const* vessel_guid) {
   RelativeDegreesOfFreedom<AliceSun> const result =
@@ -319,6 +432,23 @@ LineAndIterator* principia__RenderedPrediction(
   return result.release();
 }
 
+LineAndIterator* principia__RenderedBatchedPrediction(
+    Plugin* const plugin,
+    char const* vessel_guid,
+    RenderingTransforms* const transforms,
+    XYZ const sun_world_position) {
+  RenderedTrajectory<World> rendered_trajectory =
+      CHECK_NOTNULL(plugin)->RenderedBatchedPrediction(
+          vessel_guid,
+          transforms,
+          World::origin + Displacement<World>(
+                              ToR3Element(sun_world_position) * Metre));
+  not_null<std::unique_ptr<LineAndIterator>> result =
+      make_not_null_unique<LineAndIterator>(std::move(rendered_trajectory));
+  result->it = result->rendered_trajectory.begin();
+  return result.release();
+}
+
 void principia__set_predicted_vessel(Plugin* const plugin,
                                      char const* vessel_guid) {
   CHECK_NOTNULL(plugin)->set_predicted_vessel(vessel_guid);
@@ -338,6 +468,58 @@ void principia__set_prediction_step(Plugin* const plugin,
   CHECK_NOTNULL(plugin)->set_prediction_step(t * Second);
 }
 
+void principia__set_rendering_tolerance(Plugin* const plugin,
+                                        double const tolerance) {
+  CHECK_NOTNULL(plugin)->set_rendering_tolerance(tolerance * Metre);
+}
+
+void principia__set_prediction_tolerances(Plugin* const plugin,
+                                          double const length_tolerance,
+                                          double const speed_tolerance) {
+  CHECK_NOTNULL(plugin)->set_prediction_tolerances(
+      length_tolerance * Metre,
+      speed_tolerance * (Metre / Second));
+}
+
+void principia__set_incremental_prediction_tolerances(
+    Plugin* const plugin,
+    double const length_tolerance,
+    double const speed_tolerance) {
+  CHECK_NOTNULL(plugin)->set_incremental_prediction_tolerances(
+      length_tolerance * Metre,
+      speed_tolerance * (Metre / Second));
+}
+
+void principia__set_asynchronous_predictions(Plugin* const plugin,
+                                             bool const asynchronous) {
+  CHECK_NOTNULL(plugin)->set_asynchronous_predictions(asynchronous);
+}
+
+int principia__PredictionStaleness(Plugin const* const plugin) {
+  CHECK_NOTNULL(plugin);
+  return static_cast<int>(plugin->requested_prediction_generation() -
+                          plugin->rendered_prediction_generation());
+}
+
+void principia__AddVesselToBatchedPredictions(Plugin* const plugin,
+                                              char const* vessel_guid,
+                                              double const length,
+                                              double const step) {
+  CHECK_NOTNULL(plugin)->AddVesselToBatchedPredictions(vessel_guid,
+                                                       length * Second,
+                                                       step * Second);
+}
+
+void principia__RemoveVesselFromBatchedPredictions(Plugin* const plugin,
+                                                   char const* vessel_guid) {
+  CHECK_NOTNULL(plugin)->RemoveVesselFromBatchedPredictions(vessel_guid);
+}
+
+void principia__set_number_of_threads(Plugin* const plugin,
+                                      int const number_of_threads) {
+  CHECK_NOTNULL(plugin)->set_number_of_threads(number_of_threads);
+}
+
 bool principia__has_vessel(Plugin* const plugin,
                            char const* vessel_guid) {
   return CHECK_NOTNULL(plugin)->has_vessel(vessel_guid);
@@ -362,6 +544,38 @@ bool principia__AtEnd(LineAndIterator* const line_and_iterator) {
   return line_and_iterator->it == line_and_iterator->rendered_trajectory.end();
 }
 
+int principia__NumberOfVertices(
+    LineAndIterator const* const line_and_iterator) {
+  RenderedTrajectory<World> const& rendered_trajectory =
+      CHECK_NOTNULL(line_and_iterator)->rendered_trajectory;
+  return rendered_trajectory.empty() ? 0 : rendered_trajectory.size() + 1;
+}
+
+int principia__FetchVertices(LineAndIterator const* const line_and_iterator,
+                             XYZ* const vertices,
+                             int const capacity) {
+  RenderedTrajectory<World> const& rendered_trajectory =
+      CHECK_NOTNULL(line_and_iterator)->rendered_trajectory;
+  CHECK_NOTNULL(vertices);
+  CHECK_LE(0, capacity);
+  int const number_of_vertices = principia__NumberOfVertices(line_and_iterator);
+  int const count = std::min(number_of_vertices, capacity);
+  int const first_vertex = number_of_vertices - count;
+  for (int i = first_vertex; i < number_of_vertices; ++i) {
+    // The vertex |i| is the end of the segment |i - 1| and the beginning of
+    // the segment |i|, if they exist.
+    if (i > 0 && i < number_of_vertices - 1) {
+      CHECK(rendered_trajectory[i - 1].end == rendered_trajectory[i].begin)
+          << "Discontinuous trajectory at vertex " << i;
+    }
+    Position<World> const& vertex = i == 0 ? rendered_trajectory[i].begin
+                                           : rendered_trajectory[i - 1].end;
+    vertices[i - first_vertex] =
+        ToXYZ((vertex - World::origin).coordinates() / Metre);
+  }
+  return count;
+}
+
 void principia__DeleteLineAndIterator(
     LineAndIterator** const line_and_iterator) {
   TakeOwnership(line_and_iterator);
@@ -445,34 +659,17 @@ double principia__current_time(Plugin const* const plugin) {
 char const* principia__SerializePlugin(Plugin const* const plugin,
                                        PullSerializer** const serializer) {
   LOG(INFO) << __FUNCTION__;
-  CHECK_NOTNULL(plugin);
-  CHECK_NOTNULL(serializer);
-
-  // Create and start a serializer if the caller didn't provide one.
-  if (*serializer == nullptr) {
-    *serializer = new PullSerializer(kChunkSize, kNumberOfChunks);
-    auto message = make_not_null_unique<serialization::Plugin>();
-    plugin->WriteToMessage(message.get());
-    (*serializer)->Start(std::move(message));
-  }
-
-  // Pull a chunk.
-  Bytes bytes;
-  bytes = (*serializer)->Pull();
-
-  // If this is the end of the serialization, delete the serializer and return a
-  // nullptr.
-  if (bytes.size == 0) {
-    TakeOwnership(serializer);
-    return nullptr;
-  }
+  return ToHexadecimal(
+      PullPluginChunk(plugin, /*since=*/nullptr, serializer));
+}
 
-  // Convert to hexadecimal and return to the client.
-  std::int64_t const hexadecimal_size = (bytes.size << 1) + 1;
-  UniqueBytes hexadecimal(hexadecimal_size);
-  HexadecimalEncode(bytes, hexadecimal.get());
-  hexadecimal.data.get()[hexadecimal_size - 1] = '\0';
-  return reinterpret_cast<char const*>(hexadecimal.data.release());
+char const* principia__SerializePluginDelta(
+    Plugin const* const plugin,
+    double const since,
+    PullSerializer** const serializer) {
+  LOG(INFO) << __FUNCTION__;
+  Instant const since_instant(since * Second);
+  return ToHexadecimal(PullPluginChunk(plugin, &since_instant, serializer));
 }
 
 void principia__DeletePluginSerialization(char const** const serialization) {
@@ -480,46 +677,92 @@ void principia__DeletePluginSerialization(char const** const serialization) {
   TakeOwnershipArray(reinterpret_cast<uint8_t const**>(serialization));
 }
 
+std::uint8_t const* principia__SerializePluginBytes(
+    Plugin const* const plugin,
+    PullSerializer** const serializer,
+    int* const size) {
+  LOG(INFO) << __FUNCTION__;
+  CHECK_NOTNULL(size);
+  Bytes const bytes = PullPluginChunk(plugin, /*since=*/nullptr, serializer);
+  *size = static_cast<int>(bytes.size);
+  return bytes.size == 0 ? nullptr : bytes.data;
+}
+
 void principia__DeserializePlugin(char const* const serialization,
                                   int const serialization_size,
                                   PushDeserializer** const deserializer,
                                   Plugin const** const plugin) {
   LOG(INFO) << __FUNCTION__;
-  CHECK_NOTNULL(serialization);
-  CHECK_NOTNULL(deserializer);
   CHECK_NOTNULL(plugin);
+  PushPluginChunk<serialization::Plugin>(
+      FromHexadecimal(serialization, serialization_size),
+      deserializer,
+      [plugin](not_null<serialization::Plugin*> const message) {
+        *plugin = Plugin::ReadFromMessage(*message).release();
+      });
+}
+
+void principia__DeserializePluginBytes(std::uint8_t const* const serialization,
+                                       int const serialization_size,
+                                       PushDeserializer** const deserializer,
+                                       Plugin const** const plugin) {
+  LOG(INFO) << __FUNCTION__;
+  CHECK_NOTNULL(serialization);
+  CHECK_LE(0, serialization_size);
 
-  // Create and start a deserializer if the caller didn't provide one.
-  if (*deserializer == nullptr) {
-    *deserializer = new PushDeserializer(kChunkSize, kNumberOfChunks);
-    auto message = make_not_null_unique<serialization::Plugin>();
-    (*deserializer)->Start(
-        std::move(message),
-        [plugin](google::protobuf::Message const& message) {
-          *plugin = Plugin::ReadFromMessage(
-              static_cast<serialization::Plugin const&>(message)).release();
-        });
-  }
-
-  // Decode the hexadecimal representation.
-  uint8_t const* const hexadecimal =
-      reinterpret_cast<uint8_t const*>(serialization);
-  int const hexadecimal_size = serialization_size;
-  int const byte_size = hexadecimal_size >> 1;
-  // Ownership of the following pointer is transfered to the deserializer using
-  // the callback to |Push|.
-  std::uint8_t* bytes = new uint8_t[byte_size];
-  HexadecimalDecode({hexadecimal, hexadecimal_size}, {bytes, byte_size});
+  // The deserializer consumes the data after this function has returned, so
+  // it needs its own copy.  Ownership of the following pointer is transfered
+  // to the deserializer using the callback to |Push|.
+  std::uint8_t* bytes = new uint8_t[serialization_size];
+  std::memcpy(bytes, serialization, serialization_size);
 
-  // Push the data, taking ownership of it.
-  (*deserializer)->Push(Bytes(&bytes[0], byte_size),
-                        [bytes]() { delete bytes; });
+  CHECK_NOTNULL(plugin);
+  PushPluginChunk<serialization::Plugin>(
+      Bytes(bytes, serialization_size),
+      deserializer,
+      [plugin](not_null<serialization::Plugin*> const message) {
+        *plugin = Plugin::ReadFromMessage(*message).release();
+      });
+}
+
+void principia__DeserializePluginMessage(
+    char const* const serialization,
+    int const serialization_size,
+    PushDeserializer** const deserializer,
+    serialization::Plugin** const message) {
+  LOG(INFO) << __FUNCTION__;
+  CHECK_NOTNULL(message);
+  PushPluginChunk<serialization::Plugin>(
+      FromHexadecimal(serialization, serialization_size),
+      deserializer,
+      [message](not_null<serialization::Plugin*> const deserialized) {
+        *message = new serialization::Plugin;
+        (*message)->Swap(deserialized);
+      });
+}
+
+void principia__MergePluginDeltaIntoMessage(
+    char const* const serialization,
+    int const serialization_size,
+    PushDeserializer** const deserializer,
+    serialization::Plugin* const message) {
+  LOG(INFO) << __FUNCTION__;
+  CHECK_NOTNULL(message);
+  PushPluginChunk<serialization::PluginDelta>(
+      FromHexadecimal(serialization, serialization_size),
+      deserializer,
+      [message](not_null<serialization::PluginDelta*> const delta) {
+        Plugin::MergeDeltaIntoMessage(*delta, message);
+      });
+}
 
-  // If the data was empty, delete the deserializer.  This ensures that
-  // |*plugin| is filled.
-  if (byte_size == 0) {
-    delete *deserializer;
-  }
+Plugin const* principia__NewPluginFromMessage(
+    serialization::Plugin** const message) {
+  LOG(INFO) << __FUNCTION__;
+  std::unique_ptr<serialization::Plugin> const owned_message =
+      TakeOwnership(message);
+  CHECK_NOTNULL(owned_message.get());
+  return Plugin::ReadFromMessage(*owned_message).release();
 }
 
 char const* principia__SayHello() {
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <type_traits>
 
 #include "base/macros.hpp"
@@ -176,6 +177,13 @@ extern "C" DLLEXPORT
 void CDECL principia__ForgetAllHistoriesBefore(Plugin* const plugin,
                                                double const t);
 
+// Calls |plugin->ArchiveAllHistoriesBefore| with the arguments given.
+// |plugin| must not be null.  No transfer of ownership.
+extern "C" DLLEXPORT
+void CDECL principia__ArchiveAllHistoriesBefore(Plugin* const plugin,
+                                                double const t,
+                                                char const* directory);
+
 // Calls |plugin->VesselFromParent| with the arguments given.
 // |plugin| must not be null.  No transfer of ownership.
 extern "C" DLLEXPORT
@@ -227,6 +235,18 @@ LineAndIterator* CDECL principia__RenderedPrediction(
     RenderingTransforms* const transforms,
     XYZ const sun_world_position);
 
+// Returns the result of |plugin->RenderedBatchedPrediction| called with the
+// arguments given, together with an iterator to its beginning.  |plugin| must
+// not be null.  No transfer of ownership of |plugin|.  The caller gets
+// ownership of the result.  |transforms| must not be null.  No transfer of
+// ownership of |transforms|.
+extern "C" DLLEXPORT
+LineAndIterator* CDECL principia__RenderedBatchedPrediction(
+    Plugin* const plugin,
+    char const* vessel_guid,
+    RenderingTransforms* const transforms,
+    XYZ const sun_world_position);
+
 // Returns |line_and_iterator->rendered_trajectory.size()|.
 // |line_and_iterator| must not be null.  No transfer of ownership.
 extern "C" DLLEXPORT
@@ -247,6 +267,28 @@ XYZSegment CDECL principia__FetchAndIncrement(
 extern "C" DLLEXPORT
 bool CDECL principia__AtEnd(LineAndIterator* const line_and_iterator);
 
+// Returns the number of vertices of the polyline formed by the segments of
+// |line_and_iterator->rendered_trajectory|, i.e., the number of segments plus
+// one, or 0 if there are no segments.  |line_and_iterator| must not be null.
+// No transfer of ownership.
+extern "C" DLLEXPORT
+int CDECL principia__NumberOfVertices(
+    LineAndIterator const* const line_and_iterator);
+
+// Writes the vertices of the polyline formed by the segments of
+// |line_and_iterator->rendered_trajectory| to the |capacity| elements starting
+// at |vertices|, in one call rather than one call per segment.  The end of
+// each segment must be the beginning of the next one, and it is written only
+// once.  If there are more than |capacity| vertices, only the last |capacity|
+// ones are written.  Returns the number of vertices written.  Does not use or
+// change |line_and_iterator->it|.  |line_and_iterator| and |vertices| must not
+// be null.  No transfer of ownership.
+extern "C" DLLEXPORT
+int CDECL principia__FetchVertices(
+    LineAndIterator const* const line_and_iterator,
+    XYZ* const vertices,
+    int const capacity);
+
 // Deletes and nulls |*line_and_iterator|.
 // |line_and_iterator| must not be null.  No transfer of ownership of
 // |*line_and_iterator|, takes ownership of |**line_and_iterator|.
@@ -269,6 +311,58 @@ extern "C" DLLEXPORT
 void CDECL principia__set_prediction_step(Plugin* const plugin,
                                           double const t);
 
+// Calls |plugin->set_rendering_tolerance| with the given tolerance, in m.
+// |plugin| must not be null.  No transfer of ownership.
+extern "C" DLLEXPORT
+void CDECL principia__set_rendering_tolerance(Plugin* const plugin,
+                                              double const tolerance);
+
+// Calls |plugin->set_prediction_tolerances| with the given tolerances, in m
+// and m/s respectively.  |plugin| must not be null.  No transfer of ownership.
+extern "C" DLLEXPORT
+void CDECL principia__set_prediction_tolerances(
+    Plugin* const plugin,
+    double const length_tolerance,
+    double const speed_tolerance);
+
+// Calls |plugin->set_incremental_prediction_tolerances| with the given
+// tolerances, in m and m/s respectively.  |plugin| must not be null.  No
+// transfer of ownership.
+extern "C" DLLEXPORT
+void CDECL principia__set_incremental_prediction_tolerances(
+    Plugin* const plugin,
+    double const length_tolerance,
+    double const speed_tolerance);
+
+extern "C" DLLEXPORT
+void CDECL principia__set_asynchronous_predictions(Plugin* const plugin,
+                                                   bool const asynchronous);
+
+// Returns the number of predictions that have been requested since the one
+// currently rendered, see |Plugin::rendered_prediction_generation|.  |plugin|
+// must not be null.  No transfer of ownership.
+extern "C" DLLEXPORT
+int CDECL principia__PredictionStaleness(Plugin const* const plugin);
+
+// Calls |plugin->AddVesselToBatchedPredictions| with the given |length| and
+// |step|, in s.  |plugin| must not be null.  No transfer of ownership.
+extern "C" DLLEXPORT
+void CDECL principia__AddVesselToBatchedPredictions(Plugin* const plugin,
+                                                    char const* vessel_guid,
+                                                    double const length,
+                                                    double const step);
+
+extern "C" DLLEXPORT
+void CDECL principia__RemoveVesselFromBatchedPredictions(
+    Plugin* const plugin,
+    char const* vessel_guid);
+
+// Calls |plugin->set_number_of_threads(number_of_threads)|.  |plugin| must not
+// be null.  No transfer of ownership.
+extern "C" DLLEXPORT
+void CDECL principia__set_number_of_threads(Plugin* const plugin,
+                                            int const number_of_threads);
+
 extern "C" DLLEXPORT
 bool CDECL principia__has_vessel(Plugin* const plugin,
                                  char const* vessel_guid);
@@ -304,15 +398,28 @@ XYZ CDECL principia__VesselTangent(Plugin const* const plugin,
 extern "C" DLLEXPORT
 double CDECL principia__current_time(Plugin const* const plugin);
 
-// |plugin| must not be null.  The caller takes ownership of the result, except
-// when it is null (at the end of the stream).  No transfer of ownership of
-// |*plugin|.  |*serializer| must be null on the first call and must be passed
-// unchanged to the successive calls; its ownership is not transferred.
+// |plugin| must not be null.  The serialization is compressed.  The caller
+// takes ownership of the result, except when it is null (at the end of the
+// stream).  No transfer of ownership of |*plugin|.  |*serializer| must be null
+// on the first call and must be passed unchanged to the successive calls; its
+// ownership is not transferred.
 extern "C" DLLEXPORT
 char const* CDECL principia__SerializePlugin(
     Plugin const* const plugin,
     base::PullSerializer** const serializer);
 
+// Same as |principia__SerializePlugin|, but serializes the result of
+// |plugin->WriteDeltaToMessage| for the time |since|, in seconds, which must be
+// the |principia__current_time| of a previous serialization of |plugin|.  The
+// cost of this call is proportional to the data added since then, but the
+// delta is only usable together with that previous serialization, which the
+// caller must keep and save again.
+extern "C" DLLEXPORT
+char const* CDECL principia__SerializePluginDelta(
+    Plugin const* const plugin,
+    double const since,
+    base::PullSerializer** const serializer);
+
 // Deletes and nulls |*serialization|.
 // |serialization| must not be null.  No transfer of ownership of
 // |*serialization|, takes ownership of |**serialization|.
@@ -320,12 +427,25 @@ extern "C" DLLEXPORT
 void CDECL principia__DeletePluginSerialization(
     char const** const serialization);
 
+// Same as |principia__SerializePlugin|, but returns the raw bytes of the
+// serialization without hexadecimal encoding, and without copying them: the
+// result is owned by |*serializer| and is only valid until the next call.
+// Sets |*size| to the number of bytes returned, 0 at the end of the stream,
+// where the result is null.  |size| must not be null.
+extern "C" DLLEXPORT
+std::uint8_t const* CDECL principia__SerializePluginBytes(
+    Plugin const* const plugin,
+    base::PullSerializer** const serializer,
+    int* const size);
+
 // The caller takes ownership of |**plugin| when it is not null.  No transfer of
 // ownership of |*serialization| or |**deserializer|.  |*deserializer| and
 // |*plugin| must be null on the first call and must be passed unchanged to the
-// successive calls.  The caller must perform an extra call with
-// |serialization_size| set to 0 to indicate the end of the input stream.  When
-// this last call returns, |*plugin| is not null and may be used by the caller.
+// successive calls.  The serialization may be compressed or not, the latter
+// being the case of saves made before compression was introduced.  The caller
+// must perform an extra call with |serialization_size| set to 0 to indicate
+// the end of the input stream.  When this last call returns, |*plugin| is not
+// null and may be used by the caller.
 extern "C" DLLEXPORT
 void CDECL principia__DeserializePlugin(
     char const* const serialization,
@@ -333,6 +453,48 @@ void CDECL principia__DeserializePlugin(
     base::PushDeserializer** const deserializer,
     Plugin const** const plugin);
 
+// Same as |principia__DeserializePlugin|, but |serialization| holds
+// |serialization_size| raw bytes instead of their hexadecimal representation.
+// No transfer of ownership of |*serialization|, which need not outlive the
+// call.
+extern "C" DLLEXPORT
+void CDECL principia__DeserializePluginBytes(
+    std::uint8_t const* const serialization,
+    int const serialization_size,
+    base::PushDeserializer** const deserializer,
+    Plugin const** const plugin);
+
+// Same as |principia__DeserializePlugin|, but fills |*message| with the
+// deserialized message instead of constructing the plugin, so that deltas may
+// be merged into it.  The caller takes ownership of |**message| when it is not
+// null.
+extern "C" DLLEXPORT
+void CDECL principia__DeserializePluginMessage(
+    char const* const serialization,
+    int const serialization_size,
+    base::PushDeserializer** const deserializer,
+    serialization::Plugin** const message);
+
+// Deserializes the output of |principia__SerializePluginDelta| like
+// |principia__DeserializePlugin|, and at the end of the input stream calls
+// |Plugin::MergeDeltaIntoMessage| on |*message|, which must be the message of
+// the serialization from which the delta was computed.  |message| must not be
+// null.  No transfer of ownership of |*message|.
+extern "C" DLLEXPORT
+void CDECL principia__MergePluginDeltaIntoMessage(
+    char const* const serialization,
+    int const serialization_size,
+    base::PushDeserializer** const deserializer,
+    serialization::Plugin* const message);
+
+// Returns the result of |Plugin::ReadFromMessage(**message)|, and deletes and
+// nulls |*message|.  |message| and |*message| must not be null.  No transfer
+// of ownership of |*message|, takes ownership of |**message|.  The caller gets
+// ownership of the result.
+extern "C" DLLEXPORT
+Plugin const* CDECL principia__NewPluginFromMessage(
+    serialization::Plugin** const message);
+
 // Says hello, convenient for checking that calls to the DLL work.
 extern "C" DLLEXPORT
 char const* CDECL principia__SayHello();
@@ -43,6 +43,8 @@ class MockPlugin : public Plugin {
                void(Instant const& t, Angle const& planetarium_rotation));
 
   MOCK_CONST_METHOD1(ForgetAllHistoriesBefore, void(Instant const& t));
+  MOCK_CONST_METHOD2(ArchiveAllHistoriesBefore,
+                     void(Instant const& t, std::string const& directory));
 
   MOCK_CONST_METHOD1(VesselFromParent,
                      RelativeDegreesOfFreedom<AliceSun>(
@@ -65,6 +67,13 @@ class MockPlugin : public Plugin {
           not_null<RenderingTransforms*> const transforms,
           Position<World> const& sun_world_position));
 
+  MOCK_METHOD3(
+      RenderedBatchedPrediction,
+      RenderedTrajectory<World>(
+          GUID const& vessel_guid,
+          not_null<RenderingTransforms*> const transforms,
+          Position<World> const& sun_world_position));
+
   MOCK_METHOD1(set_predicted_vessel, void(GUID const& vessel_guid));
 
   MOCK_METHOD0(clear_predicted_vessel, void());
@@ -72,6 +81,29 @@ class MockPlugin : public Plugin {
   MOCK_METHOD1(set_prediction_length, void(Time const& t));
 
   MOCK_METHOD1(set_prediction_step, void(Time const& t));
+  MOCK_METHOD1(set_rendering_tolerance, void(Length const& tolerance));
+
+  MOCK_METHOD2(set_prediction_tolerances,
+               void(Length const& length_tolerance,
+                    Speed const& speed_tolerance));
+
+  MOCK_METHOD2(set_incremental_prediction_tolerances,
+               void(Length const& length_tolerance,
+                    Speed const& speed_tolerance));
+
+  MOCK_METHOD1(set_asynchronous_predictions, void(bool const asynchronous));
+
+  MOCK_CONST_METHOD0(requested_prediction_generation, std::int64_t());
+  MOCK_CONST_METHOD0(rendered_prediction_generation, std::int64_t());
+
+  MOCK_METHOD3(AddVesselToBatchedPredictions,
+               void(GUID const& vessel_guid,
+                    Time const& length,
+                    Time const& step));
+  MOCK_METHOD1(RemoveVesselFromBatchedPredictions,
+               void(GUID const& vessel_guid));
+
+  MOCK_METHOD1(set_number_of_threads, void(int const number_of_threads));
 
   MOCK_CONST_METHOD1(has_vessel, bool(GUID const& vessel_guid));
 
@@ -131,6 +163,10 @@ class MockPlugin : public Plugin {
 
   MOCK_CONST_METHOD1(WriteToMessage,
                      void(not_null<serialization::Plugin*> const message));
+  MOCK_CONST_METHOD2(
+      WriteDeltaToMessage,
+      void(Instant const& since,
+           not_null<serialization::PluginDelta*> const message));
 };
 
 }  // namespace ksp_plugin
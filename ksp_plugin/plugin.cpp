@@ -1,15 +1,19 @@
 ﻿#include "ksp_plugin/plugin.hpp"
 
 #include <algorithm>
+#include <chrono>  // NOLINT(build/c++11)
 #include <cmath>
+#include <functional>
 #include <map>
 #include <string>
+#include <thread>  // NOLINT(build/c++11)
 #include <utility>
 #include <vector>
 #include <set>
 
 #include "base/map_util.hpp"
 #include "base/not_null.hpp"
+#include "base/thread_pool.hpp"
 #include "base/unique_ptr_logging.hpp"
 #include "geometry/affine_map.hpp"
 #include "geometry/barycentre_calculator.hpp"
@@ -24,15 +28,20 @@ namespace ksp_plugin {
 
 using base::FindOrDie;
 using base::make_not_null_unique;
+using base::ThreadPool;
 using geometry::AffineMap;
 using geometry::AngularVelocity;
 using geometry::BarycentreCalculator;
 using geometry::Bivector;
 using geometry::Identity;
+using geometry::InnerProduct;
 using geometry::Normalize;
 using geometry::Permutation;
 using geometry::Sign;
+using integrators::DormandElMikkawyPrince1986RKN434FM;
 using integrators::McLachlanAtela1992Order5Optimal;
+using physics::ContinuousTrajectory;
+using quantities::Area;
 using quantities::Force;
 using si::Radian;
 
@@ -46,6 +55,116 @@ Permutation<World, AliceWorld> const kWorldLookingGlass(
 Permutation<WorldSun, AliceSun> const kSunLookingGlass(
     Permutation<WorldSun, AliceSun>::CoordinatePermutation::XZY);
 
+// The cubic Hermite interpolation at |t| of the trajectory given by the
+// |degrees_of_freedom| at the |times|.  |t| must be in
+// [times.front(), times.back()].
+DegreesOfFreedom<Barycentric> HermiteInterpolation(
+    std::vector<Instant> const& times,
+    std::vector<DegreesOfFreedom<Barycentric>> const& degrees_of_freedom,
+    Instant const& t) {
+  CHECK_LE(times.front(), t);
+  CHECK_LE(t, times.back());
+  std::size_t const i1 =
+      std::lower_bound(times.begin(), times.end(), t) - times.begin();
+  if (times[i1] == t) {
+    return degrees_of_freedom[i1];
+  }
+  std::size_t const i0 = i1 - 1;
+  Position<Barycentric> const& q0 = degrees_of_freedom[i0].position();
+  Velocity<Barycentric> const& v0 = degrees_of_freedom[i0].velocity();
+  Velocity<Barycentric> const& v1 = degrees_of_freedom[i1].velocity();
+  Displacement<Barycentric> const Δq = degrees_of_freedom[i1].position() - q0;
+  Time const h = times[i1] - times[i0];
+  double const s = (t - times[i0]) / h;
+  return DegreesOfFreedom<Barycentric>(
+      q0 + s * s * (3 - 2 * s) * Δq +
+           s * (1 - s) * (1 - s) * h * v0 -
+           s * s * (1 - s) * h * v1,
+      6 * s * (1 - s) * Δq / h +
+          (1 - s) * (1 - 3 * s) * v0 +
+          s * (3 * s - 2) * v1);
+}
+
+// A pool with as many threads as there are cores, for the serialization.
+not_null<std::unique_ptr<ThreadPool>> NewSerializationThreadPool() {
+  return make_not_null_unique<ThreadPool>(
+      std::max(1, static_cast<int>(std::thread::hardware_concurrency())));
+}
+
+// Runs the |tasks| in parallel on the |thread_pool|.  The tasks must be
+// independent.
+void RunInParallel(std::vector<std::function<void()>> const& tasks,
+                   not_null<ThreadPool*> const thread_pool) {
+  thread_pool->ParallelFor(
+      0,
+      tasks.size(),
+      /*minimum_chunk_size=*/1,
+      [&tasks](std::size_t const begin, std::size_t const end) {
+        for (std::size_t i = begin; i < end; ++i) {
+          tasks[i]();
+        }
+      });
+}
+
+// The distance from |point| to the segment [|begin|, |end|].
+template<typename Frame>
+Length DistanceToSegment(Position<Frame> const& point,
+                         Position<Frame> const& begin,
+                         Position<Frame> const& end) {
+  Displacement<Frame> const chord = end - begin;
+  Displacement<Frame> const offset = point - begin;
+  Area const chord_squared = InnerProduct(chord, chord);
+  if (chord_squared == Area()) {
+    return offset.Norm();
+  }
+  double const s = std::min(
+      1.0, std::max(0.0, InnerProduct(offset, chord) / chord_squared));
+  return (offset - s * chord).Norm();
+}
+
+// Returns whether each of the |vertices| of a polyline must be kept so that
+// the simplified polyline is within |tolerance| of all the vertices.  This is
+// the Douglas-Peucker algorithm: the vertex farthest from the chord of a
+// section is kept if it is farther than |tolerance|, and the section is split
+// there.  Sections that curve sharply are thus split more finely.
+template<typename Frame>
+std::vector<bool> VerticesToKeep(std::vector<Position<Frame>> const& vertices,
+                                 Length const& tolerance) {
+  if (tolerance == Length()) {
+    return std::vector<bool>(vertices.size(), true);
+  }
+  std::vector<bool> keep(vertices.size(), false);
+  if (vertices.empty()) {
+    return keep;
+  }
+  keep.front() = true;
+  keep.back() = true;
+  // The sections [first, last] left to simplify.
+  std::vector<std::pair<std::size_t, std::size_t>> sections;
+  sections.emplace_back(0, vertices.size() - 1);
+  while (!sections.empty()) {
+    std::size_t const first = sections.back().first;
+    std::size_t const last = sections.back().second;
+    sections.pop_back();
+    Length max_distance;
+    std::size_t farthest = first;
+    for (std::size_t i = first + 1; i < last; ++i) {
+      Length const distance =
+          DistanceToSegment(vertices[i], vertices[first], vertices[last]);
+      if (distance > max_distance) {
+        max_distance = distance;
+        farthest = i;
+      }
+    }
+    if (max_distance > tolerance) {
+      keep[farthest] = true;
+      sections.emplace_back(first, farthest);
+      sections.emplace_back(farthest, last);
+    }
+  }
+  return keep;
+}
+
 }  // namespace
 
 Plugin::Plugin(Instant const& initial_time,
@@ -53,9 +172,10 @@ Plugin::Plugin(Instant const& initial_time,
                GravitationalParameter const& sun_gravitational_parameter,
                Angle const& planetarium_rotation)
     : bubble_(make_not_null_unique<PhysicsBubble>()),
-      n_body_system_(make_not_null_unique<NBodySystem<Barycentric>>()),
+      serialization_thread_pool_(NewSerializationThreadPool()),
       history_integrator_(&McLachlanAtela1992Order5Optimal()),
       prolongation_integrator_(&McLachlanAtela1992Order5Optimal()),
+      prediction_integrator_(&DormandElMikkawyPrince1986RKN434FM()),
       planetarium_rotation_(planetarium_rotation),
       current_time_(initial_time),
       sun_(celestials_.emplace(sun_index,
@@ -97,6 +217,24 @@ void Plugin::InsertCelestial(
 
 void Plugin::EndInitialization() {
   initializing_.Flop();
+  if (ephemeris_ == nullptr) {
+    std::vector<not_null<MassiveBody const*>> bodies;
+    std::vector<DegreesOfFreedom<Barycentric>> initial_state;
+    for (auto const& pair : celestials_) {
+      not_null<std::unique_ptr<Celestial>> const& celestial = pair.second;
+      bodies.push_back(&celestial->body());
+      initial_state.push_back(
+          celestial->history().last().degrees_of_freedom());
+    }
+    ephemeris_ = std::make_unique<Ephemeris<Barycentric>>(
+                     bodies,
+                     initial_state,
+                     HistoryTime(),
+                     *history_integrator_,
+                     ephemeris_step_,
+                     ephemeris_fitting_tolerance_);
+  }
+  ephemeris_->set_number_of_threads(number_of_threads_);
 }
 
 void Plugin::UpdateCelestialHierarchy(Index const celestial_index,
@@ -154,6 +292,8 @@ void Plugin::AdvanceTime(Instant const& t, Angle const& planetarium_rotation) {
           << NAMED(t) << '\n' << NAMED(planetarium_rotation);
   CHECK(!initializing_);
   CHECK_GT(t, current_time_);
+  // The predictions are forks of the prolongations, which are about to change.
+  DeletePredictions();
   CleanUpVessels();
   bubble_->Prepare(BarycentricToWorldSun(), current_time_, t);
   if (HistoryTime() + Δt_ < t) {
@@ -190,6 +330,23 @@ void Plugin::ForgetAllHistoriesBefore(Instant const& t) const {
       vessel->mutable_history()->ForgetBefore(t);
     }
   }
+  // The pending prediction, if any, may still need the ephemeris before |t|.
+  ephemeris_->ForgetBefore(
+      pending_prediction_.valid() ? std::min(t, pending_prediction_time_) : t);
+}
+
+void Plugin::ArchiveAllHistoriesBefore(Instant const& t,
+                                       std::string const& directory) const {
+  for (auto const& pair : celestials_) {
+    not_null<std::unique_ptr<Celestial>> const& celestial = pair.second;
+    celestial->mutable_history()->ArchiveBefore(t, directory);
+  }
+  for (auto const& pair : vessels_) {
+    not_null<std::unique_ptr<Vessel>> const& vessel = pair.second;
+    if (unsynchronized_vessels_.count(vessel.get()) == 0) {
+      vessel->mutable_history()->ArchiveBefore(t, directory);
+    }
+  }
 }
 
 RelativeDegreesOfFreedom<AliceSun> Plugin::VesselFromParent(
@@ -243,24 +400,27 @@ RenderedTrajectory<World> Plugin::RenderedVesselTrajectory(
     return RenderedTrajectory<World>();
   }
 
-  // Compute the apparent trajectory using the given |transforms|.
-  return RenderTrajectory(vessel->body(),
-                          transforms->first(*vessel,
-                                            &MobileInterface::history),
-                          transforms,
-                          sun_world_position);
+  // Compute the apparent trajectory using the given |transforms|.  The
+  // reference celestials are evaluated from the |ephemeris_|, which may start
+  // after the history if it was read from a save that didn't include it.
+  return RenderTrajectory(
+      transforms->first_positions_on_or_after(
+          *vessel,
+          &MobileInterface::history,
+          std::max(vessel->history().first().time(), ephemeris_->t_min())),
+      transforms,
+      sun_world_position);
 }
 
 RenderedTrajectory<World> Plugin::RenderedPrediction(
     not_null<RenderingTransforms*> const transforms,
     Position<World> const& sun_world_position) {
   CHECK(!initializing_);
-  if (!HasPredictions()) {
+  if (!has_predicted_vessel() || !predicted_vessel_->has_prediction()) {
     return RenderedTrajectory<World>();
   }
   RenderedTrajectory<World> result =
-      RenderTrajectory(predicted_vessel_->body(),
-                       transforms->first_on_or_after(
+      RenderTrajectory(transforms->first_positions_on_or_after(
                            *predicted_vessel_,
                            &MobileInterface::prediction,
                            *predicted_vessel_->prediction().fork_time()),
@@ -277,16 +437,114 @@ void Plugin::set_predicted_vessel(GUID const& vessel_guid) {
 void Plugin::clear_predicted_vessel() {
   DeletePredictions();
   predicted_vessel_ = nullptr;
+  // The predictions already requested, including any that is still running,
+  // are for the previous vessel.
+  completed_prediction_.reset();
+  rendered_prediction_generation_ = 0;
+  first_prediction_generation_ = requested_prediction_generation_ + 1;
 }
 
 void Plugin::set_prediction_length(Time const& t) {
   prediction_length_ = t;
 }
 
+void Plugin::set_rendering_tolerance(Length const& tolerance) {
+  CHECK_LE(Length(), tolerance);
+  rendering_tolerance_ = tolerance;
+}
+
 void Plugin::set_prediction_step(Time const& t) {
   prediction_step_ = t;
 }
 
+void Plugin::set_prediction_tolerances(Length const& length_tolerance,
+                                       Speed const& speed_tolerance) {
+  CHECK_LE(Length(), length_tolerance);
+  CHECK_LE(Speed(), speed_tolerance);
+  CHECK_EQ(length_tolerance == Length(), speed_tolerance == Speed())
+      << "Inconsistent tolerances " << length_tolerance << ", "
+      << speed_tolerance;
+  prediction_length_tolerance_ = length_tolerance;
+  prediction_speed_tolerance_ = speed_tolerance;
+}
+
+void Plugin::set_asynchronous_predictions(bool const asynchronous) {
+  asynchronous_predictions_ = asynchronous;
+}
+
+void Plugin::set_incremental_prediction_tolerances(
+    Length const& length_tolerance,
+    Speed const& speed_tolerance) {
+  CHECK_LE(Length(), length_tolerance);
+  CHECK_LE(Speed(), speed_tolerance);
+  CHECK_EQ(length_tolerance == Length(), speed_tolerance == Speed())
+      << "Inconsistent tolerances " << length_tolerance << ", "
+      << speed_tolerance;
+  incremental_prediction_length_tolerance_ = length_tolerance;
+  incremental_prediction_speed_tolerance_ = speed_tolerance;
+}
+
+std::int64_t Plugin::requested_prediction_generation() const {
+  return requested_prediction_generation_;
+}
+
+std::int64_t Plugin::rendered_prediction_generation() const {
+  return rendered_prediction_generation_;
+}
+
+void Plugin::AddVesselToBatchedPredictions(GUID const& vessel_guid,
+                                           Time const& length,
+                                           Time const& step) {
+  CHECK_LT(Time(), length);
+  CHECK_LT(Time(), step);
+  CHECK(has_vessel(vessel_guid)) << "No vessel with GUID " << vessel_guid;
+  batched_predictions_[vessel_guid] = {length, step};
+}
+
+void Plugin::RemoveVesselFromBatchedPredictions(GUID const& vessel_guid) {
+  auto const it = batched_predictions_.find(vessel_guid);
+  CHECK(it != batched_predictions_.end())
+      << "No batched prediction for the vessel with GUID " << vessel_guid;
+  batched_predictions_.erase(it);
+  not_null<Vessel*> const vessel =
+      find_vessel_by_guid_or_die(vessel_guid).get();
+  if (vessel != predicted_vessel_ && vessel->has_prediction()) {
+    vessel->DeletePrediction();
+  }
+}
+
+RenderedTrajectory<World> Plugin::RenderedBatchedPrediction(
+    GUID const& vessel_guid,
+    not_null<RenderingTransforms*> const transforms,
+    Position<World> const& sun_world_position) {
+  CHECK(!initializing_);
+  CHECK(batched_predictions_.count(vessel_guid) > 0)
+      << "No batched prediction for the vessel with GUID " << vessel_guid;
+  not_null<std::unique_ptr<Vessel>> const& vessel =
+      find_vessel_by_guid_or_die(vessel_guid);
+  if (!vessel->has_prediction()) {
+    return RenderedTrajectory<World>();
+  }
+  return RenderTrajectory(transforms->first_positions_on_or_after(
+                              *vessel,
+                              &MobileInterface::prediction,
+                              *vessel->prediction().fork_time()),
+                          transforms,
+                          sun_world_position);
+}
+
+void Plugin::set_number_of_threads(int const number_of_threads) {
+  // The thread pool of the |ephemeris_| may not change while the prediction is
+  // using it.
+  if (pending_prediction_.valid()) {
+    pending_prediction_.wait();
+  }
+  number_of_threads_ = number_of_threads;
+  if (ephemeris_ != nullptr) {
+    ephemeris_->set_number_of_threads(number_of_threads_);
+  }
+}
+
 bool Plugin::has_vessel(GUID const& vessel_guid) const {
   return vessels_.find(vessel_guid) != vessels_.end();
 }
@@ -301,6 +559,8 @@ Plugin::NewBodyCentredNonRotatingTransforms(
                         *reference_body,
                         &MobileInterface::prolongation);
   transforms->set_cacheable(&MobileInterface::history);
+  transforms->set_evaluator(&MobileInterface::history,
+                            CelestialHistoryEvaluator());
   return transforms;
 }
 
@@ -317,6 +577,8 @@ Plugin::NewBarycentricRotatingTransforms(Index const primary_index,
                         *secondary,
                         &MobileInterface::prolongation);
   transforms->set_cacheable(&MobileInterface::history);
+  transforms->set_evaluator(&MobileInterface::history,
+                            CelestialHistoryEvaluator());
   return transforms;
 }
 
@@ -405,57 +667,31 @@ Instant Plugin::current_time() const {
 void Plugin::WriteToMessage(
     not_null<serialization::Plugin*> const message) const {
   LOG(INFO) << __FUNCTION__;
-  CHECK(!initializing_);
-  std::map<not_null<Celestial const*>, Index const> celestial_to_index;
-  for (auto const& index_celestial : celestials_) {
-    celestial_to_index.emplace(index_celestial.second.get(),
-                               index_celestial.first);
-  }
-  for (auto const& index_celestial : celestials_) {
-    Index const index = index_celestial.first;
-    not_null<Celestial const*> const celestial = index_celestial.second.get();
-    auto const celestial_message = message->add_celestial();
-    celestial_message->set_index(index);
-    celestial->WriteToMessage(celestial_message->mutable_celestial());
-    if (celestial->has_parent()) {
-      Index const parent_index =
-          FindOrDie(celestial_to_index, celestial->parent());
-      celestial_message->set_parent_index(parent_index);
-    }
-  }
-  std::map<not_null<Vessel const*>, GUID const> vessel_to_guid;
-  for (auto const& guid_vessel : vessels_) {
-    std::string const& guid = guid_vessel.first;
-    not_null<Vessel*> const vessel = guid_vessel.second.get();
-    vessel_to_guid.emplace(vessel, guid);
-    auto* const vessel_message = message->add_vessel();
-    vessel_message->set_guid(guid);
-    vessel->WriteToMessage(vessel_message->mutable_vessel());
-    Index const parent_index = FindOrDie(celestial_to_index, vessel->parent());
-    vessel_message->set_parent_index(parent_index);
-    vessel_message->set_dirty(is_dirty(vessel));
-  }
-
-  bubble_->WriteToMessage(
-      [&vessel_to_guid](not_null<Vessel const*> const vessel) -> GUID {
-        return FindOrDie(vessel_to_guid, vessel);
-      },
-      message->mutable_bubble());
-
-  planetarium_rotation_.WriteToMessage(message->mutable_planetarium_rotation());
-  current_time_.WriteToMessage(message->mutable_current_time());
-  Index const sun_index = FindOrDie(celestial_to_index, sun_);
-  message->set_sun_index(sun_index);
+  WritePluginToMessage(/*since=*/nullptr, message);
 }
 
 std::unique_ptr<Plugin> Plugin::ReadFromMessage(
     serialization::Plugin const& message) {
   LOG(INFO) << __FUNCTION__;
+  // The celestials, and then the vessels, which depend on them, are
+  // deserialized in parallel, each from its own submessage.  The pool is then
+  // kept by the plugin for its serialization.
+  not_null<std::unique_ptr<ThreadPool>> thread_pool =
+      NewSerializationThreadPool();
+  std::vector<std::unique_ptr<Celestial>> read_celestials(
+      message.celestial_size());
+  std::vector<std::function<void()>> tasks;
+  for (int i = 0; i < message.celestial_size(); ++i) {
+    tasks.emplace_back([&message, &read_celestials, i]() {
+      read_celestials[i] =
+          Celestial::ReadFromMessage(message.celestial(i).celestial());
+    });
+  }
+  RunInParallel(tasks, thread_pool.get());
   IndexToOwnedCelestial celestials;
-  for (auto const& celestial_message : message.celestial()) {
-    celestials.emplace(
-        celestial_message.index(),
-        Celestial::ReadFromMessage(celestial_message.celestial()));
+  for (int i = 0; i < message.celestial_size(); ++i) {
+    celestials.emplace(message.celestial(i).index(),
+                       std::move(read_celestials[i]));
   }
   for (auto const& celestial_message : message.celestial()) {
     if (celestial_message.has_parent_index()) {
@@ -466,13 +702,35 @@ std::unique_ptr<Plugin> Plugin::ReadFromMessage(
       celestial->set_parent(parent);
     }
   }
+  // The trajectories of the ephemeris are in the order of the indices of the
+  // celestials, see |EndInitialization|.
+  std::unique_ptr<Ephemeris<Barycentric>> ephemeris;
+  if (message.has_ephemeris()) {
+    std::vector<not_null<MassiveBody const*>> bodies;
+    for (auto const& pair : celestials) {
+      bodies.push_back(&pair.second->body());
+    }
+    ephemeris = Ephemeris<Barycentric>::ReadFromMessage(
+                    bodies,
+                    McLachlanAtela1992Order5Optimal(),
+                    message.ephemeris());
+  }
+  std::vector<std::unique_ptr<Vessel>> read_vessels(message.vessel_size());
+  tasks.clear();
+  for (int i = 0; i < message.vessel_size(); ++i) {
+    not_null<Celestial const*> const parent =
+        FindOrDie(celestials, message.vessel(i).parent_index()).get();
+    tasks.emplace_back([&message, &read_vessels, i, parent]() {
+      read_vessels[i] =
+          Vessel::ReadFromMessage(message.vessel(i).vessel(), parent);
+    });
+  }
+  RunInParallel(tasks, thread_pool.get());
   GUIDToOwnedVessel vessels;
   std::set<not_null<Vessel*> const> dirty_vessels;
-  for (auto const& vessel_message : message.vessel()) {
-    not_null<Celestial const*> const parent =
-        FindOrDie(celestials, vessel_message.parent_index()).get();
-    not_null<std::unique_ptr<Vessel>> vessel =
-        Vessel::ReadFromMessage(vessel_message.vessel(), parent);
+  for (int i = 0; i < message.vessel_size(); ++i) {
+    auto const& vessel_message = message.vessel(i);
+    not_null<std::unique_ptr<Vessel>> vessel = std::move(read_vessels[i]);
     if (vessel_message.dirty()) {
       dirty_vessels.emplace(vessel.get());
     }
@@ -492,15 +750,92 @@ std::unique_ptr<Plugin> Plugin::ReadFromMessage(
                  std::move(celestials),
                  std::move(dirty_vessels),
                  std::move(bubble),
+                 std::move(thread_pool),
+                 std::move(ephemeris),
                  Angle::ReadFromMessage(message.planetarium_rotation()),
                  Instant::ReadFromMessage(message.current_time()),
                  message.sun_index()));
 }
 
+void Plugin::WriteDeltaToMessage(
+    Instant const& since,
+    not_null<serialization::PluginDelta*> const message) const {
+  LOG(INFO) << __FUNCTION__;
+  since.WriteToMessage(message->mutable_since());
+  WritePluginToMessage(&since, message->mutable_plugin());
+}
+
+void Plugin::MergeDeltaIntoMessage(
+    serialization::PluginDelta const& delta,
+    not_null<serialization::Plugin*> const message) {
+  LOG(INFO) << __FUNCTION__;
+  // The histories of the vessels of |message|, by GUID.  The histories of the
+  // celestials only hold their last point, so the delta has them in full.
+  std::map<GUID, not_null<serialization::Trajectory const*>> vessel_histories;
+  for (auto const& vessel_message : message->vessel()) {
+    if (vessel_message.vessel().has_history_and_prolongation()) {
+      vessel_histories.emplace(
+          vessel_message.guid(),
+          &vessel_message.vessel().history_and_prolongation().history());
+    }
+  }
+
+  // Replaces |*tail| with the history |previous| extended by |*tail|.  The
+  // prolongation pointers remain valid since the forks are those of |*tail|.
+  // The body is not serialized, so any body will do.
+  auto const merge = [](serialization::Trajectory const& previous,
+                        not_null<serialization::Trajectory*> const tail) {
+    MasslessBody const body;
+    std::unique_ptr<Trajectory<Barycentric>> const history =
+        Trajectory<Barycentric>::ReadFromMessage(previous, &body);
+    history->MergeTailFromMessage(*tail);
+    tail->Clear();
+    history->WriteToMessage(tail);
+  };
+
+  // The vessels absent from |message| were inserted after the save, so the
+  // delta holds their entire histories.
+  serialization::Plugin merged = delta.plugin();
+  for (auto& vessel_message : *merged.mutable_vessel()) {
+    auto const it = vessel_histories.find(vessel_message.guid());
+    if (it != vessel_histories.end() &&
+        vessel_message.vessel().has_history_and_prolongation()) {
+      merge(*it->second,
+            vessel_message.mutable_vessel()->
+                mutable_history_and_prolongation()->mutable_history());
+    }
+  }
+
+  // The series of the ephemeris of |message| are extended by those of the
+  // delta.  If |message| has no ephemeris, the tail is useless and the
+  // ephemeris will be recomputed when the plugin is read.
+  if (merged.has_ephemeris()) {
+    if (message->has_ephemeris()) {
+      auto const& previous = message->ephemeris();
+      not_null<serialization::Ephemeris*> const tail =
+          merged.mutable_ephemeris();
+      CHECK_EQ(previous.trajectory_size(), tail->trajectory_size());
+      for (int i = 0; i < tail->trajectory_size(); ++i) {
+        not_null<std::unique_ptr<ContinuousTrajectory<Barycentric>>> const
+            trajectory = ContinuousTrajectory<Barycentric>::ReadFromMessage(
+                             previous.trajectory(i));
+        trajectory->MergeTailFromMessage(tail->trajectory(i));
+        tail->mutable_trajectory(i)->Clear();
+        trajectory->WriteToMessage(tail->mutable_trajectory(i));
+      }
+    } else {
+      merged.clear_ephemeris();
+    }
+  }
+  message->Swap(&merged);
+}
+
 Plugin::Plugin(GUIDToOwnedVessel vessels,
                IndexToOwnedCelestial celestials,
                std::set<not_null<Vessel*> const> dirty_vessels,
                not_null<std::unique_ptr<PhysicsBubble>> bubble,
+               not_null<std::unique_ptr<ThreadPool>> serialization_thread_pool,
+               std::unique_ptr<Ephemeris<Barycentric>> ephemeris,
                Angle planetarium_rotation,
                Instant current_time,
                Index sun_index)
@@ -508,9 +843,11 @@ Plugin::Plugin(GUIDToOwnedVessel vessels,
       celestials_(std::move(celestials)),
       dirty_vessels_(std::move(dirty_vessels)),
       bubble_(std::move(bubble)),
-      n_body_system_(make_not_null_unique<NBodySystem<Barycentric>>()),
+      serialization_thread_pool_(std::move(serialization_thread_pool)),
+      ephemeris_(std::move(ephemeris)),
       history_integrator_(&McLachlanAtela1992Order5Optimal()),
       prolongation_integrator_(&McLachlanAtela1992Order5Optimal()),
+      prediction_integrator_(&DormandElMikkawyPrince1986RKN434FM()),
       planetarium_rotation_(planetarium_rotation),
       current_time_(current_time),
       sun_(FindOrDie(celestials_, sun_index).get()) {
@@ -547,21 +884,26 @@ bool Plugin::has_predicted_vessel() const {
 }
 
 bool Plugin::HasPredictions() const {
-  if (has_predicted_vessel()) {
-    bool const has_prediction = predicted_vessel_->has_prediction();
-    for (auto const& pair : celestials_) {
-      not_null<std::unique_ptr<Celestial>> const& celestial = pair.second;
-      CHECK_EQ(celestial->has_prediction(), has_prediction);
-    }
-    return has_prediction;
-  } else {
-    return false;
+  bool const has_predictions = sun_->has_prediction();
+  for (auto const& pair : celestials_) {
+    not_null<std::unique_ptr<Celestial>> const& celestial = pair.second;
+    CHECK_EQ(celestial->has_prediction(), has_predictions);
   }
+  return has_predictions;
 }
 
 void Plugin::DeletePredictions() {
   if (HasPredictions()) {
-    predicted_vessel_->DeletePrediction();
+    if (has_predicted_vessel() && predicted_vessel_->has_prediction()) {
+      predicted_vessel_->DeletePrediction();
+    }
+    for (auto const& pair : batched_predictions_) {
+      not_null<std::unique_ptr<Vessel>> const& vessel =
+          find_vessel_by_guid_or_die(pair.first);
+      if (vessel->has_prediction()) {
+        vessel->DeletePrediction();
+      }
+    }
     for (auto const& pair : celestials_) {
       not_null<std::unique_ptr<Celestial>> const& celestial = pair.second;
       celestial->DeletePrediction();
@@ -569,6 +911,82 @@ void Plugin::DeletePredictions() {
   }
 }
 
+void Plugin::WritePluginToMessage(
+    Instant const* const since,
+    not_null<serialization::Plugin*> const message) const {
+  CHECK(!initializing_);
+  std::map<not_null<Celestial const*>, Index const> celestial_to_index;
+  for (auto const& index_celestial : celestials_) {
+    celestial_to_index.emplace(index_celestial.second.get(),
+                               index_celestial.first);
+  }
+  // The celestials and the vessels, which hold the bulk of the data, are
+  // serialized in parallel, each into its own submessage.  The submessages are
+  // created beforehand, since adding to a repeated field is not thread-safe.
+  std::vector<std::function<void()>> tasks;
+  for (auto const& index_celestial : celestials_) {
+    Index const index = index_celestial.first;
+    not_null<Celestial const*> const celestial = index_celestial.second.get();
+    auto const celestial_message = message->add_celestial();
+    celestial_message->set_index(index);
+    not_null<serialization::Celestial*> const shard =
+        celestial_message->mutable_celestial();
+    tasks.emplace_back([celestial, shard, since]() {
+      if (since == nullptr) {
+        celestial->WriteToMessage(shard);
+      } else {
+        celestial->WriteDeltaToMessage(*since, shard);
+      }
+    });
+    if (celestial->has_parent()) {
+      Index const parent_index =
+          FindOrDie(celestial_to_index, celestial->parent());
+      celestial_message->set_parent_index(parent_index);
+    }
+  }
+  std::map<not_null<Vessel const*>, GUID const> vessel_to_guid;
+  for (auto const& guid_vessel : vessels_) {
+    std::string const& guid = guid_vessel.first;
+    not_null<Vessel*> const vessel = guid_vessel.second.get();
+    vessel_to_guid.emplace(vessel, guid);
+    auto* const vessel_message = message->add_vessel();
+    vessel_message->set_guid(guid);
+    not_null<serialization::Vessel*> const shard =
+        vessel_message->mutable_vessel();
+    tasks.emplace_back([vessel, shard, since]() {
+      if (since == nullptr) {
+        vessel->WriteToMessage(shard);
+      } else {
+        vessel->WriteDeltaToMessage(*since, shard);
+      }
+    });
+    Index const parent_index = FindOrDie(celestial_to_index, vessel->parent());
+    vessel_message->set_parent_index(parent_index);
+    vessel_message->set_dirty(is_dirty(vessel));
+  }
+  not_null<serialization::Ephemeris*> const ephemeris_message =
+      message->mutable_ephemeris();
+  tasks.emplace_back([this, ephemeris_message, since]() {
+    if (since == nullptr) {
+      ephemeris_->WriteToMessage(ephemeris_message);
+    } else {
+      ephemeris_->WriteTailToMessage(*since, ephemeris_message);
+    }
+  });
+  RunInParallel(tasks, serialization_thread_pool_.get());
+
+  bubble_->WriteToMessage(
+      [&vessel_to_guid](not_null<Vessel const*> const vessel) -> GUID {
+        return FindOrDie(vessel_to_guid, vessel);
+      },
+      message->mutable_bubble());
+
+  planetarium_rotation_.WriteToMessage(message->mutable_planetarium_rotation());
+  current_time_.WriteToMessage(message->mutable_current_time());
+  Index const sun_index = FindOrDie(celestial_to_index, sun_);
+  message->set_sun_index(sun_index);
+}
+
 Instant const& Plugin::HistoryTime() const {
   return sun_->history().last().time();
 }
@@ -605,6 +1023,9 @@ void Plugin::CleanUpVessels() {
       if (dirty_vessels_.erase(vessel)) {
         LOG(INFO) << "Vessel was dirty";
       }
+      if (batched_predictions_.erase(it->first)) {
+        LOG(INFO) << "Vessel had a batched prediction";
+      }
       // |std::map::erase| invalidates its parameter so we post-increment.
       vessels_.erase(it++);
     }
@@ -631,16 +1052,14 @@ void Plugin::CheckVesselInvariants(
 
 void Plugin::EvolveHistories(Instant const& t) {
   VLOG(1) << __FUNCTION__ << '\n' << NAMED(t);
-  // Integration with a constant step.
-  NBodySystem<Barycentric>::Trajectories trajectories;
+  // Integration with a constant step.  The histories end at the last multiple
+  // of |Δt_| before |t|.
+  Instant const history_time =
+      HistoryTime() + std::floor((t - HistoryTime()) / Δt_) * Δt_;
+  Ephemeris<Barycentric>::Trajectories trajectories;
   // NOTE(egg): This may be too large, vessels that are not new and in the
   // physics bubble or dirty will not be added.
-  trajectories.reserve(vessels_.size() - unsynchronized_vessels_.size() +
-                       celestials_.size());
-  for (auto const& pair : celestials_) {
-    not_null<std::unique_ptr<Celestial>> const& celestial = pair.second;
-    trajectories.push_back(celestial->mutable_history());
-  }
+  trajectories.reserve(vessels_.size() - unsynchronized_vessels_.size());
   for (auto const& pair : vessels_) {
     not_null<Vessel*> const vessel = pair.second.get();
     if (vessel->is_synchronized() &&
@@ -651,12 +1070,20 @@ void Plugin::EvolveHistories(Instant const& t) {
   }
   VLOG(1) << "Starting the evolution of the histories" << '\n'
           << "from : " << HistoryTime();
-  n_body_system_->Integrate(*history_integrator_,  // integrator
-                            t,                     // tmax
-                            Δt_,                   // Δt
-                            0,                     // sampling_period
-                            false,                 // tmax_is_exact
-                            trajectories);         // trajectories
+  ephemeris_->Prolong(history_time);
+  ephemeris_->FlowWithFixedStep(*history_integrator_,  // integrator
+                                history_time,          // tmax
+                                Δt_,                   // Δt
+                                0,                     // sampling_period
+                                true,                  // tmax_is_exact
+                                trajectories);         // trajectories
+  for (auto const& pair : celestials_) {
+    not_null<std::unique_ptr<Celestial>> const& celestial = pair.second;
+    celestial->mutable_history()->Append(
+        history_time,
+        ephemeris_->EvaluateDegreesOfFreedom(&celestial->body(),
+                                             history_time));
+  }
   CHECK_GE(HistoryTime(), current_time_);
   VLOG(1) << "Evolved the histories" << '\n'
           << "to   : " << HistoryTime();
@@ -664,13 +1091,9 @@ void Plugin::EvolveHistories(Instant const& t) {
 
 void Plugin::SynchronizeNewVesselsAndCleanDirtyVessels() {
   VLOG(1) << __FUNCTION__;
-  NBodySystem<Barycentric>::Trajectories trajectories;
-  trajectories.reserve(celestials_.size() + unsynchronized_vessels_.size() +
+  Ephemeris<Barycentric>::Trajectories trajectories;
+  trajectories.reserve(unsynchronized_vessels_.size() + dirty_vessels_.size() +
                        bubble_->size());
-  for (auto const& pair : celestials_) {
-    not_null<std::unique_ptr<Celestial>> const& celestial = pair.second;
-    trajectories.push_back(celestial->mutable_prolongation());
-  }
   for (not_null<Vessel*> const vessel : unsynchronized_vessels_) {
     if (!bubble_->contains(vessel)) {
       trajectories.push_back(vessel->mutable_prolongation());
@@ -686,12 +1109,12 @@ void Plugin::SynchronizeNewVesselsAndCleanDirtyVessels() {
   }
   VLOG(1) << "Starting the synchronization of the new vessels"
           << (bubble_->empty() ? "" : " and of the bubble");
-  n_body_system_->Integrate(*prolongation_integrator_,  // integrator
-                            HistoryTime(),              // tmax
-                            Δt_,                        // Δt
-                            0,                          // sampling_period
-                            true,                       // tmax_is_exact
-                            trajectories);              // trajectories
+  ephemeris_->FlowWithFixedStep(*prolongation_integrator_,  // integrator
+                                HistoryTime(),              // tmax
+                                Δt_,                        // Δt
+                                0,                          // sampling_period
+                                true,                       // tmax_is_exact
+                                trajectories);              // trajectories
   if (!bubble_->empty()) {
     SynchronizeBubbleHistories();
   }
@@ -741,22 +1164,30 @@ void Plugin::ResetProlongations() {
     not_null<std::unique_ptr<Vessel>> const& vessel = pair.second;
     vessel->ResetProlongation(HistoryTime());
   }
+  Instant const history_time = HistoryTime();
   for (auto const& pair : celestials_) {
     not_null<std::unique_ptr<Celestial>> const& celestial = pair.second;
-    celestial->ResetProlongation(HistoryTime());
+    celestial->ResetProlongation(history_time);
+    // Forget all the points of the history but the last one, where the
+    // prolongation is forked.  Since |ForgetBefore| also forgets the point at
+    // the given time, this is done at the time of the penultimate point.
+    auto it = celestial->history().first();
+    if (it.time() < history_time) {
+      Instant penultimate_time = it.time();
+      for (++it; it.time() < history_time; ++it) {
+        penultimate_time = it.time();
+      }
+      celestial->mutable_history()->ForgetBefore(penultimate_time);
+    }
   }
   VLOG(1) << "Prolongations have been reset";
 }
 
 void Plugin::EvolveProlongationsAndBubble(Instant const& t) {
   VLOG(1) << __FUNCTION__ << '\n' << NAMED(t);
-  NBodySystem<Barycentric>::Trajectories trajectories;
-  trajectories.reserve(vessels_.size() + celestials_.size() -
-                       bubble_->number_of_vessels() + bubble_->size());
-  for (auto const& pair : celestials_) {
-    not_null<std::unique_ptr<Celestial>> const& celestial = pair.second;
-    trajectories.push_back(celestial->mutable_prolongation());
-  }
+  Ephemeris<Barycentric>::Trajectories trajectories;
+  trajectories.reserve(vessels_.size() - bubble_->number_of_vessels() +
+                       bubble_->size());
   for (auto const& pair : vessels_) {
     not_null<Vessel*> const vessel = pair.second.get();
     if (!bubble_->contains(vessel)) {
@@ -768,14 +1199,21 @@ void Plugin::EvolveProlongationsAndBubble(Instant const& t) {
   }
   VLOG(1) << "Evolving prolongations"
           << (bubble_->empty() ? "" : " and bubble") << '\n'
-          << "from : " << trajectories.front()->last().time() << '\n'
+          << "from : " << sun_->prolongation().last().time() << '\n'
           << "to   : " << t;
-  n_body_system_->Integrate(*prolongation_integrator_,  // integrator
-                            t,                          // tmax
-                            Δt_,                        // Δt
-                            0,                          // sampling_period
-                            true,                       // tmax_is_exact
-                            trajectories);              // trajectories
+  ephemeris_->Prolong(t);
+  ephemeris_->FlowWithFixedStep(*prolongation_integrator_,  // integrator
+                                t,                          // tmax
+                                Δt_,                        // Δt
+                                0,                          // sampling_period
+                                true,                       // tmax_is_exact
+                                trajectories);              // trajectories
+  for (auto const& pair : celestials_) {
+    not_null<std::unique_ptr<Celestial>> const& celestial = pair.second;
+    celestial->mutable_prolongation()->Append(
+        t,
+        ephemeris_->EvaluateDegreesOfFreedom(&celestial->body(), t));
+  }
   if (!bubble_->empty()) {
     DegreesOfFreedom<Barycentric> const& centre_of_mass =
         bubble_->centre_of_mass_trajectory().last().degrees_of_freedom();
@@ -792,29 +1230,339 @@ void Plugin::EvolveProlongationsAndBubble(Instant const& t) {
 void Plugin::UpdatePredictions() {
   DeletePredictions();
   if (has_predicted_vessel()) {
-    NBodySystem<Barycentric>::Trajectories predictions;
-    // Room for all the celestials and for the vessel.
-    predictions.reserve(celestials_.size() + 1);
-    for (auto const& index_celestial : celestials_) {
-      auto const& celestial = index_celestial.second;
-      celestial->ForkPrediction();
-      predictions.emplace_back(celestial->mutable_prediction());
+    ++requested_prediction_generation_;
+    // The ephemeris is prolonged here rather than in |ComputePrediction| so
+    // that an asynchronous prediction does not integrate the celestials while
+    // holding the lock of the |ephemeris_|.
+    ephemeris_->Prolong(current_time_ + prediction_length_);
+    auto const last = predicted_vessel_->prolongation().last();
+    if (asynchronous_predictions_) {
+      // Collect the prediction that has completed, if any, and start a new one
+      // if none is running.  There is at most one asynchronous prediction at a
+      // time, so the requests made while it runs are only served by the next
+      // one.
+      if (pending_prediction_.valid() &&
+          pending_prediction_.wait_for(std::chrono::seconds(0)) ==
+              std::future_status::ready) {
+        Prediction prediction = pending_prediction_.get();
+        if (prediction.generation >= first_prediction_generation_) {
+          completed_prediction_ =
+              std::make_unique<Prediction>(std::move(prediction));
+        }
+      }
+      if (!pending_prediction_.valid()) {
+        // The completed prediction is still needed here until the new one
+        // completes, so the computation gets a copy.
+        std::unique_ptr<Prediction> previous;
+        if (completed_prediction_ != nullptr &&
+            IsConsistentWithPrediction(*completed_prediction_,
+                                       last.time(),
+                                       last.degrees_of_freedom())) {
+          previous = std::make_unique<Prediction>(*completed_prediction_);
+        }
+        pending_prediction_time_ =
+            previous == nullptr ? last.time() : previous->times.front();
+        pending_prediction_ = std::async(std::launch::async,
+                                         &Plugin::ComputePrediction,
+                                         this,
+                                         requested_prediction_generation_,
+                                         last.time(),
+                                         last.degrees_of_freedom(),
+                                         prediction_length_,
+                                         prediction_step_,
+                                         prediction_length_tolerance_,
+                                         prediction_speed_tolerance_,
+                                         std::move(previous));
+      }
+    } else {
+      std::unique_ptr<Prediction> previous;
+      if (completed_prediction_ != nullptr &&
+          IsConsistentWithPrediction(*completed_prediction_,
+                                     last.time(),
+                                     last.degrees_of_freedom())) {
+        previous = std::move(completed_prediction_);
+      }
+      completed_prediction_ = std::make_unique<Prediction>(
+          ComputePrediction(requested_prediction_generation_,
+                            last.time(),
+                            last.degrees_of_freedom(),
+                            prediction_length_,
+                            prediction_step_,
+                            prediction_length_tolerance_,
+                            prediction_speed_tolerance_,
+                            std::move(previous)));
     }
-    predicted_vessel_->ForkPrediction();
-    predictions.emplace_back(predicted_vessel_->mutable_prediction());
-    n_body_system_->Integrate(
+  }
+  std::vector<BatchedPredictions> const batched_predictions =
+      ComputeBatchedPredictions();
+  if (completed_prediction_ != nullptr || !batched_predictions.empty()) {
+    ForkPredictions(completed_prediction_.get(), batched_predictions);
+  }
+}
+
+std::vector<Plugin::BatchedPredictions>
+Plugin::ComputeBatchedPredictions() const {
+  // The vessels and the lengths of their predictions, grouped by step.
+  std::map<Time, std::vector<std::pair<not_null<Vessel*>, Time>>>
+      vessels_by_step;
+  for (auto const& pair : batched_predictions_) {
+    not_null<Vessel*> const vessel =
+        find_vessel_by_guid_or_die(pair.first).get();
+    if (vessel != predicted_vessel_) {
+      BatchedPredictionParameters const& parameters = pair.second;
+      vessels_by_step[parameters.step].emplace_back(vessel, parameters.length);
+    }
+  }
+
+  std::vector<BatchedPredictions> result;
+  for (auto const& step_vessels : vessels_by_step) {
+    Time const& step = step_vessels.first;
+    auto const& vessels_and_lengths = step_vessels.second;
+    Time length;
+    for (auto const& vessel_and_length : vessels_and_lengths) {
+      length = std::max(length, vessel_and_length.second);
+    }
+
+    // All the vessels are integrated by a single flow, in which the positions
+    // of the celestials are evaluated once per step.  The flow requires a
+    // distinct body for each trajectory.  The vector is sized beforehand so
+    // that the bodies don't move.
+    std::vector<MasslessBody> const bodies(vessels_and_lengths.size());
+    std::vector<not_null<std::unique_ptr<Trajectory<Barycentric>>>>
+        trajectories;
+    Ephemeris<Barycentric>::Trajectories flowed_trajectories;
+    for (std::size_t i = 0; i < vessels_and_lengths.size(); ++i) {
+      auto const last = vessels_and_lengths[i].first->prolongation().last();
+      trajectories.push_back(
+          make_not_null_unique<Trajectory<Barycentric>>(&bodies[i]));
+      trajectories.back()->Append(last.time(), last.degrees_of_freedom());
+      flowed_trajectories.push_back(trajectories.back().get());
+    }
+    ephemeris_->FlowWithFixedStep(
         *prolongation_integrator_,
-        current_time_ + prediction_length_,
-        prediction_step_,
+        current_time_ + length,
+        step,
         1,  // sampling_period
         false,  // tmax_is_exact
-        predictions);
+        flowed_trajectories);
+
+    result.emplace_back();
+    BatchedPredictions& predictions = result.back();
+    for (auto it = trajectories.front()->first(); !it.at_end(); ++it) {
+      predictions.times.push_back(it.time());
+    }
+    for (std::size_t i = 0; i < vessels_and_lengths.size(); ++i) {
+      Instant const tmax = current_time_ + vessels_and_lengths[i].second;
+      std::vector<DegreesOfFreedom<Barycentric>>& degrees_of_freedom =
+          predictions.vessel_degrees_of_freedom[vessels_and_lengths[i].first];
+      for (auto it = trajectories[i]->first();
+           !it.at_end() && it.time() <= tmax;
+           ++it) {
+        degrees_of_freedom.push_back(it.degrees_of_freedom());
+      }
+    }
   }
+  return result;
+}
+
+Plugin::Prediction Plugin::ComputePrediction(
+    std::int64_t const generation,
+    Instant const& initial_time,
+    DegreesOfFreedom<Barycentric> const& initial_state,
+    Time const& length,
+    Time const& step,
+    Length const& length_tolerance,
+    Speed const& speed_tolerance,
+    std::unique_ptr<Prediction> previous) const {
+  Prediction prediction;
+  if (previous == nullptr) {
+    prediction.times.push_back(initial_time);
+    prediction.vessel_degrees_of_freedom.push_back(initial_state);
+  } else {
+    // Keep the points of |previous| from the last one at or before
+    // |initial_time|, which is needed to interpolate the prediction at later
+    // times, and up to |initial_time + length|.
+    prediction = std::move(*previous);
+    std::vector<Instant> const& times = prediction.times;
+    std::size_t const begin =
+        std::upper_bound(times.begin(), times.end(), initial_time) -
+        times.begin() - 1;
+    std::size_t const end =
+        std::upper_bound(times.begin() + begin + 1,
+                         times.end(),
+                         initial_time + length) - times.begin();
+    auto const truncate = [begin, end](auto* const values) {
+      values->erase(values->begin() + end, values->end());
+      values->erase(values->begin(), values->begin() + begin);
+    };
+    truncate(&prediction.times);
+    truncate(&prediction.vessel_degrees_of_freedom);
+    for (auto& pair : prediction.celestial_degrees_of_freedom) {
+      truncate(&pair.second);
+    }
+  }
+  prediction.generation = generation;
+  prediction.step = step;
+  prediction.length_tolerance = length_tolerance;
+  prediction.speed_tolerance = speed_tolerance;
+
+  Instant const tmax = initial_time + length;
+  if (prediction.times.back() < tmax) {
+    MasslessBody const body;
+    Trajectory<Barycentric> trajectory(&body);
+    trajectory.Append(prediction.times.back(),
+                      prediction.vessel_degrees_of_freedom.back());
+    if (length_tolerance == Length()) {
+      ephemeris_->FlowWithFixedStep(
+          *prolongation_integrator_,
+          tmax,
+          step,
+          1,  // sampling_period
+          false,  // tmax_is_exact
+          {&trajectory});
+    } else {
+      ephemeris_->FlowWithAdaptiveStep(
+          *prediction_integrator_,
+          tmax,
+          step,  // first_time_step
+          length_tolerance,
+          speed_tolerance,
+          {&trajectory});
+    }
+    auto it = trajectory.first();
+    for (++it; !it.at_end(); ++it) {
+      prediction.times.push_back(it.time());
+      prediction.vessel_degrees_of_freedom.push_back(it.degrees_of_freedom());
+    }
+  }
+
+  // The predictions of the celestials are sampled at the same times as that
+  // of the vessel.  Only the new points need to be evaluated.
+  for (auto const& index_celestial : celestials_) {
+    not_null<MassiveBody const*> const body = &index_celestial.second->body();
+    std::vector<DegreesOfFreedom<Barycentric>>& degrees_of_freedom =
+        prediction.celestial_degrees_of_freedom[index_celestial.first];
+    degrees_of_freedom.reserve(prediction.times.size());
+    for (std::size_t i = degrees_of_freedom.size();
+         i < prediction.times.size();
+         ++i) {
+      degrees_of_freedom.push_back(
+          ephemeris_->EvaluateDegreesOfFreedom(body, prediction.times[i]));
+    }
+  }
+  return prediction;
+}
+
+bool Plugin::IsConsistentWithPrediction(
+    Prediction const& prediction,
+    Instant const& time,
+    DegreesOfFreedom<Barycentric> const& degrees_of_freedom) const {
+  if (incremental_prediction_length_tolerance_ == Length() ||
+      prediction.step != prediction_step_ ||
+      prediction.length_tolerance != prediction_length_tolerance_ ||
+      prediction.speed_tolerance != prediction_speed_tolerance_ ||
+      time < prediction.times.front() ||
+      time > prediction.times.back()) {
+    return false;
+  }
+  DegreesOfFreedom<Barycentric> const interpolated =
+      HermiteInterpolation(prediction.times,
+                           prediction.vessel_degrees_of_freedom,
+                           time);
+  return (interpolated.position() - degrees_of_freedom.position()).Norm() <=
+             incremental_prediction_length_tolerance_ &&
+         (interpolated.velocity() - degrees_of_freedom.velocity()).Norm() <=
+             incremental_prediction_speed_tolerance_;
+}
+
+void Plugin::ForkPredictions(
+    Prediction const* const prediction,
+    std::vector<BatchedPredictions> const& batched_predictions) {
+  CHECK(!HasPredictions());
+  // The times of the points of all the predictions.
+  std::vector<Instant> times;
+  // The index of the first point of |prediction| which is appended.
+  std::size_t first = 0;
+  if (prediction != nullptr) {
+    predicted_vessel_->ForkPrediction();
+    Instant const& fork_time = *predicted_vessel_->prediction().fork_time();
+    // The prediction may have been computed from an earlier state of the
+    // vessel, in which case its beginning is skipped.
+    first = std::upper_bound(prediction->times.begin(),
+                             prediction->times.end(),
+                             fork_time) -
+            prediction->times.begin();
+    for (std::size_t i = first; i < prediction->times.size(); ++i) {
+      predicted_vessel_->mutable_prediction()->Append(
+          prediction->times[i],
+          prediction->vessel_degrees_of_freedom[i]);
+    }
+    times.insert(times.end(),
+                 prediction->times.begin() + first,
+                 prediction->times.end());
+    rendered_prediction_generation_ = prediction->generation;
+  }
+  for (auto const& predictions : batched_predictions) {
+    // The first point is the end of the prolongations.
+    for (auto const& pair : predictions.vessel_degrees_of_freedom) {
+      not_null<Vessel*> const vessel = pair.first;
+      std::vector<DegreesOfFreedom<Barycentric>> const& degrees_of_freedom =
+          pair.second;
+      vessel->ForkPrediction();
+      for (std::size_t i = 1; i < degrees_of_freedom.size(); ++i) {
+        vessel->mutable_prediction()->Append(predictions.times[i],
+                                             degrees_of_freedom[i]);
+      }
+    }
+    times.insert(times.end(),
+                 predictions.times.begin() + 1,
+                 predictions.times.end());
+  }
+  std::sort(times.begin(), times.end());
+  times.erase(std::unique(times.begin(), times.end()), times.end());
+
+  // The degrees of freedom of the celestials are taken from |prediction| when
+  // it has them, and are evaluated otherwise.  The batched predictions that
+  // have the same step share their times, so the number of evaluations does
+  // not depend on the number of vessels.
+  for (auto const& index_celestial : celestials_) {
+    auto const& celestial = index_celestial.second;
+    not_null<MassiveBody const*> const body = &celestial->body();
+    std::vector<DegreesOfFreedom<Barycentric>> const* const
+        degrees_of_freedom =
+            prediction == nullptr
+                ? nullptr
+                : &FindOrDie(prediction->celestial_degrees_of_freedom,
+                             index_celestial.first);
+    celestial->ForkPrediction();
+    std::size_t j = first;
+    for (Instant const& time : times) {
+      if (prediction != nullptr &&
+          j < prediction->times.size() &&
+          prediction->times[j] == time) {
+        celestial->mutable_prediction()->Append(time,
+                                                (*degrees_of_freedom)[j]);
+        ++j;
+      } else {
+        celestial->mutable_prediction()->Append(
+            time,
+            ephemeris_->EvaluateDegreesOfFreedom(body, time));
+      }
+    }
+  }
+}
+
+RenderingTransforms::Evaluator Plugin::CelestialHistoryEvaluator() const {
+  return [this](MobileInterface const& mobile,
+                Instant const& t) -> DegreesOfFreedom<Barycentric> {
+    // The references of the |RenderingTransforms| are celestials.
+    return ephemeris_->EvaluateDegreesOfFreedom(
+               &static_cast<Celestial const&>(mobile).body(), t);
+  };
 }
 
 RenderedTrajectory<World> Plugin::RenderTrajectory(
-    not_null<Body const*> const body,
-    Trajectory<Barycentric>::TransformingIterator<Rendering> const& actual_it,
+    std::vector<Position<Rendering>> const& intermediate_positions,
     not_null<RenderingTransforms*> const transforms,
     Position<World> const& sun_world_position) const {
   RenderedTrajectory<World> result;
@@ -823,30 +1571,24 @@ RenderedTrajectory<World> Plugin::RenderTrajectory(
           sun_->prolongation().last().degrees_of_freedom().position(),
           sun_world_position,
           OrthogonalMap<WorldSun, World>::Identity() * BarycentricToWorldSun());
+  // The second transform is the same for all points, it is applied when
+  // building the result.
+  auto const to_apparent = transforms->second_position_map();
 
-  // First build the trajectory resulting from the first transform.
-  Trajectory<Rendering> intermediate_trajectory(body);
-  for (auto it = actual_it; !it.at_end(); ++it) {
-    intermediate_trajectory.Append(it.time(), it.degrees_of_freedom());
-  }
-
-  // Then build the apparent trajectory using the second transform.
-  Trajectory<Barycentric> apparent_trajectory(body);
-  for (auto intermediate_it = transforms->second(intermediate_trajectory);
-       !intermediate_it.at_end();
-       ++intermediate_it) {
-    apparent_trajectory.Append(intermediate_it.time(),
-                               intermediate_it.degrees_of_freedom());
-  }
-
-  // Finally use the apparent trajectory to build the result.
-  auto initial_it = apparent_trajectory.first();
-  if (!initial_it.at_end()) {
-    for (auto final_it = initial_it;
-         ++final_it, !final_it.at_end();
-         initial_it = final_it) {
-      result.emplace_back(to_world(initial_it.degrees_of_freedom().position()),
-                          to_world(final_it.degrees_of_freedom().position()));
+  // Both maps are isometries, so the vertices which are not needed to stay
+  // within |rendering_tolerance_| may be dropped before applying them.
+  std::vector<bool> const keep =
+      VerticesToKeep(intermediate_positions, rendering_tolerance_);
+  if (!intermediate_positions.empty()) {
+    Position<World> initial =
+        to_world(to_apparent(intermediate_positions.front()));
+    for (std::size_t i = 1; i < intermediate_positions.size(); ++i) {
+      if (keep[i]) {
+        Position<World> const final =
+            to_world(to_apparent(intermediate_positions[i]));
+        result.emplace_back(initial, final);
+        initial = final;
+      }
     }
   }
   VLOG(1) << "Returning a " << result.size() << "-segment trajectory";
@@ -1,5 +1,7 @@
 ﻿#pragma once
 
+#include <cstdint>
+#include <future>  // NOLINT(build/c++11)
 #include <map>
 #include <memory>
 #include <set>
@@ -8,6 +10,7 @@
 #include <vector>
 
 #include "base/monostable.hpp"
+#include "base/thread_pool.hpp"
 #include "geometry/named_quantities.hpp"
 #include "geometry/point.hpp"
 #include "gtest/gtest.h"
@@ -16,7 +19,7 @@
 #include "ksp_plugin/physics_bubble.hpp"
 #include "ksp_plugin/vessel.hpp"
 #include "physics/body.hpp"
-#include "physics/n_body_system.hpp"
+#include "physics/ephemeris.hpp"
 #include "physics/trajectory.hpp"
 #include "physics/transforms.hpp"
 #include "quantities/quantities.hpp"
@@ -27,19 +30,23 @@
 namespace principia {
 namespace ksp_plugin {
 
+using base::ThreadPool;
 using geometry::Displacement;
 using geometry::Instant;
 using geometry::Point;
 using geometry::Rotation;
 using integrators::SPRKIntegrator;
 using physics::Body;
+using physics::Ephemeris;
 using physics::FrameField;
-using physics::NBodySystem;
 using physics::Trajectory;
 using physics::Transforms;
 using quantities::Angle;
 using si::Second;
 using si::Hour;
+using si::Metre;
+using si::Milli;
+using si::Minute;
 
 // The GUID of a vessel, obtained by |v.id.ToString()| in C#. We use this as a
 // key in an |std::map|.
@@ -110,7 +117,8 @@ class Plugin {
     Index const parent_index,
     RelativeDegreesOfFreedom<AliceSun> const& from_parent);
 
-  // Ends initialization.
+  // Ends initialization.  Creates the |ephemeris_| of the celestials from their
+  // states at |current_time_|, unless it was deserialized.
   virtual void EndInitialization();
 
   // Sets the parent of the celestial body with index |celestial_index| to the
@@ -161,10 +169,16 @@ class Plugin {
   // degrees.
   virtual void AdvanceTime(Instant const& t, Angle const& planetarium_rotation);
 
-  // Forgets the histories of the |celestials_| and of the synchronized vessels
-  // before |t|.
+  // Forgets the histories of the |celestials_| and of the synchronized vessels,
+  // and the |ephemeris_|, before |t|.
   virtual void ForgetAllHistoriesBefore(Instant const& t) const;
 
+  // Archives the histories of the |celestials_| and of the synchronized
+  // vessels before |t| to memory-mapped temporary files in |directory|, so
+  // that the memory used by old histories stays bounded.
+  virtual void ArchiveAllHistoriesBefore(Instant const& t,
+                                         std::string const& directory) const;
+
   // Returns the displacement and velocity of the vessel with GUID |vessel_guid|
   // relative to its parent at current time. For a KSP |Vessel| |v|, the
   // argument corresponds to  |v.id.ToString()|, the return value to
@@ -212,9 +226,86 @@ class Plugin {
 
   virtual void set_prediction_length(Time const& t);
 
-  // The step used when computing the prediction.
+  // The rendered trajectories only have the vertices needed for the line to be
+  // within |tolerance| of all the points of the trajectory in |World|, so that
+  // their number of segments depends on how much they curve rather than on
+  // how long they are.  The default is zero, which keeps all the points.
+  virtual void set_rendering_tolerance(Length const& tolerance);
+
+  // The step used when computing the prediction.  With adaptive steps, the
+  // length of the first step attempted.
   virtual void set_prediction_step(Time const& t);
 
+  // If both tolerances are positive, the prediction is computed with an
+  // adaptive step which keeps the local errors in position and velocity below
+  // them; this is much cheaper than a constant step for orbits with close
+  // approaches.  If both are zero, the prediction is computed with the
+  // constant step |prediction_step_|, which is the default.
+  virtual void set_prediction_tolerances(Length const& length_tolerance,
+                                         Speed const& speed_tolerance);
+
+  // If |asynchronous|, the predictions are computed on another thread from the
+  // state of the |predicted_vessel_| when they are requested, and
+  // |AdvanceTime()| does not wait for them: |RenderedPrediction()| returns the
+  // latest prediction that has completed, which may be stale.  Otherwise, the
+  // predictions are computed by |AdvanceTime()|, which is the default.
+  virtual void set_asynchronous_predictions(bool const asynchronous);
+
+  // If both tolerances are positive, a new prediction reuses the previous one
+  // if it was computed with the same step and integration tolerances, and if,
+  // interpolated at the end of the prolongation of the |predicted_vessel_|, it
+  // is within these tolerances of that prolongation: only the part beyond its
+  // end is integrated.  This is much cheaper than computing the prediction
+  // from scratch when the vessel is not accelerating.  If both tolerances are
+  // zero, which is the default, the predictions are always computed from
+  // scratch.
+  virtual void set_incremental_prediction_tolerances(
+      Length const& length_tolerance,
+      Speed const& speed_tolerance);
+
+  // Each call to |AdvanceTime()| while there is a |predicted_vessel_| requests
+  // a new prediction; |requested_prediction_generation()| is the number of
+  // such requests.  |rendered_prediction_generation()| is the number of the
+  // request for which the prediction returned by |RenderedPrediction()| was
+  // computed, or 0 if there is no such prediction.  The prediction is stale if
+  // the latter is less than the former, which only happens with asynchronous
+  // predictions.
+  virtual std::int64_t requested_prediction_generation() const;
+  virtual std::int64_t rendered_prediction_generation() const;
+
+  // Adds the vessel with GUID |vessel_guid| to the vessels whose predictions
+  // are computed by |AdvanceTime()| in addition to that of the
+  // |predicted_vessel_|, with the given |length| and constant |step|; if it is
+  // already there, replaces its parameters.  The batched vessels that have the
+  // same step are integrated in a single pass, and the celestials are only
+  // evaluated once per step for all of them, so that the cost of the
+  // predictions is proportional to the number of vessels.  The parameters of
+  // the |predicted_vessel_| are ignored, its prediction is the one computed
+  // for |RenderedPrediction()|.  A vessel with GUID |vessel_guid| must have
+  // been inserted and kept.
+  virtual void AddVesselToBatchedPredictions(GUID const& vessel_guid,
+                                             Time const& length,
+                                             Time const& step);
+  // Removes the vessel with GUID |vessel_guid|, which must have been added by
+  // |AddVesselToBatchedPredictions()|, from the batched predictions.  The
+  // vessels that are not kept are removed by |AdvanceTime()|.
+  virtual void RemoveVesselFromBatchedPredictions(GUID const& vessel_guid);
+
+  // Returns a polygon in |World| space depicting the prediction of the vessel
+  // with GUID |vessel_guid|, which must have been added by
+  // |AddVesselToBatchedPredictions()|, as for |RenderedPrediction()|.  The
+  // polygon is empty if |AdvanceTime()| has not been called since the vessel
+  // was added, or since the |predicted_vessel_| was changed.  Not const for
+  // the same reason as |RenderedPrediction()|.
+  virtual RenderedTrajectory<World> RenderedBatchedPrediction(
+      GUID const& vessel_guid,
+      not_null<RenderingTransforms*> const transforms,
+      Position<World> const& sun_world_position);
+
+  // The number of threads used to compute the accelerations of the vessels.
+  // This does not affect the results.  The default is 1.
+  virtual void set_number_of_threads(int const number_of_threads);
+
   virtual bool has_vessel(GUID const& vessel_guid) const;
 
   virtual not_null<std::unique_ptr<RenderingTransforms>>
@@ -271,6 +362,22 @@ class Plugin {
   static std::unique_ptr<Plugin> ReadFromMessage(
       serialization::Plugin const& message);
 
+  // Writes the changes since the plugin was saved at |since|, which is the
+  // |current_time()| at which |WriteToMessage| or |WriteDeltaToMessage| was
+  // called.  The size of the histories in |message| only depends on the
+  // amount of history computed since |since|.  Must be called after
+  // initialization.
+  virtual void WriteDeltaToMessage(
+      Instant const& since,
+      not_null<serialization::PluginDelta*> const message) const;
+  // Replays |delta| on |message|, which must be the save from which |delta|
+  // was computed, or the result of replaying the previous deltas on it.  Any
+  // points forgotten since the save are kept.  Replaying decodes and reencodes
+  // the histories of |message|.
+  static void MergeDeltaIntoMessage(
+      serialization::PluginDelta const& delta,
+      not_null<serialization::Plugin*> const message);
+
  private:
   using GUIDToOwnedVessel = std::map<GUID, not_null<std::unique_ptr<Vessel>>>;
   using GUIDToUnownedVessel = std::map<GUID, not_null<Vessel*> const>;
@@ -279,11 +386,15 @@ class Plugin {
 
   // This constructor should only be used during deserialization.
   // |unsynchronized_vessels_| is initialized consistently.  All vessels are
-  // added to |kept_vessels_|  The resulting plugin is not |initializing_|.
+  // added to |kept_vessels_|  The resulting plugin is not |initializing_|.  If
+  // |ephemeris| is null, it is recomputed from the last points of the histories
+  // of the |celestials|.
   Plugin(GUIDToOwnedVessel vessels,
          IndexToOwnedCelestial celestials,
          std::set<not_null<Vessel*> const> dirty_vessels,
          not_null<std::unique_ptr<PhysicsBubble>> bubble,
+         not_null<std::unique_ptr<ThreadPool>> serialization_thread_pool,
+         std::unique_ptr<Ephemeris<Barycentric>> ephemeris,
          Angle planetarium_rotation,
          Instant current_time,
          Index sun_index);
@@ -299,11 +410,18 @@ class Plugin {
   bool is_dirty(not_null<Vessel*> const vessel) const;
   // Returns |predicted_vessel_ != nullptr|.
   bool has_predicted_vessel() const;
-  // Returns true if there is a |predicted_vessel_| and it has a prediction.
+  // Returns true if the predictions have been forked, in which case the
+  // celestials and some of the vessels have predictions.
   bool HasPredictions() const;
   // Deletes all the predictions.
   void DeletePredictions();
 
+  // Implements |WriteToMessage| if |since| is null, and
+  // |WriteDeltaToMessage(*since, ...)| otherwise.
+  void WritePluginToMessage(
+      Instant const* const since,
+      not_null<serialization::Plugin*> const message) const;
+
   // The common last time of the histories of synchronized vessels and
   // celestials.
   Instant const& HistoryTime() const;
@@ -331,7 +449,9 @@ class Plugin {
   void CheckVesselInvariants(GUIDToOwnedVessel::const_iterator const it) const;
   // Evolves the histories of the |celestials_| and of the synchronized vessels
   // up to at most |t|. |t| must be large enough that at least one step of
-  // size |Δt_| can fit between |current_time_| and |t|.
+  // size |Δt_| can fit between |current_time_| and |t|.  The histories of the
+  // celestials are evaluated from the |ephemeris_|, the vessels are flowed in
+  // its gravitational field.
   void EvolveHistories(Instant const& t);
   // Synchronizes the |unsynchronized_vessels_|, clears
   // |unsynchronized_vessels_|.  Prolongs the histories of the vessels in the
@@ -345,28 +465,115 @@ class Plugin {
   // synchronized and removed from |unsynchronized_vessels_|.
   void SynchronizeBubbleHistories();
   // Resets the prolongations of all vessels and celestials to |HistoryTime()|.
-  // All vessels must satisfy |is_synchronized()|.
+  // All vessels must satisfy |is_synchronized()|.  The histories of the
+  // celestials are then reduced to their last point: the past of the
+  // celestials is evaluated from the |ephemeris_|, whose series take much less
+  // memory than the sampled points.
   void ResetProlongations();
   // Evolves the prolongations of all celestials and vessels up to exactly
   // instant |t|.  Also evolves the trajectory of the |current_physics_bubble_|
   // if there is one.
   void EvolveProlongationsAndBubble(Instant const& t);
-  // Calls |DeletePredictions()|.  If |has_predicted_vessel()|, computes
-  // |system_predictions_| and |prediction_| for the |predicted_vessel_|
-  // according to |prediction_length_| and |prediction_step_|.
+  // Calls |DeletePredictions()|.  If |has_predicted_vessel()|, requests a new
+  // prediction for the |predicted_vessel_| according to |prediction_length_|,
+  // |prediction_step_| and the tolerances.  Computes the batched predictions,
+  // and forks the predictions of the vessels and of the celestials from the
+  // latest prediction of the |predicted_vessel_| that has completed and from
+  // the batched predictions.
   void UpdatePredictions();
 
+  // The result of |ComputePrediction|: the times of the points of the
+  // prediction of a vessel, starting at or before its initial time, and the
+  // degrees of freedom of the vessel and of each celestial at these times.
+  struct Prediction {
+    std::int64_t generation;
+    // The parameters of the integration.
+    Time step;
+    Length length_tolerance;
+    Speed speed_tolerance;
+    std::vector<Instant> times;
+    std::vector<DegreesOfFreedom<Barycentric>> vessel_degrees_of_freedom;
+    std::map<Index, std::vector<DegreesOfFreedom<Barycentric>>>
+        celestial_degrees_of_freedom;
+  };
+
+  // Computes a prediction starting from |initial_state| at |initial_time|
+  // with the given parameters.  If |previous| is not null, it must satisfy
+  // |IsConsistentWithPrediction|, and the result is made of the points of
+  // |previous| from |initial_time| on, followed by a prolongation of
+  // |previous| until |initial_time + length|.  Only uses the |ephemeris_| and
+  // the bodies of the |celestials_|, so it may run on another thread than the
+  // rest of the plugin.
+  Prediction ComputePrediction(
+      std::int64_t const generation,
+      Instant const& initial_time,
+      DegreesOfFreedom<Barycentric> const& initial_state,
+      Time const& length,
+      Time const& step,
+      Length const& length_tolerance,
+      Speed const& speed_tolerance,
+      std::unique_ptr<Prediction> previous) const;
+
+  // Returns true if |prediction| may be reused for a prediction starting from
+  // |degrees_of_freedom| at |time|, according to the incremental prediction
+  // tolerances and to the current prediction parameters.
+  bool IsConsistentWithPrediction(
+      Prediction const& prediction,
+      Instant const& time,
+      DegreesOfFreedom<Barycentric> const& degrees_of_freedom) const;
+
+  // The parameters of the prediction of a vessel in |batched_predictions_|.
+  struct BatchedPredictionParameters {
+    Time length;
+    Time step;
+  };
+
+  // The predictions of the batched vessels that have the same step.  They are
+  // integrated together, so their points are at the same |times|, starting
+  // with the end of the prolongations; the prediction of a vessel has fewer
+  // points if its length is shorter.
+  struct BatchedPredictions {
+    std::vector<Instant> times;
+    std::map<not_null<Vessel*>, std::vector<DegreesOfFreedom<Barycentric>>>
+        vessel_degrees_of_freedom;
+  };
+
+  // Computes the predictions of the vessels of |batched_predictions_| other
+  // than the |predicted_vessel_|, with one integration per distinct step.
+  std::vector<BatchedPredictions> ComputeBatchedPredictions() const;
+
+  // Forks the predictions of the vessels and of the celestials at the end of
+  // their prolongations.  Appends to the prediction of the |predicted_vessel_|
+  // the points of |prediction|, if it is not null, which are after that time,
+  // and to those of the batched vessels the points of |batched_predictions|.
+  // The predictions of the celestials have a point at each of these times.
+  // |!HasPredictions()| must hold.
+  void ForkPredictions(Prediction const* const prediction,
+                       std::vector<BatchedPredictions> const&
+                           batched_predictions);
+
+  // A utility for the factories of |RenderingTransforms|, returns the
+  // evaluator of the reference celestials when transforming the histories:
+  // since the histories of the celestials only hold their last point, their
+  // past is evaluated from the |ephemeris_|.
+  RenderingTransforms::Evaluator CelestialHistoryEvaluator() const;
+
   // A utility for |RenderedPrediction| and |RenderedVesselTrajectory|,
-  // returns a |RenderedTrajectory| as computed by the given |transforms|
-  // from the trajectory of |body| starting at |actual_it|.
+  // returns a |RenderedTrajectory| joining the |intermediate_positions|, which
+  // were computed by the first of the given |transforms|, after applying the
+  // second.
   RenderedTrajectory<World> RenderTrajectory(
-      not_null<Body const*> const body,
-      Trajectory<Barycentric>::TransformingIterator<Rendering> const& actual_it,
+      std::vector<Position<Rendering>> const& intermediate_positions,
       not_null<RenderingTransforms*>const transforms,
       Position<World> const& sun_world_position) const;
 
   // TODO(egg): Constant time step for now.
   Time const Δt_ = 10 * Second;
+  // The celestials move slowly enough that they can be integrated with a longer
+  // step than the vessels.  Their positions are then fitted by Чебышёв series,
+  // which take much less memory than the integrated points.
+  Time const ephemeris_step_ = 1 * Minute;
+  Length const ephemeris_fitting_tolerance_ = 1 * Milli(Metre);
 
   GUIDToOwnedVessel vessels_;
   IndexToOwnedCelestial celestials_;
@@ -384,18 +591,47 @@ class Plugin {
   // The vessels that will be kept during the next call to |AdvanceTime|.
   std::set<not_null<Vessel const*> const> kept_vessels_;
 
-  // Only one prediction for now, using constant timestep.
-  Vessel* predicted_vessel_;
+  // The vessel whose prediction is rendered by |RenderedPrediction()|.
+  Vessel* predicted_vessel_ = nullptr;
   Time prediction_length_ = 1 * Hour;
   Time prediction_step_ = Δt_;
+  Length rendering_tolerance_;
+  // Zero if the prediction uses a constant timestep.
+  Length prediction_length_tolerance_;
+  Speed prediction_speed_tolerance_;
+  bool asynchronous_predictions_ = false;
+  // Zero if the predictions are always computed from scratch.
+  Length incremental_prediction_length_tolerance_;
+  Speed incremental_prediction_speed_tolerance_;
+  std::int64_t requested_prediction_generation_ = 0;
+  std::int64_t rendered_prediction_generation_ = 0;
+  // The predictions of generations before this one were not computed for the
+  // current |predicted_vessel_|.
+  std::int64_t first_prediction_generation_ = 1;
+  // The latest prediction that has completed, if any.
+  std::unique_ptr<Prediction> completed_prediction_;
+  // The vessels whose predictions are computed in a batch.
+  std::map<GUID, BatchedPredictionParameters> batched_predictions_;
 
   not_null<std::unique_ptr<PhysicsBubble>> const bubble_;
 
-  not_null<std::unique_ptr<NBodySystem<Barycentric>>> n_body_system_;
+  // The threads on which the celestials and vessels are serialized.  They are
+  // started once, rather than for each save.
+  not_null<std::unique_ptr<ThreadPool>> const serialization_thread_pool_;
+
+  // The trajectories of the celestials, from which their histories,
+  // prolongations and predictions are evaluated.  It spans the histories of
+  // the vessels, which are rendered in the frames of the celestials by
+  // evaluating it.  Null during initialization.
+  std::unique_ptr<Ephemeris<Barycentric>> ephemeris_;
+  // The number of threads used by the |ephemeris_|.
+  int number_of_threads_ = 1;
   // The symplectic integrator computing the synchronized histories.
   not_null<SRKNIntegrator const*> const history_integrator_;
   // The integrator computing the prolongations.
   not_null<SRKNIntegrator const*> const prolongation_integrator_;
+  // The integrator computing the predictions when the step is adaptive.
+  not_null<EmbeddedRKNIntegrator const*> const prediction_integrator_;
 
   // Whether initialization is ongoing.
   base::Monostable initializing_;
@@ -406,6 +642,12 @@ class Plugin {
 
   not_null<Celestial*> const sun_;  // Not owning.
 
+  // The asynchronous prediction being computed, if |valid()|, and its initial
+  // time.  It reads the |ephemeris_| and the |celestials_|, so it must be
+  // destroyed, and therefore completed, first.
+  std::future<Prediction> pending_prediction_;
+  Instant pending_prediction_time_;
+
   friend class TestablePlugin;
 };
 
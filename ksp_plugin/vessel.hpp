@@ -93,6 +93,12 @@ class Vessel : public MobileInterface {
 
   // The vessel must satisfy |is_initialized()|.
   void WriteToMessage(not_null<serialization::Vessel*> const message) const;
+  // Same as above, but only writes the tail of the history since |since|, see
+  // |Trajectory::WriteTailToMessage|.  The prolongation of an unsynchronized
+  // vessel is written in full.
+  void WriteDeltaToMessage(
+      Instant const& since,
+      not_null<serialization::Vessel*> const message) const;
   // NOTE(egg): This should return a |not_null|, but we can't do that until
   // |not_null<std::unique_ptr<T>>| is convertible to |std::unique_ptr<T>|, and
   // that requires a VS 2015 feature (rvalue references for |*this|).
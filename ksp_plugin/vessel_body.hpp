@@ -123,6 +123,22 @@ inline void Vessel::WriteToMessage(
   }
 }
 
+inline void Vessel::WriteDeltaToMessage(
+    Instant const& since,
+    not_null<serialization::Vessel*> const message) const {
+  CHECK(is_initialized());
+  body_.WriteToMessage(message->mutable_body());
+  if (is_synchronized()) {
+    history_->WriteTailToMessage(
+        since,
+        message->mutable_history_and_prolongation()->mutable_history());
+    prolongation_->WritePointerToMessage(
+        message->mutable_history_and_prolongation()->mutable_prolongation());
+  } else {
+    owned_prolongation_->WriteToMessage(message->mutable_owned_prolongation());
+  }
+}
+
 inline std::unique_ptr<Vessel> Vessel::ReadFromMessage(
     serialization::Vessel const& message,
     not_null<Celestial const*> const parent) {
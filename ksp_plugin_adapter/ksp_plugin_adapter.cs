@@ -15,11 +15,13 @@ namespace ksp_plugin_adapter {
 public partial class PrincipiaPluginAdapter : ScenarioModule {
 
   private const String kPrincipiaKey = "serialized_plugin";
+  // The changes since the save under |kPrincipiaKey|, if any.
+  private const String kPrincipiaDeltaKey = "serialized_plugin_delta";
   private const double kΔt = 10;
 
-  // The number of points in a |VectorLine| can be at most 32766, since
-  // Vectrosity imposes a maximum of 65534 vertices, where there are 2 vertices
-  // per point on discrete lines.
+  // The number of points in a |VectorLine| can be at most 16384, since
+  // Vectrosity imposes a maximum of 65534 vertices, where there are 4 vertices
+  // per segment on continuous lines.
   // TODO(egg): At the moment we store points in the history every
   // 10 n seconds, where n is maximal such that 10 n seconds is less than the
   // length of a |FixedUpdate|. This means we sometimes have very large gaps.
@@ -30,7 +32,22 @@ public partial class PrincipiaPluginAdapter : ScenarioModule {
   // 10 segments counts 20 towards |kLinePoints| (and probably takes as long to
   // render as 10 segments from the actual data, with extra overhead for
   // the evaluation of the cubic).
-  private const int kMaxVectorLinePoints = 32766;
+  private const int kMaxVectorLinePoints = 16384;
+  // The angle under which the rendered trajectories may deviate from the
+  // actual ones, as seen from the camera.  About a pixel.
+  private const double kRenderingAngularTolerance = 1e-3;
+  // The histories are archived by blocks of 512 points, one every |kΔt|, so
+  // there is nothing new to archive until the archiving horizon has advanced
+  // by that much.
+  private const double kArchivingPeriod = 512 * kΔt;
+  // The number of saves that only serialize the changes since the last full
+  // serialization, which is reused, before a full serialization is made again.
+  // The size of the delta grows with the time elapsed since the full
+  // serialization, so the latter is redone periodically.
+  // Only the time spent serializing is proportional to the new data: since KSP
+  // rewrites the entire save file, each save still writes the full
+  // serialization, so the size of the file is that of the entire histories.
+  private const int kDeltaSavesPerSnapshot = 8;
 
   private ApplicationLauncherButton toolbar_button_;
   private bool hide_all_gui_ = false;
@@ -45,6 +62,8 @@ public partial class PrincipiaPluginAdapter : ScenarioModule {
   // TODO(egg): rendering only one trajectory at the moment.
   private VectorLine rendered_prediction_;
   private VectorLine rendered_trajectory_;
+  // The buffer to which the vertices of the rendered trajectories are fetched.
+  private XYZ[] rendered_vertices_ = new XYZ[0];
   private IntPtr transforms_ = IntPtr.Zero;
 
   private int first_selected_celestial_ = 0;
@@ -63,11 +82,31 @@ public partial class PrincipiaPluginAdapter : ScenarioModule {
        1 << 18, 1 << 19, 1 << 20, 1 << 21, 1 << 22, 1 << 23, 1 << 24, 1 << 25,
        1 << 26, 1 << 27, 1 << 28};
   private int prediction_length_index_ = 0;
+  // The tolerance on the local error in position of the adaptive step
+  // integrator of the predictions; the tolerance on the velocity is the same
+  // number of metres per second.  Zero selects a constant step.
+  private double[] prediction_length_tolerances_ =
+      {0, 1e-3, 1e-2, 1e-1, 1e0, 1e1, 1e2, 1e3, 1e4};
+  private int prediction_length_tolerance_index_ = 0;
   private double[] history_lengths_ =
       {1 << 10, 1 << 11, 1 << 12, 1 << 13, 1 << 14, 1 << 15, 1 << 16, 1 << 17,
        1 << 18, 1 << 19, 1 << 20, 1 << 21, 1 << 22, 1 << 23, 1 << 24, 1 << 25,
        1 << 26, 1 << 27, 1 << 28, 1 << 29, double.PositiveInfinity};
   private int history_length_index_ = 10;
+  // The part of the histories older than this is archived to disk.
+  private double[] resident_history_lengths_ =
+      {1 << 16, 1 << 18, 1 << 20, 1 << 22, 1 << 24, 1 << 26, 1 << 28,
+       double.PositiveInfinity};
+  private int resident_history_length_index_ = 7;
+  // The horizon of the last call to |ArchiveAllHistoriesBefore|.
+  private double last_archiving_horizon_ = double.NegativeInfinity;
+  // The chunks of the last full serialization of |plugin_|, made at
+  // |snapshot_time_|, or null if none was made since the plugin was created.
+  // They stay in managed memory for the rest of the session.  That memory is as
+  // large as a save.  It is not bounded by the archiving of the histories.
+  private List<String> snapshot_ = null;
+  private double snapshot_time_;
+  private int delta_saves_since_snapshot_ = 0;
 
   private bool show_reference_frame_selection_ = true;
   private bool show_prediction_settings_ = true;
@@ -111,6 +150,13 @@ public partial class PrincipiaPluginAdapter : ScenarioModule {
     Cleanup();
   }
 
+  // With an adaptive step, the number of points of the prediction is not
+  // bounded by its length divided by the step.
+  private bool adaptive_prediction_step() {
+    return prediction_length_tolerances_[
+               prediction_length_tolerance_index_] > 0;
+  }
+
   private bool PluginRunning() {
     return plugin_ != IntPtr.Zero;
   }
@@ -348,20 +394,51 @@ where is_in_physics_bubble(vessel)
     GameEvents.onHideUI.Add(HideGUI);
   }
 
+  private delegate IntPtr ChunkSerializer(ref IntPtr serializer);
+
+  // Returns the chunks returned by |serialize| until it returns null.
+  private static List<String> SerializeChunks(ChunkSerializer serialize) {
+    List<String> chunks = new List<String>();
+    IntPtr serialization = IntPtr.Zero;
+    IntPtr serializer = IntPtr.Zero;
+    for (;;) {
+      try {
+        serialization = serialize(ref serializer);
+        if (serialization == IntPtr.Zero) {
+          break;
+        }
+        chunks.Add(Marshal.PtrToStringAnsi(serialization));
+      } finally {
+        DeletePluginSerialization(ref serialization);
+      }
+    }
+    return chunks;
+  }
+
   public override void OnSave(ConfigNode node) {
     base.OnSave(node);
     if (PluginRunning()) {
-      IntPtr serialization = IntPtr.Zero;
-      IntPtr serializer = IntPtr.Zero;
-      for (;;) {
-        try {
-          serialization = SerializePlugin(plugin_, ref serializer);
-          if (serialization == IntPtr.Zero) {
-            break;
-          }
-          node.AddValue(kPrincipiaKey, Marshal.PtrToStringAnsi(serialization));
-        } finally {
-          DeletePluginSerialization(ref serialization);
+      if (snapshot_ == null ||
+          delta_saves_since_snapshot_ >= kDeltaSavesPerSnapshot) {
+        snapshot_time_ = current_time(plugin_);
+        snapshot_ = SerializeChunks(
+            (ref IntPtr serializer) => SerializePlugin(plugin_,
+                                                       ref serializer));
+        delta_saves_since_snapshot_ = 0;
+        foreach (String chunk in snapshot_) {
+          node.AddValue(kPrincipiaKey, chunk);
+        }
+      } else {
+        List<String> delta = SerializeChunks(
+            (ref IntPtr serializer) => SerializePluginDelta(plugin_,
+                                                            snapshot_time_,
+                                                            ref serializer));
+        ++delta_saves_since_snapshot_;
+        foreach (String chunk in snapshot_) {
+          node.AddValue(kPrincipiaKey, chunk);
+        }
+        foreach (String chunk in delta) {
+          node.AddValue(kPrincipiaDeltaKey, chunk);
         }
       }
     }
@@ -376,15 +453,37 @@ where is_in_physics_bubble(vessel)
       IntPtr deserializer = IntPtr.Zero;
       String[] serializations = node.GetValues(kPrincipiaKey);
       Log.Info("Serialization has " + serializations.Length + " chunks");
-      foreach (String serialization in serializations) {
-        Log.Info("serialization is " + serialization.Length +
-                 " characters long");
-        DeserializePlugin(serialization,
-                          serialization.Length,
-                          ref deserializer,
-                          ref plugin_);
+      if (node.HasValue(kPrincipiaDeltaKey)) {
+        String[] delta_serializations = node.GetValues(kPrincipiaDeltaKey);
+        Log.Info("Delta serialization has " + delta_serializations.Length +
+                 " chunks");
+        IntPtr message = IntPtr.Zero;
+        foreach (String serialization in serializations) {
+          DeserializePluginMessage(serialization,
+                                   serialization.Length,
+                                   ref deserializer,
+                                   ref message);
+        }
+        DeserializePluginMessage("", 0, ref deserializer, ref message);
+        foreach (String serialization in delta_serializations) {
+          MergePluginDeltaIntoMessage(serialization,
+                                      serialization.Length,
+                                      ref deserializer,
+                                      message);
+        }
+        MergePluginDeltaIntoMessage("", 0, ref deserializer, message);
+        plugin_ = NewPluginFromMessage(ref message);
+      } else {
+        foreach (String serialization in serializations) {
+          Log.Info("serialization is " + serialization.Length +
+                   " characters long");
+          DeserializePlugin(serialization,
+                            serialization.Length,
+                            ref deserializer,
+                            ref plugin_);
+        }
+        DeserializePlugin("", 0, ref deserializer, ref plugin_);
       }
-      DeserializePlugin("", 0, ref deserializer, ref plugin_);
 
       UpdateRenderingFrame();
       plugin_construction_ = DateTime.Now;
@@ -554,6 +653,11 @@ where is_in_physics_bubble(vessel)
             prediction_step_sizes_[prediction_step_index_]);
         set_prediction_length(plugin_,
                               prediction_lengths_[prediction_length_index_]);
+        double prediction_length_tolerance =
+            prediction_length_tolerances_[prediction_length_tolerance_index_];
+        set_prediction_tolerances(plugin_,
+                                  prediction_length_tolerance,
+                                  prediction_length_tolerance);
       } else {
         clear_predicted_vessel(plugin_);
       }
@@ -561,6 +665,20 @@ where is_in_physics_bubble(vessel)
       ForgetAllHistoriesBefore(
           plugin_,
           universal_time - history_lengths_[history_length_index_]);
+      double resident_history_length =
+          resident_history_lengths_[resident_history_length_index_];
+      if (!double.IsPositiveInfinity(resident_history_length)) {
+        double archiving_horizon = universal_time - resident_history_length;
+        // The horizon moves backwards if the resident history length is
+        // increased.
+        if (archiving_horizon >= last_archiving_horizon_ + kArchivingPeriod ||
+            archiving_horizon < last_archiving_horizon_) {
+          ArchiveAllHistoriesBefore(plugin_,
+                                    archiving_horizon,
+                                    Path.GetTempPath());
+          last_archiving_horizon_ = archiving_horizon;
+        }
+      }
       ApplyToBodyTree(body => UpdateBody(body, universal_time));
       ApplyToVesselsOnRailsOrInInertialPhysicsBubbleInSpace(
           vessel => UpdateVessel(vessel, universal_time));
@@ -619,6 +737,12 @@ where is_in_physics_bubble(vessel)
         if (rendered_trajectory_ == null || rendered_prediction_ == null) {
           ResetRenderedTrajectory();
         }
+        // The rendered trajectories may deviate from the actual ones by a
+        // fixed fraction of the distance to the camera, i.e., by a fixed angle.
+        set_rendering_tolerance(
+            plugin_,
+            kRenderingAngularTolerance * PlanetariumCamera.fetch.Distance *
+                ScaledSpace.ScaleFactor);
         IntPtr trajectory_iterator = IntPtr.Zero;
         trajectory_iterator = RenderedVesselTrajectory(
                                   plugin_,
@@ -659,29 +783,31 @@ where is_in_physics_bubble(vessel)
   private void RenderAndDeleteTrajectory(ref IntPtr trajectory_iterator,
                                          VectorLine vector_line) {
     try {
-      LineSegment segment;
-      int index_in_line_points = vector_line.points3.Length -
-          2 * NumberOfSegments(trajectory_iterator);
-      // If the |VectorLine| is too big, make sure we're not keeping garbage.
-      for (int i = 0; i < index_in_line_points; ++i) {
-        vector_line.points3[i] = UnityEngine.Vector3.zero;
+      int capacity = vector_line.points3.Length;
+      if (rendered_vertices_.Length < capacity) {
+        rendered_vertices_ = new XYZ[capacity];
+      }
+      // A single call fills the array, which is pinned rather than copied
+      // since |XYZ| is blittable.
+      int count = FetchVertices(trajectory_iterator,
+                                rendered_vertices_,
+                                capacity);
+      int index_in_line_points = capacity - count;
+      // If the |VectorLine| is too big, make sure we're not keeping garbage:
+      // the unused points collapse onto the first vertex.
+      UnityEngine.Vector3 first_point = UnityEngine.Vector3.zero;
+      if (count > 0) {
+        first_point = ScaledSpace.LocalToScaledSpace(
+                          (Vector3d)rendered_vertices_[0]);
       }
-      while (index_in_line_points < 0) {
-        FetchAndIncrement(trajectory_iterator);
-        index_in_line_points += 2;
+      for (int i = 0; i < index_in_line_points; ++i) {
+        vector_line.points3[i] = first_point;
       }
-      while (!AtEnd(trajectory_iterator)) {
-        segment = FetchAndIncrement(trajectory_iterator);
+      for (int i = 0; i < count; ++i) {
         // TODO(egg): should we do the |LocalToScaledSpace| conversion in
         // native code?
-        // TODO(egg): could we directly assign to
-        // |vector_line.points3| from C++ using unsafe code and
-        // something like the following?
-        // |fixed (UnityEngine.Vector3* pts = vector_line.points3)|
         vector_line.points3[index_in_line_points++] =
-            ScaledSpace.LocalToScaledSpace((Vector3d)segment.begin);
-        vector_line.points3[index_in_line_points++] =
-            ScaledSpace.LocalToScaledSpace((Vector3d)segment.end);
+            ScaledSpace.LocalToScaledSpace((Vector3d)rendered_vertices_[i]);
       }
     } finally {
       DeleteLineAndIterator(ref trajectory_iterator);
@@ -695,12 +821,12 @@ where is_in_physics_bubble(vessel)
         linePoints   : new UnityEngine.Vector3[
                            Math.Min(
                                kMaxVectorLinePoints,
-                               2 * (int)(history_lengths_[
-                                             history_length_index_] / kΔt))],
+                               (int)(history_lengths_[
+                                         history_length_index_] / kΔt) + 1)],
         lineMaterial : MapView.OrbitLinesMaterial,
         color        : XKCDColors.AcidGreen,
         width        : 5,
-        lineType     : LineType.Discrete);
+        lineType     : LineType.Continuous);
     rendered_trajectory_.vectorObject.transform.parent =
         ScaledSpace.Instance.transform;
     rendered_trajectory_.vectorObject.renderer.castShadows = false;
@@ -711,14 +837,16 @@ where is_in_physics_bubble(vessel)
         linePoints   : new UnityEngine.Vector3[
                            Math.Min(
                                kMaxVectorLinePoints,
-                               2 * (int)(prediction_lengths_[
-                                             prediction_length_index_] /
-                                         prediction_step_sizes_[
-                                             prediction_step_index_]))],
+                               adaptive_prediction_step()
+                                   ? kMaxVectorLinePoints
+                                   : (int)(prediction_lengths_[
+                                               prediction_length_index_] /
+                                           prediction_step_sizes_[
+                                               prediction_step_index_]) + 1)],
         lineMaterial : MapView.OrbitLinesMaterial,
         color        : XKCDColors.Fuchsia,
         width        : 5,
-        lineType     : LineType.Discrete);
+        lineType     : LineType.Continuous);
     rendered_prediction_.vectorObject.transform.parent =
         ScaledSpace.Instance.transform;
     rendered_prediction_.vectorObject.renderer.castShadows = false;
@@ -737,6 +865,8 @@ where is_in_physics_bubble(vessel)
 
   private void Cleanup() {
     DeletePlugin(ref plugin_);
+    last_archiving_horizon_ = double.NegativeInfinity;
+    snapshot_ = null;
     DeleteTransforms(ref transforms_);
     DestroyRenderedTrajectory();
     navball_changed_ = true;
@@ -799,6 +929,12 @@ where is_in_physics_bubble(vessel)
     if (changed_history_length) {
       ResetRenderedTrajectory();
     }
+    bool changed_resident_history_length = false;
+    Selector(resident_history_lengths_,
+             ref resident_history_length_index_,
+             "Max resident history length",
+             ref changed_resident_history_length,
+             "{0:0.00e00} s");
     ToggleableSection(name   : "Reference Frame Selection",
                       show   : ref show_reference_frame_selection_,
                       render : ReferenceFrameSelection);
@@ -965,6 +1101,11 @@ where is_in_physics_bubble(vessel)
              "Length",
              ref changed_settings,
              "{0:0.00e0} s");
+    Selector(prediction_length_tolerances_,
+             ref prediction_length_tolerance_index_,
+             "Tolerance",
+             ref changed_settings,
+             "{0:0.00e0' m';;'fixed step'}");
     if (changed_settings) {
       ResetRenderedTrajectory();
     }
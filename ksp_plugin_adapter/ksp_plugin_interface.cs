@@ -129,6 +129,14 @@ struct KSPPart {
   private static extern void ForgetAllHistoriesBefore(IntPtr plugin,
                                                       double t);
 
+  [DllImport(dllName           : kDllPath,
+             EntryPoint        = "principia__ArchiveAllHistoriesBefore",
+             CallingConvention = CallingConvention.Cdecl)]
+  private static extern void ArchiveAllHistoriesBefore(
+      IntPtr plugin,
+      double t,
+      [MarshalAs(UnmanagedType.LPStr)] String directory);
+
   [DllImport(dllName: kDllPath,
              EntryPoint        = "principia__VesselFromParent",
              CallingConvention = CallingConvention.Cdecl)]
@@ -181,6 +189,15 @@ struct KSPPart {
       IntPtr transforms,
       XYZ sun_world_position);
 
+  [DllImport(dllName           : kDllPath,
+             EntryPoint        = "principia__RenderedBatchedPrediction",
+             CallingConvention = CallingConvention.Cdecl)]
+  private static extern IntPtr RenderedBatchedPrediction(
+      IntPtr plugin,
+      [MarshalAs(UnmanagedType.LPStr)] String vessel_guid,
+      IntPtr transforms,
+      XYZ sun_world_position);
+
   [DllImport(dllName           : kDllPath,
              EntryPoint        = "principia__NumberOfSegments",
              CallingConvention = CallingConvention.Cdecl)]
@@ -196,6 +213,18 @@ struct KSPPart {
              CallingConvention = CallingConvention.Cdecl)]
   private static extern bool AtEnd(IntPtr line);
 
+  [DllImport(dllName           : kDllPath,
+             EntryPoint        = "principia__NumberOfVertices",
+             CallingConvention = CallingConvention.Cdecl)]
+  private static extern int NumberOfVertices(IntPtr line);
+
+  [DllImport(dllName           : kDllPath,
+             EntryPoint        = "principia__FetchVertices",
+             CallingConvention = CallingConvention.Cdecl)]
+  private static extern int FetchVertices(IntPtr line,
+                                          [Out] XYZ[] vertices,
+                                          int capacity);
+
   [DllImport(dllName           : kDllPath,
              EntryPoint        = "principia__DeleteLineAndIterator",
              CallingConvention = CallingConvention.Cdecl)]
@@ -223,6 +252,57 @@ struct KSPPart {
              CallingConvention = CallingConvention.Cdecl)]
   private static extern void set_prediction_step(IntPtr plugin, double t);
 
+  [DllImport(dllName           : kDllPath,
+             EntryPoint        = "principia__set_rendering_tolerance",
+             CallingConvention = CallingConvention.Cdecl)]
+  private static extern void set_rendering_tolerance(IntPtr plugin,
+                                                     double tolerance);
+
+  [DllImport(dllName           : kDllPath,
+             EntryPoint        = "principia__set_prediction_tolerances",
+             CallingConvention = CallingConvention.Cdecl)]
+  private static extern void set_prediction_tolerances(
+      IntPtr plugin,
+      double length_tolerance,
+      double speed_tolerance);
+
+  [DllImport(
+      dllName           : kDllPath,
+      EntryPoint        = "principia__set_incremental_prediction_tolerances",
+      CallingConvention = CallingConvention.Cdecl)]
+  private static extern void set_incremental_prediction_tolerances(
+      IntPtr plugin,
+      double length_tolerance,
+      double speed_tolerance);
+
+  [DllImport(dllName           : kDllPath,
+             EntryPoint        = "principia__set_asynchronous_predictions",
+             CallingConvention = CallingConvention.Cdecl)]
+  private static extern void set_asynchronous_predictions(IntPtr plugin,
+                                                         bool asynchronous);
+
+  [DllImport(dllName           : kDllPath,
+             EntryPoint        = "principia__PredictionStaleness",
+             CallingConvention = CallingConvention.Cdecl)]
+  private static extern int PredictionStaleness(IntPtr plugin);
+
+  [DllImport(dllName           : kDllPath,
+             EntryPoint        = "principia__AddVesselToBatchedPredictions",
+             CallingConvention = CallingConvention.Cdecl)]
+  private static extern void AddVesselToBatchedPredictions(
+      IntPtr plugin,
+      [MarshalAs(UnmanagedType.LPStr)] String vessel_guid,
+      double length,
+      double step);
+
+  [DllImport(
+      dllName           : kDllPath,
+      EntryPoint        = "principia__RemoveVesselFromBatchedPredictions",
+      CallingConvention = CallingConvention.Cdecl)]
+  private static extern void RemoveVesselFromBatchedPredictions(
+      IntPtr plugin,
+      [MarshalAs(UnmanagedType.LPStr)] String vessel_guid);
+
   [DllImport(dllName             : kDllPath,
              EntryPoint =        "principia__has_vessel",
              CallingConvention = CallingConvention.Cdecl)]
@@ -284,6 +364,13 @@ struct KSPPart {
   private static extern IntPtr SerializePlugin(IntPtr plugin,
                                                ref IntPtr serializer);
 
+  [DllImport(dllName           : kDllPath,
+             EntryPoint        = "principia__SerializePluginDelta",
+             CallingConvention = CallingConvention.Cdecl)]
+  private static extern IntPtr SerializePluginDelta(IntPtr plugin,
+                                                    double since,
+                                                    ref IntPtr serializer);
+
   [DllImport(dllName           : kDllPath,
              EntryPoint        = "principia__DeletePluginSerialization",
              CallingConvention = CallingConvention.Cdecl)]
@@ -299,6 +386,45 @@ struct KSPPart {
       ref IntPtr deserializer,
       ref IntPtr plugin);
 
+  [DllImport(dllName           : kDllPath,
+             EntryPoint        = "principia__SerializePluginBytes",
+             CallingConvention = CallingConvention.Cdecl)]
+  private static extern IntPtr SerializePluginBytes(IntPtr plugin,
+                                                    ref IntPtr serializer,
+                                                    out int size);
+
+  [DllImport(dllName           : kDllPath,
+             EntryPoint        = "principia__DeserializePluginBytes",
+             CallingConvention = CallingConvention.Cdecl)]
+  private static extern void DeserializePluginBytes(
+      byte[] serialization,
+      int serialization_size,
+      ref IntPtr deserializer,
+      ref IntPtr plugin);
+
+  [DllImport(dllName           : kDllPath,
+             EntryPoint        = "principia__DeserializePluginMessage",
+             CallingConvention = CallingConvention.Cdecl)]
+  private static extern void DeserializePluginMessage(
+      [MarshalAs(UnmanagedType.LPStr)] String serialization,
+      int serialization_size,
+      ref IntPtr deserializer,
+      ref IntPtr message);
+
+  [DllImport(dllName           : kDllPath,
+             EntryPoint        = "principia__MergePluginDeltaIntoMessage",
+             CallingConvention = CallingConvention.Cdecl)]
+  private static extern void MergePluginDeltaIntoMessage(
+      [MarshalAs(UnmanagedType.LPStr)] String serialization,
+      int serialization_size,
+      ref IntPtr deserializer,
+      IntPtr message);
+
+  [DllImport(dllName           : kDllPath,
+             EntryPoint        = "principia__NewPluginFromMessage",
+             CallingConvention = CallingConvention.Cdecl)]
+  private static extern IntPtr NewPluginFromMessage(ref IntPtr message);
+
 }
 
 }  // namespace ksp_plugin_adapter
@@ -1,7 +1,9 @@
 ﻿
 #include "ksp_plugin/interface.hpp"
 
+#include <cstring>
 #include <string>
+#include <vector>
 
 #include "base/not_null.hpp"
 #include "base/pull_serializer.hpp"
@@ -33,6 +35,7 @@ using ::testing::Property;
 using ::testing::Ref;
 using ::testing::Return;
 using ::testing::SetArgPointee;
+using ::testing::StartsWith;
 using ::testing::StrictMock;
 using ::testing::_;
 
@@ -256,6 +259,13 @@ TEST_F(InterfaceTest, ForgetAllHistoriesBefore) {
   principia__ForgetAllHistoriesBefore(plugin_.get(), kTime);
 }
 
+TEST_F(InterfaceTest, ArchiveAllHistoriesBefore) {
+  EXPECT_CALL(*plugin_,
+              ArchiveAllHistoriesBefore(Instant(kTime * SIUnit<Time>()),
+                                        "/tmp"));
+  principia__ArchiveAllHistoriesBefore(plugin_.get(), kTime, "/tmp");
+}
+
 TEST_F(InterfaceTest, VesselFromParent) {
   EXPECT_CALL(*plugin_,
               VesselFromParent(kVesselGUID))
@@ -391,6 +401,25 @@ TEST_F(InterfaceTest, RenderedPrediction) {
   EXPECT_THAT(line_and_iterator, Not(IsNull()));
   principia__DeleteLineAndIterator(&line_and_iterator);
   EXPECT_THAT(line_and_iterator, IsNull());
+
+  // The batched predictions are rendered the same way.
+  EXPECT_CALL(*plugin_,
+              RenderedBatchedPrediction(
+                  kVesselGUID,
+                  check_not_null(transforms),
+                  World::origin + Displacement<World>(
+                                      {kParentPosition.x * SIUnit<Length>(),
+                                       kParentPosition.y * SIUnit<Length>(),
+                                       kParentPosition.z * SIUnit<Length>()})))
+      .WillOnce(Return(rendered_trajectory));
+  line_and_iterator = principia__RenderedBatchedPrediction(plugin_.get(),
+                                                           kVesselGUID,
+                                                           transforms,
+                                                           kParentPosition);
+  EXPECT_EQ(kTrajectorySize, principia__NumberOfSegments(line_and_iterator));
+  principia__DeleteLineAndIterator(&line_and_iterator);
+  EXPECT_THAT(line_and_iterator, IsNull());
+
   EXPECT_EQ(dummy_transforms, transforms);
   principia__DeleteTransforms(&transforms);
   EXPECT_THAT(transforms, IsNull());
@@ -456,6 +485,23 @@ TEST_F(InterfaceTest, LineAndIterator) {
   }
   EXPECT_TRUE(principia__AtEnd(line_and_iterator));
 
+  // Fetch the vertices in bulk, with a buffer too small for all of them.
+  EXPECT_EQ(kTrajectorySize + 1,
+            principia__NumberOfVertices(line_and_iterator));
+  std::vector<XYZ> vertices(kTrajectorySize + 1);
+  EXPECT_EQ(kTrajectorySize + 1,
+            principia__FetchVertices(line_and_iterator,
+                                     vertices.data(),
+                                     vertices.size()));
+  for (int i = 0; i <= kTrajectorySize; ++i) {
+    EXPECT_EQ(1 + 10 * i, vertices[i].x);
+    EXPECT_EQ(2 + 20 * i, vertices[i].y);
+    EXPECT_EQ(3 + 30 * i, vertices[i].z);
+  }
+  EXPECT_EQ(2, principia__FetchVertices(line_and_iterator, vertices.data(), 2));
+  EXPECT_EQ(1 + 10 * (kTrajectorySize - 1), vertices[0].x);
+  EXPECT_EQ(1 + 10 * kTrajectorySize, vertices[1].x);
+
   // Delete it.
   EXPECT_THAT(line_and_iterator, Not(IsNull()));
   principia__DeleteLineAndIterator(&line_and_iterator);
@@ -474,6 +520,32 @@ TEST_F(InterfaceTest, PredictionGettersAndSetters) {
   principia__set_prediction_length(plugin_.get(), 42);
   EXPECT_CALL(*plugin_, set_prediction_step(20 * Milli(Second)));
   principia__set_prediction_step(plugin_.get(), 0.02);
+  EXPECT_CALL(*plugin_, set_rendering_tolerance(1000 * Metre));
+  principia__set_rendering_tolerance(plugin_.get(), 1000);
+  EXPECT_CALL(*plugin_, set_prediction_tolerances(1 * Metre,
+                                                  1 * Milli(Metre) / Second));
+  principia__set_prediction_tolerances(plugin_.get(), 1, 1E-3);
+  EXPECT_CALL(*plugin_,
+              set_incremental_prediction_tolerances(
+                  10 * Metre, 10 * Milli(Metre) / Second));
+  principia__set_incremental_prediction_tolerances(plugin_.get(), 10, 1E-2);
+  EXPECT_CALL(*plugin_, set_asynchronous_predictions(true));
+  principia__set_asynchronous_predictions(plugin_.get(), true);
+  EXPECT_CALL(*plugin_, requested_prediction_generation()).WillOnce(Return(7));
+  EXPECT_CALL(*plugin_, rendered_prediction_generation()).WillOnce(Return(5));
+  EXPECT_EQ(2, principia__PredictionStaleness(plugin_.get()));
+  EXPECT_CALL(*plugin_,
+              AddVesselToBatchedPredictions(kVesselGUID,
+                                            3600 * Second,
+                                            10 * Second));
+  principia__AddVesselToBatchedPredictions(plugin_.get(),
+                                           kVesselGUID,
+                                           3600,
+                                           10);
+  EXPECT_CALL(*plugin_, RemoveVesselFromBatchedPredictions(kVesselGUID));
+  principia__RemoveVesselFromBatchedPredictions(plugin_.get(), kVesselGUID);
+  EXPECT_CALL(*plugin_, set_number_of_threads(4));
+  principia__set_number_of_threads(plugin_.get(), 4);
 }
 
 TEST_F(InterfaceTest, PhysicsBubble) {
@@ -606,12 +678,84 @@ TEST_F(InterfaceTest, SerializePlugin) {
   EXPECT_CALL(*plugin_, WriteToMessage(_)).WillOnce(SetArgPointee<0>(message));
   char const* serialization =
       principia__SerializePlugin(plugin_.get(), &serializer);
-  EXPECT_STREQ(kHexadecimalBoringPlugin, serialization);
   EXPECT_EQ(nullptr, principia__SerializePlugin(plugin_.get(), &serializer));
+
+  // The serialization is compressed in the gzip format, and is smaller than
+  // the plain one.
+  EXPECT_THAT(serialization, StartsWith("1F8B"));
+  EXPECT_GT(std::strlen(kHexadecimalBoringPlugin), std::strlen(serialization));
+  PushDeserializer* deserializer = nullptr;
+  Plugin const* plugin = nullptr;
+  principia__DeserializePlugin(serialization,
+                               std::strlen(serialization),
+                               &deserializer,
+                               &plugin);
+  principia__DeserializePlugin(serialization, 0, &deserializer, &plugin);
+  EXPECT_THAT(plugin, NotNull());
+  EXPECT_EQ(Instant(), plugin->current_time());
+  principia__DeletePlugin(&plugin);
+
   principia__DeletePluginSerialization(&serialization);
   EXPECT_THAT(serialization, IsNull());
 }
 
+TEST_F(InterfaceTest, SerializePluginDelta) {
+  std::string const message_bytes =
+      std::string(kSerializedBoringPlugin,
+                  (sizeof(kSerializedBoringPlugin) - 1) / sizeof(char));
+  principia::serialization::Plugin message;
+  message.ParseFromString(message_bytes);
+  principia::serialization::PluginDelta delta;
+  Instant(kTime * Second).WriteToMessage(delta.mutable_since());
+  *delta.mutable_plugin() = message;
+  Instant(2 * kTime * Second).WriteToMessage(
+      delta.mutable_plugin()->mutable_current_time());
+
+  EXPECT_CALL(*plugin_, WriteToMessage(_)).WillOnce(SetArgPointee<0>(message));
+  PullSerializer* serializer = nullptr;
+  char const* serialization =
+      principia__SerializePlugin(plugin_.get(), &serializer);
+  EXPECT_EQ(nullptr, principia__SerializePlugin(plugin_.get(), &serializer));
+  EXPECT_CALL(*plugin_, WriteDeltaToMessage(Instant(kTime * Second), _))
+      .WillOnce(SetArgPointee<1>(delta));
+  char const* delta_serialization =
+      principia__SerializePluginDelta(plugin_.get(), kTime, &serializer);
+  EXPECT_EQ(nullptr,
+            principia__SerializePluginDelta(plugin_.get(), kTime, &serializer));
+  EXPECT_THAT(delta_serialization, StartsWith("1F8B"));
+
+  PushDeserializer* deserializer = nullptr;
+  principia::serialization::Plugin* deserialized_message = nullptr;
+  principia__DeserializePluginMessage(serialization,
+                                      std::strlen(serialization),
+                                      &deserializer,
+                                      &deserialized_message);
+  principia__DeserializePluginMessage(serialization,
+                                      0,
+                                      &deserializer,
+                                      &deserialized_message);
+  ASSERT_THAT(deserialized_message, NotNull());
+  EXPECT_EQ(message.SerializeAsString(),
+            deserialized_message->SerializeAsString());
+  principia__MergePluginDeltaIntoMessage(delta_serialization,
+                                         std::strlen(delta_serialization),
+                                         &deserializer,
+                                         deserialized_message);
+  principia__MergePluginDeltaIntoMessage(delta_serialization,
+                                         0,
+                                         &deserializer,
+                                         deserialized_message);
+  EXPECT_THAT(deserializer, IsNull());
+  Plugin const* plugin = principia__NewPluginFromMessage(&deserialized_message);
+  EXPECT_THAT(deserialized_message, IsNull());
+  EXPECT_THAT(plugin, NotNull());
+  EXPECT_EQ(Instant(2 * kTime * Second), plugin->current_time());
+  principia__DeletePlugin(&plugin);
+
+  principia__DeletePluginSerialization(&serialization);
+  principia__DeletePluginSerialization(&delta_serialization);
+}
+
 TEST_F(InterfaceTest, DeserializePlugin) {
   PushDeserializer* deserializer = nullptr;
   Plugin const* plugin = nullptr;
@@ -629,6 +773,64 @@ TEST_F(InterfaceTest, DeserializePlugin) {
   principia__DeletePlugin(&plugin);
 }
 
+TEST_F(InterfaceTest, SerializePluginBytes) {
+  PullSerializer* serializer = nullptr;
+  std::string const message_bytes =
+      std::string(kSerializedBoringPlugin,
+                  (sizeof(kSerializedBoringPlugin) - 1) / sizeof(char));
+  principia::serialization::Plugin message;
+  message.ParseFromString(message_bytes);
+
+  EXPECT_CALL(*plugin_, WriteToMessage(_)).WillOnce(SetArgPointee<0>(message));
+  int size = -1;
+  std::uint8_t const* const chunk =
+      principia__SerializePluginBytes(plugin_.get(), &serializer, &size);
+  EXPECT_THAT(serializer, NotNull());
+  EXPECT_LT(0, size);
+  // Copy the chunk, which is owned by the serializer.
+  std::string const serialization(reinterpret_cast<char const*>(chunk), size);
+  EXPECT_EQ(nullptr,
+            principia__SerializePluginBytes(plugin_.get(), &serializer, &size));
+  EXPECT_EQ(0, size);
+  EXPECT_THAT(serializer, IsNull());
+
+  EXPECT_EQ('\x1F', serialization[0]);
+  PushDeserializer* deserializer = nullptr;
+  Plugin const* plugin = nullptr;
+  principia__DeserializePluginBytes(
+      reinterpret_cast<std::uint8_t const*>(serialization.data()),
+      serialization.size(),
+      &deserializer,
+      &plugin);
+  principia__DeserializePluginBytes(
+      reinterpret_cast<std::uint8_t const*>(serialization.data()),
+      0,
+      &deserializer,
+      &plugin);
+  EXPECT_THAT(plugin, NotNull());
+  EXPECT_EQ(Instant(), plugin->current_time());
+  principia__DeletePlugin(&plugin);
+}
+
+TEST_F(InterfaceTest, DeserializePluginBytes) {
+  PushDeserializer* deserializer = nullptr;
+  Plugin const* plugin = nullptr;
+  principia__DeserializePluginBytes(
+      reinterpret_cast<std::uint8_t const*>(kSerializedBoringPlugin),
+      (sizeof(kSerializedBoringPlugin) - 1) / sizeof(char),
+      &deserializer,
+      &plugin);
+  principia__DeserializePluginBytes(
+      reinterpret_cast<std::uint8_t const*>(kSerializedBoringPlugin),
+      0,
+      &deserializer,
+      &plugin);
+  EXPECT_THAT(deserializer, IsNull());
+  EXPECT_THAT(plugin, NotNull());
+  EXPECT_EQ(Instant(), plugin->current_time());
+  principia__DeletePlugin(&plugin);
+}
+
 TEST_F(InterfaceDeathTest, SettersAndGetters) {
   // We use EXPECT_EXITs in this test to avoid interfering with the execution of
   // the other tests.
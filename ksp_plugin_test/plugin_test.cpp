@@ -2,17 +2,19 @@
 #include "ksp_plugin/plugin.hpp"
 
 #include <algorithm>
+#include <chrono>  // NOLINT(build/c++11)
 #include <cmath>
 #include <limits>
 #include <map>
 #include <memory>
+#include <thread>  // NOLINT(build/c++11)
 #include <utility>
 #include <vector>
 
 #include "geometry/permutation.hpp"
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
-#include "physics/mock_n_body_system.hpp"
+#include "physics/mock_ephemeris.hpp"
 #include "quantities/si.hpp"
 #include "testing_utilities/almost_equals.hpp"
 #include "testing_utilities/componentwise.hpp"
@@ -24,7 +26,7 @@ namespace principia {
 using geometry::Bivector;
 using geometry::Permutation;
 using geometry::Trivector;
-using physics::MockNBodySystem;
+using physics::MockEphemeris;
 using quantities::Abs;
 using quantities::ArcTan;
 using quantities::Cos;
@@ -62,12 +64,12 @@ int const kNotABody = 1729;
 
 // Appends a |DegreesOfFreedom| equal to the last one at the given |time| to
 // each |Trajectory| in the |k|th parameter of the expected call.
-// This parameter must be an |NBodySystem<Barycentric>::Trajectories|, |time|
+// This parameter must be an |Ephemeris<Barycentric>::Trajectories|, |time|
 // must be an |Instant|.
 ACTION_TEMPLATE(AppendTimeToTrajectories,
                 HAS_1_TEMPLATE_PARAMS(int, k),
                 AND_1_VALUE_PARAMS(time)) {
-  for (auto trajectory : static_cast<NBodySystem<Barycentric>::Trajectories>(
+  for (auto trajectory : static_cast<Ephemeris<Barycentric>::Trajectories>(
                              std::tr1::get<k>(args))) {
     trajectory->Append(time, trajectory->last().degrees_of_freedom());
   }
@@ -92,19 +94,41 @@ MATCHER_P(HasNonvanishingIntrinsicAccelerationAt, t, "") {
 
 class TestablePlugin : public Plugin {
  public:
-  // Takes ownership of |n_body_system|.
-  // TODO(phl): We'd like to pass a |unique_ptr<>| but that seems to confuse
-  // gMock.
   TestablePlugin(Instant const& initial_time,
                  Index const sun_index,
                  GravitationalParameter const& sun_gravitational_parameter,
-                 Angle const& planetarium_rotation,
-                 not_null<MockNBodySystem<Barycentric>*> const n_body_system)
+                 Angle const& planetarium_rotation)
       : Plugin(initial_time,
                sun_index,
                sun_gravitational_parameter,
-               planetarium_rotation) {
-    n_body_system_.reset(n_body_system);
+               planetarium_rotation) {}
+
+  // Replaces the ephemeris created by |Plugin::EndInitialization| with a mock
+  // having the same bodies and initial state.  The massive bodies are actually
+  // integrated, only the flow of the massless bodies is mocked.
+  void EndInitialization() override {
+    Plugin::EndInitialization();
+    std::vector<not_null<MassiveBody const*>> bodies;
+    std::vector<DegreesOfFreedom<Barycentric>> initial_state;
+    for (auto const& pair : celestials_) {
+      not_null<std::unique_ptr<Celestial>> const& celestial = pair.second;
+      bodies.push_back(&celestial->body());
+      initial_state.push_back(
+          celestial->history().last().degrees_of_freedom());
+    }
+    mock_ephemeris_ = new MockEphemeris<Barycentric>(
+                          bodies,
+                          initial_state,
+                          HistoryTime(),
+                          *history_integrator_,
+                          ephemeris_step_,
+                          ephemeris_fitting_tolerance_);
+    ephemeris_.reset(mock_ephemeris_);
+  }
+
+  // Must be called after |EndInitialization|.
+  not_null<MockEphemeris<Barycentric>*> mock_ephemeris() const {
+    return CHECK_NOTNULL(mock_ephemeris_);
   }
 
   Time const& Δt() const {
@@ -118,13 +142,15 @@ class TestablePlugin : public Plugin {
   SRKNIntegrator const& history_integrator() const {
     return *history_integrator_;
   }
+
+ private:
+  MockEphemeris<Barycentric>* mock_ephemeris_ = nullptr;  // Owned by the base.
 };
 
 class PluginTest : public testing::Test {
  protected:
   PluginTest()
       : looking_glass_(Permutation<ICRFJ2000Ecliptic, AliceSun>::XZY),
-        n_body_system_(new MockNBodySystem<Barycentric>()),
         solar_system_(SolarSystem::AtСпутник1Launch(
             SolarSystem::Accuracy::kMajorBodiesOnly)),
         bodies_(solar_system_->massive_bodies()),
@@ -136,8 +162,7 @@ class PluginTest : public testing::Test {
                     initial_time_,
                     SolarSystem::kSun,
                     sun_gravitational_parameter_,
-                    planetarium_rotation_,
-                    n_body_system_)) {
+                    planetarium_rotation_)) {
     satellite_initial_displacement_ =
         Displacement<AliceSun>({3111.0 * Kilo(Metre),
                                 4400.0 * Kilo(Metre),
@@ -205,7 +230,6 @@ class PluginTest : public testing::Test {
   }
 
   Permutation<ICRFJ2000Ecliptic, AliceSun> looking_glass_;
-  not_null<MockNBodySystem<Barycentric>*> n_body_system_;  // Not owned.
   not_null<std::unique_ptr<SolarSystem>> solar_system_;
   SolarSystem::Bodies bodies_;
   Instant initial_time_;
@@ -280,20 +304,156 @@ TEST_F(PluginTest, Serialization) {
   EXPECT_EQ(bodies_.size(), message.celestial_size());
   auto const& celestial_0_history =
       message.celestial(0).celestial().history_and_prolongation().history();
-  EXPECT_EQ(1, celestial_0_history.timeline_size());
-  EXPECT_EQ((HistoryTime(6) - Instant()) / (1 * Second),
-            celestial_0_history.timeline(0).instant().scalar().magnitude());
+  MasslessBody const body;
+  EXPECT_EQ(1, celestial_0_history.columns().time_size());
+  EXPECT_EQ(HistoryTime(6),
+            Trajectory<Barycentric>::ReadFromMessage(celestial_0_history,
+                                                     &body)->last().time());
   EXPECT_EQ(1, message.vessel_size());
   EXPECT_EQ(SolarSystem::kEarth, message.vessel(0).parent_index());
   EXPECT_TRUE(message.vessel(0).vessel().has_history_and_prolongation());
   auto const& vessel_0_history =
       message.vessel(0).vessel().history_and_prolongation().history();
-  EXPECT_EQ(1, vessel_0_history.timeline_size());
-  EXPECT_EQ((HistoryTime(6) - Instant()) / (1 * Second),
-            vessel_0_history.timeline(0).instant().scalar().magnitude());
+  EXPECT_EQ(1, vessel_0_history.columns().time_size());
+  EXPECT_EQ(HistoryTime(6),
+            Trajectory<Barycentric>::ReadFromMessage(vessel_0_history,
+                                                     &body)->last().time());
   EXPECT_FALSE(message.bubble().has_current());
 }
 
+// Replaying a delta on a save yields the same message as a full save.
+TEST_F(PluginTest, IncrementalSerialization) {
+  GUID const satellite = "satellite";
+  GUID const probe = "probe";
+  auto plugin = make_not_null_unique<Plugin>(
+                    initial_time_,
+                    SolarSystem::kSun,
+                    sun_gravitational_parameter_,
+                    planetarium_rotation_);
+  for (std::size_t index = SolarSystem::kSun + 1;
+       index < bodies_.size();
+       ++index) {
+    Index const parent_index = SolarSystem::parent(index);
+    RelativeDegreesOfFreedom<AliceSun> const from_parent = looking_glass_(
+        solar_system_->trajectories()[index]->
+            last().degrees_of_freedom() -
+        solar_system_->trajectories()[parent_index]->
+            last().degrees_of_freedom());
+    plugin->InsertCelestial(index,
+                            bodies_[index]->gravitational_parameter(),
+                            parent_index,
+                            from_parent);
+  }
+  plugin->EndInitialization();
+  plugin->InsertOrKeepVessel(satellite, SolarSystem::kEarth);
+  plugin->SetVesselStateOffset(satellite,
+                               RelativeDegreesOfFreedom<AliceSun>(
+                                   satellite_initial_displacement_,
+                                   satellite_initial_velocity_));
+  plugin->AdvanceTime(HistoryTime(3), Angle());
+  plugin->InsertOrKeepVessel(satellite, SolarSystem::kEarth);
+  plugin->AdvanceTime(HistoryTime(6), Angle());
+
+  serialization::Plugin message;
+  plugin->WriteToMessage(&message);
+  Instant const since = plugin->current_time();
+
+  // A vessel is inserted after the save.
+  plugin->InsertOrKeepVessel(satellite, SolarSystem::kEarth);
+  plugin->InsertOrKeepVessel(probe, SolarSystem::kEarth);
+  plugin->SetVesselStateOffset(probe,
+                               RelativeDegreesOfFreedom<AliceSun>(
+                                   -satellite_initial_displacement_,
+                                   satellite_initial_velocity_));
+  plugin->AdvanceTime(HistoryTime(9), Angle());
+  plugin->InsertOrKeepVessel(satellite, SolarSystem::kEarth);
+  plugin->InsertOrKeepVessel(probe, SolarSystem::kEarth);
+  plugin->AdvanceTime(HistoryTime(12), Angle());
+
+  serialization::PluginDelta delta;
+  plugin->WriteDeltaToMessage(since, &delta);
+  serialization::Plugin full_message;
+  plugin->WriteToMessage(&full_message);
+  EXPECT_EQ(since, Instant::ReadFromMessage(delta.since()));
+  EXPECT_EQ(2, delta.plugin().vessel_size());
+  // The history of the satellite has points at |HistoryTime(3)|,
+  // |HistoryTime(6)|, |HistoryTime(9)| and |HistoryTime(12)|.  The delta only
+  // holds the last point that was saved and the new ones.  The histories of the
+  // celestials only hold their last point.
+  EXPECT_EQ(satellite, full_message.vessel(1).guid());
+  EXPECT_EQ(4, full_message.vessel(1).vessel().
+                    history_and_prolongation().history().columns().time_size());
+  EXPECT_EQ(3, delta.plugin().vessel(1).vessel().
+                   history_and_prolongation().history().columns().time_size());
+  EXPECT_EQ(1, full_message.celestial(0).celestial().
+                    history_and_prolongation().history().columns().time_size());
+  EXPECT_EQ(1, delta.plugin().celestial(0).celestial().
+                   history_and_prolongation().history().columns().time_size());
+
+  Plugin::MergeDeltaIntoMessage(delta, &message);
+  EXPECT_EQ(full_message.SerializeAsString(), message.SerializeAsString());
+  plugin = Plugin::ReadFromMessage(message);
+  EXPECT_EQ(HistoryTime(12), plugin->current_time());
+}
+
+// The past of the celestials is kept in the Чебышёв series of the ephemeris,
+// which take much less memory than points sampled every |Δt()|, and their
+// histories only hold their last point.
+TEST_F(PluginTest, CelestialHistoriesMemory) {
+  // We need an actual |Plugin| here rather than a |TestablePlugin|, since the
+  // latter has a mock ephemeris.
+  auto const plugin = make_not_null_unique<Plugin>(
+                          initial_time_,
+                          SolarSystem::kSun,
+                          sun_gravitational_parameter_,
+                          planetarium_rotation_);
+  for (std::size_t index = SolarSystem::kSun + 1;
+       index < bodies_.size();
+       ++index) {
+    Index const parent_index = SolarSystem::parent(index);
+    RelativeDegreesOfFreedom<AliceSun> const from_parent = looking_glass_(
+        solar_system_->trajectories()[index]->
+            last().degrees_of_freedom() -
+        solar_system_->trajectories()[parent_index]->
+            last().degrees_of_freedom());
+    plugin->InsertCelestial(index,
+                            bodies_[index]->gravitational_parameter(),
+                            parent_index,
+                            from_parent);
+  }
+  plugin->EndInitialization();
+  for (int i = 1; i <= 6 * 60; ++i) {
+    plugin->AdvanceTime(initial_time_ + i * Minute, Angle());
+  }
+  serialization::Plugin message;
+  plugin->WriteToMessage(&message);
+
+  // The sizes in memory of the coefficients of the series and of the points.
+  std::int64_t const point_bytes =
+      sizeof(Instant) + sizeof(DegreesOfFreedom<Barycentric>);
+  std::int64_t series_bytes = 0;
+  std::int64_t sampled_bytes = 0;
+  for (auto const& trajectory : message.ephemeris().trajectory()) {
+    for (auto const& series : trajectory.series()) {
+      series_bytes +=
+          series.coefficient_size() * sizeof(Displacement<Barycentric>) +
+          2 * sizeof(Instant);
+    }
+    series_bytes += trajectory.last_point_size() * point_bytes;
+    Instant const t_min =
+        Instant::ReadFromMessage(trajectory.series(0).t_min());
+    Instant const t_max = Instant::ReadFromMessage(
+        trajectory.series(trajectory.series_size() - 1).t_max());
+    sampled_bytes +=
+        std::floor((t_max - t_min) / plugin_->Δt()) * point_bytes;
+  }
+  EXPECT_LT(10 * series_bytes, sampled_bytes);
+  for (auto const& celestial_message : message.celestial()) {
+    EXPECT_EQ(1, celestial_message.celestial().history_and_prolongation().
+                     history().columns().time_size());
+  }
+}
+
 TEST_F(PluginTest, Initialization) {
   InsertAllSolarSystemBodies();
   plugin_->EndInitialization();
@@ -416,10 +576,11 @@ TEST_F(PluginDeathTest, AdvanceTimeError) {
 
 TEST_F(PluginDeathTest, ForgetAllHistoriesBeforeError) {
   EXPECT_DEATH({
-    EXPECT_CALL(*n_body_system_, Integrate(_, _, _, _, _, _)).Times(2);
-    Instant const t(1 * Second);
+    Instant const t = HistoryTime(1) + 1 * Second;
     InsertAllSolarSystemBodies();
     plugin_->EndInitialization();
+    EXPECT_CALL(*plugin_->mock_ephemeris(),
+                FlowWithFixedStep(_, _, _, _, _, _)).Times(2);
     plugin_->AdvanceTime(t, Angle());
     plugin_->ForgetAllHistoriesBefore(t);
   }, "Check failed: t < HistoryTime");
@@ -490,25 +651,26 @@ TEST_F(PluginTest, AdvanceTimeWithCelestialsOnly) {
          t <= HistoryTime(step + 1);
          t += δt) {
       // Called to compute the prolongations.
-      EXPECT_CALL(*n_body_system_,
-                  Integrate(Ref(plugin_->prolongation_integrator()), t,
-                            plugin_->Δt(), 0, true, SizeIs(bodies_.size())))
+      EXPECT_CALL(*plugin_->mock_ephemeris(),
+                  FlowWithFixedStep(Ref(plugin_->prolongation_integrator()), t,
+                                    plugin_->Δt(), 0, true, SizeIs(0)))
           .RetiresOnSaturation();
       plugin_->AdvanceTime(t, planetarium_rotation);
     }
     // Called to advance the synchronized histories.
-    EXPECT_CALL(*n_body_system_,
-                Integrate(Ref(plugin_->history_integrator()),
-                          HistoryTime(step + 1) + δt,
-                          plugin_->Δt(), 0, false,
-                          SizeIs(bodies_.size())))
+    EXPECT_CALL(*plugin_->mock_ephemeris(),
+                FlowWithFixedStep(Ref(plugin_->history_integrator()),
+                                  HistoryTime(step + 1),
+                                  plugin_->Δt(), 0, true,
+                                  SizeIs(0)))
         .WillOnce(AppendTimeToTrajectories<5>(HistoryTime(step + 1)))
         .RetiresOnSaturation();
     // Called to compute the prolongations.
-    EXPECT_CALL(*n_body_system_,
-                Integrate(Ref(plugin_->prolongation_integrator()),
-                          HistoryTime(step + 1) + δt, plugin_->Δt(), 0, true,
-                          SizeIs(bodies_.size())))
+    EXPECT_CALL(*plugin_->mock_ephemeris(),
+                FlowWithFixedStep(Ref(plugin_->prolongation_integrator()),
+                                  HistoryTime(step + 1) + δt,
+                                  plugin_->Δt(), 0, true,
+                                  SizeIs(0)))
         .RetiresOnSaturation();
     plugin_->AdvanceTime(HistoryTime(step + 1) + δt, planetarium_rotation);
   }
@@ -573,12 +735,11 @@ TEST_F(PluginTest, AdvanceTimeWithVessels) {
       }
       // Called to compute the prolongations and advance the unsynchronized
       // histories.
-      EXPECT_CALL(*n_body_system_,
-                  Integrate(Ref(plugin_->prolongation_integrator()), t,
-                            plugin_->Δt(), 0, true,
-                            SizeIs(bodies_.size() +
-                                       expected_number_of_old_vessels +
-                                       expected_number_of_new_vessels)))
+      EXPECT_CALL(*plugin_->mock_ephemeris(),
+                  FlowWithFixedStep(Ref(plugin_->prolongation_integrator()), t,
+                                    plugin_->Δt(), 0, true,
+                                    SizeIs(expected_number_of_old_vessels +
+                                               expected_number_of_new_vessels)))
           .RetiresOnSaturation();
       plugin_->AdvanceTime(t, planetarium_rotation);
       if (AbsoluteError(t - HistoryTime(0), a_while) < ε_δt) {
@@ -600,33 +761,31 @@ TEST_F(PluginTest, AdvanceTimeWithVessels) {
       KeepVessel(constantinople);
     }
     // Called to advance the synchronized histories.
-    EXPECT_CALL(*n_body_system_,
-                Integrate(Ref(plugin_->history_integrator()),
-                          HistoryTime(step + 1) + δt,
-                          plugin_->Δt(), 0, false,
-                          SizeIs(bodies_.size() +
-                                     expected_number_of_old_vessels)))
+    EXPECT_CALL(*plugin_->mock_ephemeris(),
+                FlowWithFixedStep(Ref(plugin_->history_integrator()),
+                                  HistoryTime(step + 1),
+                                  plugin_->Δt(), 0, true,
+                                  SizeIs(expected_number_of_old_vessels)))
         .WillOnce(AppendTimeToTrajectories<5>(HistoryTime(step + 1)))
         .RetiresOnSaturation();
     if (expected_number_of_new_vessels > 0) {
       // Called to synchronize the new histories.
-      EXPECT_CALL(*n_body_system_,
-                  Integrate(Ref(plugin_->prolongation_integrator()),
-                            HistoryTime(step + 1),
-                            plugin_->Δt(), 0, true,
-                            SizeIs(bodies_.size() +
-                                       expected_number_of_new_vessels)))
+      EXPECT_CALL(*plugin_->mock_ephemeris(),
+                  FlowWithFixedStep(Ref(plugin_->prolongation_integrator()),
+                                    HistoryTime(step + 1),
+                                    plugin_->Δt(), 0, true,
+                                    SizeIs(expected_number_of_new_vessels)))
           .WillOnce(AppendTimeToTrajectories<5>(HistoryTime(step + 1)))
           .RetiresOnSaturation();
     }
     expected_number_of_old_vessels += expected_number_of_new_vessels;
     expected_number_of_new_vessels = 0;
     // Called to compute the prolongations.
-    EXPECT_CALL(*n_body_system_,
-                Integrate(Ref(plugin_->prolongation_integrator()),
-                          HistoryTime(step + 1) + δt, plugin_->Δt(), 0, true,
-                          SizeIs(bodies_.size() +
-                                     expected_number_of_old_vessels)))
+    EXPECT_CALL(*plugin_->mock_ephemeris(),
+                FlowWithFixedStep(Ref(plugin_->prolongation_integrator()),
+                                  HistoryTime(step + 1) + δt,
+                                  plugin_->Δt(), 0, true,
+                                  SizeIs(expected_number_of_old_vessels)))
         .RetiresOnSaturation();
     plugin_->AdvanceTime(HistoryTime(step + 1) + δt, planetarium_rotation);
     if (step == 2) {
@@ -772,27 +931,27 @@ TEST_F(PluginTest, PhysicsBubble) {
       // histories.
       if (expect_intrinsic_acceleration) {
         EXPECT_CALL(
-            *n_body_system_,
-            Integrate(Ref(plugin_->prolongation_integrator()), t,
-                      plugin_->Δt(), 0, true,
-                      AllOf(
-                          SizeIs(bodies_.size() +
-                                 expected_number_of_clean_old_vessels +
-                                 expected_number_of_new_off_rails_vessels +
-                                 expected_number_of_dirty_old_on_rails_vessels +
-                                 (expect_to_have_physics_bubble ? 1 : 0)),
-                          Contains(HasNonvanishingIntrinsicAccelerationAt(t)))))
+            *plugin_->mock_ephemeris(),
+            FlowWithFixedStep(
+                Ref(plugin_->prolongation_integrator()), t,
+                plugin_->Δt(), 0, true,
+                AllOf(
+                    SizeIs(expected_number_of_clean_old_vessels +
+                           expected_number_of_new_off_rails_vessels +
+                           expected_number_of_dirty_old_on_rails_vessels +
+                           (expect_to_have_physics_bubble ? 1 : 0)),
+                    Contains(HasNonvanishingIntrinsicAccelerationAt(t)))))
             .RetiresOnSaturation();
       } else {
         EXPECT_CALL(
-            *n_body_system_,
-            Integrate(Ref(plugin_->prolongation_integrator()), t,
-                      plugin_->Δt(), 0, true,
-                      SizeIs(bodies_.size() +
-                             expected_number_of_clean_old_vessels +
-                             expected_number_of_new_off_rails_vessels +
-                             expected_number_of_dirty_old_on_rails_vessels +
-                             (expect_to_have_physics_bubble ? 1 : 0))))
+            *plugin_->mock_ephemeris(),
+            FlowWithFixedStep(
+                Ref(plugin_->prolongation_integrator()), t,
+                plugin_->Δt(), 0, true,
+                SizeIs(expected_number_of_clean_old_vessels +
+                       expected_number_of_new_off_rails_vessels +
+                       expected_number_of_dirty_old_on_rails_vessels +
+                       (expect_to_have_physics_bubble ? 1 : 0))))
             .RetiresOnSaturation();
       }
       plugin_->AdvanceTime(t, planetarium_rotation);
@@ -826,12 +985,11 @@ TEST_F(PluginTest, PhysicsBubble) {
     }
     // Called to advance the synchronized histories.
     EXPECT_CALL(
-        *n_body_system_,
-        Integrate(Ref(plugin_->history_integrator()),
-                      HistoryTime(step + 1) + δt,
-                      plugin_->Δt(), 0, false,
-                      SizeIs(bodies_.size() +
-                             expected_number_of_clean_old_vessels)))
+        *plugin_->mock_ephemeris(),
+        FlowWithFixedStep(Ref(plugin_->history_integrator()),
+                          HistoryTime(step + 1),
+                          plugin_->Δt(), 0, true,
+                          SizeIs(expected_number_of_clean_old_vessels)))
         .WillOnce(AppendTimeToTrajectories<5>(HistoryTime(step + 1)))
         .RetiresOnSaturation();
     if (expected_number_of_new_off_rails_vessels > 0 ||
@@ -839,14 +997,14 @@ TEST_F(PluginTest, PhysicsBubble) {
         expect_to_have_physics_bubble) {
       // Called to synchronize the new histories.
       EXPECT_CALL(
-          *n_body_system_,
-          Integrate(Ref(plugin_->prolongation_integrator()),
-                        HistoryTime(step + 1),
-                        plugin_->Δt(), 0, true,
-                        SizeIs(bodies_.size() +
-                               expected_number_of_new_off_rails_vessels +
-                               expected_number_of_dirty_old_on_rails_vessels +
-                               (expect_to_have_physics_bubble ? 1 : 0))))
+          *plugin_->mock_ephemeris(),
+          FlowWithFixedStep(
+              Ref(plugin_->prolongation_integrator()),
+              HistoryTime(step + 1),
+              plugin_->Δt(), 0, true,
+              SizeIs(expected_number_of_new_off_rails_vessels +
+                     expected_number_of_dirty_old_on_rails_vessels +
+                     (expect_to_have_physics_bubble ? 1 : 0))))
           .WillOnce(AppendTimeToTrajectories<5>(HistoryTime(step + 1)))
           .RetiresOnSaturation();
     }
@@ -856,12 +1014,13 @@ TEST_F(PluginTest, PhysicsBubble) {
     expected_number_of_new_off_rails_vessels = 0;
     expected_number_of_dirty_old_on_rails_vessels = 0;
     // Called to compute the prolongations.
-    EXPECT_CALL(*n_body_system_,
-                Integrate(Ref(plugin_->prolongation_integrator()),
-                          HistoryTime(step + 1) + δt, plugin_->Δt(), 0, true,
-                          SizeIs(bodies_.size() +
-                                     expected_number_of_clean_old_vessels +
-                                     (expect_to_have_physics_bubble ? 1 : 0))))
+    EXPECT_CALL(*plugin_->mock_ephemeris(),
+                FlowWithFixedStep(Ref(plugin_->prolongation_integrator()),
+                                  HistoryTime(step + 1) + δt,
+                                  plugin_->Δt(), 0, true,
+                                  SizeIs(expected_number_of_clean_old_vessels +
+                                         (expect_to_have_physics_bubble ? 1
+                                                                        : 0))))
         .RetiresOnSaturation();
     plugin_->AdvanceTime(HistoryTime(step + 1) + δt, planetarium_rotation);
     if (expect_to_have_physics_bubble) {
@@ -1152,6 +1311,296 @@ TEST_F(PluginTest, Prediction) {
   plugin.clear_predicted_vessel();
 }
 
+// With a nonzero rendering tolerance, a finely sampled circular prediction is
+// rendered with few segments, which are contiguous and within the tolerance of
+// all the points of the prediction.
+TEST_F(PluginTest, RenderingTolerance) {
+  GUID const satellite = "satellite";
+  Index const celestial = 0;
+  int const n = 1000;
+  Length const tolerance = 0.01 * Metre;
+  Plugin plugin(Instant(),
+                celestial,
+                SIUnit<GravitationalParameter>(),
+                0 * Radian);
+  plugin.EndInitialization();
+  EXPECT_TRUE(plugin.InsertOrKeepVessel(satellite, celestial));
+  auto transforms = plugin.NewBodyCentredNonRotatingTransforms(celestial);
+  plugin.SetVesselStateOffset(
+      satellite,
+      {Displacement<AliceSun>({1 * Metre, 0 * Metre, 0 * Metre}),
+       Velocity<AliceSun>(
+           {0 * Metre / Second, 1 * Metre / Second, 0 * Metre / Second})});
+  plugin.set_predicted_vessel(satellite);
+  plugin.set_prediction_length(2 * π * Second);
+  plugin.set_prediction_step(2 * π / n * Second);
+  plugin.AdvanceTime(Instant(1e-10 * Second), 0 * Radian);
+  RenderedTrajectory<World> const all_points =
+      plugin.RenderedPrediction(transforms.get(), World::origin);
+  // The last step may be lost to rounding.
+  EXPECT_THAT(all_points.size(), AllOf(Ge(n - 1), Le(n)));
+
+  plugin.set_rendering_tolerance(tolerance);
+  RenderedTrajectory<World> const simplified =
+      plugin.RenderedPrediction(transforms.get(), World::origin);
+  // The sagitta of a chord subtending an angle θ of the unit circle is
+  // θ² / 8, so about 2π / √(8 tolerance) segments are needed.
+  EXPECT_THAT(simplified.size(), AllOf(Gt(8), Lt(40)));
+  EXPECT_THAT(simplified.front().begin, Eq(all_points.front().begin));
+  EXPECT_THAT(simplified.back().end, Eq(all_points.back().end));
+  for (std::size_t i = 0; i + 1 < simplified.size(); ++i) {
+    EXPECT_THAT(simplified[i].end, Eq(simplified[i + 1].begin));
+  }
+  for (auto const& segment : all_points) {
+    Length distance = std::numeric_limits<double>::infinity() * Metre;
+    for (auto const& simplified_segment : simplified) {
+      Displacement<World> const chord =
+          simplified_segment.end - simplified_segment.begin;
+      Displacement<World> const offset =
+          segment.begin - simplified_segment.begin;
+      double const s = std::min(
+          1.0,
+          std::max(0.0,
+                   InnerProduct(offset, chord) / InnerProduct(chord, chord)));
+      distance = std::min(distance, (offset - s * chord).Norm());
+    }
+    EXPECT_THAT(distance, Le(tolerance));
+  }
+  plugin.clear_predicted_vessel();
+}
+
+// The batched predictions of vessels with different steps and lengths, in
+// addition to that of the predicted vessel.  |opposite| and |companion| have
+// the same step, so they are integrated by the same flow.
+TEST_F(PluginTest, BatchedPredictions) {
+  GUID const predicted = "predicted";
+  GUID const fine = "fine";
+  GUID const opposite = "opposite";
+  GUID const companion = "companion";
+  Index const celestial = 0;
+  int const n = 8;
+  Plugin plugin(Instant(),
+                celestial,
+                SIUnit<GravitationalParameter>(),
+                0 * Radian);
+  plugin.EndInitialization();
+  auto transforms = plugin.NewBodyCentredNonRotatingTransforms(celestial);
+  // All the vessels are on the same circular orbit, |opposite| is half an
+  // orbit ahead of the others.
+  for (GUID const& vessel : {predicted, fine, opposite, companion}) {
+    EXPECT_TRUE(plugin.InsertOrKeepVessel(vessel, celestial));
+    double const sign = vessel == opposite ? -1 : 1;
+    plugin.SetVesselStateOffset(
+        vessel,
+        {Displacement<AliceSun>({sign * Metre, 0 * Metre, 0 * Metre}),
+         Velocity<AliceSun>({0 * Metre / Second,
+                             sign * Metre / Second,
+                             0 * Metre / Second})});
+  }
+  plugin.set_predicted_vessel(predicted);
+  plugin.set_prediction_length(2 * π * Second);
+  plugin.set_prediction_step(2 * π / n * Second);
+  plugin.AddVesselToBatchedPredictions(predicted, 1 * Second, 1 * Second);
+  plugin.AddVesselToBatchedPredictions(fine, π * Second, π / n * Second);
+  plugin.AddVesselToBatchedPredictions(opposite,
+                                       2 * π * Second,
+                                       2 * π / n * Second);
+  plugin.AddVesselToBatchedPredictions(companion,
+                                       π * Second,
+                                       2 * π / n * Second);
+  for (GUID const& vessel : {predicted, fine, opposite, companion}) {
+    plugin.InsertOrKeepVessel(vessel, celestial);
+  }
+  plugin.AdvanceTime(Instant(1e-10 * Second), 0 * Radian);
+
+  // Checks that the |rendered_prediction| has |segments| segments of angle
+  // |α|, starting from angle |initial_angle|.
+  auto const check_circle = [](RenderedTrajectory<World> const& rendered,
+                               int const segments,
+                               Angle const& α,
+                               Angle const& initial_angle) {
+    EXPECT_EQ(segments, rendered.size());
+    for (int k = 0; k < segments && k < rendered.size(); ++k) {
+      Angle const angle = initial_angle + (k + 1) * α;
+      EXPECT_THAT(
+          RelativeError(rendered[k].end - World::origin,
+                        Displacement<World>({Cos(angle) * Metre,
+                                             0 * Metre,
+                                             Sin(angle) * Metre})),
+          Lt(0.011));
+    }
+  };
+  Angle const α = 2 * π * Radian / n;
+  // The batched parameters of the predicted vessel are ignored.
+  check_circle(plugin.RenderedPrediction(transforms.get(), World::origin),
+               n, α, 0 * Radian);
+  EXPECT_EQ(n,
+            plugin.RenderedBatchedPrediction(predicted,
+                                             transforms.get(),
+                                             World::origin).size());
+  check_circle(plugin.RenderedBatchedPrediction(fine,
+                                                transforms.get(),
+                                                World::origin),
+               n, α / 2, 0 * Radian);
+  check_circle(plugin.RenderedBatchedPrediction(opposite,
+                                                transforms.get(),
+                                                World::origin),
+               n, α, π * Radian);
+  // The flow of |opposite| and |companion| has the same times for both, but
+  // each keeps its own degrees of freedom, up to its own length.
+  check_circle(plugin.RenderedBatchedPrediction(companion,
+                                                transforms.get(),
+                                                World::origin),
+               n / 2, α, 0 * Radian);
+
+  plugin.RemoveVesselFromBatchedPredictions(fine);
+  for (GUID const& vessel : {predicted, fine, opposite, companion}) {
+    plugin.InsertOrKeepVessel(vessel, celestial);
+  }
+  plugin.AdvanceTime(Instant(2e-10 * Second), 0 * Radian);
+  check_circle(plugin.RenderedBatchedPrediction(opposite,
+                                                transforms.get(),
+                                                World::origin),
+               n, α, π * Radian);
+  plugin.clear_predicted_vessel();
+}
+
+// With adaptive steps, the prediction of a circular orbit stays on the circle.
+TEST_F(PluginTest, AdaptivePrediction) {
+  GUID const satellite = "satellite";
+  Index const celestial = 0;
+  Plugin plugin(Instant(),
+                celestial,
+                SIUnit<GravitationalParameter>(),
+                0 * Radian);
+  plugin.EndInitialization();
+  EXPECT_TRUE(plugin.InsertOrKeepVessel(satellite, celestial));
+  auto transforms = plugin.NewBodyCentredNonRotatingTransforms(celestial);
+  plugin.SetVesselStateOffset(
+      satellite,
+      {Displacement<AliceSun>({1 * Metre, 0 * Metre, 0 * Metre}),
+       Velocity<AliceSun>(
+           {0 * Metre / Second, 1 * Metre / Second, 0 * Metre / Second})});
+  plugin.set_predicted_vessel(satellite);
+  plugin.set_prediction_length(2 * π * Second);
+  plugin.set_prediction_step(1 * Second);
+  plugin.set_prediction_tolerances(1E-6 * Metre, 1E-6 * Metre / Second);
+  plugin.AdvanceTime(Instant(1e-10 * Second), 0 * Radian);
+  RenderedTrajectory<World> rendered_prediction =
+      plugin.RenderedPrediction(transforms.get(), World::origin);
+  EXPECT_LT(8, rendered_prediction.size());
+  for (auto const& segment : rendered_prediction) {
+    EXPECT_THAT(AbsoluteError(1 * Metre, (segment.end - World::origin).Norm()),
+                Lt(1E-5 * Metre));
+  }
+  EXPECT_THAT(
+      RelativeError(rendered_prediction.back().end - World::origin,
+                    Displacement<World>({1 * Metre, 0 * Metre, 0 * Metre})),
+      Lt(1E-5));
+  plugin.clear_predicted_vessel();
+}
+
+// An asynchronous prediction is rendered once it has completed, possibly a few
+// requests later.
+TEST_F(PluginTest, AsynchronousPrediction) {
+  GUID const satellite = "satellite";
+  Index const celestial = 0;
+  int const n = 8;
+  Plugin plugin(Instant(),
+                celestial,
+                SIUnit<GravitationalParameter>(),
+                0 * Radian);
+  plugin.EndInitialization();
+  EXPECT_TRUE(plugin.InsertOrKeepVessel(satellite, celestial));
+  auto transforms = plugin.NewBodyCentredNonRotatingTransforms(celestial);
+  plugin.SetVesselStateOffset(
+      satellite,
+      {Displacement<AliceSun>({1 * Metre, 0 * Metre, 0 * Metre}),
+       Velocity<AliceSun>(
+           {0 * Metre / Second, 1 * Metre / Second, 0 * Metre / Second})});
+  plugin.set_predicted_vessel(satellite);
+  plugin.set_prediction_length(2 * π * Second);
+  plugin.set_prediction_step(2 * π / n * Second);
+  plugin.set_asynchronous_predictions(true);
+  EXPECT_EQ(0, plugin.requested_prediction_generation());
+  EXPECT_EQ(0, plugin.rendered_prediction_generation());
+  Instant t;
+  for (int i = 0; i < 10000 && plugin.rendered_prediction_generation() == 0;
+       ++i) {
+    t += 1e-10 * Second;
+    plugin.InsertOrKeepVessel(satellite, celestial);
+    plugin.AdvanceTime(t, 0 * Radian);
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  EXPECT_LE(2, plugin.requested_prediction_generation());
+  EXPECT_LE(1, plugin.rendered_prediction_generation());
+  EXPECT_GT(plugin.requested_prediction_generation(),
+            plugin.rendered_prediction_generation());
+  // The prediction was computed from an earlier state, but the vessel has only
+  // moved by a few ångströms since then.
+  RenderedTrajectory<World> rendered_prediction =
+      plugin.RenderedPrediction(transforms.get(), World::origin);
+  EXPECT_EQ(n, rendered_prediction.size());
+  EXPECT_THAT(
+      RelativeError(rendered_prediction.back().end - World::origin,
+                    Displacement<World>({1 * Metre, 0 * Metre, 0 * Metre})),
+      Lt(0.011));
+  plugin.clear_predicted_vessel();
+  EXPECT_EQ(0, plugin.rendered_prediction_generation());
+}
+
+// When the vessel follows the previous prediction, the new one reuses its
+// points, so it remains on the grid of the first prediction.
+TEST_F(PluginTest, IncrementalPrediction) {
+  GUID const satellite = "satellite";
+  Index const celestial = 0;
+  int const n = 8;
+  Time const step = 2 * π / n * Second;
+  auto const first_segment_end = [satellite, celestial, n, step](
+      bool const incremental) {
+    Plugin plugin(Instant(),
+                  celestial,
+                  SIUnit<GravitationalParameter>(),
+                  0 * Radian);
+    plugin.EndInitialization();
+    plugin.InsertOrKeepVessel(satellite, celestial);
+    auto transforms = plugin.NewBodyCentredNonRotatingTransforms(celestial);
+    plugin.SetVesselStateOffset(
+        satellite,
+        {Displacement<AliceSun>({1 * Metre, 0 * Metre, 0 * Metre}),
+         Velocity<AliceSun>(
+             {0 * Metre / Second, 1 * Metre / Second, 0 * Metre / Second})});
+    plugin.set_predicted_vessel(satellite);
+    plugin.set_prediction_length(2 * π * Second);
+    plugin.set_prediction_step(step);
+    if (incremental) {
+      plugin.set_incremental_prediction_tolerances(
+          1E-2 * Metre, 1E-2 * Metre / Second);
+    }
+    plugin.InsertOrKeepVessel(satellite, celestial);
+    plugin.AdvanceTime(Instant() + 1e-10 * Second, 0 * Radian);
+    plugin.InsertOrKeepVessel(satellite, celestial);
+    plugin.AdvanceTime(Instant() + 0.1 * Second, 0 * Radian);
+    RenderedTrajectory<World> const rendered_prediction =
+        plugin.RenderedPrediction(transforms.get(), World::origin);
+    EXPECT_LE(n, rendered_prediction.size());
+    return rendered_prediction.front().end - World::origin;
+  };
+  double const angle = step / Second;
+  EXPECT_THAT(
+      AbsoluteError(first_segment_end(true),
+                    Displacement<World>({std::cos(angle) * Metre,
+                                         0 * Metre,
+                                         std::sin(angle) * Metre})),
+      Lt(1E-3 * Metre));
+  EXPECT_THAT(
+      AbsoluteError(first_segment_end(false),
+                    Displacement<World>({std::cos(0.1 + angle) * Metre,
+                                         0 * Metre,
+                                         std::sin(0.1 + angle) * Metre})),
+      Lt(1E-3 * Metre));
+}
+
 TEST_F(PluginTest, Navball) {
   // Create a plugin with planetarium rotation 0.
   Plugin plugin(initial_time_,
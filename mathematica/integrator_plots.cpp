@@ -2,9 +2,15 @@
 #include "mathematica/integrator_plots.hpp"
 
 #include <algorithm>
+#include <cmath>
 #include <fstream>  // NOLINT(readability/streams)
+#include <iomanip>
 #include <iostream>  // NOLINT(readability/streams)
+#include <limits>
+#include <map>
+#include <sstream>
 #include <string>
+#include <tuple>
 #include <vector>
 
 #include "geometry/barycentre_calculator.hpp"
@@ -136,9 +142,65 @@ std::vector<SimpleHarmonicMotionPlottedIntegrator> ReferenceMethods() {
       {INTEGRATOR(McLachlan1995SS17), 17}};
 }
 
-}  // namespace
+char const kCSVHeader[] =
+    "problem,method,evaluations,position_error,velocity_error,energy_error";
 
-void GenerateSimpleHarmonicMotionWorkErrorGraphs() {
+// JSON has no representation for infinities and NaNs.
+std::string JSONNumber(double const x) {
+  if (!std::isfinite(x)) {
+    return "null";
+  }
+  std::stringstream stream;
+  stream << std::setprecision(std::numeric_limits<double>::max_digits10) << x;
+  return stream.str();
+}
+
+// Whether the error |actual| is larger by more than a factor |1 + tolerance|
+// than the error |baseline|, or has become NaN.
+template<typename Quantity>
+bool Regressed(Quantity const& baseline,
+               Quantity const& actual,
+               double const tolerance) {
+  return actual > (1 + tolerance) * baseline ||
+         (std::isnan(actual / SIUnit<Quantity>()) &&
+          !std::isnan(baseline / SIUnit<Quantity>()));
+}
+
+// Writes the work-error graphs of |work_errors|, which must be grouped by
+// method, to |filename|.
+void WriteGraphs(std::vector<WorkError> const& work_errors,
+                 std::string const& filename) {
+  std::vector<std::string> q_error_data;
+  std::vector<std::string> v_error_data;
+  std::vector<std::string> e_error_data;
+  std::vector<std::string> names;
+  for (auto it = work_errors.begin(); it != work_errors.end();) {
+    std::string const& method = it->method;
+    std::vector<Length> q_errors;
+    std::vector<Speed> v_errors;
+    std::vector<Energy> e_errors;
+    std::vector<double> evaluations;
+    for (; it != work_errors.end() && it->method == method; ++it) {
+      q_errors.emplace_back(it->position_error);
+      v_errors.emplace_back(it->velocity_error);
+      e_errors.emplace_back(it->energy_error);
+      evaluations.emplace_back(it->evaluations);
+    }
+    q_error_data.emplace_back(PlottableDataset(evaluations, q_errors));
+    v_error_data.emplace_back(PlottableDataset(evaluations, v_errors));
+    e_error_data.emplace_back(PlottableDataset(evaluations, e_errors));
+    names.emplace_back(Escape(method));
+  }
+  std::ofstream file;
+  file.open(filename);
+  file << Assign("qErrorData", q_error_data);
+  file << Assign("vErrorData", v_error_data);
+  file << Assign("eErrorData", e_error_data);
+  file << Assign("names", names);
+  file.close();
+}
+
+std::vector<WorkError> SimpleHarmonicMotionWorkErrors(int const stride) {
   SRKNIntegrator::Parameters<Length, Speed> parameters;
   SRKNIntegrator::Solution<Length, Speed> solution;
   Length const q_amplitude = 1 * Metre;
@@ -154,18 +216,14 @@ void GenerateSimpleHarmonicMotionWorkErrorGraphs() {
   // We use dense sampling in order to compute average errors, this leads to
   // more evaluations than reported for FSAL methods.
   parameters.sampling_period = 1;
-  std::vector<std::string> q_error_data;
-  std::vector<std::string> v_error_data;
-  std::vector<std::string> e_error_data;
-  std::vector<std::string> names;
+  std::vector<WorkError> work_errors;
   for (auto const& method : Methods()) {
     LOG(INFO) << method.name;
     parameters.Δt = method.stages * 1 * Second;
-    std::vector<Length> q_errors;
-    std::vector<Speed> v_errors;
-    std::vector<Energy> e_errors;
-    std::vector<double> evaluations;
     for (int i = 0; i < 500; ++i, parameters.Δt /= step_reduction) {
+      if (i % stride != 0) {
+        continue;
+      }
       int const number_of_evaluations =
           method.stages *
               static_cast<int>(std::floor(parameters.tmax / parameters.Δt));
@@ -193,26 +251,19 @@ void GenerateSimpleHarmonicMotionWorkErrorGraphs() {
       // We plot the maximum error, i.e., the L∞ norm of the error.
       // Blanes and Moan (2002), or Blanes, Casas and Ros (2001) tend to use
       // the average error (the normalized L¹ norm) instead.
-      q_errors.emplace_back(*std::max_element(q_error.begin(), q_error.end()));
-      v_errors.emplace_back(*std::max_element(v_error.begin(), v_error.end()));
-      e_errors.emplace_back(*std::max_element(e_error.begin(), e_error.end()));
-      evaluations.emplace_back(number_of_evaluations);
+      work_errors.push_back(
+          {"SimpleHarmonicMotion",
+           method.name,
+           number_of_evaluations,
+           *std::max_element(q_error.begin(), q_error.end()),
+           *std::max_element(v_error.begin(), v_error.end()),
+           *std::max_element(e_error.begin(), e_error.end())});
     }
-    q_error_data.emplace_back(PlottableDataset(evaluations, q_errors));
-    v_error_data.emplace_back(PlottableDataset(evaluations, v_errors));
-    e_error_data.emplace_back(PlottableDataset(evaluations, e_errors));
-    names.emplace_back(Escape(method.name));
   }
-  std::ofstream file;
-  file.open("simple_harmonic_motion_graphs.generated.wl");
-  file << Assign("qErrorData", q_error_data);
-  file << Assign("vErrorData", v_error_data);
-  file << Assign("eErrorData", e_error_data);
-  file << Assign("names", names);
-  file.close();
+  return work_errors;
 }
 
-void GenerateKeplerProblemWorkErrorGraphs() {
+std::vector<WorkError> KeplerProblemWorkErrors(int const stride) {
   SRKNIntegrator::Parameters<Length, Speed> parameters;
   SRKNIntegrator::Solution<Length, Speed> solution;
   // Semi-major axis.
@@ -235,18 +286,14 @@ void GenerateKeplerProblemWorkErrorGraphs() {
   // We use dense sampling in order to compute average errors, this leads to
   // more evaluations than reported for FSAL methods.
   parameters.sampling_period = 1;
-  std::vector<std::string> q_error_data;
-  std::vector<std::string> v_error_data;
-  std::vector<std::string> e_error_data;
-  std::vector<std::string> names;
+  std::vector<WorkError> work_errors;
   for (auto const& method : Methods()) {
     LOG(INFO) << method.name;
     parameters.Δt = method.stages * 1 * Second;
-    std::vector<Length> q_errors;
-    std::vector<Speed> v_errors;
-    std::vector<Energy> e_errors;
-    std::vector<double> evaluations;
     for (int i = 0; i < 500; ++i, parameters.Δt /= step_reduction) {
+      if (i % stride != 0) {
+        continue;
+      }
       int const number_of_evaluations =
           method.stages *
               static_cast<int>(std::floor(parameters.tmax / parameters.Δt));
@@ -284,26 +331,19 @@ void GenerateKeplerProblemWorkErrorGraphs() {
       // We plot the maximum error, i.e., the L∞ norm of the error.
       // Blanes and Moan (2002), or Blanes, Casas and Ros (2001) tend to use
       // the average error (the normalized L¹ norm) instead.
-      q_errors.emplace_back(*std::max_element(q_error.begin(), q_error.end()));
-      v_errors.emplace_back(*std::max_element(v_error.begin(), v_error.end()));
-      e_errors.emplace_back(*std::max_element(e_error.begin(), e_error.end()));
-      evaluations.emplace_back(number_of_evaluations);
+      work_errors.push_back(
+          {"KeplerProblem",
+           method.name,
+           number_of_evaluations,
+           *std::max_element(q_error.begin(), q_error.end()),
+           *std::max_element(v_error.begin(), v_error.end()),
+           *std::max_element(e_error.begin(), e_error.end())});
     }
-    q_error_data.emplace_back(PlottableDataset(evaluations, q_errors));
-    v_error_data.emplace_back(PlottableDataset(evaluations, v_errors));
-    e_error_data.emplace_back(PlottableDataset(evaluations, e_errors));
-    names.emplace_back(Escape(method.name));
   }
-  std::ofstream file;
-  file.open("kepler_problem_graphs.generated.wl");
-  file << Assign("qErrorData", q_error_data);
-  file << Assign("vErrorData", v_error_data);
-  file << Assign("eErrorData", e_error_data);
-  file << Assign("names", names);
-  file.close();
+  return work_errors;
 }
 
-void GenerateSolarSystemPlanetsWorkErrorGraph() {
+std::vector<WorkError> SolarSystemPlanetsWorkErrors(int const stride) {
   SRKNIntegrator::Parameters<Position<ICRFJ2000Ecliptic>,
                              Velocity<ICRFJ2000Ecliptic>> parameters;
   Energy initial_energy;
@@ -387,23 +427,19 @@ void GenerateSolarSystemPlanetsWorkErrorGraph() {
   }
   SRKNIntegrator::Solution<Position<ICRFJ2000Ecliptic>,
                            Velocity<ICRFJ2000Ecliptic>> solution;
-  std::vector<std::string> q_error_data;
-  std::vector<std::string> v_error_data;
-  std::vector<std::string> e_error_data;
-  std::vector<std::string> names;
+  std::vector<WorkError> work_errors;
   double const step_reduction = 1.015;
   for (auto const& method : Methods()) {
     LOG(INFO) << method.name;
     parameters.Δt = method.stages * 30 * Day;
-    std::vector<Length> q_errors;
-    std::vector<Speed> v_errors;
-    std::vector<Energy> e_errors;
-    std::vector<double> evaluations;
     for (int i = 0;
          parameters.Δt > 0 * Second;
          ++i,
          parameters.Δt = Δt_reference *
              std::floor((parameters.Δt / step_reduction) / Δt_reference)) {
+      if (i % stride != 0) {
+        continue;
+      }
       int const number_of_evaluations =
           method.stages *
               static_cast<int>(std::floor(parameters.tmax / parameters.Δt));
@@ -449,24 +485,169 @@ void GenerateSolarSystemPlanetsWorkErrorGraph() {
       // We plot the maximum error, i.e., the L∞ norm of the error.
       // Blanes and Moan (2002), or Blanes, Casas and Ros (2001) tend to use
       // the average error (the normalized L¹ norm) instead.
-      q_errors.emplace_back(q_error);
-      v_errors.emplace_back(v_error);
-      e_errors.emplace_back(e_error);
-      evaluations.emplace_back(number_of_evaluations);
+      work_errors.push_back({"SolarSystemPlanets",
+                             method.name,
+                             number_of_evaluations,
+                             q_error,
+                             v_error,
+                             e_error});
     }
-    q_error_data.emplace_back(PlottableDataset(evaluations, q_errors));
-    v_error_data.emplace_back(PlottableDataset(evaluations, v_errors));
-    e_error_data.emplace_back(PlottableDataset(evaluations, e_errors));
-    names.emplace_back(Escape(method.name));
   }
+  return work_errors;
+}
+
+}  // namespace
+
+void GenerateSimpleHarmonicMotionWorkErrorGraphs() {
+  WriteGraphs(SimpleHarmonicMotionWorkErrors(/*stride=*/1),
+              "simple_harmonic_motion_graphs.generated.wl");
+}
+
+void GenerateKeplerProblemWorkErrorGraphs() {
+  WriteGraphs(KeplerProblemWorkErrors(/*stride=*/1),
+              "kepler_problem_graphs.generated.wl");
+}
+
+void GenerateSolarSystemPlanetsWorkErrorGraph() {
+  WriteGraphs(SolarSystemPlanetsWorkErrors(/*stride=*/1),
+              "planets_graphs.generated.wl");
+}
+
+std::vector<WorkError> ComputeWorkErrors(int const stride) {
+  CHECK_LT(0, stride);
+  std::vector<WorkError> work_errors;
+  for (auto const& problem_work_errors :
+           {SimpleHarmonicMotionWorkErrors(stride),
+            KeplerProblemWorkErrors(stride),
+            SolarSystemPlanetsWorkErrors(stride)}) {
+    work_errors.insert(work_errors.end(),
+                       problem_work_errors.begin(),
+                       problem_work_errors.end());
+  }
+  return work_errors;
+}
+
+void WriteWorkErrorsCSV(std::vector<WorkError> const& work_errors,
+                        std::string const& filename) {
   std::ofstream file;
-  file.open("planets_graphs.generated.wl");
-  file << Assign("qErrorData", q_error_data);
-  file << Assign("vErrorData", v_error_data);
-  file << Assign("eErrorData", e_error_data);
-  file << Assign("names", names);
+  file.open(filename);
+  CHECK(file.good()) << filename;
+  file << std::setprecision(std::numeric_limits<double>::max_digits10);
+  file << kCSVHeader << "\n";
+  for (auto const& work_error : work_errors) {
+    file << work_error.problem << ","
+         << work_error.method << ","
+         << work_error.evaluations << ","
+         << work_error.position_error / Metre << ","
+         << work_error.velocity_error / (Metre / Second) << ","
+         << work_error.energy_error / Joule << "\n";
+  }
+  file.close();
+}
+
+void WriteWorkErrorsJSON(std::vector<WorkError> const& work_errors,
+                         std::string const& filename) {
+  std::ofstream file;
+  file.open(filename);
+  CHECK(file.good()) << filename;
+  file << std::setprecision(std::numeric_limits<double>::max_digits10);
+  file << "[";
+  for (int i = 0; i < work_errors.size(); ++i) {
+    WorkError const& work_error = work_errors[i];
+    file << (i == 0 ? "\n" : ",\n")
+         << "  {\"problem\": \"" << work_error.problem << "\", "
+         << "\"method\": \"" << work_error.method << "\", "
+         << "\"evaluations\": " << work_error.evaluations << ", "
+         << "\"position_error\": "
+         << JSONNumber(work_error.position_error / Metre) << ", "
+         << "\"velocity_error\": "
+         << JSONNumber(work_error.velocity_error / (Metre / Second)) << ", "
+         << "\"energy_error\": "
+         << JSONNumber(work_error.energy_error / Joule) << "}";
+  }
+  file << "\n]\n";
   file.close();
 }
 
+std::vector<WorkError> ReadWorkErrorsCSV(std::string const& filename) {
+  std::ifstream file;
+  file.open(filename);
+  CHECK(file.good()) << filename;
+  std::string line;
+  std::getline(file, line);
+  CHECK_EQ(kCSVHeader, line) << filename;
+  std::vector<WorkError> work_errors;
+  while (std::getline(file, line)) {
+    if (line.empty()) {
+      continue;
+    }
+    std::vector<std::string> fields;
+    std::stringstream stream(line);
+    for (std::string field; std::getline(stream, field, ',');) {
+      fields.push_back(field);
+    }
+    CHECK_EQ(6, fields.size()) << line;
+    work_errors.push_back({fields[0],
+                           fields[1],
+                           std::stoi(fields[2]),
+                           std::stod(fields[3]) * Metre,
+                           std::stod(fields[4]) * (Metre / Second),
+                           std::stod(fields[5]) * Joule});
+  }
+  return work_errors;
+}
+
+std::vector<std::string> WorkErrorRegressions(
+    std::vector<WorkError> const& baseline,
+    std::vector<WorkError> const& work_errors,
+    double const tolerance) {
+  std::map<std::tuple<std::string, std::string, int>, WorkError const*>
+      computed_points;
+  for (auto const& work_error : work_errors) {
+    computed_points.emplace(std::make_tuple(work_error.problem,
+                                            work_error.method,
+                                            work_error.evaluations),
+                            &work_error);
+  }
+  std::vector<std::string> regressions;
+  int compared = 0;
+  for (auto const& expected : baseline) {
+    auto const it = computed_points.find(std::make_tuple(
+        expected.problem, expected.method, expected.evaluations));
+    if (it == computed_points.end()) {
+      // A point that was not computed was not checked, which must not pass
+      // silently, e.g., if the stride or the methods changed.
+      std::stringstream regression;
+      regression << expected.problem << " " << expected.method << " with "
+                 << expected.evaluations << " evaluations: not computed";
+      regressions.push_back(regression.str());
+      continue;
+    }
+    ++compared;
+    WorkError const& work_error = *it->second;
+    if (Regressed(expected.position_error,
+                  work_error.position_error,
+                  tolerance) ||
+        Regressed(expected.velocity_error,
+                  work_error.velocity_error,
+                  tolerance) ||
+        Regressed(expected.energy_error, work_error.energy_error, tolerance)) {
+      std::stringstream regression;
+      regression << work_error.problem << " " << work_error.method << " with "
+                 << work_error.evaluations << " evaluations: errors "
+                 << work_error.position_error << ", "
+                 << work_error.velocity_error << ", "
+                 << work_error.energy_error << ", baseline "
+                 << expected.position_error << ", "
+                 << expected.velocity_error << ", "
+                 << expected.energy_error;
+      regressions.push_back(regression.str());
+    }
+  }
+  LOG(INFO) << "Compared " << compared << " points out of "
+            << baseline.size() << " in the baseline";
+  return regressions;
+}
+
 }  // namespace mathematica
 }  // namespace principia
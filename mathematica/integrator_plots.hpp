@@ -1,11 +1,59 @@
 #pragma once
 
+#include <string>
+#include <vector>
+
+#include "quantities/named_quantities.hpp"
+#include "quantities/quantities.hpp"
+
 namespace principia {
+
+using quantities::Energy;
+using quantities::Length;
+using quantities::Speed;
+
 namespace mathematica {
 
 void GenerateSimpleHarmonicMotionWorkErrorGraphs();
 void GenerateKeplerProblemWorkErrorGraphs();
 void GenerateSolarSystemPlanetsWorkErrorGraph();
 
+// A point of a work-error graph: the maximal errors of the integrator named
+// |method| on |problem| with the time step for which the integration costs
+// |evaluations| evaluations of the right-hand side.
+struct WorkError {
+  std::string problem;
+  std::string method;
+  int evaluations;
+  Length position_error;
+  Speed velocity_error;
+  Energy energy_error;
+};
+
+// Returns the points of the three graphs above, for all the methods, keeping
+// one time step out of |stride|.  The points are grouped by problem and by
+// method, in order of increasing number of evaluations.
+std::vector<WorkError> ComputeWorkErrors(int const stride);
+
+// The errors are written in SI units.  In JSON, non-finite errors are written
+// as null.
+void WriteWorkErrorsCSV(std::vector<WorkError> const& work_errors,
+                        std::string const& filename);
+void WriteWorkErrorsJSON(std::vector<WorkError> const& work_errors,
+                         std::string const& filename);
+// Reads a file written by |WriteWorkErrorsCSV|.
+std::vector<WorkError> ReadWorkErrorsCSV(std::string const& filename);
+
+// Returns a description of each point of |work_errors| one of whose errors
+// exceeds by more than a factor |1 + tolerance| that of the point of
+// |baseline| with the same problem, method and number of evaluations, and of
+// each point of |baseline| that has no counterpart in |work_errors|, so that
+// the baseline must be computed with the same stride.  The points of
+// |work_errors| that have no counterpart in |baseline| are not checked.
+std::vector<std::string> WorkErrorRegressions(
+    std::vector<WorkError> const& baseline,
+    std::vector<WorkError> const& work_errors,
+    double const tolerance);
+
 }  // namespace mathematica
 }  // namespace principia
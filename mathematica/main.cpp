@@ -1,12 +1,77 @@
 
+#include <string>
+#include <vector>
+
 #include "glog/logging.h"
 #include "mathematica/integrator_plots.hpp"
 
+namespace {
+
+// If |argument| is of the form --|name|=value, sets |value| and returns true.
+bool ParseFlag(std::string const& argument,
+               std::string const& name,
+               std::string* const value) {
+  std::string const prefix = "--" + name + "=";
+  if (argument.compare(0, prefix.size(), prefix) != 0) {
+    return false;
+  }
+  *value = argument.substr(prefix.size());
+  return true;
+}
+
+}  // namespace
+
+// Without arguments, generates the Mathematica work-error graphs.  Otherwise
+// computes the work-error tables for one time step out of
+// --work_error_stride, writes them to --work_error_csv and
+// --work_error_json if specified, and fails if they regress by more than
+// --work_error_tolerance with respect to the table --work_error_baseline, or if
+// they lack some of its points.
 int main(int argc, char const* argv[]) {
   google::InitGoogleLogging(argv[0]);
   google::LogToStderr();
-  principia::mathematica::GenerateSimpleHarmonicMotionWorkErrorGraphs();
-  principia::mathematica::GenerateKeplerProblemWorkErrorGraphs();
-  principia::mathematica::GenerateSolarSystemPlanetsWorkErrorGraph();
+  if (argc == 1) {
+    principia::mathematica::GenerateSimpleHarmonicMotionWorkErrorGraphs();
+    principia::mathematica::GenerateKeplerProblemWorkErrorGraphs();
+    principia::mathematica::GenerateSolarSystemPlanetsWorkErrorGraph();
+    return 0;
+  }
+
+  std::string csv;
+  std::string json;
+  std::string baseline;
+  std::string stride = "50";
+  std::string tolerance = "1";
+  for (int i = 1; i < argc; ++i) {
+    std::string const argument = argv[i];
+    CHECK(ParseFlag(argument, "work_error_csv", &csv) ||
+          ParseFlag(argument, "work_error_json", &json) ||
+          ParseFlag(argument, "work_error_baseline", &baseline) ||
+          ParseFlag(argument, "work_error_stride", &stride) ||
+          ParseFlag(argument, "work_error_tolerance", &tolerance))
+        << "Unknown argument " << argument;
+  }
+
+  std::vector<principia::mathematica::WorkError> const work_errors =
+      principia::mathematica::ComputeWorkErrors(std::stoi(stride));
+  if (!csv.empty()) {
+    principia::mathematica::WriteWorkErrorsCSV(work_errors, csv);
+  }
+  if (!json.empty()) {
+    principia::mathematica::WriteWorkErrorsJSON(work_errors, json);
+  }
+  if (!baseline.empty()) {
+    std::vector<std::string> const regressions =
+        principia::mathematica::WorkErrorRegressions(
+            principia::mathematica::ReadWorkErrorsCSV(baseline),
+            work_errors,
+            std::stod(tolerance));
+    for (auto const& regression : regressions) {
+      LOG(ERROR) << regression;
+    }
+    if (!regressions.empty()) {
+      return 1;
+    }
+  }
   return 0;
 }
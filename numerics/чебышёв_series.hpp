@@ -0,0 +1,87 @@
+﻿#pragma once
+
+#include <vector>
+
+#include "base/not_null.hpp"
+#include "geometry/named_quantities.hpp"
+#include "quantities/named_quantities.hpp"
+#include "quantities/quantities.hpp"
+#include "serialization/numerics.pb.h"
+
+namespace principia {
+
+using base::not_null;
+using geometry::Instant;
+using quantities::Time;
+using quantities::Variation;
+
+namespace numerics {
+
+// A Чебышёв series with values in the vector space |Vector|.  The argument is
+// an |Instant| in the interval [t_min, t_max], which is mapped affinely to
+// [-1, 1].
+template<typename Vector>
+class ЧебышёвSeries {
+ public:
+  // The element at position i in |coefficients| is the coefficient of Tᵢ.
+  // |t_min| must be strictly before |t_max|.
+  ЧебышёвSeries(std::vector<Vector> const& coefficients,
+                Instant const& t_min,
+                Instant const& t_max);
+  ЧебышёвSeries(ЧебышёвSeries&& other) = default;
+  ЧебышёвSeries& operator=(ЧебышёвSeries&& other) = default;
+
+  bool operator==(ЧебышёвSeries const& right) const;
+  bool operator!=(ЧебышёвSeries const& right) const;
+
+  Instant const& t_min() const;
+  Instant const& t_max() const;
+
+  // The coefficient of the term of highest degree.  For a well-converged
+  // series it is an estimate of the truncation error.
+  Vector const& last_coefficient() const;
+
+  int degree() const;
+
+  // The value of the series and of its derivative at |t|, which must be in
+  // [t_min, t_max].  Uses the Clenshaw algorithm.
+  Vector Evaluate(Instant const& t) const;
+  Variation<Vector> EvaluateDerivative(Instant const& t) const;
+
+  void WriteToMessage(
+      not_null<serialization::ChebyshevSeries*> const message) const;
+  static ЧебышёвSeries ReadFromMessage(
+      serialization::ChebyshevSeries const& message);
+
+  // Returns the series of the given |degree| which matches the values |q| and
+  // the derivatives |v| at the ends of [t_min, t_max] and approximates them in
+  // the least-squares sense at the interior points.  |q| and |v| must have
+  // |kNewhallSamples| elements, sampled at equally spaced times, including
+  // |t_min| and |t_max|.  |degree| must be in [kMinNewhallDegree,
+  // kMaxNewhallDegree].  The coefficients are linear combinations of the
+  // samples, so the cost is proportional to |degree| times |kNewhallSamples|.
+  // See Newhall (1989), Numerical representation of planetary ephemerides.
+  static ЧебышёвSeries NewhallApproximation(
+      int const degree,
+      std::vector<Vector> const& q,
+      std::vector<Variation<Vector>> const& v,
+      Instant const& t_min,
+      Instant const& t_max);
+
+  static int const kNewhallSamples = 9;
+  static int const kMinNewhallDegree = 3;
+  static int const kMaxNewhallDegree = 17;
+
+ private:
+  std::vector<Vector> coefficients_;
+  int degree_;
+  Instant t_min_;
+  Instant t_max_;
+  Instant t_mean_;
+  Time half_duration_;
+};
+
+}  // namespace numerics
+}  // namespace principia
+
+#include "numerics/чебышёв_series_body.hpp"
@@ -0,0 +1,296 @@
+﻿#pragma once
+
+#include "numerics/чебышёв_series.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+#include "glog/logging.h"
+
+namespace principia {
+namespace numerics {
+
+namespace {
+
+// The relative weight of the derivatives in the least-squares fit of the
+// Newhall approximation, as suggested by Newhall.
+double const kNewhallVelocityWeight = 0.4;
+
+// Solves the linear system |a| x = |b| in place by Gaussian elimination with
+// partial pivoting.  |a| is |n| × |n| and |b| is |n| × |m|, both row-major.  On
+// return |b| contains x.
+void SolveLinearSystem(int const n,
+                       int const m,
+                       std::vector<double>* const a,
+                       std::vector<double>* const b) {
+  std::vector<double>& aa = *a;
+  std::vector<double>& bb = *b;
+  for (int column = 0; column < n; ++column) {
+    int pivot = column;
+    for (int row = column + 1; row < n; ++row) {
+      if (std::abs(aa[row * n + column]) > std::abs(aa[pivot * n + column])) {
+        pivot = row;
+      }
+    }
+    CHECK_NE(0.0, aa[pivot * n + column]) << "Singular system";
+    if (pivot != column) {
+      for (int j = 0; j < n; ++j) {
+        std::swap(aa[pivot * n + j], aa[column * n + j]);
+      }
+      for (int j = 0; j < m; ++j) {
+        std::swap(bb[pivot * m + j], bb[column * m + j]);
+      }
+    }
+    for (int row = column + 1; row < n; ++row) {
+      double const factor = aa[row * n + column] / aa[column * n + column];
+      for (int j = column; j < n; ++j) {
+        aa[row * n + j] -= factor * aa[column * n + j];
+      }
+      for (int j = 0; j < m; ++j) {
+        bb[row * m + j] -= factor * bb[column * m + j];
+      }
+    }
+  }
+  for (int row = n - 1; row >= 0; --row) {
+    for (int j = 0; j < m; ++j) {
+      double x = bb[row * m + j];
+      for (int k = row + 1; k < n; ++k) {
+        x -= aa[row * n + k] * bb[k * m + j];
+      }
+      bb[row * m + j] = x / aa[row * n + row];
+    }
+  }
+}
+
+// Returns the matrix which maps the samples (q₀, v₀ h, q₁, v₁ h, ...) to the
+// coefficients of the Newhall approximation of the given |degree|, where h is
+// the half-duration of the interval.  The matrix is row-major, with
+// |degree + 1| rows and |2 * samples| columns.  It is obtained by minimizing
+// the weighted squared residuals at the |samples| subject to the constraints
+// that the values and derivatives be matched at both ends, using Lagrange
+// multipliers.
+std::vector<double> ComputeNewhallMatrix(int const degree, int const samples) {
+  int const n = degree + 1;
+  int const m = 2 * samples;
+  int const constraints = 4;
+  int const size = n + constraints;
+  double const w_squared = kNewhallVelocityWeight * kNewhallVelocityWeight;
+
+  // The values of Tₖ and of its derivative at the sample points, which are
+  // equally spaced in [-1, 1].
+  std::vector<std::vector<double>> t(samples, std::vector<double>(n));
+  std::vector<std::vector<double>> dt(samples, std::vector<double>(n));
+  for (int i = 0; i < samples; ++i) {
+    double const x = -1.0 + 2.0 * i / (samples - 1);
+    // Uₖ is used for the derivative: Tₖ′ = k Uₖ₋₁.
+    double t_kminus1 = 1.0;
+    double t_k = x;
+    double u_kminus2 = 0.0;
+    double u_kminus1 = 1.0;
+    t[i][0] = 1.0;
+    dt[i][0] = 0.0;
+    for (int k = 1; k < n; ++k) {
+      t[i][k] = t_k;
+      dt[i][k] = k * u_kminus1;
+      double const t_kplus1 = 2.0 * x * t_k - t_kminus1;
+      double const u_k = (k == 1 ? 2.0 * x : 2.0 * x * u_kminus1 - u_kminus2);
+      t_kminus1 = t_k;
+      t_k = t_kplus1;
+      u_kminus2 = u_kminus1;
+      u_kminus1 = u_k;
+    }
+  }
+
+  // The normal equations augmented with the constraints.
+  std::vector<double> a(size * size, 0.0);
+  std::vector<double> b(size * m, 0.0);
+  for (int k = 0; k < n; ++k) {
+    for (int l = 0; l < n; ++l) {
+      double sum = 0.0;
+      for (int i = 0; i < samples; ++i) {
+        sum += t[i][k] * t[i][l] + w_squared * dt[i][k] * dt[i][l];
+      }
+      a[k * size + l] = 2.0 * sum;
+    }
+    for (int i = 0; i < samples; ++i) {
+      b[k * m + 2 * i] = 2.0 * t[i][k];
+      b[k * m + 2 * i + 1] = 2.0 * w_squared * dt[i][k];
+    }
+  }
+  int const last = samples - 1;
+  for (int k = 0; k < n; ++k) {
+    double const constraint[constraints] =
+        {t[0][k], dt[0][k], t[last][k], dt[last][k]};
+    for (int c = 0; c < constraints; ++c) {
+      a[(n + c) * size + k] = constraint[c];
+      a[k * size + n + c] = constraint[c];
+    }
+  }
+  b[n * m] = 1.0;
+  b[(n + 1) * m + 1] = 1.0;
+  b[(n + 2) * m + 2 * last] = 1.0;
+  b[(n + 3) * m + 2 * last + 1] = 1.0;
+
+  SolveLinearSystem(size, m, &a, &b);
+  b.resize(n * m);
+  return b;
+}
+
+}  // namespace
+
+template<typename Vector>
+int const ЧебышёвSeries<Vector>::kNewhallSamples;
+template<typename Vector>
+int const ЧебышёвSeries<Vector>::kMinNewhallDegree;
+template<typename Vector>
+int const ЧебышёвSeries<Vector>::kMaxNewhallDegree;
+
+template<typename Vector>
+ЧебышёвSeries<Vector>::ЧебышёвSeries(std::vector<Vector> const& coefficients,
+                                     Instant const& t_min,
+                                     Instant const& t_max)
+    : coefficients_(coefficients),
+      degree_(static_cast<int>(coefficients_.size()) - 1),
+      t_min_(t_min),
+      t_max_(t_max),
+      t_mean_(t_min_ + (t_max_ - t_min_) / 2),
+      half_duration_((t_max_ - t_min_) / 2) {
+  CHECK_LE(0, degree_) << "Degree must be at least 0";
+  CHECK_LT(t_min_, t_max_) << "Time interval must not be empty";
+}
+
+template<typename Vector>
+bool ЧебышёвSeries<Vector>::operator==(ЧебышёвSeries const& right) const {
+  return coefficients_ == right.coefficients_ &&
+         t_min_ == right.t_min_ &&
+         t_max_ == right.t_max_;
+}
+
+template<typename Vector>
+bool ЧебышёвSeries<Vector>::operator!=(ЧебышёвSeries const& right) const {
+  return !ЧебышёвSeries<Vector>::operator==(right);
+}
+
+template<typename Vector>
+Instant const& ЧебышёвSeries<Vector>::t_min() const {
+  return t_min_;
+}
+
+template<typename Vector>
+Instant const& ЧебышёвSeries<Vector>::t_max() const {
+  return t_max_;
+}
+
+template<typename Vector>
+Vector const& ЧебышёвSeries<Vector>::last_coefficient() const {
+  return coefficients_.back();
+}
+
+template<typename Vector>
+int ЧебышёвSeries<Vector>::degree() const {
+  return degree_;
+}
+
+template<typename Vector>
+Vector ЧебышёвSeries<Vector>::Evaluate(Instant const& t) const {
+  double const scaled_t = (t - t_mean_) / half_duration_;
+  // We have to allow |scaled_t| to go slightly out of [-1, 1] because of
+  // computation errors.
+  CHECK_LE(std::abs(scaled_t), 1.1) << t << " not in [" << t_min_ << ", "
+                                    << t_max_ << "]";
+  double const two_scaled_t = scaled_t + scaled_t;
+  Vector b_kplus2{};
+  Vector b_kplus1{};
+  for (int k = degree_; k >= 1; --k) {
+    Vector const b_k = coefficients_[k] + two_scaled_t * b_kplus1 - b_kplus2;
+    b_kplus2 = b_kplus1;
+    b_kplus1 = b_k;
+  }
+  return coefficients_[0] + scaled_t * b_kplus1 - b_kplus2;
+}
+
+template<typename Vector>
+Variation<Vector> ЧебышёвSeries<Vector>::EvaluateDerivative(
+    Instant const& t) const {
+  double const scaled_t = (t - t_mean_) / half_duration_;
+  CHECK_LE(std::abs(scaled_t), 1.1) << t << " not in [" << t_min_ << ", "
+                                    << t_max_ << "]";
+  // The derivative of Σ cₖ Tₖ is Σ k cₖ Uₖ₋₁, which is evaluated by the
+  // Clenshaw algorithm for the polynomials Uₖ.
+  double const two_scaled_t = scaled_t + scaled_t;
+  Vector b_kplus2{};
+  Vector b_kplus1{};
+  for (int k = degree_ - 1; k >= 0; --k) {
+    Vector const b_k = (k + 1) * coefficients_[k + 1] +
+                       two_scaled_t * b_kplus1 - b_kplus2;
+    b_kplus2 = b_kplus1;
+    b_kplus1 = b_k;
+  }
+  return b_kplus1 / half_duration_;
+}
+
+template<typename Vector>
+void ЧебышёвSeries<Vector>::WriteToMessage(
+    not_null<serialization::ChebyshevSeries*> const message) const {
+  for (auto const& coefficient : coefficients_) {
+    coefficient.WriteToMessage(message->add_coefficient());
+  }
+  t_min_.WriteToMessage(message->mutable_t_min());
+  t_max_.WriteToMessage(message->mutable_t_max());
+}
+
+template<typename Vector>
+ЧебышёвSeries<Vector> ЧебышёвSeries<Vector>::ReadFromMessage(
+    serialization::ChebyshevSeries const& message) {
+  std::vector<Vector> coefficients;
+  coefficients.reserve(message.coefficient_size());
+  for (auto const& coefficient : message.coefficient()) {
+    coefficients.push_back(Vector::ReadFromMessage(coefficient));
+  }
+  return ЧебышёвSeries(coefficients,
+                       Instant::ReadFromMessage(message.t_min()),
+                       Instant::ReadFromMessage(message.t_max()));
+}
+
+template<typename Vector>
+ЧебышёвSeries<Vector> ЧебышёвSeries<Vector>::NewhallApproximation(
+    int const degree,
+    std::vector<Vector> const& q,
+    std::vector<Variation<Vector>> const& v,
+    Instant const& t_min,
+    Instant const& t_max) {
+  CHECK_LE(kMinNewhallDegree, degree);
+  CHECK_GE(kMaxNewhallDegree, degree);
+  CHECK_EQ(kNewhallSamples, static_cast<int>(q.size()));
+  CHECK_EQ(kNewhallSamples, static_cast<int>(v.size()));
+
+  // The matrices only depend on the degree, so they are computed once.
+  static std::vector<std::vector<double>> const* const newhall_matrices = [] {
+    auto* const matrices = new std::vector<std::vector<double>>;
+    for (int d = kMinNewhallDegree; d <= kMaxNewhallDegree; ++d) {
+      matrices->push_back(ComputeNewhallMatrix(d, kNewhallSamples));
+    }
+    return matrices;
+  }();
+  std::vector<double> const& matrix =
+      (*newhall_matrices)[degree - kMinNewhallDegree];
+
+  Time const half_duration = (t_max - t_min) / 2;
+  int const columns = 2 * kNewhallSamples;
+  std::vector<Vector> coefficients(degree + 1);
+  for (int k = 0; k <= degree; ++k) {
+    double const* const row = &matrix[k * columns];
+    Vector coefficient{};
+    for (int i = 0; i < kNewhallSamples; ++i) {
+      coefficient += row[2 * i] * q[i] +
+                     row[2 * i + 1] * (v[i] * half_duration);
+    }
+    coefficients[k] = coefficient;
+  }
+  return ЧебышёвSeries(coefficients, t_min, t_max);
+}
+
+}  // namespace numerics
+}  // namespace principia
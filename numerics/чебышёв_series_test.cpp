@@ -0,0 +1,173 @@
+﻿#include "numerics/чебышёв_series.hpp"
+
+#include <algorithm>
+#include <vector>
+
+#include "geometry/frame.hpp"
+#include "geometry/grassmann.hpp"
+#include "geometry/named_quantities.hpp"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "quantities/elementary_functions.hpp"
+#include "quantities/numbers.hpp"
+#include "quantities/si.hpp"
+#include "serialization/geometry.pb.h"
+#include "testing_utilities/almost_equals.hpp"
+
+namespace principia {
+
+using geometry::Displacement;
+using geometry::Frame;
+using geometry::Velocity;
+using quantities::Abs;
+using quantities::AngularFrequency;
+using quantities::Cos;
+using quantities::Length;
+using quantities::Sin;
+using quantities::Speed;
+using si::Metre;
+using si::Radian;
+using si::Second;
+using testing_utilities::AlmostEquals;
+using ::testing::Eq;
+using ::testing::Lt;
+
+namespace numerics {
+
+class ЧебышёвSeriesTest : public ::testing::Test {
+ protected:
+  using World = Frame<serialization::Frame::TestTag,
+                      serialization::Frame::TEST, true>;
+
+  ЧебышёвSeriesTest()
+      : t_min_(t0_ - 3 * Second),
+        t_max_(t0_ + 1 * Second) {}
+
+  Instant const t0_;
+  Instant const t_min_;
+  Instant const t_max_;
+};
+
+using ЧебышёвSeriesDeathTest = ЧебышёвSeriesTest;
+
+TEST_F(ЧебышёвSeriesDeathTest, Errors) {
+  EXPECT_DEATH({
+    ЧебышёвSeries<Length> p({}, t_min_, t_max_);
+  }, "Degree must be at least 0");
+  EXPECT_DEATH({
+    ЧебышёвSeries<Length> p({1 * Metre}, t_max_, t_min_);
+  }, "Time interval must not be empty");
+  EXPECT_DEATH({
+    ЧебышёвSeries<Length> p({1 * Metre}, t_min_, t_max_);
+    p.Evaluate(t_max_ + 1 * Second);
+  }, "not in ");
+  EXPECT_DEATH({
+    std::vector<Length> const q(5);
+    std::vector<Speed> const v(5);
+    ЧебышёвSeries<Length>::NewhallApproximation(5, q, v, t_min_, t_max_);
+  }, "q.size");
+}
+
+TEST_F(ЧебышёвSeriesTest, T0) {
+  ЧебышёвSeries<Length> const t0({1 * Metre}, t_min_, t_max_);
+  EXPECT_EQ(0, t0.degree());
+  EXPECT_THAT(t0.last_coefficient(), Eq(1 * Metre));
+  EXPECT_THAT(t0.Evaluate(t_min_), Eq(1 * Metre));
+  EXPECT_THAT(t0.Evaluate(t_max_), Eq(1 * Metre));
+  EXPECT_THAT(t0.Evaluate(t0_), Eq(1 * Metre));
+  EXPECT_THAT(t0.EvaluateDerivative(t0_), Eq(0 * Metre / Second));
+}
+
+TEST_F(ЧебышёвSeriesTest, T2) {
+  // 1 T₀ + 2 T₁ + 3 T₂ = 6 x² + 2 x - 2, where x = (t - t0_ + 1 s) / 2 s.
+  ЧебышёвSeries<Length> const p({1 * Metre, 2 * Metre, 3 * Metre},
+                                t_min_, t_max_);
+  EXPECT_EQ(2, p.degree());
+  EXPECT_THAT(p.last_coefficient(), Eq(3 * Metre));
+  EXPECT_THAT(p.Evaluate(t_min_), Eq(2 * Metre));
+  EXPECT_THAT(p.Evaluate(t_max_), Eq(6 * Metre));
+  EXPECT_THAT(p.Evaluate(t0_ - 1 * Second), Eq(-2 * Metre));
+  EXPECT_THAT(p.Evaluate(t0_), AlmostEquals(0.5 * Metre, 0));
+  // The derivative is (12 x + 2) / 2 s.
+  EXPECT_THAT(p.EvaluateDerivative(t_min_), Eq(-5 * Metre / Second));
+  EXPECT_THAT(p.EvaluateDerivative(t_max_), Eq(7 * Metre / Second));
+  EXPECT_THAT(p.EvaluateDerivative(t0_ - 1 * Second), Eq(1 * Metre / Second));
+}
+
+TEST_F(ЧебышёвSeriesTest, Vector) {
+  ЧебышёвSeries<Displacement<World>> const p(
+      {Displacement<World>({1 * Metre, 0 * Metre, -1 * Metre}),
+       Displacement<World>({0 * Metre, 2 * Metre, 1 * Metre})},
+      t_min_, t_max_);
+  EXPECT_THAT(p.Evaluate(t_max_),
+              Eq(Displacement<World>({1 * Metre, 2 * Metre, 0 * Metre})));
+  EXPECT_THAT(p.EvaluateDerivative(t0_),
+              Eq(Velocity<World>({0 * Metre / Second,
+                                  1 * Metre / Second,
+                                  0.5 * Metre / Second})));
+}
+
+TEST_F(ЧебышёвSeriesTest, Serialization) {
+  ЧебышёвSeries<Displacement<World>> const p(
+      {Displacement<World>({1 * Metre, 0 * Metre, -1 * Metre}),
+       Displacement<World>({0 * Metre, 2 * Metre, 1 * Metre}),
+       Displacement<World>({3 * Metre, -4 * Metre, 5 * Metre})},
+      t_min_, t_max_);
+  serialization::ChebyshevSeries message;
+  p.WriteToMessage(&message);
+  EXPECT_EQ(3, message.coefficient_size());
+  ЧебышёвSeries<Displacement<World>> const q =
+      ЧебышёвSeries<Displacement<World>>::ReadFromMessage(message);
+  EXPECT_EQ(p, q);
+  EXPECT_EQ(2, q.degree());
+  EXPECT_THAT(q.Evaluate(t0_), Eq(p.Evaluate(t0_)));
+}
+
+// The Newhall approximation matches the samples at the ends of the interval
+// and converges rapidly for smooth functions.
+TEST_F(ЧебышёвSeriesTest, NewhallApproximation) {
+  AngularFrequency const ω = 0.5 * Radian / Second;
+  auto const q = [this, ω](Instant const& t) {
+    return 10 * Metre * Sin(ω * (t - t0_)) + 3 * Metre;
+  };
+  auto const v = [this, ω](Instant const& t) {
+    return 10 * Metre * ω * Cos(ω * (t - t0_)) / Radian;
+  };
+  int const samples = ЧебышёвSeries<Length>::kNewhallSamples;
+  std::vector<Length> q_samples;
+  std::vector<Speed> v_samples;
+  for (int i = 0; i < samples; ++i) {
+    Instant const t = t_min_ + i * (t_max_ - t_min_) / (samples - 1);
+    q_samples.push_back(q(t));
+    v_samples.push_back(v(t));
+  }
+
+  std::vector<double> errors;
+  for (int degree = ЧебышёвSeries<Length>::kMinNewhallDegree;
+       degree <= ЧебышёвSeries<Length>::kMaxNewhallDegree;
+       ++degree) {
+    ЧебышёвSeries<Length> const series =
+        ЧебышёвSeries<Length>::NewhallApproximation(
+            degree, q_samples, v_samples, t_min_, t_max_);
+    EXPECT_EQ(degree, series.degree());
+    EXPECT_THAT(series.Evaluate(t_min_), AlmostEquals(q(t_min_), 0, 1000));
+    EXPECT_THAT(series.Evaluate(t_max_), AlmostEquals(q(t_max_), 0, 1000));
+    EXPECT_THAT(series.EvaluateDerivative(t_min_),
+                AlmostEquals(v(t_min_), 0, 1000));
+    EXPECT_THAT(series.EvaluateDerivative(t_max_),
+                AlmostEquals(v(t_max_), 0, 1000));
+    double error = 0;
+    for (Instant t = t_min_; t <= t_max_; t += 0.01 * Second) {
+      error = std::max(error, Abs(series.Evaluate(t) - q(t)) / Metre);
+    }
+    errors.push_back(error);
+  }
+  EXPECT_THAT(errors.front(), Lt(0.2));
+  EXPECT_THAT(errors[5 - ЧебышёвSeries<Length>::kMinNewhallDegree], Lt(1E-3));
+  EXPECT_THAT(errors[10 - ЧебышёвSeries<Length>::kMinNewhallDegree],
+              Lt(1E-9));
+  EXPECT_THAT(errors.back(), Lt(1E-11));
+}
+
+}  // namespace numerics
+}  // namespace principia
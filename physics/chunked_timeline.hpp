@@ -0,0 +1,164 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/mapped_file.hpp"
+#include "base/not_null.hpp"
+#include "geometry/named_quantities.hpp"
+
+namespace principia {
+
+using base::MappedFile;
+using base::not_null;
+using geometry::Instant;
+
+namespace physics {
+
+// A sequence of values indexed by strictly increasing times, which can only be
+// appended to at the end and truncated at either end.  This is the access
+// pattern of the timeline of a |Trajectory|, for which a |std::map| costs one
+// allocation per point and poor locality.  The values are stored contiguously
+// in blocks of |kBlockSize| entries, and lookups are binary searches.
+// Iterators remain valid when values are appended and when other values are
+// erased; the past-the-end iterator remains past-the-end when values are
+// appended.  Since the iterators refer to the container, it cannot be copied or
+// moved.
+// The oldest blocks may be archived to memory-mapped files, in which case they
+// are read transparently from the mappings.
+template<typename Value>
+class ChunkedTimeline {
+ public:
+  using value_type = std::pair<Instant, Value>;
+
+  class const_iterator {
+   public:
+    using iterator_category = std::bidirectional_iterator_tag;
+    using value_type = typename ChunkedTimeline::value_type;
+    using difference_type = std::ptrdiff_t;
+    using pointer = value_type const*;
+    using reference = value_type const&;
+
+    const_iterator() = default;
+
+    reference operator*() const;
+    pointer operator->() const;
+    const_iterator& operator++();
+    const_iterator& operator--();
+    const_iterator operator++(int);
+    const_iterator operator--(int);
+
+    bool operator==(const_iterator const& right) const;
+    bool operator!=(const_iterator const& right) const;
+
+   private:
+    const_iterator(ChunkedTimeline const* const timeline,
+                   std::int64_t const index);
+
+    ChunkedTimeline const* timeline_ = nullptr;
+    // An absolute index which does not change when values are erased at the
+    // front of the timeline, or |kEnd| for the past-the-end iterator.
+    std::int64_t index_ = kEnd;
+
+    friend class ChunkedTimeline;
+  };
+
+  ChunkedTimeline() = default;
+
+  ChunkedTimeline(ChunkedTimeline const&) = delete;
+  ChunkedTimeline(ChunkedTimeline&&) = delete;
+  ChunkedTimeline& operator=(ChunkedTimeline const&) = delete;
+  ChunkedTimeline& operator=(ChunkedTimeline&&) = delete;
+
+  bool empty() const;
+  std::size_t size() const;
+
+  const_iterator begin() const;
+  const_iterator end() const;
+
+  // Same semantics as the functions of |std::map|, complexity
+  // O(Ln(|size()|)), except that |lower_bound| is O(1) when |time| is after the
+  // last value.
+  const_iterator lower_bound(Instant const& time) const;
+  const_iterator upper_bound(Instant const& time) const;
+  const_iterator find(Instant const& time) const;
+
+  // |time| must be strictly after the time of the last value, if any.
+  // Amortized O(1), with one allocation every |kBlockSize| values.
+  void Append(Instant const& time, Value const& value);
+
+  // Erases the values in [first, last[, which must either start at |begin()|
+  // or end at |end()|.  The blocks that become empty are freed.
+  void erase(const_iterator const first, const_iterator const last);
+
+  // Moves the full blocks whose values are all strictly before |time| to
+  // memory-mapped temporary files, and frees their memory.  The blocks are
+  // appended to the file of the previous call until it is full; the next file
+  // is created in |directory|, with twice the capacity up to a limit, so that
+  // the number of files and mappings only grows with the amount of archived
+  // data, not with the number of calls.  A file is deleted when all its blocks
+  // have been erased.  The values are copied bitwise, so |Value| must be
+  // trivially copyable.  Iterators, which hold indices, remain valid, but
+  // references and pointers to the values of the archived blocks do not, since
+  // their memory is freed.  The archived values are copied back to memory if
+  // they are erased at the end of the timeline, which likewise invalidates the
+  // references to them.
+  void Archive(Instant const& time, std::string const& directory);
+
+  // The number of values in archived blocks, including erased ones.
+  std::int64_t archived_size() const;
+
+ private:
+  // A block of |kBlockSize| entries, except for the last one which may be
+  // shorter.  The entries of a resident block are in |resident|.  Those of an
+  // archived block are in |archive|, which is shared with the other blocks
+  // archived to the same file, and |resident| is empty.
+  struct Block {
+    Block();
+
+    std::vector<value_type> resident;
+    std::shared_ptr<MappedFile const> archive;
+    // The first entry of the block, in |resident| or in |archive|.
+    value_type const* data;
+  };
+
+  static std::int64_t const kBlockSize = 512;
+  static std::int64_t const kEnd;
+  // The bounds of the capacity, in blocks, of the archive files.
+  static std::int64_t const kMinimumArchiveBlocks = 16;
+  static std::int64_t const kMaximumArchiveBlocks = 2048;
+
+  value_type const& at(std::int64_t const index) const;
+
+  // Maps |kEnd| to |end_index_| so that the iterators may be compared.
+  std::int64_t IndexOf(const_iterator const& it) const;
+
+  // Copies the entries of |block| back to memory.
+  static void Unarchive(not_null<Block*> const block);
+
+  // Restores the invariants after the last value has been erased.
+  void ClearIfEmpty();
+
+  // The values with absolute indices in [begin_index_, end_index_[ are stored
+  // in |blocks_|.  The absolute index of the first entry of the first block is
+  // |first_block_ * kBlockSize|.  The entries of the first block which precede
+  // |begin_index_| have been erased and are not accessible.  The archived
+  // blocks, if any, are at the front.
+  std::deque<Block> blocks_;
+  std::int64_t first_block_ = 0;
+  std::int64_t begin_index_ = 0;
+  std::int64_t end_index_ = 0;
+
+  // The file to which the next blocks are archived if it is not full, or null.
+  std::shared_ptr<MappedFile> archive_;
+};
+
+}  // namespace physics
+}  // namespace principia
+
+#include "physics/chunked_timeline_body.hpp"
@@ -0,0 +1,298 @@
+#pragma once
+
+#include "physics/chunked_timeline.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+#include "glog/logging.h"
+
+namespace principia {
+namespace physics {
+
+template<typename Value>
+std::int64_t const ChunkedTimeline<Value>::kBlockSize;
+
+template<typename Value>
+std::int64_t const ChunkedTimeline<Value>::kMinimumArchiveBlocks;
+
+template<typename Value>
+std::int64_t const ChunkedTimeline<Value>::kMaximumArchiveBlocks;
+
+template<typename Value>
+std::int64_t const ChunkedTimeline<Value>::kEnd =
+    std::numeric_limits<std::int64_t>::max();
+
+template<typename Value>
+typename ChunkedTimeline<Value>::const_iterator::reference
+ChunkedTimeline<Value>::const_iterator::operator*() const {
+  return timeline_->at(index_);
+}
+
+template<typename Value>
+typename ChunkedTimeline<Value>::const_iterator::pointer
+ChunkedTimeline<Value>::const_iterator::operator->() const {
+  return &timeline_->at(index_);
+}
+
+template<typename Value>
+typename ChunkedTimeline<Value>::const_iterator&
+ChunkedTimeline<Value>::const_iterator::operator++() {
+  ++index_;
+  if (index_ == timeline_->end_index_) {
+    index_ = kEnd;
+  }
+  return *this;
+}
+
+template<typename Value>
+typename ChunkedTimeline<Value>::const_iterator&
+ChunkedTimeline<Value>::const_iterator::operator--() {
+  if (index_ == kEnd) {
+    index_ = timeline_->end_index_;
+  }
+  --index_;
+  return *this;
+}
+
+template<typename Value>
+typename ChunkedTimeline<Value>::const_iterator
+ChunkedTimeline<Value>::const_iterator::operator++(int) {
+  const_iterator const result = *this;
+  ++*this;
+  return result;
+}
+
+template<typename Value>
+typename ChunkedTimeline<Value>::const_iterator
+ChunkedTimeline<Value>::const_iterator::operator--(int) {
+  const_iterator const result = *this;
+  --*this;
+  return result;
+}
+
+template<typename Value>
+bool ChunkedTimeline<Value>::const_iterator::operator==(
+    const_iterator const& right) const {
+  return index_ == right.index_ && timeline_ == right.timeline_;
+}
+
+template<typename Value>
+bool ChunkedTimeline<Value>::const_iterator::operator!=(
+    const_iterator const& right) const {
+  return !operator==(right);
+}
+
+template<typename Value>
+ChunkedTimeline<Value>::const_iterator::const_iterator(
+    ChunkedTimeline const* const timeline,
+    std::int64_t const index)
+    : timeline_(timeline),
+      index_(index == timeline->end_index_ ? kEnd : index) {}
+
+template<typename Value>
+ChunkedTimeline<Value>::Block::Block() {
+  resident.reserve(kBlockSize);
+  data = resident.data();
+}
+
+template<typename Value>
+bool ChunkedTimeline<Value>::empty() const {
+  return begin_index_ == end_index_;
+}
+
+template<typename Value>
+std::size_t ChunkedTimeline<Value>::size() const {
+  return static_cast<std::size_t>(end_index_ - begin_index_);
+}
+
+template<typename Value>
+typename ChunkedTimeline<Value>::const_iterator
+ChunkedTimeline<Value>::begin() const {
+  return const_iterator(this, begin_index_);
+}
+
+template<typename Value>
+typename ChunkedTimeline<Value>::const_iterator
+ChunkedTimeline<Value>::end() const {
+  return const_iterator(this, kEnd);
+}
+
+template<typename Value>
+typename ChunkedTimeline<Value>::const_iterator
+ChunkedTimeline<Value>::lower_bound(Instant const& time) const {
+  // Lookups past the end are frequent, e.g., when appending to a fork.
+  if (empty() || at(end_index_ - 1).first < time) {
+    return end();
+  }
+  std::int64_t first = begin_index_;
+  std::int64_t count = end_index_ - begin_index_;
+  while (count > 0) {
+    std::int64_t const half = count / 2;
+    std::int64_t const middle = first + half;
+    if (at(middle).first < time) {
+      first = middle + 1;
+      count -= half + 1;
+    } else {
+      count = half;
+    }
+  }
+  return const_iterator(this, first);
+}
+
+template<typename Value>
+typename ChunkedTimeline<Value>::const_iterator
+ChunkedTimeline<Value>::upper_bound(Instant const& time) const {
+  const_iterator it = lower_bound(time);
+  if (it != end() && it->first == time) {
+    ++it;
+  }
+  return it;
+}
+
+template<typename Value>
+typename ChunkedTimeline<Value>::const_iterator
+ChunkedTimeline<Value>::find(Instant const& time) const {
+  const_iterator const it = lower_bound(time);
+  if (it != end() && it->first == time) {
+    return it;
+  } else {
+    return end();
+  }
+}
+
+template<typename Value>
+void ChunkedTimeline<Value>::Append(Instant const& time, Value const& value) {
+  if (!empty()) {
+    Instant const& last_time = at(end_index_ - 1).first;
+    CHECK_NE(last_time, time) << "Append at existing time " << time;
+    CHECK_LT(last_time, time) << "Append out of order at " << time;
+  }
+  if (end_index_ % kBlockSize == 0) {
+    if (blocks_.empty()) {
+      first_block_ = end_index_ / kBlockSize;
+    }
+    blocks_.emplace_back();
+  }
+  // No reallocation takes place since the capacity is |kBlockSize|, and the
+  // last block is never archived unless it is full.
+  blocks_.back().resident.emplace_back(time, value);
+  ++end_index_;
+}
+
+template<typename Value>
+void ChunkedTimeline<Value>::erase(const_iterator const first,
+                                   const_iterator const last) {
+  std::int64_t const first_index = IndexOf(first);
+  std::int64_t const last_index = IndexOf(last);
+  CHECK_LE(first_index, last_index);
+  if (first_index == last_index) {
+    return;
+  }
+  if (first_index == begin_index_) {
+    begin_index_ = last_index;
+    while (!blocks_.empty() &&
+           (first_block_ + 1) * kBlockSize <= begin_index_) {
+      blocks_.pop_front();
+      ++first_block_;
+    }
+  } else {
+    CHECK_EQ(end_index_, last_index) << "Erase in the middle of the timeline";
+    while (end_index_ > first_index) {
+      Block& last_block = blocks_.back();
+      if (last_block.archive != nullptr) {
+        Unarchive(&last_block);
+      }
+      last_block.resident.pop_back();
+      if (last_block.resident.empty()) {
+        blocks_.pop_back();
+      }
+      --end_index_;
+    }
+  }
+  ClearIfEmpty();
+}
+
+template<typename Value>
+void ChunkedTimeline<Value>::Archive(Instant const& time,
+                                     std::string const& directory) {
+  // |std::pair| is not trivially copyable because of its assignment, but a
+  // pair of trivially copyable members may be copied bitwise.
+  static_assert(std::is_trivially_copyable<Instant>::value &&
+                    std::is_trivially_copyable<Value>::value,
+                "Cannot archive values that are not trivially copyable");
+  std::int64_t const block_bytes = kBlockSize * sizeof(value_type);
+  // The archived blocks are at the front.
+  for (Block& block : blocks_) {
+    if (block.archive != nullptr) {
+      continue;
+    }
+    if (static_cast<std::int64_t>(block.resident.size()) != kBlockSize ||
+        !(block.data[kBlockSize - 1].first < time)) {
+      break;
+    }
+    if (archive_ == nullptr || archive_->size() == archive_->capacity()) {
+      std::int64_t const capacity =
+          archive_ == nullptr
+              ? kMinimumArchiveBlocks * block_bytes
+              : std::min(2 * archive_->capacity(),
+                         kMaximumArchiveBlocks * block_bytes);
+      archive_ = std::make_shared<MappedFile>(directory, capacity);
+    }
+    std::uint8_t* const data = archive_->Append(block_bytes);
+    std::memcpy(data, block.data, static_cast<std::size_t>(block_bytes));
+    block.archive = archive_;
+    block.data = reinterpret_cast<value_type const*>(data);
+    // Actually free the memory, |clear| would keep it.
+    std::vector<value_type>().swap(block.resident);
+  }
+}
+
+template<typename Value>
+std::int64_t ChunkedTimeline<Value>::archived_size() const {
+  std::int64_t size = 0;
+  for (Block const& block : blocks_) {
+    if (block.archive == nullptr) {
+      break;
+    }
+    size += kBlockSize;
+  }
+  return size;
+}
+
+template<typename Value>
+typename ChunkedTimeline<Value>::value_type const&
+ChunkedTimeline<Value>::at(std::int64_t const index) const {
+  return blocks_[index / kBlockSize - first_block_].data[index % kBlockSize];
+}
+
+template<typename Value>
+void ChunkedTimeline<Value>::Unarchive(not_null<Block*> const block) {
+  block->resident.reserve(kBlockSize);
+  block->resident.assign(block->data, block->data + kBlockSize);
+  block->data = block->resident.data();
+  block->archive.reset();
+}
+
+template<typename Value>
+std::int64_t ChunkedTimeline<Value>::IndexOf(const_iterator const& it) const {
+  CHECK_EQ(this, it.timeline_) << "Iterator into another timeline";
+  return it.index_ == kEnd ? end_index_ : it.index_;
+}
+
+template<typename Value>
+void ChunkedTimeline<Value>::ClearIfEmpty() {
+  if (empty()) {
+    // The first block may contain erased entries, so the next value must go
+    // at the beginning of a new block.
+    blocks_.clear();
+    end_index_ = (end_index_ + kBlockSize - 1) / kBlockSize * kBlockSize;
+    begin_index_ = end_index_;
+    first_block_ = end_index_ / kBlockSize;
+  }
+}
+
+}  // namespace physics
+}  // namespace principia
@@ -0,0 +1,189 @@
+#include "physics/chunked_timeline.hpp"
+
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "quantities/si.hpp"
+
+namespace principia {
+
+using si::Second;
+using ::testing::ElementsAre;
+using ::testing::Eq;
+
+namespace physics {
+
+class ChunkedTimelineTest : public testing::Test {
+ protected:
+  // Appends the values [first, last[ at times |t0_ + value * Second|.
+  void AppendRange(int const first, int const last) {
+    for (int i = first; i < last; ++i) {
+      timeline_.Append(Time(i), i);
+    }
+  }
+
+  Instant Time(int const i) const {
+    return t0_ + i * Second;
+  }
+
+  std::vector<int> Values() const {
+    std::vector<int> values;
+    for (auto const& pair : timeline_) {
+      values.push_back(pair.second);
+    }
+    return values;
+  }
+
+  Instant const t0_;
+  ChunkedTimeline<int> timeline_;
+};
+
+using ChunkedTimelineDeathTest = ChunkedTimelineTest;
+
+TEST_F(ChunkedTimelineDeathTest, Errors) {
+  EXPECT_DEATH({
+    timeline_.Append(Time(2), 2);
+    timeline_.Append(Time(1), 1);
+  }, "out of order");
+  EXPECT_DEATH({
+    timeline_.Append(Time(1), 1);
+    timeline_.Append(Time(1), 1);
+  }, "existing time");
+  EXPECT_DEATH({
+    AppendRange(0, 10);
+    timeline_.erase(timeline_.find(Time(3)), timeline_.find(Time(5)));
+  }, "middle");
+}
+
+// Lookups across block boundaries.
+TEST_F(ChunkedTimelineTest, Lookup) {
+  int const size = 2000;
+  EXPECT_TRUE(timeline_.empty());
+  EXPECT_TRUE(timeline_.begin() == timeline_.end());
+  EXPECT_TRUE(timeline_.lower_bound(Time(0)) == timeline_.end());
+  AppendRange(0, size);
+  EXPECT_FALSE(timeline_.empty());
+  EXPECT_EQ(size, static_cast<int>(timeline_.size()));
+  for (int i = 0; i < size; ++i) {
+    EXPECT_EQ(i, timeline_.find(Time(i))->second);
+    EXPECT_EQ(i, timeline_.lower_bound(Time(i) - 0.5 * Second)->second);
+    EXPECT_EQ(i, timeline_.upper_bound(Time(i) - 0.5 * Second)->second);
+    if (i + 1 < size) {
+      EXPECT_EQ(i + 1, timeline_.upper_bound(Time(i))->second);
+    }
+  }
+  EXPECT_TRUE(timeline_.find(Time(size)) == timeline_.end());
+  EXPECT_TRUE(timeline_.find(Time(3) + 0.5 * Second) == timeline_.end());
+  EXPECT_TRUE(timeline_.upper_bound(Time(size - 1)) == timeline_.end());
+  EXPECT_EQ(size - 1, (--timeline_.end())->second);
+  int expected = 0;
+  for (auto it = timeline_.begin(); it != timeline_.end(); ++it) {
+    EXPECT_THAT(it->first, Eq(Time(expected)));
+    ++expected;
+  }
+  EXPECT_EQ(size, expected);
+}
+
+// The iterators are not invalidated by appending or by erasing other values,
+// and the past-the-end iterator stays past the end.
+TEST_F(ChunkedTimelineTest, IteratorStability) {
+  auto const end = timeline_.end();
+  AppendRange(0, 3);
+  auto const last = --timeline_.end();
+  AppendRange(3, 1500);
+  EXPECT_TRUE(end == timeline_.end());
+  EXPECT_EQ(2, last->second);
+  auto next = last;
+  EXPECT_EQ(3, (++next)->second);
+
+  auto const middle = timeline_.find(Time(1000));
+  timeline_.erase(timeline_.begin(), timeline_.find(Time(700)));
+  EXPECT_EQ(1000, middle->second);
+  EXPECT_EQ(700, timeline_.begin()->second);
+  timeline_.erase(timeline_.find(Time(1200)), timeline_.end());
+  EXPECT_EQ(1000, middle->second);
+  EXPECT_EQ(1199, (--timeline_.end())->second);
+  EXPECT_EQ(500, static_cast<int>(timeline_.size()));
+}
+
+TEST_F(ChunkedTimelineTest, Erase) {
+  AppendRange(0, 5);
+  timeline_.erase(timeline_.begin(), timeline_.upper_bound(Time(1)));
+  EXPECT_THAT(Values(), ElementsAre(2, 3, 4));
+  timeline_.erase(timeline_.upper_bound(Time(3)), timeline_.end());
+  EXPECT_THAT(Values(), ElementsAre(2, 3));
+  timeline_.erase(timeline_.begin(), timeline_.end());
+  EXPECT_TRUE(timeline_.empty());
+  EXPECT_TRUE(timeline_.begin() == timeline_.end());
+
+  // Values may be appended after the timeline has been emptied, including at
+  // earlier times.
+  AppendRange(1, 1000);
+  timeline_.erase(timeline_.find(Time(600)), timeline_.end());
+  AppendRange(600, 1100);
+  timeline_.erase(timeline_.begin(), timeline_.find(Time(1090)));
+  EXPECT_THAT(Values(),
+              ElementsAre(1090, 1091, 1092, 1093, 1094,
+                          1095, 1096, 1097, 1098, 1099));
+}
+
+// The archived values are read transparently, and copied back to memory when
+// values are erased at the end.
+TEST_F(ChunkedTimelineTest, Archive) {
+  AppendRange(0, 2000);
+  auto const it = timeline_.find(Time(100));
+  // Only the first two blocks are strictly before the horizon.
+  timeline_.Archive(Time(1100), ".");
+  EXPECT_EQ(1024, timeline_.archived_size());
+  EXPECT_EQ(100, it->second);
+  EXPECT_EQ(2000, static_cast<int>(timeline_.size()));
+  for (int i = 0; i < 2000; ++i) {
+    EXPECT_EQ(i, timeline_.find(Time(i))->second);
+  }
+  // Archiving again is a no-op for the blocks already archived.
+  timeline_.Archive(Time(1600), ".");
+  EXPECT_EQ(1536, timeline_.archived_size());
+
+  timeline_.erase(timeline_.begin(), timeline_.find(Time(600)));
+  EXPECT_EQ(1024, timeline_.archived_size());
+  EXPECT_EQ(600, timeline_.begin()->second);
+  timeline_.erase(timeline_.find(Time(1000)), timeline_.end());
+  EXPECT_EQ(0, timeline_.archived_size());
+  AppendRange(1000, 1010);
+  EXPECT_EQ(410, static_cast<int>(timeline_.size()));
+  int expected = 600;
+  for (auto const& pair : timeline_) {
+    EXPECT_EQ(expected, pair.second);
+    ++expected;
+  }
+}
+
+// Archiving one block at a time fills the archive files one after the other.
+TEST_F(ChunkedTimelineTest, ArchiveIncrementally) {
+  int const block_size = 512;
+  for (int block = 0; block < 100; ++block) {
+    AppendRange(block * block_size, (block + 1) * block_size);
+    timeline_.Archive(Time((block + 1) * block_size), ".");
+    EXPECT_EQ((block + 1) * block_size, timeline_.archived_size());
+  }
+  for (int i = 0; i < 100 * block_size; i += 97) {
+    EXPECT_EQ(i, timeline_.find(Time(i))->second);
+  }
+
+  // Erase the blocks of the first file, and some of the second.
+  timeline_.erase(timeline_.begin(), timeline_.find(Time(20 * block_size)));
+  EXPECT_EQ(80 * block_size, timeline_.archived_size());
+  AppendRange(100 * block_size, 101 * block_size);
+  timeline_.Archive(Time(101 * block_size), ".");
+  EXPECT_EQ(81 * block_size, timeline_.archived_size());
+  int expected = 20 * block_size;
+  for (auto const& pair : timeline_) {
+    EXPECT_EQ(expected, pair.second);
+    ++expected;
+  }
+  EXPECT_EQ(101 * block_size, expected);
+}
+
+}  // namespace physics
+}  // namespace principia
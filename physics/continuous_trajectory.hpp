@@ -0,0 +1,135 @@
+﻿#pragma once
+
+#include <deque>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "base/not_null.hpp"
+#include "geometry/grassmann.hpp"
+#include "geometry/named_quantities.hpp"
+#include "numerics/чебышёв_series.hpp"
+#include "physics/degrees_of_freedom.hpp"
+#include "quantities/quantities.hpp"
+#include "serialization/physics.pb.h"
+
+namespace principia {
+
+using base::not_null;
+using geometry::Displacement;
+using geometry::Instant;
+using geometry::Position;
+using geometry::Velocity;
+using numerics::ЧебышёвSeries;
+using quantities::Length;
+using quantities::Time;
+
+namespace physics {
+
+// A trajectory which is represented by a sequence of Чебышёв series fitted to
+// equally spaced points.  Each series covers |kStepsPerSeries| steps and is
+// obtained by a Newhall approximation whose degree is chosen so that the
+// estimated error is below a given tolerance.  The storage is a few
+// coefficients per series instead of one point per step, and evaluation at an
+// arbitrary time is O(1).
+template<typename Frame>
+class ContinuousTrajectory {
+ public:
+  // The number of steps covered by each series, i.e., one less than the number
+  // of points used to fit it.
+  static int const kStepsPerSeries =
+      ЧебышёвSeries<Displacement<Frame>>::kNewhallSamples - 1;
+
+  // The points appended to the trajectory must be separated by |step|.  The
+  // position error of the approximation is at most |tolerance| at these points,
+  // and its estimated error, based on the last coefficient of the series, is at
+  // most |tolerance| elsewhere, unless the maximum degree is reached, in which
+  // case an error is logged.  For positions far from the origin the tolerance
+  // is raised to a few ulps of the positions.
+  ContinuousTrajectory(Time const& step, Length const& tolerance);
+
+  ContinuousTrajectory(ContinuousTrajectory const&) = delete;
+  ContinuousTrajectory(ContinuousTrajectory&&) = delete;
+  ContinuousTrajectory& operator=(ContinuousTrajectory const&) = delete;
+  ContinuousTrajectory& operator=(ContinuousTrajectory&&) = delete;
+
+  // Returns true if this trajectory cannot be evaluated, because fewer than
+  // |kStepsPerSeries + 1| points have been appended since its creation.
+  bool empty() const;
+
+  // The interval over which the trajectory may be evaluated.  The trajectory
+  // must not be empty.
+  Instant t_min() const;
+  Instant t_max() const;
+
+  // Appends one point to the trajectory.  |time| must be |step| after the last
+  // appended time, if any.  A new series is fitted every |kStepsPerSeries|
+  // points.
+  void Append(Instant const& time,
+              DegreesOfFreedom<Frame> const& degrees_of_freedom);
+
+  // Removes the series which end strictly before |time|, which must be at most
+  // |t_max()|.  |t_min()| becomes the beginning of a series that contains
+  // |time|.
+  void ForgetBefore(Instant const& time);
+
+  // The position, velocity and degrees of freedom at |time|, which must be in
+  // [t_min(), t_max()].
+  Position<Frame> EvaluatePosition(Instant const& time) const;
+  Velocity<Frame> EvaluateVelocity(Instant const& time) const;
+  DegreesOfFreedom<Frame> EvaluateDegreesOfFreedom(Instant const& time) const;
+
+  // The time and degrees of freedom of the last point appended, from which the
+  // computation of the trajectory may be resumed.  At least one point must have
+  // been appended.
+  std::pair<Instant, DegreesOfFreedom<Frame>> const& last_point() const;
+
+  // The average degree of the series currently held by this trajectory.  Only
+  // useful for analyzing the performance of the compression.
+  double average_degree() const;
+
+  void WriteToMessage(
+      not_null<serialization::ContinuousTrajectory*> const message) const;
+  // Same as |WriteToMessage|, but only writes the series which end at or after
+  // |time|, i.e., those that were not complete at |time|.
+  void WriteTailToMessage(
+      Instant const& time,
+      not_null<serialization::ContinuousTrajectory*> const message) const;
+  // Merges into this trajectory a |message| written by |WriteTailToMessage|:
+  // the series of this trajectory which don't end before the first series of
+  // |message| are replaced by those of |message|, and so are the points
+  // appended since the last series.
+  void MergeTailFromMessage(
+      serialization::ContinuousTrajectory const& message);
+  static not_null<std::unique_ptr<ContinuousTrajectory>> ReadFromMessage(
+      serialization::ContinuousTrajectory const& message);
+
+ private:
+  // Fits a series to |last_points_|, trying degrees starting just below that
+  // of the previous series.
+  void ComputeBestNewhallApproximation();
+
+  // The series which covers |time|, found in O(1) since all the series have the
+  // same duration.
+  ЧебышёвSeries<Displacement<Frame>> const& FindSeriesForInstant(
+      Instant const& time) const;
+
+  Time const step_;
+  Length const tolerance_;
+
+  // The series are approximations of the displacement from the origin of
+  // |Frame|, in increasing order of time, without gaps.
+  std::deque<ЧебышёвSeries<Displacement<Frame>>> series_;
+
+  // The degree of the last series, used as a starting point for the next one.
+  int degree_;
+
+  // The points which have been appended since the last series was fitted.  The
+  // first element is the last point of the previous series, if any.
+  std::vector<std::pair<Instant, DegreesOfFreedom<Frame>>> last_points_;
+};
+
+}  // namespace physics
+}  // namespace principia
+
+#include "physics/continuous_trajectory_body.hpp"
@@ -0,0 +1,256 @@
+﻿#pragma once
+
+#include "physics/continuous_trajectory.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "glog/logging.h"
+
+namespace principia {
+
+using base::make_not_null_unique;
+using quantities::Abs;
+
+namespace physics {
+
+namespace {
+
+// The number of ulps of the positions below which the fitting error is
+// considered to be roundoff.
+double const kRoundoffUlps = 8;
+
+}  // namespace
+
+template<typename Frame>
+int const ContinuousTrajectory<Frame>::kStepsPerSeries;
+
+template<typename Frame>
+ContinuousTrajectory<Frame>::ContinuousTrajectory(Time const& step,
+                                                  Length const& tolerance)
+    : step_(step),
+      tolerance_(tolerance),
+      degree_(ЧебышёвSeries<Displacement<Frame>>::kMinNewhallDegree) {
+  CHECK_LT(Time(), step_);
+  CHECK_LT(Length(), tolerance_);
+}
+
+template<typename Frame>
+bool ContinuousTrajectory<Frame>::empty() const {
+  return series_.empty();
+}
+
+template<typename Frame>
+Instant ContinuousTrajectory<Frame>::t_min() const {
+  CHECK(!empty()) << "Empty trajectory";
+  return series_.front().t_min();
+}
+
+template<typename Frame>
+Instant ContinuousTrajectory<Frame>::t_max() const {
+  CHECK(!empty()) << "Empty trajectory";
+  return series_.back().t_max();
+}
+
+template<typename Frame>
+void ContinuousTrajectory<Frame>::Append(
+    Instant const& time,
+    DegreesOfFreedom<Frame> const& degrees_of_freedom) {
+  if (!last_points_.empty()) {
+    // The times computed by the integrators may be a few ulps away from the
+    // nominal ones.
+    Time const Δt = time - last_points_.back().first;
+    CHECK_LT(Abs(Δt - step_), 1E-6 * step_)
+        << "Append at " << time << " inconsistent with step " << step_;
+  }
+  last_points_.emplace_back(time, degrees_of_freedom);
+  if (static_cast<int>(last_points_.size()) == kStepsPerSeries + 1) {
+    ComputeBestNewhallApproximation();
+    // The last point is the first point of the next series.
+    last_points_.erase(last_points_.begin(), last_points_.end() - 1);
+  }
+}
+
+template<typename Frame>
+void ContinuousTrajectory<Frame>::ForgetBefore(Instant const& time) {
+  CHECK_LE(time, t_max());
+  while (series_.front().t_max() < time) {
+    series_.pop_front();
+  }
+}
+
+template<typename Frame>
+Position<Frame> ContinuousTrajectory<Frame>::EvaluatePosition(
+    Instant const& time) const {
+  return Frame::origin + FindSeriesForInstant(time).Evaluate(time);
+}
+
+template<typename Frame>
+Velocity<Frame> ContinuousTrajectory<Frame>::EvaluateVelocity(
+    Instant const& time) const {
+  return FindSeriesForInstant(time).EvaluateDerivative(time);
+}
+
+template<typename Frame>
+DegreesOfFreedom<Frame> ContinuousTrajectory<Frame>::EvaluateDegreesOfFreedom(
+    Instant const& time) const {
+  ЧебышёвSeries<Displacement<Frame>> const& series =
+      FindSeriesForInstant(time);
+  return DegreesOfFreedom<Frame>(Frame::origin + series.Evaluate(time),
+                                 series.EvaluateDerivative(time));
+}
+
+template<typename Frame>
+std::pair<Instant, DegreesOfFreedom<Frame>> const&
+ContinuousTrajectory<Frame>::last_point() const {
+  CHECK(!last_points_.empty()) << "No point appended";
+  return last_points_.back();
+}
+
+template<typename Frame>
+double ContinuousTrajectory<Frame>::average_degree() const {
+  if (series_.empty()) {
+    return 0;
+  }
+  double total_degree = 0;
+  for (auto const& series : series_) {
+    total_degree += series.degree();
+  }
+  return total_degree / series_.size();
+}
+
+template<typename Frame>
+void ContinuousTrajectory<Frame>::WriteToMessage(
+    not_null<serialization::ContinuousTrajectory*> const message) const {
+  // All the series end at or after |t_min()|.
+  WriteTailToMessage(empty() ? Instant() : t_min(), message);
+}
+
+template<typename Frame>
+void ContinuousTrajectory<Frame>::WriteTailToMessage(
+    Instant const& time,
+    not_null<serialization::ContinuousTrajectory*> const message) const {
+  step_.WriteToMessage(message->mutable_step());
+  tolerance_.WriteToMessage(message->mutable_tolerance());
+  for (auto const& series : series_) {
+    if (series.t_max() >= time) {
+      series.WriteToMessage(message->add_series());
+    }
+  }
+  message->set_degree(degree_);
+  for (auto const& point : last_points_) {
+    auto* const instantaneous_degrees_of_freedom = message->add_last_point();
+    point.first.WriteToMessage(
+        instantaneous_degrees_of_freedom->mutable_instant());
+    point.second.WriteToMessage(
+        instantaneous_degrees_of_freedom->mutable_degrees_of_freedom());
+  }
+}
+
+template<typename Frame>
+void ContinuousTrajectory<Frame>::MergeTailFromMessage(
+    serialization::ContinuousTrajectory const& message) {
+  CHECK_EQ(step_, Time::ReadFromMessage(message.step()));
+  CHECK_EQ(tolerance_, Length::ReadFromMessage(message.tolerance()));
+  if (message.series_size() > 0) {
+    Instant const first_t_min =
+        Instant::ReadFromMessage(message.series(0).t_min());
+    while (!series_.empty() && series_.back().t_max() > first_t_min) {
+      series_.pop_back();
+    }
+  }
+  for (auto const& series : message.series()) {
+    series_.push_back(
+        ЧебышёвSeries<Displacement<Frame>>::ReadFromMessage(series));
+  }
+  degree_ = message.degree();
+  last_points_.clear();
+  for (auto const& point : message.last_point()) {
+    last_points_.emplace_back(
+        Instant::ReadFromMessage(point.instant()),
+        DegreesOfFreedom<Frame>::ReadFromMessage(point.degrees_of_freedom()));
+  }
+}
+
+template<typename Frame>
+not_null<std::unique_ptr<ContinuousTrajectory<Frame>>>
+ContinuousTrajectory<Frame>::ReadFromMessage(
+    serialization::ContinuousTrajectory const& message) {
+  auto continuous_trajectory =
+      make_not_null_unique<ContinuousTrajectory<Frame>>(
+          Time::ReadFromMessage(message.step()),
+          Length::ReadFromMessage(message.tolerance()));
+  continuous_trajectory->MergeTailFromMessage(message);
+  return continuous_trajectory;
+}
+
+template<typename Frame>
+void ContinuousTrajectory<Frame>::ComputeBestNewhallApproximation() {
+  using Series = ЧебышёвSeries<Displacement<Frame>>;
+  std::vector<Displacement<Frame>> q;
+  std::vector<Velocity<Frame>> v;
+  for (auto const& point : last_points_) {
+    q.push_back(point.second.position() - Frame::origin);
+    v.push_back(point.second.velocity());
+  }
+  Instant const& t_min = last_points_.front().first;
+  Instant const& t_max = last_points_.back().first;
+
+  // The positions cannot be fitted more precisely than they are represented,
+  // so far from the origin the tolerance is raised to a few ulps.
+  Length largest_position;
+  for (auto const& displacement : q) {
+    largest_position = std::max(largest_position, displacement.Norm());
+  }
+  Length const adjusted_tolerance =
+      std::max(tolerance_,
+               kRoundoffUlps * std::numeric_limits<double>::epsilon() *
+                   largest_position);
+
+  // Start one degree below the previous series so that the degree may decrease
+  // when the trajectory becomes smoother.
+  for (int degree = std::max(Series::kMinNewhallDegree, degree_ - 1);;
+       ++degree) {
+    Series series = Series::NewhallApproximation(degree, q, v, t_min, t_max);
+    // The last coefficient estimates the error between the points; the
+    // residuals at the points are checked explicitly.
+    Length error = series.last_coefficient().Norm();
+    for (std::size_t i = 0; i < last_points_.size(); ++i) {
+      error = std::max(
+          error, (series.Evaluate(last_points_[i].first) - q[i]).Norm());
+    }
+    if (error <= adjusted_tolerance || degree == Series::kMaxNewhallDegree) {
+      LOG_IF(ERROR, error > adjusted_tolerance)
+          << "Error " << error << " above tolerance " << adjusted_tolerance
+          << " at maximum degree " << degree << " for [" << t_min << ", "
+          << t_max << "]";
+      degree_ = degree;
+      series_.push_back(std::move(series));
+      return;
+    }
+  }
+}
+
+template<typename Frame>
+ЧебышёвSeries<Displacement<Frame>> const&
+ContinuousTrajectory<Frame>::FindSeriesForInstant(Instant const& time) const {
+  CHECK_LE(t_min(), time) << "Evaluation before t_min";
+  CHECK_LE(time, t_max()) << "Evaluation after t_max";
+  // All the series have nominally the same duration, so the index is
+  // obtained by a division, up to roundoff.
+  std::size_t index = static_cast<std::size_t>(
+      (time - t_min()) / ((t_max() - t_min()) / series_.size()));
+  index = std::min(index, series_.size() - 1);
+  while (time < series_[index].t_min()) {
+    --index;
+  }
+  while (time > series_[index].t_max()) {
+    ++index;
+  }
+  return series_[index];
+}
+
+}  // namespace physics
+}  // namespace principia
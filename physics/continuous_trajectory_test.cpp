@@ -0,0 +1,205 @@
+﻿#include "physics/continuous_trajectory.hpp"
+
+#include <algorithm>
+#include <functional>
+
+#include "geometry/frame.hpp"
+#include "geometry/grassmann.hpp"
+#include "geometry/named_quantities.hpp"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "quantities/elementary_functions.hpp"
+#include "quantities/numbers.hpp"
+#include "quantities/si.hpp"
+#include "serialization/geometry.pb.h"
+
+namespace principia {
+
+using geometry::Frame;
+using quantities::AngularFrequency;
+using quantities::Cos;
+using quantities::Sin;
+using quantities::Speed;
+using si::Metre;
+using si::Micro;
+using si::Milli;
+using si::Minute;
+using si::Radian;
+using si::Second;
+using ::testing::Eq;
+using ::testing::Gt;
+using ::testing::Lt;
+
+namespace physics {
+
+class ContinuousTrajectoryTest : public testing::Test {
+ protected:
+  using World = Frame<serialization::Frame::TestTag,
+                      serialization::Frame::TEST, true>;
+
+  // Appends to |trajectory| the points of a circular orbit of radius
+  // |radius_| from |t0_| to |t0_ + duration|, at intervals of |step|.
+  void AppendCircularOrbit(Time const& step,
+                           Time const& duration,
+                           ContinuousTrajectory<World>* const trajectory) {
+    for (Instant t = t0_; t <= t0_ + duration; t += step) {
+      trajectory->Append(t, CircularOrbit(t));
+    }
+  }
+
+  DegreesOfFreedom<World> CircularOrbit(Instant const& t) const {
+    return DegreesOfFreedom<World>(
+        World::origin +
+            Displacement<World>({radius_ * Cos(ω_ * (t - t0_)),
+                                 radius_ * Sin(ω_ * (t - t0_)),
+                                 0 * Metre}),
+        Velocity<World>({-radius_ * ω_ * Sin(ω_ * (t - t0_)) / Radian,
+                         radius_ * ω_ * Cos(ω_ * (t - t0_)) / Radian,
+                         0 * Metre / Second}));
+  }
+
+  // Roughly the orbit of the Mun around Kerbin.
+  Length const radius_ = 1.2E7 * Metre;
+  AngularFrequency const ω_ = 4.52E-5 * Radian / Second;
+  Instant const t0_;
+};
+
+using ContinuousTrajectoryDeathTest = ContinuousTrajectoryTest;
+
+TEST_F(ContinuousTrajectoryDeathTest, Errors) {
+  EXPECT_DEATH({
+    ContinuousTrajectory<World> trajectory(1 * Second, 1 * Milli(Metre));
+    trajectory.t_min();
+  }, "Empty trajectory");
+  EXPECT_DEATH({
+    ContinuousTrajectory<World> trajectory(1 * Second, 1 * Milli(Metre));
+    trajectory.Append(t0_, CircularOrbit(t0_));
+    trajectory.Append(t0_ + 2 * Second, CircularOrbit(t0_ + 2 * Second));
+  }, "inconsistent with step");
+  EXPECT_DEATH({
+    ContinuousTrajectory<World> trajectory(1 * Second, 1 * Milli(Metre));
+    AppendCircularOrbit(1 * Second, 8 * Second, &trajectory);
+    trajectory.EvaluatePosition(t0_ + 9 * Second);
+  }, "t_max");
+}
+
+// The series are only created when enough points have been appended, and
+// they cover the trajectory without gaps.
+TEST_F(ContinuousTrajectoryTest, Append) {
+  Time const step = 1 * Minute;
+  int const steps = ContinuousTrajectory<World>::kStepsPerSeries;
+  ContinuousTrajectory<World> trajectory(step, 1 * Milli(Metre));
+  AppendCircularOrbit(step, (steps - 1) * step, &trajectory);
+  EXPECT_TRUE(trajectory.empty());
+  trajectory.Append(t0_ + steps * step, CircularOrbit(t0_ + steps * step));
+  EXPECT_FALSE(trajectory.empty());
+  EXPECT_THAT(trajectory.t_min(), Eq(t0_));
+  EXPECT_THAT(trajectory.t_max(), Eq(t0_ + steps * step));
+  for (int i = steps + 1; i <= 3 * steps; ++i) {
+    trajectory.Append(t0_ + i * step, CircularOrbit(t0_ + i * step));
+  }
+  EXPECT_THAT(trajectory.t_max(), Eq(t0_ + 3 * steps * step));
+  for (int i = 0; i <= 3 * steps; ++i) {
+    EXPECT_THAT((trajectory.EvaluatePosition(t0_ + i * step) -
+                     CircularOrbit(t0_ + i * step).position()).Norm(),
+                Lt(1 * Milli(Metre)));
+  }
+}
+
+// The approximation is within the tolerance between the points, and its
+// degree increases when the tolerance decreases.  For a tolerance of 1 mm the
+// series, which cover 8 minutes, have fewer than 8 coefficients, that is, at
+// most 7 × 3 doubles.  A |Trajectory| sampled every 10 s over the same
+// interval would hold 48 points of 7 doubles each, not counting the nodes of
+// the map: the compression ratio is more than 15.
+TEST_F(ContinuousTrajectoryTest, Accuracy) {
+  Time const step = 1 * Minute;
+  Time const duration = 2 * π * Radian / ω_;
+  ContinuousTrajectory<World> coarse(step, 1 * Milli(Metre));
+  ContinuousTrajectory<World> fine(step, 1 * Micro(Metre));
+  AppendCircularOrbit(step, duration, &coarse);
+  AppendCircularOrbit(step, duration, &fine);
+  EXPECT_THAT(coarse.average_degree(), Lt(7));
+  EXPECT_THAT(fine.average_degree(), Gt(coarse.average_degree()));
+
+  Length coarse_position_error;
+  Length fine_position_error;
+  Speed coarse_velocity_error;
+  for (Instant t = coarse.t_min(); t <= coarse.t_max(); t += 10 * Second) {
+    DegreesOfFreedom<World> const expected = CircularOrbit(t);
+    coarse_position_error =
+        std::max(coarse_position_error,
+                 (coarse.EvaluatePosition(t) - expected.position()).Norm());
+    fine_position_error =
+        std::max(fine_position_error,
+                 (fine.EvaluatePosition(t) - expected.position()).Norm());
+    coarse_velocity_error =
+        std::max(coarse_velocity_error,
+                 (coarse.EvaluateVelocity(t) - expected.velocity()).Norm());
+  }
+  EXPECT_THAT(coarse_position_error, Lt(1 * Milli(Metre)));
+  EXPECT_THAT(fine_position_error, Lt(1 * Micro(Metre)));
+  EXPECT_THAT(coarse_velocity_error, Lt(1 * Micro(Metre) / Second));
+}
+
+TEST_F(ContinuousTrajectoryTest, ForgetBefore) {
+  Time const step = 1 * Minute;
+  int const steps = ContinuousTrajectory<World>::kStepsPerSeries;
+  ContinuousTrajectory<World> trajectory(step, 1 * Milli(Metre));
+  AppendCircularOrbit(step, 10 * steps * step, &trajectory);
+  Instant const t = t0_ + 3.5 * steps * step;
+  Position<World> const expected_position = trajectory.EvaluatePosition(t);
+  trajectory.ForgetBefore(t);
+  EXPECT_THAT(trajectory.t_min(), Eq(t0_ + 3 * steps * step));
+  EXPECT_THAT(trajectory.EvaluatePosition(t), Eq(expected_position));
+  trajectory.ForgetBefore(t0_ + 5 * steps * step);
+  EXPECT_THAT(trajectory.t_min(), Eq(t0_ + 4 * steps * step));
+  trajectory.ForgetBefore(trajectory.t_max());
+  EXPECT_FALSE(trajectory.empty());
+  EXPECT_THAT(trajectory.t_min(), Eq(t0_ + 9 * steps * step));
+}
+
+TEST_F(ContinuousTrajectoryTest, Serialization) {
+  Time const step = 1 * Minute;
+  int const steps = ContinuousTrajectory<World>::kStepsPerSeries;
+  ContinuousTrajectory<World> trajectory(step, 1 * Milli(Metre));
+  AppendCircularOrbit(step, (4 * steps + 3) * step, &trajectory);
+  serialization::ContinuousTrajectory message;
+  trajectory.WriteToMessage(&message);
+  EXPECT_EQ(4, message.series_size());
+  EXPECT_EQ(4, message.last_point_size());
+  Instant const since = trajectory.last_point().first;
+
+  // The trajectory read from |message| continues like the original one.
+  not_null<std::unique_ptr<ContinuousTrajectory<World>>> const read_trajectory =
+      ContinuousTrajectory<World>::ReadFromMessage(message);
+  EXPECT_THAT(read_trajectory->t_min(), Eq(trajectory.t_min()));
+  EXPECT_THAT(read_trajectory->t_max(), Eq(trajectory.t_max()));
+  EXPECT_THAT(read_trajectory->last_point().first, Eq(since));
+  for (Instant t = since + step; t <= t0_ + 10 * steps * step; t += step) {
+    trajectory.Append(t, CircularOrbit(t));
+    read_trajectory->Append(t, CircularOrbit(t));
+  }
+  Instant const t = t0_ + 7.5 * steps * step;
+  EXPECT_THAT(read_trajectory->EvaluateDegreesOfFreedom(t),
+              Eq(trajectory.EvaluateDegreesOfFreedom(t)));
+
+  // The tail since the first save only holds the series that were incomplete
+  // at that time, and merging it into the first save yields the whole
+  // trajectory.
+  serialization::ContinuousTrajectory tail;
+  trajectory.WriteTailToMessage(since, &tail);
+  EXPECT_EQ(6, tail.series_size());
+  not_null<std::unique_ptr<ContinuousTrajectory<World>>> const
+      merged_trajectory = ContinuousTrajectory<World>::ReadFromMessage(message);
+  merged_trajectory->MergeTailFromMessage(tail);
+  serialization::ContinuousTrajectory merged_message;
+  merged_trajectory->WriteToMessage(&merged_message);
+  serialization::ContinuousTrajectory full_message;
+  trajectory.WriteToMessage(&full_message);
+  EXPECT_EQ(full_message.SerializeAsString(),
+            merged_message.SerializeAsString());
+}
+
+}  // namespace physics
+}  // namespace principia
@@ -0,0 +1,243 @@
+﻿#pragma once
+
+#include <map>
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "base/macros.hpp"
+#include "base/not_null.hpp"
+#include "base/thread_pool.hpp"
+#include "geometry/grassmann.hpp"
+#include "geometry/named_quantities.hpp"
+#include "integrators/embedded_runge_kutta_nystrom_integrator.hpp"
+#include "integrators/symplectic_runge_kutta_nystrom_integrator.hpp"
+#include "physics/continuous_trajectory.hpp"
+#include "physics/degrees_of_freedom.hpp"
+#include "physics/massive_body.hpp"
+#include "physics/n_body_system.hpp"
+#include "physics/trajectory.hpp"
+#include "quantities/named_quantities.hpp"
+#include "quantities/quantities.hpp"
+#include "serialization/physics.pb.h"
+
+namespace principia {
+
+using base::not_null;
+using base::ThreadPool;
+using geometry::Instant;
+using geometry::Position;
+using geometry::Vector;
+using geometry::Velocity;
+using integrators::EmbeddedRKNIntegrator;
+using integrators::SRKNIntegrator;
+using integrators::SymplecticIntegrator;
+using quantities::Acceleration;
+using quantities::GravitationalParameter;
+using quantities::Length;
+using quantities::Speed;
+using quantities::Time;
+
+namespace physics {
+
+// The trajectories of a set of massive bodies, integrated once and stored as
+// Чебышёв series, and the gravitational field that they create.  The
+// motion of massless bodies may be computed in that field without integrating
+// the massive bodies again, so the cost of a step is proportional to the
+// number of massless bodies times the number of massive bodies.
+// The member functions may be called concurrently from several threads, e.g.,
+// to compute a prediction in the background while the prolongations are being
+// computed.  The massive bodies are only integrated by one thread at a time,
+// and the evaluations of their positions wait until the integration is done.
+template<typename Frame>
+class Ephemeris {
+  static_assert(Frame::is_inertial, "Frame must be inertial");
+
+ public:
+  using Trajectories = std::vector<not_null<Trajectory<Frame>*>>;  // Not owned.
+
+  // The |bodies| must be distinct and must outlive the ephemeris.
+  // |initial_state| is parallel to |bodies| and gives their degrees of freedom
+  // at |initial_time|.  The massive bodies are integrated with
+  // |planetary_integrator| using the constant step |step|, and their positions
+  // are approximated within |fitting_tolerance| by |ContinuousTrajectory|.
+  Ephemeris(std::vector<not_null<MassiveBody const*>> const& bodies,
+            std::vector<DegreesOfFreedom<Frame>> const& initial_state,
+            Instant const& initial_time,
+            SRKNIntegrator const& planetary_integrator,
+            Time const& step,
+            Length const& fitting_tolerance);
+  virtual ~Ephemeris() = default;
+
+  Ephemeris(Ephemeris const&) = delete;
+  Ephemeris(Ephemeris&&) = delete;
+  Ephemeris& operator=(Ephemeris const&) = delete;
+  Ephemeris& operator=(Ephemeris&&) = delete;
+
+  // The interval over which the ephemeris may be evaluated.  It is never empty.
+  Instant t_min() const;
+  Instant t_max() const;
+
+  // The position and degrees of freedom of |body| at |t|, which must be in
+  // [t_min(), t_max()].
+  Position<Frame> EvaluatePosition(not_null<MassiveBody const*> const body,
+                                   Instant const& t) const;
+  DegreesOfFreedom<Frame> EvaluateDegreesOfFreedom(
+      not_null<MassiveBody const*> const body,
+      Instant const& t) const;
+
+  // Integrates the massive bodies until |t_max() >= t|.
+  void Prolong(Instant const& t);
+
+  // Forgets the parts of the trajectories of the massive bodies which end
+  // before |t|.  |t| must be at most |t_max()|.  See
+  // |ContinuousTrajectory::ForgetBefore|.
+  void ForgetBefore(Instant const& t);
+
+  // Integrates the |trajectories|, which must be those of distinct massless
+  // bodies and must all have the same |last().time()|, in the gravitational
+  // field of the massive bodies, taking their intrinsic accelerations into
+  // account.  The parameters have the same meaning as for
+  // |NBodySystem::Integrate|.  If |tmax_is_exact|, the last point appended to
+  // the trajectories is exactly at |tmax|.  The ephemeris is prolonged as
+  // needed.
+  virtual void FlowWithFixedStep(SRKNIntegrator const& integrator,
+                                 Instant const& tmax,
+                                 Time const& Δt,
+                                 int const sampling_period,
+                                 bool const tmax_is_exact,
+                                 Trajectories const& trajectories);
+
+  // Same as above, but the step is adapted by |integrator| so that the local
+  // errors in position and velocity remain below the given tolerances.  This
+  // is much cheaper than a fixed step for trajectories with close approaches.
+  // A point is appended to the trajectories at the end of each step, and the
+  // last one is exactly at |tmax|.
+  virtual void FlowWithAdaptiveStep(
+      EmbeddedRKNIntegrator const& integrator,
+      Instant const& tmax,
+      Time const& first_time_step,
+      Length const& length_integration_tolerance,
+      Speed const& speed_integration_tolerance,
+      Trajectories const& trajectories);
+
+  // Computes the accelerations of the massless bodies on |number_of_threads|
+  // threads in subsequent calls to |FlowWithFixedStep| and
+  // |FlowWithAdaptiveStep|.  The results do not depend on the number of
+  // threads.  The default is 1.  Must not be called while a flow is running on
+  // another thread.
+  void set_number_of_threads(int const number_of_threads);
+
+  void WriteToMessage(not_null<serialization::Ephemeris*> const message) const;
+  // Same as |WriteToMessage|, but only writes the tails of the trajectories
+  // since |time|, see |ContinuousTrajectory::WriteTailToMessage|.
+  void WriteTailToMessage(
+      Instant const& time,
+      not_null<serialization::Ephemeris*> const message) const;
+  // The |bodies| must be parallel to those of the ephemeris that wrote
+  // |message|.  The integration of the massive bodies is resumed with
+  // |planetary_integrator| from the last points of the trajectories.
+  // NOTE(egg): This should return a |not_null|, but we can't do that until
+  // |not_null<std::unique_ptr<T>>| is convertible to |std::unique_ptr<T>|, and
+  // that requires a VS 2015 feature (rvalue references for |*this|).
+  static std::unique_ptr<Ephemeris> ReadFromMessage(
+      std::vector<not_null<MassiveBody const*>> const& bodies,
+      SRKNIntegrator const& planetary_integrator,
+      serialization::Ephemeris const& message);
+
+ private:
+  using OwnedContinuousTrajectories =
+      std::vector<not_null<std::unique_ptr<ContinuousTrajectory<Frame>>>>;
+  using ReadonlyTrajectories = std::vector<not_null<Trajectory<Frame> const*>>;
+  // The state of the massless bodies, laid out as described below.
+  using MasslessSystemState = SymplecticIntegrator::SystemState<Length, Speed>;
+
+  // Starts the integration of the massive bodies from the last points of the
+  // |trajectories|, which are parallel to |bodies| and must all have the same
+  // time.  The points computed by the integration are appended to the
+  // |trajectories|, which must have been constructed with |step|.
+  Ephemeris(std::vector<not_null<MassiveBody const*>> const& bodies,
+            OwnedContinuousTrajectories trajectories,
+            SRKNIntegrator const& planetary_integrator,
+            Time const& step);
+
+  // Returns trajectories starting with the given |initial_state| at
+  // |initial_time|.
+  static OwnedContinuousTrajectories NewTrajectories(
+      std::vector<DegreesOfFreedom<Frame>> const& initial_state,
+      Instant const& initial_time,
+      Time const& step,
+      Length const& fitting_tolerance);
+
+  // Checks that the |trajectories| may be flowed, fills
+  // |massless_trajectories| and returns their common last time.
+  Instant CheckMasslessTrajectories(
+      Trajectories const& trajectories,
+      not_null<ReadonlyTrajectories*> const massless_trajectories) const;
+
+  // Converts between the last points of the |trajectories| and the states used
+  // by the integrators, which are relative to |reference_position| and
+  // |reference_time|.
+  static void FillInitialState(
+      Trajectories const& trajectories,
+      Position<Frame> const& reference_position,
+      Instant const& reference_time,
+      not_null<MasslessSystemState*> const initial_state);
+  static void AppendMasslessState(MasslessSystemState const& state,
+                                  Instant const& time,
+                                  Position<Frame> const& reference_position,
+                                  Trajectories const& trajectories);
+  // The |IntegrationOrigin| of the centroid of the last points of the
+  // |trajectories|.
+  static Position<Frame> ReferencePosition(Trajectories const& trajectories);
+
+  // Computes the accelerations of the |massless_trajectories| at time
+  // |reference_time + t|.  |q| and |result| are laid out as in |NBodySystem|:
+  // the x coordinates of all the bodies, followed by the y coordinates,
+  // followed by the z coordinates, relative to |reference_position|.
+  void ComputeMasslessBodiesGravitationalAccelerations(
+      ReadonlyTrajectories const& massless_trajectories,
+      Position<Frame> const& reference_position,
+      Instant const& reference_time,
+      Time const& t,
+      std::vector<Length> const& q,
+      not_null<std::vector<Acceleration>*> const result) const;
+
+  std::vector<not_null<MassiveBody const*>> const bodies_;
+  std::map<not_null<MassiveBody const*>, std::size_t> body_indices_;
+  // The indices in |bodies_| of the oblate and spherical bodies, and the
+  // gravitational parameters of the latter, in the form expected by
+  // |AddPointMassAccelerations|.
+  std::vector<std::size_t> oblate_indices_;
+  std::vector<std::size_t> spherical_indices_;
+  std::vector<GravitationalParameter> spherical_gravitational_parameters_;
+
+  not_null<SRKNIntegrator const*> const planetary_integrator_;
+  Time const step_;
+  NBodySystem<Frame> n_body_system_;
+
+  // Parallel to |bodies_|.
+  mutable std::mutex lock_;
+  OwnedContinuousTrajectories trajectories_ GUARDED_BY(lock_);
+  // The points computed by |integration_| which have not yet been appended to
+  // |trajectories_|.
+  std::vector<not_null<std::unique_ptr<Trajectory<Frame>>>>
+      integrated_trajectories_ GUARDED_BY(lock_);
+  // The integration of the massive bodies, which is resumed by |Prolong|.  It
+  // keeps its state between calls, so the integration is not restarted for
+  // each series.
+  std::unique_ptr<typename NBodySystem<Frame>::Integration> integration_
+      GUARDED_BY(lock_);
+  // The time of the last point computed by |integration_|.  It is at or after
+  // |t_max()|, since the series are only fitted when enough points are
+  // available.
+  Instant last_time_ GUARDED_BY(lock_);
+
+  // Null if multithreading is disabled.
+  std::unique_ptr<ThreadPool> thread_pool_;
+};
+
+}  // namespace physics
+}  // namespace principia
+
+#include "physics/ephemeris_body.hpp"
@@ -0,0 +1,540 @@
+﻿#pragma once
+
+#include "physics/ephemeris.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <set>
+#include <vector>
+
+#include "base/map_util.hpp"
+#include "geometry/r3_element.hpp"
+#include "glog/logging.h"
+#include "physics/oblate_body.hpp"
+#include "physics/point_mass_accelerations.hpp"
+#include "quantities/elementary_functions.hpp"
+
+namespace principia {
+
+using base::FindOrDie;
+using base::make_not_null_unique;
+using geometry::R3Element;
+using quantities::Exponentiation;
+using quantities::Speed;
+using quantities::Sqrt;
+
+namespace physics {
+
+template<typename Frame>
+Ephemeris<Frame>::Ephemeris(
+    std::vector<not_null<MassiveBody const*>> const& bodies,
+    std::vector<DegreesOfFreedom<Frame>> const& initial_state,
+    Instant const& initial_time,
+    SRKNIntegrator const& planetary_integrator,
+    Time const& step,
+    Length const& fitting_tolerance)
+    : Ephemeris(bodies,
+                NewTrajectories(initial_state,
+                                initial_time,
+                                step,
+                                fitting_tolerance),
+                planetary_integrator,
+                step) {}
+
+template<typename Frame>
+Instant Ephemeris<Frame>::t_min() const {
+  std::lock_guard<std::mutex> l(lock_);
+  return trajectories_.front()->t_min();
+}
+
+template<typename Frame>
+Instant Ephemeris<Frame>::t_max() const {
+  std::lock_guard<std::mutex> l(lock_);
+  return trajectories_.front()->t_max();
+}
+
+template<typename Frame>
+Position<Frame> Ephemeris<Frame>::EvaluatePosition(
+    not_null<MassiveBody const*> const body,
+    Instant const& t) const {
+  std::size_t const b = FindOrDie(body_indices_, body);
+  std::lock_guard<std::mutex> l(lock_);
+  return trajectories_[b]->EvaluatePosition(t);
+}
+
+template<typename Frame>
+DegreesOfFreedom<Frame> Ephemeris<Frame>::EvaluateDegreesOfFreedom(
+    not_null<MassiveBody const*> const body,
+    Instant const& t) const {
+  std::size_t const b = FindOrDie(body_indices_, body);
+  std::lock_guard<std::mutex> l(lock_);
+  return trajectories_[b]->EvaluateDegreesOfFreedom(t);
+}
+
+template<typename Frame>
+void Ephemeris<Frame>::Prolong(Instant const& t) {
+  // The series are fitted every |kStepsPerSeries| steps, so we integrate by
+  // chunks of that many steps.  Since the integration does not stop exactly at
+  // its |tmax|, there may be more than one chunk even if |t| is close.
+  std::lock_guard<std::mutex> l(lock_);
+  while (trajectories_.front()->empty() ||
+         trajectories_.front()->t_max() < t) {
+    integration_->Advance(
+        last_time_ + ContinuousTrajectory<Frame>::kStepsPerSeries * step_);
+
+    // All the trajectories have the same times.  Move the new points to
+    // |trajectories_|.
+    last_time_ = integrated_trajectories_.front()->last().time();
+    for (std::size_t b = 0; b < bodies_.size(); ++b) {
+      Trajectory<Frame>& integrated_trajectory = *integrated_trajectories_[b];
+      for (auto it = integrated_trajectory.first(); !it.at_end(); ++it) {
+        trajectories_[b]->Append(it.time(), it.degrees_of_freedom());
+      }
+      integrated_trajectory.ForgetBefore(last_time_);
+    }
+  }
+}
+
+template<typename Frame>
+void Ephemeris<Frame>::ForgetBefore(Instant const& t) {
+  std::lock_guard<std::mutex> l(lock_);
+  for (auto const& trajectory : trajectories_) {
+    trajectory->ForgetBefore(t);
+  }
+}
+
+template<typename Frame>
+void Ephemeris<Frame>::FlowWithFixedStep(SRKNIntegrator const& integrator,
+                                         Instant const& tmax,
+                                         Time const& Δt,
+                                         int const sampling_period,
+                                         bool const tmax_is_exact,
+                                         Trajectories const& trajectories) {
+  if (trajectories.empty()) {
+    return;
+  }
+
+  SRKNIntegrator::Parameters<Length, Speed> parameters;
+
+  // As in |NBodySystem|, the positions are relative to an origin close to the
+  // massless bodies and the time is not translated.
+  Position<Frame> const reference_position = ReferencePosition(trajectories);
+  Instant const reference_time;
+
+  ReadonlyTrajectories massless_trajectories;
+  Instant const t0 = CheckMasslessTrajectories(trajectories,
+                                               &massless_trajectories);
+  CHECK_LE(t0, tmax);
+  // See |NBodySystem::Integrate| for why we don't call the integrator in this
+  // case.
+  if (tmax_is_exact && t0 == tmax) {
+    return;
+  }
+  Prolong(tmax);
+
+  FillInitialState(trajectories,
+                   reference_position,
+                   reference_time,
+                   &parameters.initial);
+  parameters.tmax = tmax - reference_time;
+  parameters.Δt = Δt;
+  parameters.sampling_period = sampling_period;
+  parameters.tmax_is_exact = tmax_is_exact;
+  integrator.SolveTrivialKineticEnergyIncrement<Length>(
+      std::bind(&Ephemeris::ComputeMasslessBodiesGravitationalAccelerations,
+                this,
+                massless_trajectories,
+                reference_position,
+                reference_time,
+                std::placeholders::_1,
+                std::placeholders::_2,
+                std::placeholders::_3),
+      parameters,
+      [&reference_position, &reference_time, &trajectories](
+          MasslessSystemState const& state) {
+        // If |tmax_is_exact| the integrator ends exactly at |tmax|.
+        AppendMasslessState(state,
+                            state.time.value + reference_time,
+                            reference_position,
+                            trajectories);
+      });
+}
+
+template<typename Frame>
+void Ephemeris<Frame>::FlowWithAdaptiveStep(
+    EmbeddedRKNIntegrator const& integrator,
+    Instant const& tmax,
+    Time const& first_time_step,
+    Length const& length_integration_tolerance,
+    Speed const& speed_integration_tolerance,
+    Trajectories const& trajectories) {
+  if (trajectories.empty()) {
+    return;
+  }
+
+  EmbeddedRKNIntegrator::Parameters<Length> parameters;
+  EmbeddedRKNIntegrator::Solution<Length> solution;
+
+  Position<Frame> const reference_position = ReferencePosition(trajectories);
+  Instant const reference_time;
+
+  ReadonlyTrajectories massless_trajectories;
+  Instant const t0 = CheckMasslessTrajectories(trajectories,
+                                               &massless_trajectories);
+  CHECK_LE(t0, tmax);
+  if (t0 == tmax) {
+    return;
+  }
+  Prolong(tmax);
+
+  FillInitialState(trajectories,
+                   reference_position,
+                   reference_time,
+                   &parameters.initial);
+  parameters.tmax = tmax - reference_time;
+  parameters.first_time_step = first_time_step;
+  parameters.length_tolerance = length_integration_tolerance;
+  parameters.speed_tolerance = speed_integration_tolerance;
+  integrator.Solve<Length>(
+      std::bind(&Ephemeris::ComputeMasslessBodiesGravitationalAccelerations,
+                this,
+                massless_trajectories,
+                reference_position,
+                reference_time,
+                std::placeholders::_1,
+                std::placeholders::_2,
+                std::placeholders::_3),
+      parameters, &solution);
+
+  for (std::size_t i = 0; i < solution.size(); ++i) {
+    // The integrator ends exactly at |tmax|, but the translation by
+    // |reference_time| might not.
+    Instant const time = i == solution.size() - 1
+                             ? tmax
+                             : solution[i].time.value + reference_time;
+    AppendMasslessState(solution[i], time, reference_position, trajectories);
+  }
+}
+
+template<typename Frame>
+void Ephemeris<Frame>::set_number_of_threads(int const number_of_threads) {
+  CHECK_LE(1, number_of_threads);
+  if (number_of_threads == 1) {
+    thread_pool_.reset();
+  } else if (thread_pool_ == nullptr ||
+             thread_pool_->number_of_threads() != number_of_threads) {
+    thread_pool_ = std::make_unique<ThreadPool>(number_of_threads);
+  }
+}
+
+template<typename Frame>
+void Ephemeris<Frame>::WriteToMessage(
+    not_null<serialization::Ephemeris*> const message) const {
+  std::lock_guard<std::mutex> l(lock_);
+  for (auto const& trajectory : trajectories_) {
+    trajectory->WriteToMessage(message->add_trajectory());
+  }
+}
+
+template<typename Frame>
+void Ephemeris<Frame>::WriteTailToMessage(
+    Instant const& time,
+    not_null<serialization::Ephemeris*> const message) const {
+  std::lock_guard<std::mutex> l(lock_);
+  for (auto const& trajectory : trajectories_) {
+    trajectory->WriteTailToMessage(time, message->add_trajectory());
+  }
+}
+
+template<typename Frame>
+std::unique_ptr<Ephemeris<Frame>> Ephemeris<Frame>::ReadFromMessage(
+    std::vector<not_null<MassiveBody const*>> const& bodies,
+    SRKNIntegrator const& planetary_integrator,
+    serialization::Ephemeris const& message) {
+  CHECK_LT(0, message.trajectory_size());
+  OwnedContinuousTrajectories trajectories;
+  for (auto const& trajectory : message.trajectory()) {
+    trajectories.push_back(
+        ContinuousTrajectory<Frame>::ReadFromMessage(trajectory));
+  }
+  // Can't use |make_unique| here without implementation-dependent friendships.
+  return std::unique_ptr<Ephemeris>(
+      new Ephemeris(bodies,
+                    std::move(trajectories),
+                    planetary_integrator,
+                    Time::ReadFromMessage(message.trajectory(0).step())));
+}
+
+template<typename Frame>
+Ephemeris<Frame>::Ephemeris(
+    std::vector<not_null<MassiveBody const*>> const& bodies,
+    OwnedContinuousTrajectories trajectories,
+    SRKNIntegrator const& planetary_integrator,
+    Time const& step)
+    : bodies_(bodies),
+      planetary_integrator_(&planetary_integrator),
+      step_(step),
+      trajectories_(std::move(trajectories)) {
+  CHECK_EQ(bodies_.size(), trajectories_.size());
+  last_time_ = trajectories_.front()->last_point().first;
+  typename NBodySystem<Frame>::Trajectories integrated_trajectories;
+  for (std::size_t b = 0; b < bodies_.size(); ++b) {
+    not_null<MassiveBody const*> const body = bodies_[b];
+    auto const inserted = body_indices_.emplace(body, b);
+    CHECK(inserted.second) << "Multiple occurrences of the same body";
+    if (body->is_oblate()) {
+      oblate_indices_.push_back(b);
+    } else {
+      spherical_indices_.push_back(b);
+      spherical_gravitational_parameters_.push_back(
+          body->gravitational_parameter());
+    }
+    auto const& last_point = trajectories_[b]->last_point();
+    CHECK_EQ(last_time_, last_point.first);
+    integrated_trajectories_.push_back(
+        make_not_null_unique<Trajectory<Frame>>(body));
+    integrated_trajectories_.back()->Append(last_point.first,
+                                            last_point.second);
+    integrated_trajectories.push_back(integrated_trajectories_.back().get());
+  }
+  integration_ = n_body_system_.NewIntegration(*planetary_integrator_,
+                                               step_,
+                                               1,  // sampling_period
+                                               integrated_trajectories);
+  // The last points have already been appended to |trajectories_|.
+  for (auto const& trajectory : integrated_trajectories_) {
+    trajectory->ForgetBefore(last_time_);
+  }
+  // Integrate until the first series are fitted, so that the ephemeris is never
+  // empty.  The trajectories read from a message already have their series.
+  if (trajectories_.front()->empty()) {
+    Prolong(last_time_);
+  }
+}
+
+template<typename Frame>
+typename Ephemeris<Frame>::OwnedContinuousTrajectories
+Ephemeris<Frame>::NewTrajectories(
+    std::vector<DegreesOfFreedom<Frame>> const& initial_state,
+    Instant const& initial_time,
+    Time const& step,
+    Length const& fitting_tolerance) {
+  OwnedContinuousTrajectories trajectories;
+  for (auto const& degrees_of_freedom : initial_state) {
+    trajectories.push_back(
+        make_not_null_unique<ContinuousTrajectory<Frame>>(step,
+                                                          fitting_tolerance));
+    trajectories.back()->Append(initial_time, degrees_of_freedom);
+  }
+  return trajectories;
+}
+
+template<typename Frame>
+Instant Ephemeris<Frame>::CheckMasslessTrajectories(
+    Trajectories const& trajectories,
+    not_null<ReadonlyTrajectories*> const massless_trajectories) const {
+  std::set<Instant> times_in_trajectories;
+  std::set<Body const*> bodies_in_trajectories;
+  for (auto const& trajectory : trajectories) {
+    not_null<Body const*> const body = trajectory->template body<Body>();
+    CHECK(body->is_massless()) << "Only massless bodies may be flowed";
+    auto const inserted = bodies_in_trajectories.emplace(body);
+    CHECK(inserted.second) << "Multiple trajectories for the same body";
+    times_in_trajectories.emplace(trajectory->last().time());
+    CHECK_GE(1U, times_in_trajectories.size())
+        << "Inconsistent last time in trajectories";
+    massless_trajectories->push_back(trajectory);
+  }
+  Instant const& t0 = *times_in_trajectories.cbegin();
+  CHECK_LE(t_min(), t0);
+  return t0;
+}
+
+template<typename Frame>
+void Ephemeris<Frame>::FillInitialState(
+    Trajectories const& trajectories,
+    Position<Frame> const& reference_position,
+    Instant const& reference_time,
+    not_null<MasslessSystemState*> const initial_state) {
+  std::size_t const number_of_bodies = trajectories.size();
+  initial_state->positions.resize(3 * number_of_bodies);
+  initial_state->momenta.resize(3 * number_of_bodies);
+  for (std::size_t b = 0; b < number_of_bodies; ++b) {
+    auto const last = trajectories[b]->last();
+    R3Element<Length> const position =
+        (last.degrees_of_freedom().position() -
+         reference_position).coordinates();
+    R3Element<Speed> const& velocity =
+        last.degrees_of_freedom().velocity().coordinates();
+    for (int i = 0; i < 3; ++i) {
+      initial_state->positions[i * number_of_bodies + b] = position[i];
+      initial_state->momenta[i * number_of_bodies + b] = velocity[i];
+    }
+  }
+  initial_state->time = trajectories.front()->last().time() - reference_time;
+}
+
+template<typename Frame>
+void Ephemeris<Frame>::AppendMasslessState(
+    MasslessSystemState const& state,
+    Instant const& time,
+    Position<Frame> const& reference_position,
+    Trajectories const& trajectories) {
+  std::size_t const number_of_bodies = trajectories.size();
+  for (std::size_t b = 0; b < number_of_bodies; ++b) {
+    Vector<Length, Frame> const position(
+        R3Element<Length>(
+            state.positions[b].value,
+            state.positions[number_of_bodies + b].value,
+            state.positions[2 * number_of_bodies + b].value));
+    Vector<Length, Frame> const position_error(
+        R3Element<Length>(
+            state.positions[b].error,
+            state.positions[number_of_bodies + b].error,
+            state.positions[2 * number_of_bodies + b].error));
+    Velocity<Frame> const velocity(
+        R3Element<Speed>(
+            state.momenta[b].value,
+            state.momenta[number_of_bodies + b].value,
+            state.momenta[2 * number_of_bodies + b].value));
+    trajectories[b]->Append(
+        time,
+        DegreesOfFreedom<Frame>(
+            FromIntegrationOrigin(reference_position,
+                                  position,
+                                  position_error),
+            velocity));
+  }
+}
+
+template<typename Frame>
+Position<Frame> Ephemeris<Frame>::ReferencePosition(
+    Trajectories const& trajectories) {
+  typename Position<Frame>::template BarycentreCalculator<double> centroid;
+  for (auto const& trajectory : trajectories) {
+    centroid.Add(trajectory->last().degrees_of_freedom().position(), 1);
+  }
+  return IntegrationOrigin(centroid.Get());
+}
+
+template<typename Frame>
+void Ephemeris<Frame>::ComputeMasslessBodiesGravitationalAccelerations(
+    ReadonlyTrajectories const& massless_trajectories,
+    Position<Frame> const& reference_position,
+    Instant const& reference_time,
+    Time const& t,
+    std::vector<Length> const& q,
+    not_null<std::vector<Acceleration>*> const result) const {
+  result->assign(result->size(), Acceleration());
+  std::size_t const number_of_bodies = massless_trajectories.size();
+  CHECK_EQ(3 * number_of_bodies, q.size());
+
+  // The positions of the massive bodies are only computed once per evaluation,
+  // as structures of arrays.  The oblate bodies come first.
+  Instant const time = t + reference_time;
+  std::size_t const number_of_oblate_bodies = oblate_indices_.size();
+  std::size_t const number_of_spherical_bodies = spherical_indices_.size();
+  std::size_t const number_of_massive_bodies =
+      number_of_oblate_bodies + number_of_spherical_bodies;
+  std::vector<Length> massive_q(3 * number_of_massive_bodies);
+  Length* const mx = massive_q.data();
+  Length* const my = mx + number_of_massive_bodies;
+  Length* const mz = my + number_of_massive_bodies;
+  auto const evaluate_positions = [&](std::vector<std::size_t> const& indices,
+                                      std::size_t const mb_begin) {
+    for (std::size_t j = 0; j < indices.size(); ++j) {
+      R3Element<Length> const coordinates =
+          (trajectories_[indices[j]]->EvaluatePosition(time) -
+           reference_position).coordinates();
+      mx[mb_begin + j] = coordinates.x;
+      my[mb_begin + j] = coordinates.y;
+      mz[mb_begin + j] = coordinates.z;
+    }
+  };
+  {
+    std::lock_guard<std::mutex> l(lock_);
+    evaluate_positions(oblate_indices_, 0);
+    evaluate_positions(spherical_indices_, number_of_oblate_bodies);
+  }
+
+  auto const compute_massless_accelerations =
+      [&](std::size_t const b2_begin, std::size_t const b2_end) {
+    Length const* const qx = q.data();
+    Length const* const qy = qx + number_of_bodies;
+    Length const* const qz = qy + number_of_bodies;
+    Acceleration* const ax = result->data();
+    Acceleration* const ay = ax + number_of_bodies;
+    Acceleration* const az = ay + number_of_bodies;
+
+    // The oblate bodies are processed one massless body at a time, like in
+    // |NBodySystem|.
+    for (std::size_t b1 = 0; b1 < number_of_oblate_bodies; ++b1) {
+      OblateBody<Frame> const& body1 =
+          static_cast<OblateBody<Frame> const&>(
+              *bodies_[oblate_indices_[b1]]);
+      GravitationalParameter const& body1_gravitational_parameter =
+          body1.gravitational_parameter();
+      for (std::size_t b2 = b2_begin; b2 < b2_end; ++b2) {
+        Length const Δq0 = mx[b1] - qx[b2];
+        Length const Δq1 = my[b1] - qy[b2];
+        Length const Δq2 = mz[b1] - qz[b2];
+        Exponentiation<Length, 2> const r_squared =
+            Δq0 * Δq0 + Δq1 * Δq1 + Δq2 * Δq2;
+        Exponentiation<Length, -3> const one_over_r_cubed =
+            Sqrt(r_squared) / (r_squared * r_squared);
+        auto const μ1_over_r_cubed =
+            body1_gravitational_parameter * one_over_r_cubed;
+        ax[b2] += Δq0 * μ1_over_r_cubed;
+        ay[b2] += Δq1 * μ1_over_r_cubed;
+        az[b2] += Δq2 * μ1_over_r_cubed;
+        Exponentiation<Length, -2> const one_over_r_squared = 1 / r_squared;
+        R3Element<Acceleration> const order_2_zonal_acceleration =
+            Order2ZonalAcceleration<Frame>(
+                body1,
+                Vector<Length, Frame>({Δq0, Δq1, Δq2}),
+                one_over_r_squared,
+                one_over_r_cubed).coordinates();
+        ax[b2] += order_2_zonal_acceleration.x;
+        ay[b2] += order_2_zonal_acceleration.y;
+        az[b2] += order_2_zonal_acceleration.z;
+      }
+    }
+
+    AddPointMassAccelerations(number_of_spherical_bodies,
+                              spherical_gravitational_parameters_.data(),
+                              mx + number_of_oblate_bodies,
+                              my + number_of_oblate_bodies,
+                              mz + number_of_oblate_bodies,
+                              b2_end - b2_begin,
+                              qx + b2_begin,
+                              qy + b2_begin,
+                              qz + b2_begin,
+                              ax + b2_begin,
+                              ay + b2_begin,
+                              az + b2_begin);
+
+    for (std::size_t b2 = b2_begin; b2 < b2_end; ++b2) {
+      Trajectory<Frame> const* trajectory = massless_trajectories[b2];
+      if (trajectory->has_intrinsic_acceleration()) {
+        R3Element<Acceleration> const acceleration =
+            trajectory->evaluate_intrinsic_acceleration(time).coordinates();
+        ax[b2] += acceleration.x;
+        ay[b2] += acceleration.y;
+        az[b2] += acceleration.z;
+      }
+    }
+  };
+
+  if (thread_pool_ == nullptr) {
+    compute_massless_accelerations(0, number_of_bodies);
+  } else {
+    // Same threshold as in |NBodySystem|.
+    thread_pool_->ParallelFor(0,
+                              number_of_bodies,
+                              kMinimumMasslessBodiesPerThread,
+                              compute_massless_accelerations);
+  }
+}
+
+}  // namespace physics
+}  // namespace principia
@@ -0,0 +1,373 @@
+﻿#include "physics/ephemeris.hpp"
+
+#include <memory>
+#include <vector>
+
+#include "geometry/barycentre_calculator.hpp"
+#include "geometry/grassmann.hpp"
+#include "geometry/named_quantities.hpp"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "physics/massive_body.hpp"
+#include "physics/massless_body.hpp"
+#include "physics/n_body_system.hpp"
+#include "physics/trajectory.hpp"
+#include "quantities/elementary_functions.hpp"
+#include "quantities/numbers.hpp"
+#include "quantities/si.hpp"
+#include "testing_utilities/almost_equals.hpp"
+
+namespace principia {
+
+using base::make_not_null_unique;
+using integrators::McLachlanAtela1992Order5Optimal;
+using quantities::Mass;
+using si::Metre;
+using si::Milli;
+using quantities::Pow;
+using quantities::SIUnit;
+using quantities::Sqrt;
+using testing_utilities::AlmostEquals;
+using ::testing::Eq;
+using ::testing::Lt;
+
+namespace physics {
+
+class EphemerisTest : public testing::Test {
+ protected:
+  using EarthMoonOrbitPlane = Frame<serialization::Frame::TestTag,
+                                    serialization::Frame::TEST, true>;
+
+  EphemerisTest()
+      : earth_(MassiveBody(6E24 * SIUnit<Mass>())),
+        moon_(MassiveBody(7E22 * SIUnit<Mass>())),
+        integrator_(&McLachlanAtela1992Order5Optimal()) {
+    // The Earth-Moon system, roughly, with a circular orbit with velocities
+    // in the centre-of-mass frame.
+    Position<EarthMoonOrbitPlane> const q1(
+        Vector<Length, EarthMoonOrbitPlane>({0 * SIUnit<Length>(),
+                                             0 * SIUnit<Length>(),
+                                             0 * SIUnit<Length>()}));
+    Position<EarthMoonOrbitPlane> const q2(
+        Vector<Length, EarthMoonOrbitPlane>({0 * SIUnit<Length>(),
+                                             4E8 * SIUnit<Length>(),
+                                             0 * SIUnit<Length>()}));
+    Length const semi_major_axis = (q1 - q2).Norm();
+    period_ = 2 * π * Sqrt(Pow<3>(semi_major_axis) /
+                               (earth_.gravitational_parameter() +
+                                moon_.gravitational_parameter()));
+    Position<EarthMoonOrbitPlane> const centre_of_mass =
+        geometry::Barycentre<Vector<Length, EarthMoonOrbitPlane>, Mass>(
+            {q1, q2}, {earth_.mass(), moon_.mass()});
+    Velocity<EarthMoonOrbitPlane> const v1(
+        {-2 * π * (q1 - centre_of_mass).Norm() / period_,
+         0 * SIUnit<Speed>(),
+         0 * SIUnit<Speed>()});
+    Velocity<EarthMoonOrbitPlane> const v2(
+        {2 * π * (q2 - centre_of_mass).Norm() / period_,
+         0 * SIUnit<Speed>(),
+         0 * SIUnit<Speed>()});
+    bodies_ = {&earth_, &moon_};
+    initial_state_ = {{q1, v1}, {q2, v2}};
+  }
+
+  not_null<std::unique_ptr<Ephemeris<EarthMoonOrbitPlane>>> MakeEphemeris(
+      Time const& step) {
+    return make_not_null_unique<Ephemeris<EarthMoonOrbitPlane>>(
+        bodies_, initial_state_, t0_, *integrator_, step, fitting_tolerance_);
+  }
+
+  // Integrates the Earth, the Moon and the |massless_trajectories| together
+  // using an |NBodySystem|, and returns the trajectories of the massive bodies.
+  std::vector<not_null<std::unique_ptr<Trajectory<EarthMoonOrbitPlane>>>>
+  IntegrateWithNBodySystem(
+      Instant const& tmax,
+      Time const& step,
+      bool const tmax_is_exact,
+      std::vector<not_null<Trajectory<EarthMoonOrbitPlane>*>> const&
+          massless_trajectories) {
+    std::vector<not_null<std::unique_ptr<Trajectory<EarthMoonOrbitPlane>>>>
+        massive_trajectories;
+    NBodySystem<EarthMoonOrbitPlane>::Trajectories trajectories;
+    for (std::size_t b = 0; b < bodies_.size(); ++b) {
+      massive_trajectories.push_back(
+          make_not_null_unique<Trajectory<EarthMoonOrbitPlane>>(bodies_[b]));
+      massive_trajectories.back()->Append(t0_, initial_state_[b]);
+      trajectories.push_back(massive_trajectories.back().get());
+    }
+    for (auto const& trajectory : massless_trajectories) {
+      trajectories.push_back(trajectory);
+    }
+    NBodySystem<EarthMoonOrbitPlane> system;
+    system.Integrate(*integrator_, tmax, step,
+                     1,  // sampling_period
+                     tmax_is_exact,
+                     trajectories);
+    return massive_trajectories;
+  }
+
+  // Appends to |probe| the initial state of a probe in a roughly circular low
+  // orbit around the Earth.  |i| selects the altitude.
+  void AppendProbeInitialState(int const i,
+                               not_null<Trajectory<EarthMoonOrbitPlane>*> const
+                                   probe) {
+    Length const altitude = (1E7 + i * 1E6) * SIUnit<Length>();
+    probe->Append(
+        t0_,
+        {initial_state_[0].position() +
+             Vector<Length, EarthMoonOrbitPlane>({altitude,
+                                                  0 * SIUnit<Length>(),
+                                                  0 * SIUnit<Length>()}),
+         initial_state_[0].velocity() +
+             Velocity<EarthMoonOrbitPlane>(
+                 {0 * SIUnit<Speed>(),
+                  Sqrt(earth_.gravitational_parameter() / altitude),
+                  (i % 5) * SIUnit<Speed>()})});
+  }
+
+  MassiveBody earth_;
+  MassiveBody moon_;
+  std::vector<not_null<MassiveBody const*>> bodies_;
+  std::vector<DegreesOfFreedom<EarthMoonOrbitPlane>> initial_state_;
+  Instant const t0_;
+  not_null<SRKNIntegrator const*> integrator_;
+  Time period_;
+  Length const fitting_tolerance_ = 1 * Milli(Metre);
+};
+
+using EphemerisDeathTest = EphemerisTest;
+
+TEST_F(EphemerisDeathTest, Errors) {
+  EXPECT_DEATH({
+    auto const ephemeris = MakeEphemeris(period_ / 100);
+    ephemeris->Prolong(t0_ + period_);
+    ephemeris->EvaluatePosition(&earth_, t0_ - period_);
+  }, "t_min");
+  EXPECT_DEATH({
+    auto const ephemeris = MakeEphemeris(period_ / 100);
+    Trajectory<EarthMoonOrbitPlane> trajectory(&moon_);
+    trajectory.Append(t0_, initial_state_[1]);
+    ephemeris->FlowWithFixedStep(*integrator_, t0_ + period_, period_ / 100,
+                                 1,      // sampling_period
+                                 false,  // tmax_is_exact
+                                 {&trajectory});
+  }, "Only massless");
+}
+
+// At the ends of the steps, the ephemeris matches the results of the
+// integration of the massive bodies within the fitting tolerance.
+TEST_F(EphemerisTest, Steps) {
+  Time const step = period_ / 1000;
+  int const steps_per_series =
+      ContinuousTrajectory<EarthMoonOrbitPlane>::kStepsPerSeries;
+  auto const ephemeris = MakeEphemeris(step);
+  EXPECT_THAT(ephemeris->t_min(), Eq(t0_));
+  EXPECT_THAT(ephemeris->t_max() - t0_,
+              AlmostEquals(steps_per_series * step, 0, 1));
+  ephemeris->Prolong(t0_ + period_ / 10);
+  EXPECT_LE(t0_ + period_ / 10, ephemeris->t_max());
+  EXPECT_LT(ephemeris->t_max(), t0_ + period_ / 10 + steps_per_series * step);
+
+  auto const trajectories =
+      IntegrateWithNBodySystem(t0_ + period_ / 10 + step / 2, step,
+                               false,  // tmax_is_exact
+                               {});
+  for (std::size_t b = 0; b < bodies_.size(); ++b) {
+    int number_of_points = 0;
+    for (auto it = trajectories[b]->first(); !it.at_end(); ++it) {
+      EXPECT_THAT((ephemeris->EvaluatePosition(bodies_[b], it.time()) -
+                       it.degrees_of_freedom().position()).Norm(),
+                  Lt(fitting_tolerance_));
+      ++number_of_points;
+    }
+    EXPECT_THAT(number_of_points, Eq(101));
+  }
+}
+
+// Between the ends of the steps, the ephemeris interpolates the integrated
+// positions and velocities.  Compare with an integration with half the step.
+TEST_F(EphemerisTest, Interpolation) {
+  Time const step = period_ / 1000;
+  auto const ephemeris = MakeEphemeris(step);
+  ephemeris->Prolong(t0_ + period_ / 10);
+  auto const trajectories =
+      IntegrateWithNBodySystem(t0_ + period_ / 10, step / 2,
+                               false,  // tmax_is_exact
+                               {});
+  for (std::size_t b = 0; b < bodies_.size(); ++b) {
+    for (auto it = trajectories[b]->first(); !it.at_end(); ++it) {
+      DegreesOfFreedom<EarthMoonOrbitPlane> const degrees_of_freedom =
+          ephemeris->EvaluateDegreesOfFreedom(bodies_[b], it.time());
+      EXPECT_THAT((it.degrees_of_freedom().position() -
+                       degrees_of_freedom.position()).Norm(),
+                  Lt(fitting_tolerance_));
+      EXPECT_THAT((it.degrees_of_freedom().velocity() -
+                       degrees_of_freedom.velocity()).Norm(),
+                  Lt(1E-9 * SIUnit<Speed>()));
+    }
+  }
+}
+
+// The massless bodies integrated in the field of the ephemeris follow closely
+// those integrated together with the massive bodies.
+TEST_F(EphemerisTest, FlowWithFixedStep) {
+  Time const step = period_ / 10000;
+  Instant const tmax = t0_ + period_ / 100;
+  int const number_of_probes = 10;
+  std::vector<MasslessBody> const probes(number_of_probes);
+  std::vector<not_null<std::unique_ptr<Trajectory<EarthMoonOrbitPlane>>>>
+      expected_probe_trajectories;
+  std::vector<not_null<std::unique_ptr<Trajectory<EarthMoonOrbitPlane>>>>
+      actual_probe_trajectories;
+  Ephemeris<EarthMoonOrbitPlane>::Trajectories expected_trajectories;
+  Ephemeris<EarthMoonOrbitPlane>::Trajectories actual_trajectories;
+  for (int i = 0; i < number_of_probes; ++i) {
+    expected_probe_trajectories.push_back(
+        make_not_null_unique<Trajectory<EarthMoonOrbitPlane>>(&probes[i]));
+    actual_probe_trajectories.push_back(
+        make_not_null_unique<Trajectory<EarthMoonOrbitPlane>>(&probes[i]));
+    AppendProbeInitialState(i, expected_probe_trajectories.back().get());
+    AppendProbeInitialState(i, actual_probe_trajectories.back().get());
+    expected_trajectories.push_back(expected_probe_trajectories.back().get());
+    actual_trajectories.push_back(actual_probe_trajectories.back().get());
+  }
+  IntegrateWithNBodySystem(tmax, step,
+                           true,  // tmax_is_exact
+                           expected_trajectories);
+  auto const ephemeris = MakeEphemeris(step);
+  ephemeris->FlowWithFixedStep(*integrator_, tmax, step,
+                               1,     // sampling_period
+                               true,  // tmax_is_exact
+                               actual_trajectories);
+  EXPECT_LE(tmax, ephemeris->t_max());
+  for (int i = 0; i < number_of_probes; ++i) {
+    EXPECT_THAT(actual_trajectories[i]->Times(),
+                Eq(expected_trajectories[i]->Times()));
+    EXPECT_THAT(actual_trajectories[i]->last().time(), Eq(tmax));
+    EXPECT_THAT(
+        (expected_trajectories[i]->last().degrees_of_freedom().position() -
+             actual_trajectories[i]->last().degrees_of_freedom().position()).
+            Norm(),
+        Lt(1E-3 * SIUnit<Length>()));
+  }
+}
+
+// The adaptive step follows closely a fixed-step integration with a small step,
+// with far fewer points, and ends exactly at |tmax|.
+TEST_F(EphemerisTest, FlowWithAdaptiveStep) {
+  Time const step = period_ / 10000;
+  Instant const tmax = t0_ + period_ / 100;
+  MasslessBody const probe;
+  Trajectory<EarthMoonOrbitPlane> fixed_trajectory(&probe);
+  Trajectory<EarthMoonOrbitPlane> adaptive_trajectory(&probe);
+  AppendProbeInitialState(0, &fixed_trajectory);
+  AppendProbeInitialState(0, &adaptive_trajectory);
+  auto const ephemeris = MakeEphemeris(step);
+  ephemeris->FlowWithFixedStep(*integrator_, tmax, step / 100,
+                               1,     // sampling_period
+                               true,  // tmax_is_exact
+                               {&fixed_trajectory});
+  ephemeris->FlowWithAdaptiveStep(
+      integrators::DormandElMikkawyPrince1986RKN434FM(),
+      tmax,
+      step,  // first_time_step
+      1E-3 * SIUnit<Length>(),
+      1E-6 * SIUnit<Speed>(),
+      {&adaptive_trajectory});
+  EXPECT_THAT(adaptive_trajectory.last().time(), Eq(tmax));
+  EXPECT_THAT(4 * adaptive_trajectory.Times().size(),
+              Lt(fixed_trajectory.Times().size()));
+  EXPECT_THAT(
+      (fixed_trajectory.last().degrees_of_freedom().position() -
+           adaptive_trajectory.last().degrees_of_freedom().position()).Norm(),
+      Lt(1E-1 * SIUnit<Length>()));
+}
+
+// The results of |FlowWithFixedStep| do not depend on the number of threads.
+TEST_F(EphemerisTest, Multithreading) {
+  Time const step = period_ / 10000;
+  int const number_of_probes = 100;
+  std::vector<MasslessBody> const probes(number_of_probes);
+  auto const ephemeris = MakeEphemeris(step);
+  std::vector<std::vector<DegreesOfFreedom<EarthMoonOrbitPlane>>> results;
+  for (int const number_of_threads : {1, 3}) {
+    std::vector<not_null<std::unique_ptr<Trajectory<EarthMoonOrbitPlane>>>>
+        probe_trajectories;
+    Ephemeris<EarthMoonOrbitPlane>::Trajectories trajectories;
+    for (int i = 0; i < number_of_probes; ++i) {
+      probe_trajectories.push_back(
+          make_not_null_unique<Trajectory<EarthMoonOrbitPlane>>(&probes[i]));
+      AppendProbeInitialState(i, probe_trajectories.back().get());
+      trajectories.push_back(probe_trajectories.back().get());
+    }
+    ephemeris->set_number_of_threads(number_of_threads);
+    ephemeris->FlowWithFixedStep(*integrator_, t0_ + period_ / 100, step,
+                                 0,      // sampling_period
+                                 false,  // tmax_is_exact
+                                 trajectories);
+    results.emplace_back();
+    for (auto const& trajectory : trajectories) {
+      results.back().push_back(trajectory->last().degrees_of_freedom());
+    }
+  }
+  EXPECT_THAT(results[1], Eq(results[0]));
+}
+
+TEST_F(EphemerisTest, ForgetBefore) {
+  Time const step = period_ / 1000;
+  int const steps_per_series =
+      ContinuousTrajectory<EarthMoonOrbitPlane>::kStepsPerSeries;
+  auto const ephemeris = MakeEphemeris(step);
+  ephemeris->Prolong(t0_ + period_ / 10);
+  Instant const t = t0_ + 2.5 * steps_per_series * step;
+  Position<EarthMoonOrbitPlane> const expected_position =
+      ephemeris->EvaluatePosition(&moon_, t);
+  ephemeris->ForgetBefore(t);
+  EXPECT_THAT(ephemeris->t_min() - t0_,
+              AlmostEquals(2 * steps_per_series * step, 0, 1));
+  EXPECT_THAT(ephemeris->EvaluatePosition(&moon_, t), Eq(expected_position));
+  ephemeris->ForgetBefore(ephemeris->t_max());
+  EXPECT_LT(ephemeris->t_min(), ephemeris->t_max());
+}
+
+// An ephemeris read from a message has the same series as the original one,
+// and its integration resumes where that of the original one stopped.
+TEST_F(EphemerisTest, Serialization) {
+  Time const step = period_ / 1000;
+  auto const ephemeris = MakeEphemeris(step);
+  ephemeris->Prolong(t0_ + period_ / 10);
+  serialization::Ephemeris message;
+  ephemeris->WriteToMessage(&message);
+  EXPECT_EQ(2, message.trajectory_size());
+
+  std::unique_ptr<Ephemeris<EarthMoonOrbitPlane>> const read_ephemeris =
+      Ephemeris<EarthMoonOrbitPlane>::ReadFromMessage(bodies_,
+                                                      *integrator_,
+                                                      message);
+  EXPECT_THAT(read_ephemeris->t_min(), Eq(ephemeris->t_min()));
+  EXPECT_THAT(read_ephemeris->t_max(), Eq(ephemeris->t_max()));
+  Instant const t = t0_ + period_ / 20;
+  EXPECT_THAT(read_ephemeris->EvaluateDegreesOfFreedom(&moon_, t),
+              Eq(ephemeris->EvaluateDegreesOfFreedom(&moon_, t)));
+
+  ephemeris->Prolong(t0_ + period_ / 2);
+  read_ephemeris->Prolong(t0_ + period_ / 2);
+  Instant const t_max = std::min(ephemeris->t_max(), read_ephemeris->t_max());
+  EXPECT_THAT(
+      (read_ephemeris->EvaluatePosition(&moon_, t_max) -
+           ephemeris->EvaluatePosition(&moon_, t_max)).Norm(),
+      Lt(fitting_tolerance_));
+
+  // The tail since |t| only holds the series that end after it.
+  serialization::Ephemeris full;
+  serialization::Ephemeris tail;
+  ephemeris->WriteToMessage(&full);
+  ephemeris->WriteTailToMessage(t0_ + period_ / 4, &tail);
+  EXPECT_EQ(2, tail.trajectory_size());
+  EXPECT_LT(tail.trajectory(0).series_size(),
+            full.trajectory(0).series_size());
+  EXPECT_LT(tail.ByteSize(), full.ByteSize());
+}
+
+}  // namespace physics
+}  // namespace principia
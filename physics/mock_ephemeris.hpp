@@ -0,0 +1,47 @@
+﻿#pragma once
+
+#include "physics/ephemeris.hpp"
+
+#include <vector>
+
+#include "gmock/gmock.h"
+
+namespace principia {
+namespace physics {
+
+template<typename Frame>
+class MockEphemeris : public Ephemeris<Frame> {
+ public:
+  MockEphemeris(std::vector<not_null<MassiveBody const*>> const& bodies,
+                std::vector<DegreesOfFreedom<Frame>> const& initial_state,
+                Instant const& initial_time,
+                SRKNIntegrator const& planetary_integrator,
+                Time const& step,
+                Length const& fitting_tolerance)
+      : Ephemeris<Frame>(bodies,
+                         initial_state,
+                         initial_time,
+                         planetary_integrator,
+                         step,
+                         fitting_tolerance) {}
+
+  MOCK_METHOD6_T(
+      FlowWithFixedStep,
+      void(SRKNIntegrator const& integrator,
+           Instant const& tmax,
+           Time const& Δt,
+           int const sampling_period,
+           bool const tmax_is_exact,
+           typename Ephemeris<Frame>::Trajectories const& trajectories));
+  MOCK_METHOD6_T(
+      FlowWithAdaptiveStep,
+      void(EmbeddedRKNIntegrator const& integrator,
+           Instant const& tmax,
+           Time const& first_time_step,
+           Length const& length_integration_tolerance,
+           Speed const& speed_integration_tolerance,
+           typename Ephemeris<Frame>::Trajectories const& trajectories));
+};
+
+}  // namespace physics
+}  // namespace principia
@@ -5,6 +5,7 @@
 #include <vector>
 
 #include "base/not_null.hpp"
+#include "base/thread_pool.hpp"
 #include "geometry/named_quantities.hpp"
 #include "integrators/symplectic_runge_kutta_nystrom_integrator.hpp"
 #include "physics/body.hpp"
@@ -15,15 +16,37 @@
 namespace principia {
 
 using base::not_null;
+using base::ThreadPool;
 using geometry::Instant;
+using geometry::Point;
+using geometry::Position;
 using integrators::SRKNIntegrator;
 using quantities::Acceleration;
+using quantities::GravitationalParameter;
 using quantities::Length;
 using quantities::Speed;
 using quantities::Time;
 
 namespace physics {
 
+// Returns a point close to |position| whose coordinates only keep the leading
+// bits of the mantissas of those of |position|, so that the coordinates of
+// nearby points relative to it are computed exactly.  The integrations are
+// done relative to such origins so that the integrators manipulate small
+// quantities and do not lose significant digits far from the origin of
+// |Frame|.
+template<typename Frame>
+Position<Frame> IntegrationOrigin(Position<Frame> const& position);
+
+// Returns |origin + value + error|, where |value| and |error| are the parts of
+// a compensated sum relative to an integration |origin|.  The rounding error
+// of |origin + value| is compensated too, so that the digits accumulated by
+// the integrator are not lost when going back to absolute coordinates.
+template<typename Vector>
+Point<Vector> FromIntegrationOrigin(Point<Vector> const& origin,
+                                    Vector const& value,
+                                    Vector const& error);
+
 template<typename Frame>
 class NBodySystem {
   static_assert(Frame::is_inertial, "Frame must be inertial");
@@ -44,13 +67,93 @@ class NBodySystem {
                          bool const tmax_is_exact,
                          Trajectories const& trajectories) const;
 
+  // An integration of a set of trajectories which may be resumed, see
+  // |NewIntegration|.
+  class Integration;
+
+  // Returns an integration of the |trajectories|, which are subject to the same
+  // constraints as for |Integrate|.  Successive calls to |Advance| append to
+  // the |trajectories| the same points as a single call to |Integrate| with the
+  // last |tmax| and |tmax_is_exact == false|, except that if
+  // |sampling_period == 0| a point is appended at the end of each call.  The
+  // partition of the bodies and the state of the |integrator| are kept between
+  // calls.  The trajectories must not be changed by anything else while the
+  // integration exists, and the result must not outlive this object.
+  std::unique_ptr<Integration> NewIntegration(
+      SRKNIntegrator const& integrator,
+      Time const& Δt,
+      int const sampling_period,
+      Trajectories const& trajectories) const;
+
+  // Computes the accelerations of the massless bodies on |number_of_threads|
+  // threads in subsequent calls to |Integrate|.  The massive bodies are always
+  // processed on the calling thread.  The results do not depend on the number
+  // of threads.  The default is 1, i.e., no multithreading.  Once this is set
+  // to more than 1, |Integrate| must not be called concurrently from several
+  // threads.
+  void set_number_of_threads(int const number_of_threads);
+
  private:
   using ReadonlyTrajectories = std::vector<not_null<Trajectory<Frame> const*>>;
+  using SystemState = SRKNIntegrator::SystemState<Length, Speed>;
+
+  // The bodies of an integration, partitioned and ordered as expected by
+  // |ComputeGravitationalAccelerations|, and the conversions between their
+  // trajectories and the states of the integrator.
+  class Bodies {
+   public:
+    // Checks the constraints on the |trajectories| described in |Integrate|.
+    explicit Bodies(Trajectories const& trajectories);
+
+    // The common last time of the trajectories.
+    Instant const& last_time() const;
+    // The origin of the times of the integrator.
+    Instant const& reference_time() const;
+
+    // Returns the state of the integrator at the last points of the
+    // trajectories.
+    SystemState InitialState() const;
+
+    // Appends |state| to the trajectories.
+    void Append(SystemState const& state) const;
+
+    void ComputeGravitationalAccelerations(
+        ThreadPool* const thread_pool,
+        Time const& t,
+        std::vector<Length> const& q,
+        not_null<std::vector<Acceleration>*> const result) const;
+
+   private:
+    // In the order of the state of the integrator: the oblate massive bodies,
+    // the spherical massive bodies, then the massless bodies.
+    Trajectories reordered_trajectories_;
+    ReadonlyTrajectories massive_oblate_trajectories_;
+    ReadonlyTrajectories massive_spherical_trajectories_;
+    ReadonlyTrajectories massless_trajectories_;
+    std::vector<GravitationalParameter>
+        massive_spherical_gravitational_parameters_;
+    Instant last_time_;
+
+    // In the integrator itself, all quantities are "vectors" relative to these
+    // references.  The position is the |IntegrationOrigin| of the centre of
+    // mass of the massive bodies, or of the centroid of the bodies if none is
+    // massive.  The time is not translated: the integrator already keeps it
+    // with a compensated summation, and the accelerations are evaluated at
+    // absolute instants anyway.
+    Position<Frame> reference_position_;
+    Instant const reference_time_;
+  };
+
+  // Returns a functor computing the accelerations of |bodies| with the thread
+  // pool current at the time of the call.
+  SRKNIntegrator::SRKNRightHandSideComputation<Length>
+  AccelerationComputation(Bodies const& bodies) const;
 
   // Computes the acceleration due to one body, |body1| (with index |b1| in the
   // |q| and |result| arrays) on the bodies with indices [b2_begin, b2_end[ in
   // |body2_trajectories|.  The template parameters specify what we know about
-  // the bodies, and therefore what forces apply.
+  // the bodies, and therefore what forces apply.  |q| and |result| have the
+  // layout described below.
   template<bool body1_is_oblate,
            bool body2_is_oblate,
            bool body2_is_massive>
@@ -63,15 +166,49 @@ class NBodySystem {
       std::vector<Length> const& q,
       not_null<std::vector<Acceleration>*> const result);
 
-  // No transfer of ownership.
+  // No transfer of ownership.  The state of the system is laid out as a
+  // structure of arrays: for n bodies, |q| and |result| contain the n x
+  // coordinates, followed by the n y coordinates, followed by the n z
+  // coordinates.  This makes the inner loops over the bodies access memory with
+  // unit stride, which lets the compiler vectorize them.  The integrator treats
+  // the state as an opaque vector so it is not affected by this choice.
+  // |massive_spherical_gravitational_parameters| is parallel to
+  // |massive_spherical_trajectories|, it is passed to the vectorized kernel
+  // that computes the accelerations of the massless bodies.  If |thread_pool|
+  // is not null, the massless bodies are split among its threads.
   static void ComputeGravitationalAccelerations(
       ReadonlyTrajectories const& massive_oblate_trajectories,
       ReadonlyTrajectories const& massive_spherical_trajectories,
+      std::vector<GravitationalParameter> const&
+          massive_spherical_gravitational_parameters,
       ReadonlyTrajectories const& massless_trajectories,
+      ThreadPool* const thread_pool,
       Instant const& reference_time,
       Time const& t,
       std::vector<Length> const& q,
       not_null<std::vector<Acceleration>*> const result);
+
+  // Null if multithreading is disabled.
+  std::unique_ptr<ThreadPool> thread_pool_;
+};
+
+template<typename Frame>
+class NBodySystem<Frame>::Integration {
+ public:
+  // Integrates until the last step that ends at or before |tmax|.
+  void Advance(Instant const& tmax);
+
+ private:
+  Integration(NBodySystem const& system,
+              SRKNIntegrator const& integrator,
+              Time const& Δt,
+              int const sampling_period,
+              Trajectories const& trajectories);
+
+  Bodies const bodies_;
+  SRKNIntegrator::Instance<Length> instance_;
+
+  friend class NBodySystem;
 };
 
 }  // namespace physics
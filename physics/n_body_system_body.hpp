@@ -13,11 +13,11 @@
 #include "glog/logging.h"
 #include "integrators/symplectic_partitioned_runge_kutta_integrator.hpp"
 #include "physics/oblate_body.hpp"
+#include "physics/point_mass_accelerations.hpp"
 #include "quantities/quantities.hpp"
 
 namespace principia {
 
-using geometry::InnerProduct;
 using geometry::Instant;
 using geometry::R3Element;
 using integrators::SPRKIntegrator;
@@ -26,41 +26,57 @@ using quantities::Acceleration;
 using quantities::Exponentiation;
 using quantities::GravitationalParameter;
 using quantities::Length;
+using quantities::SIUnit;
 using quantities::Speed;
 
 namespace physics {
 
 namespace {
 
-// If j is a unit vector along the axis of rotation, and r is the separation
-// between the bodies, the acceleration computed here is:
-//
-//   -(J2 / |r|^5) (3 j (r.j) + r (3 - 15 (r.j)^2 / |r|^2) / 2)
-//
-// Where |r| is the norm of r and r.j is the inner product.
-template<typename Frame>
-FORCE_INLINE Vector<Acceleration, Frame>
-    Order2ZonalAcceleration(
-        OblateBody<Frame> const& body,
-        Vector<Length, Frame> const& r,
-        Exponentiation<Length, -2> const& one_over_r_squared,
-        Exponentiation<Length, -3> const& one_over_r_cubed) {
-  Vector<double, Frame> const& axis = body.axis();
-  Length const r_axis_projection = InnerProduct(axis, r);
-  auto const j2_over_r_fifth =
-      body.j2() * one_over_r_cubed * one_over_r_squared;
-  Vector<Acceleration, Frame> const& axis_acceleration =
-      (-3 * j2_over_r_fifth * r_axis_projection) * axis;
-  Vector<Acceleration, Frame> const& radial_acceleration =
-      (j2_over_r_fifth *
-           (-1.5 +
-            7.5 * r_axis_projection *
-                  r_axis_projection * one_over_r_squared)) * r;
-  return axis_acceleration + radial_acceleration;
+// Below this number of massless bodies per thread, the cost of dispatching the
+// work to the threads exceeds the benefit of multithreading.
+std::size_t const kMinimumMasslessBodiesPerThread = 16;
+
+// The number of leading bits kept in the mantissas of the coordinates of the
+// integration origins.  The other bits of the coordinates of a point close to
+// an origin are then available for its coordinates relative to that origin.
+int const kIntegrationOriginMantissaBits = 20;
+
+Length IntegrationOriginCoordinate(Length const& coordinate) {
+  int exponent;
+  double const mantissa =
+      std::frexp(coordinate / SIUnit<Length>(), &exponent);
+  return std::ldexp(std::trunc(std::ldexp(mantissa,
+                                          kIntegrationOriginMantissaBits)),
+                    exponent - kIntegrationOriginMantissaBits) *
+         SIUnit<Length>();
 }
 
 }  // namespace
 
+template<typename Frame>
+Position<Frame> IntegrationOrigin(Position<Frame> const& position) {
+  R3Element<Length> const coordinates =
+      (position - Position<Frame>()).coordinates();
+  return Position<Frame>() + Vector<Length, Frame>(
+      R3Element<Length>(IntegrationOriginCoordinate(coordinates.x),
+                        IntegrationOriginCoordinate(coordinates.y),
+                        IntegrationOriginCoordinate(coordinates.z)));
+}
+
+template<typename Vector>
+Point<Vector> FromIntegrationOrigin(Point<Vector> const& origin,
+                                    Vector const& value,
+                                    Vector const& error) {
+  // Knuth's TwoSum, see Higham, Accuracy and Stability of Numerical
+  // Algorithms, section 4.3.
+  Point<Vector> const sum = origin + value;
+  Vector const value_in_sum = sum - origin;
+  Vector const sum_error = (origin - (sum - value_in_sum)) +
+                           (value - value_in_sum);
+  return sum + (sum_error + error);
+}
+
 template<typename Frame>
 void NBodySystem<Frame>::Integrate(SRKNIntegrator const& integrator,
                                    Instant const& tmax,
@@ -68,130 +84,51 @@ void NBodySystem<Frame>::Integrate(SRKNIntegrator const& integrator,
                                    int const sampling_period,
                                    bool const tmax_is_exact,
                                    Trajectories const& trajectories) const {
-  SRKNIntegrator::Parameters<Length, Speed> parameters;
-  SRKNIntegrator::Solution<Length, Speed> solution;
-
-  // TODO(phl): Use a position based on the first mantissa bits of the
-  // centre-of-mass referential and a time in the middle of the integration
-  // interval.  In the integrator itself, all quantities are "vectors" relative
-  // to these references.
-  Position<Frame> const reference_position;
-  Instant const reference_time;
-
-  // These objects are for checking the consistency of the parameters.
-  std::set<Instant> times_in_trajectories;
-  std::set<Body const*> bodies_in_trajectories;
-
-  // Prepare the initial state of the integrator.  For efficiently computing the
-  // accelerations, we need to separate the trajectories of oblate massive
-  // bodies from of spherical massive bodies and those of massless bodies.  They
-  // are put in this order in |reordered_trajectories|.
-  Trajectories reordered_trajectories;
-  ReadonlyTrajectories massive_oblate_trajectories;
-  ReadonlyTrajectories massive_spherical_trajectories;
-  ReadonlyTrajectories massless_trajectories;
-  // This loop ensures that the massive bodies precede the massless bodies in
-  // the vectors representing the initial data.
-  for (bool is_massless : {false, true}) {
-    for (bool is_oblate : {true, false}) {
-      for (auto const& trajectory : trajectories) {
-        // See if this trajectory should be processed in this iteration and
-        // update the appropriate vector.
-        not_null<Body const*> const body = trajectory->template body<Body>();
-        if (body->is_massless() != is_massless ||
-            body->is_oblate() != is_oblate) {
-          continue;
-        }
-        if (is_massless) {
-          CHECK(!is_oblate);
-          massless_trajectories.push_back(trajectory);
-        } else if (is_oblate) {
-          massive_oblate_trajectories.push_back(trajectory);
-        } else {
-          massive_spherical_trajectories.push_back(trajectory);
-        }
-        reordered_trajectories.push_back(trajectory);
-
-        // Fill the initial position/velocity/time.
-        // NOTE(phl): Using |const&| below doesn't work, even though 12.2/5
-        // seems to indicate that it should.  A bug in Visual Studio 2013?
-        R3Element<Length> const position =
-            (trajectory->last().degrees_of_freedom().position() -
-             reference_position).coordinates();
-        R3Element<Speed> const& velocity =
-            trajectory->last().degrees_of_freedom().velocity().coordinates();
-        Instant const& time = trajectory->last().time();
-        for (int i = 0; i < 3; ++i) {
-          parameters.initial.positions.emplace_back(position[i]);
-        }
-        for (int i = 0; i < 3; ++i) {
-          parameters.initial.momenta.emplace_back(velocity[i]);
-        }
-
-        // Check that all trajectories are for different bodies.
-        auto const inserted = bodies_in_trajectories.emplace(body);
-        CHECK(inserted.second) << "Multiple trajectories for the same body";
-        // The final points of all trajectories must all be for the same time.
-        times_in_trajectories.emplace(time);
-        CHECK_GE(1U, times_in_trajectories.size())
-            << "Inconsistent last time in trajectories";
-      }
-    }
-  }
+  Bodies const bodies(trajectories);
 
   // If |tmax_is_exact| and the trajectories already end at |tmax|, do not call
   // the integrator: it would want to overwrite the last point of each
   // trajectory, which is not something we allow.  It is better to handle this
   // case here than in all the callers.
-  CHECK_LE(*times_in_trajectories.cbegin(), tmax);
-  if (tmax_is_exact && *times_in_trajectories.cbegin() == tmax) {
+  CHECK_LE(bodies.last_time(), tmax);
+  if (tmax_is_exact && bodies.last_time() == tmax) {
     return;
   }
 
-  {
-    // Beyond this point we must not use the |trajectories| parameter as it is
-    // in the wrong order with respect to the data passed to the integrator.  We
-    // use this block to hide it.
-    Trajectories const& trajectories = reordered_trajectories;
-
-    parameters.initial.time = *times_in_trajectories.cbegin() - reference_time;
-    parameters.tmax = tmax - reference_time;
-    parameters.Δt = Δt;
-    parameters.sampling_period = sampling_period;
-    parameters.tmax_is_exact = tmax_is_exact;
-    integrator.SolveTrivialKineticEnergyIncrement<Length>(
-        std::bind(&NBodySystem::ComputeGravitationalAccelerations,
-                  massive_oblate_trajectories,
-                  massive_spherical_trajectories,
-                  massless_trajectories,
-                  reference_time,
-                  std::placeholders::_1,
-                  std::placeholders::_2,
-                  std::placeholders::_3),
-        parameters, &solution);
-
-    // TODO(phl): Ignoring errors for now.
-    // Loop over the time steps.
-    for (std::size_t i = 0; i < solution.size(); ++i) {
-      SRKNIntegrator::SystemState<Length, Speed> const& state = solution[i];
-      Instant const time = state.time.value + reference_time;
-      CHECK_EQ(state.positions.size(), state.momenta.size());
-      // Loop over the dimensions.
-      for (std::size_t k = 0, t = 0; k < state.positions.size(); k += 3, ++t) {
-        Vector<Length, Frame> const position(
-            R3Element<Length>(state.positions[k].value,
-                              state.positions[k + 1].value,
-                              state.positions[k + 2].value));
-        Velocity<Frame> const velocity(
-            R3Element<Speed>(state.momenta[k].value,
-                             state.momenta[k + 1].value,
-                             state.momenta[k + 2].value));
-        trajectories[t]->Append(
-            time,
-            DegreesOfFreedom<Frame>(position + reference_position,
-                                            velocity));
-      }
-    }
+  SRKNIntegrator::Parameters<Length, Speed> parameters;
+  parameters.initial = bodies.InitialState();
+  parameters.tmax = tmax - bodies.reference_time();
+  parameters.Δt = Δt;
+  parameters.sampling_period = sampling_period;
+  parameters.tmax_is_exact = tmax_is_exact;
+  // The states are appended to the trajectories as they are computed.
+  // TODO(phl): Ignoring errors for now.
+  integrator.SolveTrivialKineticEnergyIncrement<Length>(
+      AccelerationComputation(bodies),
+      parameters,
+      [&bodies](SystemState const& state) {
+        bodies.Append(state);
+      });
+}
+
+template<typename Frame>
+std::unique_ptr<typename NBodySystem<Frame>::Integration>
+NBodySystem<Frame>::NewIntegration(SRKNIntegrator const& integrator,
+                                   Time const& Δt,
+                                   int const sampling_period,
+                                   Trajectories const& trajectories) const {
+  return std::unique_ptr<Integration>(
+      new Integration(*this, integrator, Δt, sampling_period, trajectories));
+}
+
+template<typename Frame>
+void NBodySystem<Frame>::set_number_of_threads(int const number_of_threads) {
+  CHECK_LE(1, number_of_threads);
+  if (number_of_threads == 1) {
+    thread_pool_.reset();
+  } else if (thread_pool_ == nullptr ||
+             thread_pool_->number_of_threads() != number_of_threads) {
+    thread_pool_ = std::make_unique<ThreadPool>(number_of_threads);
   }
 }
 
@@ -207,17 +144,30 @@ inline void NBodySystem<Frame>::ComputeOneBodyGravitationalAcceleration(
     size_t const b2_end,
     std::vector<Length> const& q,
     not_null<std::vector<Acceleration>*> const result) {
-  // NOTE(phl): Declaring variables for values like 3 * b1 + 1, 3 * b2 + 1, etc.
-  // in the code below brings no performance advantage as it seems that the
-  // compiler is smart enough to figure common subexpressions.
+  // See |ComputeGravitationalAccelerations| for the layout of |q| and
+  // |result|.  The coordinates of |body1| are hoisted out of the loop, and its
+  // acceleration is accumulated in locals, so that the loop only accesses the
+  // arrays for |body2| with unit stride.
+  std::size_t const number_of_bodies = q.size() / 3;
+  Length const* const qx = q.data();
+  Length const* const qy = qx + number_of_bodies;
+  Length const* const qz = qy + number_of_bodies;
+  Acceleration* const ax = result->data();
+  Acceleration* const ay = ax + number_of_bodies;
+  Acceleration* const az = ay + number_of_bodies;
+
   GravitationalParameter const& body1_gravitational_parameter =
       body1.gravitational_parameter();
-  std::size_t const three_b1 = 3 * b1;
+  Length const q1x = qx[b1];
+  Length const q1y = qy[b1];
+  Length const q1z = qz[b1];
+  Acceleration a1x = ax[b1];
+  Acceleration a1y = ay[b1];
+  Acceleration a1z = az[b1];
   for (std::size_t b2 = std::max(b1 + 1, b2_begin); b2 < b2_end; ++b2) {
-    std::size_t const three_b2 = 3 * b2;
-    Length const Δq0 = q[three_b1] - q[three_b2];
-    Length const Δq1 = q[three_b1 + 1] - q[three_b2 + 1];
-    Length const Δq2 = q[three_b1 + 2] - q[three_b2 + 2];
+    Length const Δq0 = q1x - qx[b2];
+    Length const Δq1 = q1y - qy[b2];
+    Length const Δq2 = q1z - qz[b2];
 
     Exponentiation<Length, 2> const r_squared =
         Δq0 * Δq0 + Δq1 * Δq1 + Δq2 * Δq2;
@@ -228,9 +178,9 @@ inline void NBodySystem<Frame>::ComputeOneBodyGravitationalAcceleration(
 
     auto const μ1_over_r_cubed =
         body1_gravitational_parameter * one_over_r_cubed;
-    (*result)[three_b2] += Δq0 * μ1_over_r_cubed;
-    (*result)[three_b2 + 1] += Δq1 * μ1_over_r_cubed;
-    (*result)[three_b2 + 2] += Δq2 * μ1_over_r_cubed;
+    ax[b2] += Δq0 * μ1_over_r_cubed;
+    ay[b2] += Δq1 * μ1_over_r_cubed;
+    az[b2] += Δq2 * μ1_over_r_cubed;
 
     MassiveBody const* body2 = nullptr;
     if (body2_is_massive) {
@@ -242,9 +192,9 @@ inline void NBodySystem<Frame>::ComputeOneBodyGravitationalAcceleration(
           body2->gravitational_parameter();
       auto const μ2_over_r_cubed =
           body2_gravitational_parameter * one_over_r_cubed;
-      (*result)[three_b1] -= Δq0 * μ2_over_r_cubed;
-      (*result)[three_b1 + 1] -= Δq1 * μ2_over_r_cubed;
-      (*result)[three_b1 + 2] -= Δq2 * μ2_over_r_cubed;
+      a1x -= Δq0 * μ2_over_r_cubed;
+      a1y -= Δq1 * μ2_over_r_cubed;
+      a1z -= Δq2 * μ2_over_r_cubed;
     }
 
     if (body1_is_oblate || body2_is_oblate) {
@@ -257,9 +207,9 @@ inline void NBodySystem<Frame>::ComputeOneBodyGravitationalAcceleration(
                 Δq,
                 one_over_r_squared,
                 one_over_r_cubed).coordinates();
-        (*result)[three_b2] += order_2_zonal_acceleration1.x;
-        (*result)[three_b2 + 1] += order_2_zonal_acceleration1.y;
-        (*result)[three_b2 + 2] += order_2_zonal_acceleration1.z;
+        ax[b2] += order_2_zonal_acceleration1.x;
+        ay[b2] += order_2_zonal_acceleration1.y;
+        az[b2] += order_2_zonal_acceleration1.z;
       }
       if (body2_is_oblate) {
         // |body2| was set in the |body2_is_massive| branch above.
@@ -269,19 +219,27 @@ inline void NBodySystem<Frame>::ComputeOneBodyGravitationalAcceleration(
                 Δq,
                 one_over_r_squared,
                 one_over_r_cubed).coordinates();
-        (*result)[three_b1] -= order_2_zonal_acceleration2.x;
-        (*result)[three_b1 + 1] -= order_2_zonal_acceleration2.y;
-        (*result)[three_b1 + 2] -= order_2_zonal_acceleration2.z;
+        a1x -= order_2_zonal_acceleration2.x;
+        a1y -= order_2_zonal_acceleration2.y;
+        a1z -= order_2_zonal_acceleration2.z;
       }
     }
   }
+  if (body2_is_massive) {
+    ax[b1] = a1x;
+    ay[b1] = a1y;
+    az[b1] = a1z;
+  }
 }
 
 template<typename Frame>
 void NBodySystem<Frame>::ComputeGravitationalAccelerations(
     ReadonlyTrajectories const& massive_oblate_trajectories,
     ReadonlyTrajectories const& massive_spherical_trajectories,
+    std::vector<GravitationalParameter> const&
+        massive_spherical_gravitational_parameters,
     ReadonlyTrajectories const& massless_trajectories,
+    ThreadPool* const thread_pool,
     Instant const& reference_time,
     Time const& t,
     std::vector<Length> const& q,
@@ -292,6 +250,12 @@ void NBodySystem<Frame>::ComputeGravitationalAccelerations(
   size_t const number_of_massive_spherical_trajectories =
       massive_spherical_trajectories.size();
   size_t const number_of_massless_trajectories = massless_trajectories.size();
+  size_t const number_of_bodies = number_of_massive_oblate_trajectories +
+                                  number_of_massive_spherical_trajectories +
+                                  number_of_massless_trajectories;
+  CHECK_EQ(3 * number_of_bodies, q.size());
+  CHECK_EQ(number_of_massive_spherical_trajectories,
+           massive_spherical_gravitational_parameters.size());
 
   for (std::size_t b1 = 0; b1 < number_of_massive_oblate_trajectories; ++b1) {
     OblateBody<Frame> const& body1 =
@@ -315,18 +279,6 @@ void NBodySystem<Frame>::ComputeGravitationalAccelerations(
             number_of_massive_spherical_trajectories /*b2_end*/,
         q,
         result);
-    ComputeOneBodyGravitationalAcceleration<true /*body1_is_oblate*/,
-                                            false /*body2_is_oblate*/,
-                                            false /*body2_is_massive*/>(
-        body1, b1,
-        massless_trajectories /*body2_trajectories*/,
-        number_of_massive_oblate_trajectories +
-            number_of_massive_spherical_trajectories /*b2_begin*/,
-        number_of_massive_oblate_trajectories +
-            number_of_massive_spherical_trajectories +
-            number_of_massless_trajectories /*b2_end*/,
-        q,
-        result);
   }
   for (std::size_t b1 = number_of_massive_oblate_trajectories;
        b1 < number_of_massive_oblate_trajectories +
@@ -346,40 +298,259 @@ void NBodySystem<Frame>::ComputeGravitationalAccelerations(
             number_of_massive_spherical_trajectories /*b2_end*/,
         q,
         result);
-    ComputeOneBodyGravitationalAcceleration<false /*body1_is_oblate*/,
-                                            false /*body2_is_oblate*/,
-                                            false /*body2_is_massive*/>(
-        body1, b1,
-        massless_trajectories /*body2_trajectories*/,
-        number_of_massive_oblate_trajectories +
-            number_of_massive_spherical_trajectories /*b2_begin*/,
-        number_of_massive_oblate_trajectories +
-            number_of_massive_spherical_trajectories +
-            number_of_massless_trajectories /*b2_end*/,
-        q,
-        result);
   }
-  // Finally, take into account the intrinsic accelerations.
-  for (size_t b2 = number_of_massive_oblate_trajectories +
-                   number_of_massive_spherical_trajectories;
-       b2 < number_of_massive_oblate_trajectories +
-            number_of_massive_spherical_trajectories +
-            number_of_massless_trajectories;
-       ++b2) {
-    std::size_t const three_b2 = 3 * b2;
-    Trajectory<Frame> const* trajectory =
-        massless_trajectories[b2 - number_of_massive_oblate_trajectories -
-                                   number_of_massive_spherical_trajectories];
-    if (trajectory->has_intrinsic_acceleration()) {
-      R3Element<Acceleration> const acceleration =
-          trajectory->evaluate_intrinsic_acceleration(
-              t + reference_time).coordinates();
-      (*result)[three_b2] += acceleration.x;
-      (*result)[three_b2 + 1] += acceleration.y;
-      (*result)[three_b2 + 2] += acceleration.z;
+  // The accelerations of the massless bodies only depend on the positions, so
+  // they may be computed in parallel.  Each massless body is processed by a
+  // single thread, and the contributions of the massive bodies are summed in
+  // the same order irrespective of the number of threads.
+  size_t const massive_spherical_begin = number_of_massive_oblate_trajectories;
+  size_t const massless_begin = number_of_massive_oblate_trajectories +
+                                number_of_massive_spherical_trajectories;
+  auto const compute_massless_accelerations =
+      [&](size_t const b2_begin, size_t const b2_end) {
+    for (std::size_t b1 = 0; b1 < number_of_massive_oblate_trajectories; ++b1) {
+      OblateBody<Frame> const& body1 =
+          *massive_oblate_trajectories[b1]->template body<OblateBody<Frame>>();
+      // |body2_trajectories| is not used when |body2_is_massive| is false.
+      ComputeOneBodyGravitationalAcceleration<true /*body1_is_oblate*/,
+                                              false /*body2_is_oblate*/,
+                                              false /*body2_is_massive*/>(
+          body1, b1,
+          massless_trajectories /*body2_trajectories*/,
+          b2_begin,
+          b2_end,
+          q,
+          result);
+    }
+
+    // The spherical massive bodies act on the massless bodies through a
+    // vectorized kernel.
+    Length const* const qx = q.data();
+    Length const* const qy = qx + number_of_bodies;
+    Length const* const qz = qy + number_of_bodies;
+    Acceleration* const ax = result->data();
+    Acceleration* const ay = ax + number_of_bodies;
+    Acceleration* const az = ay + number_of_bodies;
+    AddPointMassAccelerations(number_of_massive_spherical_trajectories,
+                              massive_spherical_gravitational_parameters.data(),
+                              qx + massive_spherical_begin,
+                              qy + massive_spherical_begin,
+                              qz + massive_spherical_begin,
+                              b2_end - b2_begin,
+                              qx + b2_begin,
+                              qy + b2_begin,
+                              qz + b2_begin,
+                              ax + b2_begin,
+                              ay + b2_begin,
+                              az + b2_begin);
+
+    // Finally, take into account the intrinsic accelerations.
+    for (size_t b2 = b2_begin; b2 < b2_end; ++b2) {
+      Trajectory<Frame> const* trajectory =
+          massless_trajectories[b2 - massless_begin];
+      if (trajectory->has_intrinsic_acceleration()) {
+        R3Element<Acceleration> const acceleration =
+            trajectory->evaluate_intrinsic_acceleration(
+                t + reference_time).coordinates();
+        ax[b2] += acceleration.x;
+        ay[b2] += acceleration.y;
+        az[b2] += acceleration.z;
+      }
+    }
+  };
+
+  if (thread_pool == nullptr) {
+    compute_massless_accelerations(massless_begin, number_of_bodies);
+  } else {
+    thread_pool->ParallelFor(massless_begin,
+                             number_of_bodies,
+                             kMinimumMasslessBodiesPerThread,
+                             compute_massless_accelerations);
+  }
+}
+
+template<typename Frame>
+NBodySystem<Frame>::Bodies::Bodies(Trajectories const& trajectories) {
+  // These objects are for checking the consistency of the parameters.
+  std::set<Instant> times_in_trajectories;
+  std::set<Body const*> bodies_in_trajectories;
+
+  // For efficiently computing the accelerations, we need to separate the
+  // trajectories of oblate massive bodies from of spherical massive bodies and
+  // those of massless bodies.  They are put in this order in
+  // |reordered_trajectories_|.  This loop ensures that the massive bodies
+  // precede the massless bodies in the vectors representing the state.
+  // The reference position is computed on the way.
+  typename Position<Frame>::template BarycentreCalculator<
+      GravitationalParameter> centre_of_mass;
+  typename Position<Frame>::template BarycentreCalculator<double> centroid;
+  for (bool is_massless : {false, true}) {
+    for (bool is_oblate : {true, false}) {
+      for (auto const& trajectory : trajectories) {
+        // See if this trajectory should be processed in this iteration and
+        // update the appropriate vector.
+        not_null<Body const*> const body = trajectory->template body<Body>();
+        if (body->is_massless() != is_massless ||
+            body->is_oblate() != is_oblate) {
+          continue;
+        }
+        if (is_massless) {
+          CHECK(!is_oblate);
+          massless_trajectories_.push_back(trajectory);
+        } else if (is_oblate) {
+          massive_oblate_trajectories_.push_back(trajectory);
+        } else {
+          massive_spherical_trajectories_.push_back(trajectory);
+          massive_spherical_gravitational_parameters_.push_back(
+              trajectory->template body<MassiveBody>()->
+                  gravitational_parameter());
+        }
+        reordered_trajectories_.push_back(trajectory);
+        Position<Frame> const position =
+            trajectory->last().degrees_of_freedom().position();
+        if (!is_massless) {
+          centre_of_mass.Add(
+              position,
+              trajectory->template body<MassiveBody>()->
+                  gravitational_parameter());
+        }
+        centroid.Add(position, 1);
+
+        // Check that all trajectories are for different bodies.
+        auto const inserted = bodies_in_trajectories.emplace(body);
+        CHECK(inserted.second) << "Multiple trajectories for the same body";
+        // The final points of all trajectories must all be for the same time.
+        times_in_trajectories.emplace(trajectory->last().time());
+        CHECK_GE(1U, times_in_trajectories.size())
+            << "Inconsistent last time in trajectories";
+      }
+    }
+  }
+  CHECK(!times_in_trajectories.empty()) << "No trajectories";
+  last_time_ = *times_in_trajectories.cbegin();
+  reference_position_ = IntegrationOrigin(
+      massive_oblate_trajectories_.empty() &&
+          massive_spherical_trajectories_.empty()
+          ? centroid.Get()
+          : centre_of_mass.Get());
+}
+
+template<typename Frame>
+Instant const& NBodySystem<Frame>::Bodies::last_time() const {
+  return last_time_;
+}
+
+template<typename Frame>
+Instant const& NBodySystem<Frame>::Bodies::reference_time() const {
+  return reference_time_;
+}
+
+template<typename Frame>
+typename NBodySystem<Frame>::SystemState
+NBodySystem<Frame>::Bodies::InitialState() const {
+  // The state is laid out as a structure of arrays, see
+  // |ComputeGravitationalAccelerations|.
+  std::size_t const number_of_bodies = reordered_trajectories_.size();
+  SystemState state;
+  state.positions.resize(3 * number_of_bodies);
+  state.momenta.resize(3 * number_of_bodies);
+  for (std::size_t b = 0; b < number_of_bodies; ++b) {
+    auto const last = reordered_trajectories_[b]->last();
+    // NOTE(phl): Using |const&| below doesn't work, even though 12.2/5
+    // seems to indicate that it should.  A bug in Visual Studio 2013?
+    R3Element<Length> const position =
+        (last.degrees_of_freedom().position() -
+         reference_position_).coordinates();
+    R3Element<Speed> const& velocity =
+        last.degrees_of_freedom().velocity().coordinates();
+    for (int i = 0; i < 3; ++i) {
+      state.positions[i * number_of_bodies + b] = position[i];
+      state.momenta[i * number_of_bodies + b] = velocity[i];
     }
   }
+  state.time = last_time_ - reference_time_;
+  return state;
 }
 
+template<typename Frame>
+void NBodySystem<Frame>::Bodies::Append(SystemState const& state) const {
+  std::size_t const number_of_bodies = reordered_trajectories_.size();
+  Instant const time = state.time.value + reference_time_;
+  CHECK_EQ(state.positions.size(), state.momenta.size());
+  CHECK_EQ(3 * number_of_bodies, state.positions.size());
+  // Loop over the bodies.
+  for (std::size_t b = 0; b < number_of_bodies; ++b) {
+    Vector<Length, Frame> const position(
+        R3Element<Length>(
+            state.positions[b].value,
+            state.positions[number_of_bodies + b].value,
+            state.positions[2 * number_of_bodies + b].value));
+    Vector<Length, Frame> const position_error(
+        R3Element<Length>(
+            state.positions[b].error,
+            state.positions[number_of_bodies + b].error,
+            state.positions[2 * number_of_bodies + b].error));
+    Velocity<Frame> const velocity(
+        R3Element<Speed>(
+            state.momenta[b].value,
+            state.momenta[number_of_bodies + b].value,
+            state.momenta[2 * number_of_bodies + b].value));
+    reordered_trajectories_[b]->Append(
+        time,
+        DegreesOfFreedom<Frame>(
+            FromIntegrationOrigin(reference_position_,
+                                  position,
+                                  position_error),
+            velocity));
+  }
+}
+
+template<typename Frame>
+void NBodySystem<Frame>::Bodies::ComputeGravitationalAccelerations(
+    ThreadPool* const thread_pool,
+    Time const& t,
+    std::vector<Length> const& q,
+    not_null<std::vector<Acceleration>*> const result) const {
+  NBodySystem::ComputeGravitationalAccelerations(
+      massive_oblate_trajectories_,
+      massive_spherical_trajectories_,
+      massive_spherical_gravitational_parameters_,
+      massless_trajectories_,
+      thread_pool,
+      reference_time_,
+      t, q, result);
+}
+
+template<typename Frame>
+SRKNIntegrator::SRKNRightHandSideComputation<Length>
+NBodySystem<Frame>::AccelerationComputation(Bodies const& bodies) const {
+  return [this, &bodies](Time const& t,
+                         std::vector<Length> const& q,
+                         not_null<std::vector<Acceleration>*> const result) {
+    bodies.ComputeGravitationalAccelerations(thread_pool_.get(), t, q, result);
+  };
+}
+
+template<typename Frame>
+void NBodySystem<Frame>::Integration::Advance(Instant const& tmax) {
+  instance_.Solve(tmax - bodies_.reference_time(),
+                  [this](SystemState const& state) {
+                    bodies_.Append(state);
+                  });
+}
+
+template<typename Frame>
+NBodySystem<Frame>::Integration::Integration(NBodySystem const& system,
+                                             SRKNIntegrator const& integrator,
+                                             Time const& Δt,
+                                             int const sampling_period,
+                                             Trajectories const& trajectories)
+    : bodies_(trajectories),
+      instance_(integrator,
+                system.AccelerationComputation(bodies_),
+                bodies_.InitialState(),
+                Δt,
+                sampling_period) {}
+
 }  // namespace physics
 }  // namespace principia
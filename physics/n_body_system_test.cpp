@@ -1,8 +1,10 @@
 ﻿#include "physics/n_body_system.hpp"
 
+#include <algorithm>
 #include <map>
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "base/macros.hpp"
@@ -130,7 +132,7 @@ class NBodySystemTest : public testing::Test {
   }
 
   template<typename T1, typename T2>
-  std::vector<T2> ValuesOf(std::map<T1, Point<T2>> const& m,
+  std::vector<T2> ValuesOf(std::vector<std::pair<T1, Point<T2>>> const& m,
                            Point<T2> const& relative_to) {
     std::vector<T2> result;
     for (auto const it : m) {
@@ -206,6 +208,40 @@ TEST_F(NBodySystemTest, EarthMoon) {
   EXPECT_THAT(Abs(positions[100].coordinates().x), Lt(2 * SIUnit<Length>()));
 }
 
+// An integration resumed several times produces the same points as a single
+// integration.
+TEST_F(NBodySystemTest, ResumedIntegration) {
+  Instant const t0 = trajectory1_->last().time();
+  system_->Integrate(*integrator_,
+                     t0 + period_,
+                     period_ / 100,
+                     1,      // sampling_period
+                     false,  // tmax_is_exact
+                     {trajectory1_.get(), trajectory2_.get()});
+
+  Trajectory<EarthMoonOrbitPlane> resumed_trajectory1(&body1_);
+  Trajectory<EarthMoonOrbitPlane> resumed_trajectory2(&body2_);
+  auto const first1 = trajectory1_->first();
+  auto const first2 = trajectory2_->first();
+  resumed_trajectory1.Append(first1.time(), first1.degrees_of_freedom());
+  resumed_trajectory2.Append(first2.time(), first2.degrees_of_freedom());
+  auto const integration =
+      system_->NewIntegration(*integrator_,
+                              period_ / 100,
+                              1,  // sampling_period
+                              {&resumed_trajectory1, &resumed_trajectory2});
+  integration->Advance(t0 + period_ / 3);
+  integration->Advance(t0 + period_ / 2);
+  integration->Advance(t0 + period_);
+
+  EXPECT_THAT(resumed_trajectory1.Positions(),
+              Eq(trajectory1_->Positions()));
+  EXPECT_THAT(resumed_trajectory2.Positions(),
+              Eq(trajectory2_->Positions()));
+  EXPECT_THAT(resumed_trajectory2.Velocities(),
+              Eq(trajectory2_->Velocities()));
+}
+
 // Same as above, but the trajectories are passed in the reverse order.
 TEST_F(NBodySystemTest, MoonEarth) {
   std::vector<Vector<Length, EarthMoonOrbitPlane>> positions;
@@ -233,6 +269,63 @@ TEST_F(NBodySystemTest, MoonEarth) {
   EXPECT_THAT(Abs(positions[100].coordinates().x), Lt(2 * SIUnit<Length>()));
 }
 
+// The Earth-Moon system, far from the origin of space and time, at about the
+// distance of Jool from Kerbol and a few years into a game.  Because the
+// integration is done relative to an origin near the bodies, the relative
+// positions are as accurate as the coordinates allow.
+TEST_F(NBodySystemTest, FarFromOrigin) {
+  Vector<Length, EarthMoonOrbitPlane> const offset(
+      {7E10 * SIUnit<Length>(),
+       3E10 * SIUnit<Length>(),
+       1E9 * SIUnit<Length>()});
+  Time const time_offset = 1E8 * SIUnit<Time>();
+  Trajectory<EarthMoonOrbitPlane> far_trajectory1(&body1_);
+  Trajectory<EarthMoonOrbitPlane> far_trajectory2(&body2_);
+  for (auto const& pair : {std::make_pair(trajectory1_.get(),
+                                          &far_trajectory1),
+                           std::make_pair(trajectory2_.get(),
+                                          &far_trajectory2)}) {
+    auto const last = pair.first->last();
+    pair.second->Append(
+        last.time() + time_offset,
+        DegreesOfFreedom<EarthMoonOrbitPlane>(
+            last.degrees_of_freedom().position() + offset,
+            last.degrees_of_freedom().velocity()));
+  }
+  Instant const tmax = trajectory1_->last().time() + period_;
+  system_->Integrate(*integrator_,
+                     tmax,
+                     period_ / 100,
+                     1,     // sampling_period
+                     true,  // tmax_is_exact
+                     {trajectory1_.get(), trajectory2_.get()});
+  system_->Integrate(*integrator_,
+                     tmax + time_offset,
+                     period_ / 100,
+                     1,     // sampling_period
+                     true,  // tmax_is_exact
+                     {&far_trajectory1, &far_trajectory2});
+
+  EXPECT_THAT(far_trajectory2.last().time(), Eq(tmax + time_offset));
+  Length max_error;
+  for (auto const& pair : {std::make_pair(trajectory1_.get(),
+                                          &far_trajectory1),
+                           std::make_pair(trajectory2_.get(),
+                                          &far_trajectory2)}) {
+    auto const positions = pair.first->Positions();
+    auto const far_positions = pair.second->Positions();
+    ASSERT_THAT(far_positions.size(), Eq(positions.size()));
+    for (std::size_t i = 0; i < positions.size(); ++i) {
+      max_error = std::max(max_error,
+                           (far_positions[i].second - offset -
+                                positions[i].second).Norm());
+    }
+  }
+  LOG(INFO) << "Maximum error: " << max_error;
+  // About one ulp of the coordinates far from the origin.
+  EXPECT_THAT(max_error, Lt(2E-5 * SIUnit<Length>()));
+}
+
 // The Moon alone.  It moves in straight line.
 TEST_F(NBodySystemTest, Moon) {
   Position<EarthMoonOrbitPlane> const reference_position =
@@ -334,6 +427,57 @@ TEST_F(NBodySystemTest, EarthProbe) {
   EXPECT_THAT(positions3[100].coordinates().y, Eq(q3));
 }
 
+// The Earth, the Moon and many probes, integrated with various numbers of
+// threads.  The results must be bitwise identical.
+TEST_F(NBodySystemTest, Multithreading) {
+  int const number_of_probes = 100;
+  std::vector<MasslessBody> const probes(number_of_probes);
+  std::vector<std::vector<DegreesOfFreedom<EarthMoonOrbitPlane>>> results;
+  for (int const number_of_threads : {1, 2, 3, 7}) {
+    auto earth = make_not_null_unique<Trajectory<EarthMoonOrbitPlane>>(&body1_);
+    auto moon = make_not_null_unique<Trajectory<EarthMoonOrbitPlane>>(&body2_);
+    earth->Append(trajectory1_->last().time(),
+                  trajectory1_->last().degrees_of_freedom());
+    moon->Append(trajectory2_->last().time(),
+                 trajectory2_->last().degrees_of_freedom());
+    NBodySystem<EarthMoonOrbitPlane>::Trajectories trajectories = {
+        earth.get(), moon.get()};
+    std::vector<not_null<std::unique_ptr<Trajectory<EarthMoonOrbitPlane>>>>
+        probe_trajectories;
+    for (int i = 0; i < number_of_probes; ++i) {
+      probe_trajectories.push_back(
+          make_not_null_unique<Trajectory<EarthMoonOrbitPlane>>(&probes[i]));
+      probe_trajectories.back()->Append(
+          trajectory1_->last().time(),
+          {trajectory1_->last().degrees_of_freedom().position() +
+               Vector<Length, EarthMoonOrbitPlane>(
+                   {(1E7 + i * 1E6) * SIUnit<Length>(),
+                    (i % 7) * 1E6 * SIUnit<Length>(),
+                    (i % 3) * 1E6 * SIUnit<Length>()}),
+           trajectory1_->last().degrees_of_freedom().velocity() +
+               Velocity<EarthMoonOrbitPlane>(
+                   {0 * SIUnit<Speed>(),
+                    (5E3 - i * 10) * SIUnit<Speed>(),
+                    (i % 5) * SIUnit<Speed>()})});
+      trajectories.push_back(probe_trajectories.back().get());
+    }
+    system_->set_number_of_threads(number_of_threads);
+    system_->Integrate(*integrator_,
+                       trajectory1_->last().time() + period_ / 10,
+                       period_ / 1000,
+                       1,      // sampling_period
+                       false,  // tmax_is_exact
+                       trajectories);
+    results.emplace_back();
+    for (auto const& trajectory : trajectories) {
+      results.back().push_back(trajectory->last().degrees_of_freedom());
+    }
+  }
+  for (std::size_t i = 1; i < results.size(); ++i) {
+    EXPECT_THAT(results[i], Eq(results[0]));
+  }
+}
+
 TEST_F(NBodySystemTest, Sputnik1ToSputnik2) {
   not_null<std::unique_ptr<SolarSystem>> const evolved_system =
       SolarSystem::AtСпутник1Launch(
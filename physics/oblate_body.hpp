@@ -10,6 +10,7 @@
 
 #include <vector>
 
+#include "base/macros.hpp"
 #include "geometry/grassmann.hpp"
 #include "quantities/named_quantities.hpp"
 #include "quantities/quantities.hpp"
@@ -17,6 +18,8 @@
 namespace principia {
 
 using geometry::Vector;
+using quantities::Acceleration;
+using quantities::Exponentiation;
 using quantities::GravitationalParameter;
 using quantities::Length;
 using quantities::Mass;
@@ -75,6 +78,22 @@ class OblateBody : public MassiveBody {
   Vector<double, Frame> const axis_;
 };
 
+// The acceleration exerted by the order 2 zonal harmonic of |body| on a point
+// mass at a separation |r| from it.  If j is a unit vector along the axis of
+// rotation, the acceleration is:
+//
+//   -(J2 / |r|^5) (3 j (r.j) + r (3 - 15 (r.j)^2 / |r|^2) / 2)
+//
+// Where |r| is the norm of r and r.j is the inner product.  The inverse powers
+// of |r| are passed by the caller, which usually has them at hand.
+template<typename Frame>
+FORCE_INLINE Vector<Acceleration, Frame>
+    Order2ZonalAcceleration(
+        OblateBody<Frame> const& body,
+        Vector<Length, Frame> const& r,
+        Exponentiation<Length, -2> const& one_over_r_squared,
+        Exponentiation<Length, -3> const& one_over_r_cubed);
+
 }  // namespace physics
 }  // namespace principia
 
@@ -7,6 +7,7 @@
 namespace principia {
 
 using constants::GravitationalConstant;
+using geometry::InnerProduct;
 
 namespace physics {
 
@@ -121,5 +122,26 @@ not_null<std::unique_ptr<OblateBody<Frame>>> OblateBody<Frame>::ReadFromMessage(
           oblateness_information.axis()));
 }
 
+template<typename Frame>
+FORCE_INLINE Vector<Acceleration, Frame>
+    Order2ZonalAcceleration(
+        OblateBody<Frame> const& body,
+        Vector<Length, Frame> const& r,
+        Exponentiation<Length, -2> const& one_over_r_squared,
+        Exponentiation<Length, -3> const& one_over_r_cubed) {
+  Vector<double, Frame> const& axis = body.axis();
+  Length const r_axis_projection = InnerProduct(axis, r);
+  auto const j2_over_r_fifth =
+      body.j2() * one_over_r_cubed * one_over_r_squared;
+  Vector<Acceleration, Frame> const& axis_acceleration =
+      (-3 * j2_over_r_fifth * r_axis_projection) * axis;
+  Vector<Acceleration, Frame> const& radial_acceleration =
+      (j2_over_r_fifth *
+           (-1.5 +
+            7.5 * r_axis_projection *
+                  r_axis_projection * one_over_r_squared)) * r;
+  return axis_acceleration + radial_acceleration;
+}
+
 }  // namespace physics
 }  // namespace principia
@@ -0,0 +1,60 @@
+﻿#pragma once
+
+#include <cstddef>
+
+#include "quantities/named_quantities.hpp"
+#include "quantities/quantities.hpp"
+
+namespace principia {
+
+using quantities::Acceleration;
+using quantities::GravitationalParameter;
+using quantities::Length;
+
+namespace physics {
+
+// Adds to the accelerations |ax|, |ay|, |az| of |massless_count| massless
+// bodies located at |x|, |y|, |z| the accelerations due to the point masses of
+// |massive_count| massive bodies whose gravitational parameters are |μ| and
+// which are located at |mx|, |my|, |mz|.  All the arrays are structures of
+// arrays, indexed by body, with unit stride.
+// The massless bodies are processed in batches which are as wide as the vector
+// registers of the target (see |PRINCIPIA_USE_AVX| and |PRINCIPIA_USE_SSE2|);
+// the positions and accelerations of a batch are loaded once and the massive
+// bodies are traversed in increasing index order.  For each massless body the
+// operations are the same, and performed in the same order, as in
+// |AddPointMassAccelerationsWithoutSIMD|, so the results are bitwise identical
+// to those of that function, independently of the number of massless bodies.
+void AddPointMassAccelerations(std::size_t const massive_count,
+                               GravitationalParameter const* const μ,
+                               Length const* const mx,
+                               Length const* const my,
+                               Length const* const mz,
+                               std::size_t const massless_count,
+                               Length const* const x,
+                               Length const* const y,
+                               Length const* const z,
+                               Acceleration* const ax,
+                               Acceleration* const ay,
+                               Acceleration* const az);
+
+// Same as above, but one massless body at a time.  Exposed for testing and
+// benchmarking.
+void AddPointMassAccelerationsWithoutSIMD(
+    std::size_t const massive_count,
+    GravitationalParameter const* const μ,
+    Length const* const mx,
+    Length const* const my,
+    Length const* const mz,
+    std::size_t const massless_count,
+    Length const* const x,
+    Length const* const y,
+    Length const* const z,
+    Acceleration* const ax,
+    Acceleration* const ay,
+    Acceleration* const az);
+
+}  // namespace physics
+}  // namespace principia
+
+#include "physics/point_mass_accelerations_body.hpp"
@@ -0,0 +1,237 @@
+﻿#pragma once
+
+#include "physics/point_mass_accelerations.hpp"
+
+#include <algorithm>
+#include <type_traits>
+
+#include "base/macros.hpp"
+#include "quantities/elementary_functions.hpp"
+#include "quantities/quantities.hpp"
+
+#if PRINCIPIA_USE_AVX
+#include <immintrin.h>
+#elif PRINCIPIA_USE_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace principia {
+
+using quantities::Exponentiation;
+using quantities::Sqrt;
+
+namespace physics {
+
+namespace {
+
+#if PRINCIPIA_USE_AVX || PRINCIPIA_USE_SSE2
+
+// A thin layer over the vector registers of the target, so that the kernel
+// below is written only once.  Only correctly rounded operations are used, so
+// that each lane computes exactly what the scalar code computes.
+#if PRINCIPIA_USE_AVX
+using Pack = __m256d;
+std::size_t const kPackWidth = 4;
+FORCE_INLINE Pack Load(double const* const p) { return _mm256_loadu_pd(p); }
+FORCE_INLINE void Store(double* const p, Pack const a) {
+  _mm256_storeu_pd(p, a);
+}
+FORCE_INLINE Pack Broadcast(double const a) { return _mm256_set1_pd(a); }
+FORCE_INLINE Pack Add(Pack const a, Pack const b) {
+  return _mm256_add_pd(a, b);
+}
+FORCE_INLINE Pack Sub(Pack const a, Pack const b) {
+  return _mm256_sub_pd(a, b);
+}
+FORCE_INLINE Pack Mul(Pack const a, Pack const b) {
+  return _mm256_mul_pd(a, b);
+}
+FORCE_INLINE Pack Div(Pack const a, Pack const b) {
+  return _mm256_div_pd(a, b);
+}
+FORCE_INLINE Pack SquareRoot(Pack const a) { return _mm256_sqrt_pd(a); }
+#else
+using Pack = __m128d;
+std::size_t const kPackWidth = 2;
+FORCE_INLINE Pack Load(double const* const p) { return _mm_loadu_pd(p); }
+FORCE_INLINE void Store(double* const p, Pack const a) { _mm_storeu_pd(p, a); }
+FORCE_INLINE Pack Broadcast(double const a) { return _mm_set1_pd(a); }
+FORCE_INLINE Pack Add(Pack const a, Pack const b) {
+  return _mm_add_pd(a, b);
+}
+FORCE_INLINE Pack Sub(Pack const a, Pack const b) {
+  return _mm_sub_pd(a, b);
+}
+FORCE_INLINE Pack Mul(Pack const a, Pack const b) {
+  return _mm_mul_pd(a, b);
+}
+FORCE_INLINE Pack Div(Pack const a, Pack const b) {
+  return _mm_div_pd(a, b);
+}
+FORCE_INLINE Pack SquareRoot(Pack const a) { return _mm_sqrt_pd(a); }
+#endif
+
+// The vector code accesses the quantities through their magnitudes.
+template<typename Q>
+FORCE_INLINE double const* Magnitudes(Q const* const q) {
+  static_assert(sizeof(Q) == sizeof(double) &&
+                    std::is_standard_layout<Q>::value,
+                "Quantity must be layout-compatible with double");
+  return reinterpret_cast<double const*>(q);
+}
+
+template<typename Q>
+FORCE_INLINE double* Magnitudes(Q* const q) {
+  static_assert(sizeof(Q) == sizeof(double) &&
+                    std::is_standard_layout<Q>::value,
+                "Quantity must be layout-compatible with double");
+  return reinterpret_cast<double*>(q);
+}
+
+// Processes the |kPackWidth| massless bodies starting at |x|, |y|, |z|, |ax|,
+// |ay|, |az|.  The operations match those of
+// |AddPointMassAccelerationsWithoutSIMD| one for one.
+FORCE_INLINE void AddPointMassAccelerationsToPack(
+    std::size_t const massive_count,
+    double const* const μ,
+    double const* const mx,
+    double const* const my,
+    double const* const mz,
+    double const* const x,
+    double const* const y,
+    double const* const z,
+    double* const ax,
+    double* const ay,
+    double* const az) {
+  Pack const x2 = Load(x);
+  Pack const y2 = Load(y);
+  Pack const z2 = Load(z);
+  Pack a2x = Load(ax);
+  Pack a2y = Load(ay);
+  Pack a2z = Load(az);
+  for (std::size_t b1 = 0; b1 < massive_count; ++b1) {
+    Pack const Δq0 = Sub(Broadcast(mx[b1]), x2);
+    Pack const Δq1 = Sub(Broadcast(my[b1]), y2);
+    Pack const Δq2 = Sub(Broadcast(mz[b1]), z2);
+    Pack const r_squared =
+        Add(Add(Mul(Δq0, Δq0), Mul(Δq1, Δq1)), Mul(Δq2, Δq2));
+    Pack const one_over_r_cubed =
+        Div(SquareRoot(r_squared), Mul(r_squared, r_squared));
+    Pack const μ1_over_r_cubed = Mul(Broadcast(μ[b1]), one_over_r_cubed);
+    a2x = Add(a2x, Mul(Δq0, μ1_over_r_cubed));
+    a2y = Add(a2y, Mul(Δq1, μ1_over_r_cubed));
+    a2z = Add(a2z, Mul(Δq2, μ1_over_r_cubed));
+  }
+  Store(ax, a2x);
+  Store(ay, a2y);
+  Store(az, a2z);
+}
+
+#endif
+
+}  // namespace
+
+inline void AddPointMassAccelerations(std::size_t const massive_count,
+                                      GravitationalParameter const* const μ,
+                                      Length const* const mx,
+                                      Length const* const my,
+                                      Length const* const mz,
+                                      std::size_t const massless_count,
+                                      Length const* const x,
+                                      Length const* const y,
+                                      Length const* const z,
+                                      Acceleration* const ax,
+                                      Acceleration* const ay,
+                                      Acceleration* const az) {
+#if PRINCIPIA_USE_AVX || PRINCIPIA_USE_SSE2
+  double const* const μ_magnitudes = Magnitudes(μ);
+  double const* const mx_magnitudes = Magnitudes(mx);
+  double const* const my_magnitudes = Magnitudes(my);
+  double const* const mz_magnitudes = Magnitudes(mz);
+
+  std::size_t const full_packs_end =
+      massless_count - massless_count % kPackWidth;
+  for (std::size_t b2 = 0; b2 < full_packs_end; b2 += kPackWidth) {
+    AddPointMassAccelerationsToPack(
+        massive_count,
+        μ_magnitudes, mx_magnitudes, my_magnitudes, mz_magnitudes,
+        Magnitudes(x + b2), Magnitudes(y + b2), Magnitudes(z + b2),
+        Magnitudes(ax + b2), Magnitudes(ay + b2), Magnitudes(az + b2));
+  }
+
+  // The remaining bodies are copied to a full pack, which is padded with
+  // copies of the last body so that no lane computes on garbage (which could
+  // be slow if it were denormal).  This ensures that each body goes through
+  // the same instructions regardless of its position in the arrays.
+  if (full_packs_end < massless_count) {
+    double x2[kPackWidth];
+    double y2[kPackWidth];
+    double z2[kPackWidth];
+    double a2x[kPackWidth];
+    double a2y[kPackWidth];
+    double a2z[kPackWidth];
+    std::size_t const last = massless_count - 1;
+    for (std::size_t i = 0; i < kPackWidth; ++i) {
+      std::size_t const b2 = std::min(full_packs_end + i, last);
+      x2[i] = Magnitudes(x)[b2];
+      y2[i] = Magnitudes(y)[b2];
+      z2[i] = Magnitudes(z)[b2];
+      a2x[i] = Magnitudes(ax)[b2];
+      a2y[i] = Magnitudes(ay)[b2];
+      a2z[i] = Magnitudes(az)[b2];
+    }
+    AddPointMassAccelerationsToPack(
+        massive_count,
+        μ_magnitudes, mx_magnitudes, my_magnitudes, mz_magnitudes,
+        x2, y2, z2, a2x, a2y, a2z);
+    for (std::size_t b2 = full_packs_end; b2 < massless_count; ++b2) {
+      std::size_t const i = b2 - full_packs_end;
+      Magnitudes(ax)[b2] = a2x[i];
+      Magnitudes(ay)[b2] = a2y[i];
+      Magnitudes(az)[b2] = a2z[i];
+    }
+  }
+#else
+  AddPointMassAccelerationsWithoutSIMD(massive_count, μ, mx, my, mz,
+                                       massless_count, x, y, z, ax, ay, az);
+#endif
+}
+
+inline void AddPointMassAccelerationsWithoutSIMD(
+    std::size_t const massive_count,
+    GravitationalParameter const* const μ,
+    Length const* const mx,
+    Length const* const my,
+    Length const* const mz,
+    std::size_t const massless_count,
+    Length const* const x,
+    Length const* const y,
+    Length const* const z,
+    Acceleration* const ax,
+    Acceleration* const ay,
+    Acceleration* const az) {
+  for (std::size_t b2 = 0; b2 < massless_count; ++b2) {
+    Acceleration a2x = ax[b2];
+    Acceleration a2y = ay[b2];
+    Acceleration a2z = az[b2];
+    for (std::size_t b1 = 0; b1 < massive_count; ++b1) {
+      Length const Δq0 = mx[b1] - x[b2];
+      Length const Δq1 = my[b1] - y[b2];
+      Length const Δq2 = mz[b1] - z[b2];
+      Exponentiation<Length, 2> const r_squared =
+          Δq0 * Δq0 + Δq1 * Δq1 + Δq2 * Δq2;
+      Exponentiation<Length, -3> const one_over_r_cubed =
+          Sqrt(r_squared) / (r_squared * r_squared);
+      auto const μ1_over_r_cubed = μ[b1] * one_over_r_cubed;
+      a2x += Δq0 * μ1_over_r_cubed;
+      a2y += Δq1 * μ1_over_r_cubed;
+      a2z += Δq2 * μ1_over_r_cubed;
+    }
+    ax[b2] = a2x;
+    ay[b2] = a2y;
+    az[b2] = a2z;
+  }
+}
+
+}  // namespace physics
+}  // namespace principia
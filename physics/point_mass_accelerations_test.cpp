@@ -0,0 +1,128 @@
+﻿#include "physics/point_mass_accelerations.hpp"
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "geometry/r3_element.hpp"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "quantities/elementary_functions.hpp"
+#include "quantities/named_quantities.hpp"
+#include "quantities/quantities.hpp"
+#include "testing_utilities/numerics.hpp"
+
+namespace principia {
+
+using geometry::R3Element;
+using quantities::Acceleration;
+using quantities::GravitationalParameter;
+using quantities::Length;
+using quantities::SIUnit;
+using quantities::Sqrt;
+using testing_utilities::RelativeError;
+using ::testing::Eq;
+using ::testing::Lt;
+
+namespace physics {
+
+class PointMassAccelerationsTest : public testing::Test {
+ protected:
+  // Fills the positions and gravitational parameters of |massive_count| massive
+  // bodies and the positions and initial accelerations of |massless_count|
+  // massless bodies with reproducible pseudo-random values of
+  // solar-system-like magnitudes.
+  void Fill(std::size_t const massive_count, std::size_t const massless_count) {
+    std::mt19937_64 random(42);
+    std::uniform_real_distribution<> distribution(-1.0, 1.0);
+    μ_.clear();
+    mx_.clear();
+    my_.clear();
+    mz_.clear();
+    for (std::size_t b1 = 0; b1 < massive_count; ++b1) {
+      μ_.push_back((1 + distribution(random)) * 1E20 *
+                   SIUnit<GravitationalParameter>());
+      mx_.push_back(distribution(random) * 1E12 * SIUnit<Length>());
+      my_.push_back(distribution(random) * 1E12 * SIUnit<Length>());
+      mz_.push_back(distribution(random) * 1E10 * SIUnit<Length>());
+    }
+    x_.clear();
+    y_.clear();
+    z_.clear();
+    a_.clear();
+    for (std::size_t b2 = 0; b2 < massless_count; ++b2) {
+      x_.push_back(distribution(random) * 1E12 * SIUnit<Length>());
+      y_.push_back(distribution(random) * 1E12 * SIUnit<Length>());
+      z_.push_back(distribution(random) * 1E10 * SIUnit<Length>());
+    }
+    for (std::size_t i = 0; i < 3 * massless_count; ++i) {
+      a_.push_back(distribution(random) * 1E-5 * SIUnit<Acceleration>());
+    }
+  }
+
+  std::vector<GravitationalParameter> μ_;
+  std::vector<Length> mx_;
+  std::vector<Length> my_;
+  std::vector<Length> mz_;
+  std::vector<Length> x_;
+  std::vector<Length> y_;
+  std::vector<Length> z_;
+  // The three components of the accelerations, as a structure of arrays.
+  std::vector<Acceleration> a_;
+};
+
+// Checks that the vectorized kernel gives the same results as the scalar one,
+// to the last bit, for numbers of massless bodies that exercise the handling of
+// incomplete packs.
+TEST_F(PointMassAccelerationsTest, Bitwise) {
+  for (std::size_t const massless_count : {1, 2, 3, 4, 5, 7, 8, 9, 33}) {
+    Fill(11 /*massive_count*/, massless_count);
+    std::vector<Acceleration> expected = a_;
+    std::vector<Acceleration> actual = a_;
+    std::size_t const n = massless_count;
+    AddPointMassAccelerationsWithoutSIMD(
+        μ_.size(), μ_.data(), mx_.data(), my_.data(), mz_.data(),
+        n, x_.data(), y_.data(), z_.data(),
+        &expected[0], &expected[n], &expected[2 * n]);
+    AddPointMassAccelerations(
+        μ_.size(), μ_.data(), mx_.data(), my_.data(), mz_.data(),
+        n, x_.data(), y_.data(), z_.data(),
+        &actual[0], &actual[n], &actual[2 * n]);
+    for (std::size_t i = 0; i < 3 * n; ++i) {
+      EXPECT_THAT(actual[i], Eq(expected[i])) << massless_count << " " << i;
+    }
+  }
+}
+
+// Checks the accelerations against Newton's law of universal gravitation.
+TEST_F(PointMassAccelerationsTest, Newton) {
+  std::size_t const n = 6;
+  Fill(3 /*massive_count*/, n);
+  std::vector<Acceleration> actual = a_;
+  AddPointMassAccelerations(
+      μ_.size(), μ_.data(), mx_.data(), my_.data(), mz_.data(),
+      n, x_.data(), y_.data(), z_.data(),
+      &actual[0], &actual[n], &actual[2 * n]);
+  for (std::size_t b2 = 0; b2 < n; ++b2) {
+    Acceleration ax = a_[b2];
+    Acceleration ay = a_[n + b2];
+    Acceleration az = a_[2 * n + b2];
+    for (std::size_t b1 = 0; b1 < μ_.size(); ++b1) {
+      Length const dx = mx_[b1] - x_[b2];
+      Length const dy = my_[b1] - y_[b2];
+      Length const dz = mz_[b1] - z_[b2];
+      Length const r = Sqrt(dx * dx + dy * dy + dz * dz);
+      ax += μ_[b1] * dx / (r * r * r);
+      ay += μ_[b1] * dy / (r * r * r);
+      az += μ_[b1] * dz / (r * r * r);
+    }
+    EXPECT_THAT(RelativeError(R3Element<Acceleration>(ax, ay, az),
+                              R3Element<Acceleration>(actual[b2],
+                                                      actual[n + b2],
+                                                      actual[2 * n + b2])),
+                Lt(1E-14));
+  }
+}
+
+}  // namespace physics
+}  // namespace principia
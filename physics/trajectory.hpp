@@ -4,10 +4,14 @@
 #include <list>
 #include <map>
 #include <memory>
+#include <string>
+#include <utility>
+#include <vector>
 
 #include "base/not_null.hpp"
 #include "geometry/grassmann.hpp"
 #include "geometry/named_quantities.hpp"
+#include "physics/chunked_timeline.hpp"
 #include "physics/degrees_of_freedom.hpp"
 #include "quantities/named_quantities.hpp"
 #include "serialization/physics.pb.h"
@@ -30,12 +34,12 @@ template<typename Frame>
 class Trajectory {
   // There may be several forks starting from the same time, hence the multimap.
   using Children = std::multimap<Instant, Trajectory>;
-  using Timeline = std::map<Instant, DegreesOfFreedom<Frame>>;
+  using Timeline = ChunkedTimeline<DegreesOfFreedom<Frame>>;
 
   // The two iterators denote entries in the containers of the parent.
   // |timeline| is past the end if the fork happened at the fork point of the
-  // grandparent.  Note that this implies that the containers should not be
-  // swapped.
+  // grandparent.  Both iterators remain valid when the parent is appended to.
+  // Note that this implies that the containers should not be swapped.
   struct Fork {
     typename Children::const_iterator children;
     typename Timeline::const_iterator timeline;
@@ -98,13 +102,14 @@ class Trajectory {
       Transform<ToFrame> const& transform) const;
 
   // These functions return the series of positions/velocities/times for the
-  // trajectory of the body.  All three containers are guaranteed to have the
-  // same size.  These functions are O(|depth| + |length|).
-  std::map<Instant, Position<Frame>> Positions() const;
-  std::map<Instant, Velocity<Frame>> Velocities() const;
+  // trajectory of the body, in increasing order of time.  All three containers
+  // are guaranteed to have the same size.  These functions are
+  // O(|depth| + |length|).
+  std::vector<std::pair<Instant, Position<Frame>>> Positions() const;
+  std::vector<std::pair<Instant, Velocity<Frame>>> Velocities() const;
   std::list<Instant> Times() const;
 
-  // Appends one point to the trajectory.
+  // Appends one point to the trajectory.  Amortized O(1).
   void Append(Instant const& time,
               DegreesOfFreedom<Frame> const& degrees_of_freedom);
 
@@ -118,6 +123,12 @@ class Trajectory {
   // trajectory must be a root.
   void ForgetBefore(Instant const& time);
 
+  // Moves the oldest data, all strictly before |time|, to a read-only
+  // memory-mapped temporary file in |directory|, so that it no longer uses
+  // memory.  The data remains accessible, including through the forks.  See
+  // |ChunkedTimeline::Archive|.  This trajectory must be a root.
+  void ArchiveBefore(Instant const& time, std::string const& directory);
+
   // Creates a new child trajectory forked at time |time|, and returns it.  The
   // child trajectory shares its data with the current trajectory for times less
   // than or equal to |time|, and is an exact copy of the current trajectory for
@@ -183,9 +194,25 @@ class Trajectory {
       Instant const& time) const;
 
   // This trajectory must be a root.  The intrinsic acceleration is not
-  // serialized.  The body is not owned, and therefore is not serialized.
+  // serialized.  The body is not owned, and therefore is not serialized.  The
+  // points are written in |columns|; |ReadFromMessage| also reads the
+  // |timeline| of old messages.
   void WriteToMessage(not_null<serialization::Trajectory*> const message) const;
 
+  // Same as |WriteToMessage|, but only writes the points from the last one at
+  // or before |since| (or from the first one if there is none).  If this
+  // trajectory was saved at |since|, these are the points appended since then
+  // preceded by a point that was saved.  The forks must not be before the
+  // first point written.
+  void WriteTailToMessage(
+      Instant const& since,
+      not_null<serialization::Trajectory*> const message) const;
+
+  // Merges into this trajectory a |message| written by |WriteTailToMessage|:
+  // the points at or after the first point of |message|, and all the forks,
+  // are replaced by those of |message|.  This trajectory must be a root.
+  void MergeTailFromMessage(serialization::Trajectory const& message);
+
   // NOTE(egg): This should return a |not_null|, but we can't do that until
   // |not_null<std::unique_ptr<T>>| is convertible to |std::unique_ptr<T>|, and
   // that requires a VS 2015 feature (rvalue references for |*this|).
@@ -210,8 +237,6 @@ class Trajectory {
     Instant const& time() const;
 
    protected:
-    using Timeline = std::map<Instant, DegreesOfFreedom<Frame>>;
-
     Iterator() = default;
     // No transfer of ownership.
     void InitializeFirst(not_null<Trajectory const*> const trajectory);
@@ -263,8 +288,10 @@ class Trajectory {
   // Returns the fork time of this trajectory, which must not be a root.
   Instant const& ForkTime() const;
 
-  // This trajectory need not be a root.
+  // This trajectory need not be a root.  The points of this trajectory (but
+  // not those of its forks) before |begin| are not written.
   void WriteSubTreeToMessage(
+      typename Timeline::const_iterator const begin,
       not_null<serialization::Trajectory*> const message) const;
 
   void FillSubTreeFromMessage(serialization::Trajectory const& message);
@@ -3,20 +3,189 @@
 #include "trajectory.hpp"
 
 #include <algorithm>
+#include <cstdint>
+#include <cstring>
 #include <list>
 #include <map>
+#include <utility>
+#include <vector>
 
 #include "geometry/named_quantities.hpp"
 #include "glog/logging.h"
 #include "physics/oblate_body.hpp"
+#include "quantities/quantities.hpp"
 
 namespace principia {
 
 using base::make_not_null_unique;
+using geometry::Displacement;
 using geometry::Instant;
+using geometry::Position;
+using geometry::R3Element;
+using quantities::SIUnit;
+using quantities::Time;
 
 namespace physics {
 
+namespace {
+
+using Column = google::protobuf::RepeatedField<google::protobuf::int64>;
+
+// Appends successive doubles to a column of |serialization::Trajectory::
+// Columns|.
+class ColumnEncoder {
+ public:
+  explicit ColumnEncoder(not_null<Column*> const column);
+
+  void Append(double const value);
+
+ private:
+  not_null<Column*> const column_;
+  std::uint64_t last_bits_ = 0;
+  std::uint64_t last_difference_ = 0;
+};
+
+// Reads successive doubles from a column of |serialization::Trajectory::
+// Columns|.
+class ColumnDecoder {
+ public:
+  explicit ColumnDecoder(Column const& column);
+
+  // The column must not be exhausted.
+  double Next();
+
+ private:
+  Column const& column_;
+  int index_ = 0;
+  std::uint64_t last_bits_ = 0;
+  std::uint64_t last_difference_ = 0;
+};
+
+// Reads the points of a |serialization::Trajectory|, from its |columns| or,
+// for old messages, from its |timeline|.
+template<typename Frame>
+class TimelineReader {
+ public:
+  explicit TimelineReader(serialization::Trajectory const& message);
+
+  bool at_end() const;
+  // |at_end()| must be false.
+  Instant const& time() const;
+  DegreesOfFreedom<Frame> degrees_of_freedom() const;
+  void Next();
+
+ private:
+  // Reads the point at |index_| into |time_|, |position_| and |velocity_|.
+  void Read();
+
+  serialization::Trajectory const& message_;
+  int const size_;
+  int index_ = 0;
+  ColumnDecoder time_decoder_;
+  ColumnDecoder position_x_decoder_;
+  ColumnDecoder position_y_decoder_;
+  ColumnDecoder position_z_decoder_;
+  ColumnDecoder velocity_x_decoder_;
+  ColumnDecoder velocity_y_decoder_;
+  ColumnDecoder velocity_z_decoder_;
+  Instant time_;
+  Position<Frame> position_;
+  Velocity<Frame> velocity_;
+};
+
+ColumnEncoder::ColumnEncoder(not_null<Column*> const column)
+    : column_(column) {}
+
+void ColumnEncoder::Append(double const value) {
+  std::uint64_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  std::uint64_t const difference = bits - last_bits_;
+  column_->Add(static_cast<std::int64_t>(difference - last_difference_));
+  last_bits_ = bits;
+  last_difference_ = difference;
+}
+
+ColumnDecoder::ColumnDecoder(Column const& column) : column_(column) {}
+
+double ColumnDecoder::Next() {
+  CHECK_LT(index_, column_.size()) << "Column too short";
+  last_difference_ += static_cast<std::uint64_t>(column_.Get(index_));
+  last_bits_ += last_difference_;
+  ++index_;
+  double value;
+  std::memcpy(&value, &last_bits_, sizeof(value));
+  return value;
+}
+
+template<typename Frame>
+TimelineReader<Frame>::TimelineReader(
+    serialization::Trajectory const& message)
+    : message_(message),
+      size_(message.has_columns() ? message.columns().time_size()
+                                  : message.timeline_size()),
+      time_decoder_(message.columns().time()),
+      position_x_decoder_(message.columns().position_x()),
+      position_y_decoder_(message.columns().position_y()),
+      position_z_decoder_(message.columns().position_z()),
+      velocity_x_decoder_(message.columns().velocity_x()),
+      velocity_y_decoder_(message.columns().velocity_y()),
+      velocity_z_decoder_(message.columns().velocity_z()) {
+  if (message.has_columns()) {
+    CHECK_EQ(0, message.timeline_size());
+    Frame::ReadFromMessage(message.columns().frame());
+  }
+  if (!at_end()) {
+    Read();
+  }
+}
+
+template<typename Frame>
+bool TimelineReader<Frame>::at_end() const {
+  return index_ == size_;
+}
+
+template<typename Frame>
+Instant const& TimelineReader<Frame>::time() const {
+  return time_;
+}
+
+template<typename Frame>
+DegreesOfFreedom<Frame> TimelineReader<Frame>::degrees_of_freedom() const {
+  return DegreesOfFreedom<Frame>(position_, velocity_);
+}
+
+template<typename Frame>
+void TimelineReader<Frame>::Next() {
+  ++index_;
+  if (!at_end()) {
+    Read();
+  }
+}
+
+template<typename Frame>
+void TimelineReader<Frame>::Read() {
+  if (message_.has_columns()) {
+    time_ = Instant(time_decoder_.Next() * SIUnit<Time>());
+    position_ = Frame::origin + Displacement<Frame>(
+        R3Element<Length>(position_x_decoder_.Next() * SIUnit<Length>(),
+                          position_y_decoder_.Next() * SIUnit<Length>(),
+                          position_z_decoder_.Next() * SIUnit<Length>()));
+    velocity_ = Velocity<Frame>(
+        R3Element<Speed>(velocity_x_decoder_.Next() * SIUnit<Speed>(),
+                         velocity_y_decoder_.Next() * SIUnit<Speed>(),
+                         velocity_z_decoder_.Next() * SIUnit<Speed>()));
+  } else {
+    auto const& point = message_.timeline(index_);
+    time_ = Instant::ReadFromMessage(point.instant());
+    DegreesOfFreedom<Frame> const degrees_of_freedom =
+        DegreesOfFreedom<Frame>::ReadFromMessage(point.degrees_of_freedom());
+    position_ = degrees_of_freedom.position();
+    velocity_ = degrees_of_freedom.velocity();
+  }
+}
+
+}  // namespace
+
 template<typename Frame>
 Trajectory<Frame>::Trajectory(not_null<Body const*> const body)
     : body_(body),
@@ -79,21 +248,21 @@ Trajectory<Frame>::last_with_transform(
 }
 
 template<typename Frame>
-std::map<Instant, Position<Frame>> Trajectory<Frame>::Positions() const {
-  std::map<Instant, Position<Frame>> result;
+std::vector<std::pair<Instant, Position<Frame>>>
+Trajectory<Frame>::Positions() const {
+  std::vector<std::pair<Instant, Position<Frame>>> result;
   for (NativeIterator it = first(); !it.at_end(); ++it) {
-    Instant const& time = it.time();
-    result.emplace_hint(result.end(), time, it.degrees_of_freedom().position());
+    result.emplace_back(it.time(), it.degrees_of_freedom().position());
   }
   return result;
 }
 
 template<typename Frame>
-std::map<Instant, Velocity<Frame>> Trajectory<Frame>::Velocities() const {
-  std::map<Instant, Velocity<Frame>> result;
+std::vector<std::pair<Instant, Velocity<Frame>>>
+Trajectory<Frame>::Velocities() const {
+  std::vector<std::pair<Instant, Velocity<Frame>>> result;
   for (NativeIterator it = first(); !it.at_end(); ++it) {
-    Instant const& time = it.time();
-    result.emplace_hint(result.end(), time, it.degrees_of_freedom().velocity());
+    result.emplace_back(it.time(), it.degrees_of_freedom().velocity());
   }
   return result;
 }
@@ -111,11 +280,7 @@ template<typename Frame>
 void Trajectory<Frame>::Append(
     Instant const& time,
     DegreesOfFreedom<Frame> const& degrees_of_freedom) {
-  auto inserted = timeline_.emplace(time, degrees_of_freedom);
-  CHECK(timeline_.end() == ++inserted.first) << "Append out of order";
-  CHECK(inserted.second) << "Append at existing time " << time
-                         << ", time range = [" << Times().front() << ", "
-                         << Times().back() << "]";
+  timeline_.Append(time, degrees_of_freedom);
 }
 
 template<typename Frame>
@@ -152,6 +317,13 @@ void Trajectory<Frame>::ForgetBefore(Instant const& time) {
   }
 }
 
+template<typename Frame>
+void Trajectory<Frame>::ArchiveBefore(Instant const& time,
+                                      std::string const& directory) {
+  CHECK(is_root()) << "ArchiveBefore on a nonroot trajectory";
+  timeline_.Archive(time, directory);
+}
+
 template<typename Frame>
 not_null<Trajectory<Frame>*> Trajectory<Frame>::NewFork(Instant const& time) {
   CHECK(timeline_.find(time) != timeline_.end() ||
@@ -169,7 +341,9 @@ not_null<Trajectory<Frame>*> Trajectory<Frame>::NewFork(Instant const& time) {
       std::forward_as_tuple(time),
       std::forward_as_tuple(body_, this /*parent*/, fork));
   if (fork_it != timeline_.end()) {
-    child_it->second.timeline_.insert(++fork_it, timeline_.end());
+    for (++fork_it; fork_it != timeline_.end(); ++fork_it) {
+      child_it->second.timeline_.Append(fork_it->first, fork_it->second);
+    }
   }
   child_it->second.fork_->children = child_it;
   return &child_it->second;
@@ -276,7 +450,35 @@ template<typename Frame>
 void Trajectory<Frame>::WriteToMessage(
     not_null<serialization::Trajectory*> const message) const {
   CHECK(is_root());
-  WriteSubTreeToMessage(message);
+  WriteSubTreeToMessage(timeline_.begin(), message);
+}
+
+template<typename Frame>
+void Trajectory<Frame>::WriteTailToMessage(
+    Instant const& since,
+    not_null<serialization::Trajectory*> const message) const {
+  CHECK(is_root());
+  auto begin = timeline_.upper_bound(since);
+  if (begin != timeline_.begin()) {
+    --begin;
+  }
+  if (begin != timeline_.end() && !children_.empty()) {
+    CHECK_LE(begin->first, children_.begin()->first)
+        << "Fork before the tail at " << since;
+  }
+  WriteSubTreeToMessage(begin, message);
+}
+
+template<typename Frame>
+void Trajectory<Frame>::MergeTailFromMessage(
+    serialization::Trajectory const& message) {
+  CHECK(is_root());
+  children_.clear();
+  TimelineReader<Frame> const reader(message);
+  if (!reader.at_end()) {
+    timeline_.erase(timeline_.lower_bound(reader.time()), timeline_.end());
+  }
+  FillSubTreeFromMessage(message);
 }
 
 template<typename Frame>
@@ -472,6 +674,7 @@ Instant const& Trajectory<Frame>::ForkTime() const {
 
 template<typename Frame>
 void Trajectory<Frame>::WriteSubTreeToMessage(
+    typename Timeline::const_iterator const begin,
     not_null<serialization::Trajectory*> const message) const {
   Instant last_instant;
   bool is_first = true;
@@ -485,40 +688,54 @@ void Trajectory<Frame>::WriteSubTreeToMessage(
       litter = message->add_children();
       fork_time.WriteToMessage(litter->mutable_fork_time());
     }
-    child.WriteSubTreeToMessage(litter->add_trajectories());
+    child.WriteSubTreeToMessage(child.timeline_.begin(),
+                                litter->add_trajectories());
+  }
+  if (begin == timeline_.end()) {
+    return;
   }
-  for (auto const& pair : timeline_) {
-    Instant const& instant = pair.first;
-    DegreesOfFreedom<Frame> const& degrees_of_freedom = pair.second;
-    auto const instantaneous_degrees_of_freedom = message->add_timeline();
-    instant.WriteToMessage(instantaneous_degrees_of_freedom->mutable_instant());
-    degrees_of_freedom.WriteToMessage(
-        instantaneous_degrees_of_freedom->mutable_degrees_of_freedom());
+  serialization::Trajectory::Columns* const columns =
+      message->mutable_columns();
+  Frame::WriteToMessage(columns->mutable_frame());
+  ColumnEncoder time_encoder(columns->mutable_time());
+  ColumnEncoder position_x_encoder(columns->mutable_position_x());
+  ColumnEncoder position_y_encoder(columns->mutable_position_y());
+  ColumnEncoder position_z_encoder(columns->mutable_position_z());
+  ColumnEncoder velocity_x_encoder(columns->mutable_velocity_x());
+  ColumnEncoder velocity_y_encoder(columns->mutable_velocity_y());
+  ColumnEncoder velocity_z_encoder(columns->mutable_velocity_z());
+  for (auto it = begin; it != timeline_.end(); ++it) {
+    Instant const& instant = it->first;
+    DegreesOfFreedom<Frame> const& degrees_of_freedom = it->second;
+    R3Element<Length> const position =
+        (degrees_of_freedom.position() - Frame::origin).coordinates();
+    R3Element<Speed> const velocity =
+        degrees_of_freedom.velocity().coordinates();
+    time_encoder.Append((instant - Instant()) / SIUnit<Time>());
+    position_x_encoder.Append(position.x / SIUnit<Length>());
+    position_y_encoder.Append(position.y / SIUnit<Length>());
+    position_z_encoder.Append(position.z / SIUnit<Length>());
+    velocity_x_encoder.Append(velocity.x / SIUnit<Speed>());
+    velocity_y_encoder.Append(velocity.y / SIUnit<Speed>());
+    velocity_z_encoder.Append(velocity.z / SIUnit<Speed>());
   }
 }
 
 template<typename Frame>
 void Trajectory<Frame>::FillSubTreeFromMessage(
     serialization::Trajectory const& message) {
-  auto timeline_it = message.timeline().begin();
+  TimelineReader<Frame> reader(message);
   for (serialization::Trajectory::Litter const& litter : message.children()) {
     Instant const fork_time = Instant::ReadFromMessage(litter.fork_time());
-    for (;
-         timeline_it != message.timeline().end() &&
-         Instant::ReadFromMessage(timeline_it->instant()) <= fork_time;
-         ++timeline_it) {
-      Append(Instant::ReadFromMessage(timeline_it->instant()),
-             DegreesOfFreedom<Frame>::ReadFromMessage(
-                 timeline_it->degrees_of_freedom()));
+    for (; !reader.at_end() && reader.time() <= fork_time; reader.Next()) {
+      Append(reader.time(), reader.degrees_of_freedom());
     }
     for (serialization::Trajectory const& child : litter.trajectories()) {
       NewFork(fork_time)->FillSubTreeFromMessage(child);
     }
   }
-  for (; timeline_it != message.timeline().end(); ++timeline_it) {
-    Append(Instant::ReadFromMessage(timeline_it->instant()),
-           DegreesOfFreedom<Frame>::ReadFromMessage(
-               timeline_it->degrees_of_freedom()));
+  for (; !reader.at_end(); reader.Next()) {
+    Append(reader.time(), reader.degrees_of_freedom());
   }
 }
 
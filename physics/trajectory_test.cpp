@@ -2,8 +2,9 @@
 
 #include <functional>
 #include <list>
-#include <map>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "body.hpp"
 #include "geometry/frame.hpp"
@@ -148,9 +149,9 @@ TEST_F(TrajectoryTest, AppendSuccess) {
   massive_trajectory_->Append(t1_, d1_);
   massive_trajectory_->Append(t2_, d2_);
   massive_trajectory_->Append(t3_, d3_);
-  std::map<Instant, Position<World>> const positions =
+  std::vector<std::pair<Instant, Position<World>>> const positions =
       massive_trajectory_->Positions();
-  std::map<Instant, Velocity<World>> const velocities =
+  std::vector<std::pair<Instant, Velocity<World>>> const velocities =
       massive_trajectory_->Velocities();
   std::list<Instant> const times = massive_trajectory_->Times();
   EXPECT_THAT(positions, ElementsAre(testing::Pair(t1_, q1_),
@@ -177,9 +178,9 @@ TEST_F(TrajectoryTest, ForkSuccess) {
   massive_trajectory_->Append(t3_, d3_);
   not_null<Trajectory<World>*> const fork = massive_trajectory_->NewFork(t2_);
   fork->Append(t4_, d4_);
-  std::map<Instant, Position<World>> positions =
+  std::vector<std::pair<Instant, Position<World>>> positions =
       massive_trajectory_->Positions();
-  std::map<Instant, Velocity<World>> velocities =
+  std::vector<std::pair<Instant, Velocity<World>>> velocities =
       massive_trajectory_->Velocities();
   std::list<Instant> times = massive_trajectory_->Times();
   EXPECT_THAT(positions, ElementsAre(testing::Pair(t1_, q1_),
@@ -217,8 +218,10 @@ TEST_F(TrajectoryTest, ForkAtLast) {
   EXPECT_EQ(t3_, massive_trajectory_->last().time());
   EXPECT_EQ(t3_, fork1->last().time());
 
-  std::map<Instant, Position<World>> positions = fork2->Positions();
-  std::map<Instant, Velocity<World>> velocities = fork2->Velocities();
+  std::vector<std::pair<Instant, Position<World>>> positions =
+      fork2->Positions();
+  std::vector<std::pair<Instant, Velocity<World>>> velocities =
+      fork2->Velocities();
   std::list<Instant> times = fork2->Times();
   EXPECT_THAT(positions, ElementsAre(testing::Pair(t1_, q1_),
                                      testing::Pair(t2_, q2_),
@@ -421,55 +424,87 @@ TEST_F(TrajectoryTest, TrajectorySerializationSuccess) {
   deserialized_trajectory->WriteToMessage(&message);
   EXPECT_EQ(reference_message.SerializeAsString(), message.SerializeAsString());
   EXPECT_THAT(message.children_size(), Eq(2));
-  EXPECT_THAT(message.timeline_size(), Eq(3));
-  EXPECT_THAT(Instant::ReadFromMessage(message.timeline(0).instant()), Eq(t1_));
-  EXPECT_THAT(Instant::ReadFromMessage(message.timeline(1).instant()), Eq(t2_));
-  EXPECT_THAT(Instant::ReadFromMessage(message.timeline(2).instant()), Eq(t3_));
-  EXPECT_THAT(
-      DegreesOfFreedom<World>::ReadFromMessage(
-          message.timeline(0).degrees_of_freedom()), Eq(d1_));
-  EXPECT_THAT(
-        DegreesOfFreedom<World>::ReadFromMessage(
-            message.timeline(1).degrees_of_freedom()), Eq(d2_));
-  EXPECT_THAT(
-        DegreesOfFreedom<World>::ReadFromMessage(
-            message.timeline(2).degrees_of_freedom()), Eq(d3_));
+  EXPECT_THAT(message.timeline_size(), Eq(0));
+  EXPECT_THAT(message.columns().time_size(), Eq(3));
+  EXPECT_THAT(message.columns().velocity_z_size(), Eq(3));
   EXPECT_THAT(message.children(0).trajectories_size(), Eq(2));
   EXPECT_THAT(message.children(0).trajectories(0).children_size(), Eq(0));
-  EXPECT_THAT(message.children(0).trajectories(0).timeline_size(), Eq(1));
-  EXPECT_THAT(
-      Instant::ReadFromMessage(
-          message.children(0).trajectories(0).timeline(0).instant()), Eq(t3_));
-  EXPECT_THAT(
-      DegreesOfFreedom<World>::ReadFromMessage(
-          message.children(0).trajectories(0).timeline(0).degrees_of_freedom()),
-      Eq(d3_));
+  EXPECT_THAT(message.children(0).trajectories(0).columns().time_size(), Eq(1));
   EXPECT_THAT(message.children(0).trajectories(1).children_size(), Eq(0));
-  EXPECT_THAT(message.children(0).trajectories(1).timeline_size(), Eq(2));
-  EXPECT_THAT(
-      Instant::ReadFromMessage(
-          message.children(0).trajectories(1).timeline(0).instant()), Eq(t3_));
-  EXPECT_THAT(
-      DegreesOfFreedom<World>::ReadFromMessage(
-          message.children(0).trajectories(1).timeline(0).degrees_of_freedom()),
-      Eq(d3_));
-  EXPECT_THAT(
-      Instant::ReadFromMessage(
-          message.children(0).trajectories(1).timeline(1).instant()), Eq(t4_));
-  EXPECT_THAT(
-      DegreesOfFreedom<World>::ReadFromMessage(
-          message.children(0).trajectories(1).timeline(1).degrees_of_freedom()),
-      Eq(d4_));
+  EXPECT_THAT(message.children(0).trajectories(1).columns().time_size(), Eq(2));
   EXPECT_THAT(message.children(1).trajectories_size(), Eq(1));
   EXPECT_THAT(message.children(1).trajectories(0).children_size(), Eq(0));
-  EXPECT_THAT(message.children(1).trajectories(0).timeline_size(), Eq(1));
-  EXPECT_THAT(
-      Instant::ReadFromMessage(
-          message.children(1).trajectories(0).timeline(0).instant()), Eq(t4_));
-  EXPECT_THAT(
-      DegreesOfFreedom<World>::ReadFromMessage(
-          message.children(1).trajectories(0).timeline(0).degrees_of_freedom()),
-      Eq(d4_));
+  EXPECT_THAT(message.children(1).trajectories(0).columns().time_size(), Eq(1));
+  std::vector<Instant> times;
+  std::vector<DegreesOfFreedom<World>> degrees_of_freedom;
+  for (auto it = deserialized_trajectory->first(); !it.at_end(); ++it) {
+    times.push_back(it.time());
+    degrees_of_freedom.push_back(it.degrees_of_freedom());
+  }
+  EXPECT_THAT(times, ElementsAre(t1_, t2_, t3_));
+  EXPECT_THAT(degrees_of_freedom, ElementsAre(d1_, d2_, d3_));
+}
+
+// A tail written after some points have been appended extends an earlier
+// message of the same trajectory.
+TEST_F(TrajectoryTest, TrajectoryTailSerialization) {
+  massive_trajectory_->Append(t1_, d1_);
+  massive_trajectory_->Append(t2_, d2_);
+  serialization::Trajectory message;
+  massive_trajectory_->WriteToMessage(&message);
+
+  massive_trajectory_->Append(t3_, d3_);
+  not_null<Trajectory<World>*> const fork = massive_trajectory_->NewFork(t3_);
+  fork->Append(t4_, d4_);
+  serialization::Trajectory tail;
+  massive_trajectory_->WriteTailToMessage(t2_ + (t3_ - t2_) / 2, &tail);
+  EXPECT_THAT(tail.columns().time_size(), Eq(2));
+  EXPECT_THAT(tail.children_size(), Eq(1));
+
+  not_null<std::unique_ptr<Trajectory<World>>> const merged_trajectory =
+      Trajectory<World>::ReadFromMessage(message, &massive_body_);
+  merged_trajectory->MergeTailFromMessage(tail);
+  serialization::Trajectory merged_message;
+  merged_trajectory->WriteToMessage(&merged_message);
+  serialization::Trajectory reference_message;
+  massive_trajectory_->WriteToMessage(&reference_message);
+  EXPECT_EQ(reference_message.SerializeAsString(),
+            merged_message.SerializeAsString());
+}
+
+// Old messages have the points in |timeline|, not in |columns|.
+TEST_F(TrajectoryTest, TrajectorySerializationCompatibility) {
+  auto const add_point = [](
+      Instant const& time,
+      DegreesOfFreedom<World> const& degrees_of_freedom,
+      not_null<serialization::Trajectory*> const message) {
+    auto* const point = message->add_timeline();
+    time.WriteToMessage(point->mutable_instant());
+    degrees_of_freedom.WriteToMessage(point->mutable_degrees_of_freedom());
+  };
+  serialization::Trajectory old_message;
+  add_point(t1_, d1_, &old_message);
+  add_point(t2_, d2_, &old_message);
+  add_point(t3_, d3_, &old_message);
+  auto* const litter = old_message.add_children();
+  t2_.WriteToMessage(litter->mutable_fork_time());
+  // The fork has a copy of the points of its parent after the fork time.
+  auto* const child = litter->add_trajectories();
+  add_point(t3_, d3_, child);
+  add_point(t4_, d4_, child);
+
+  massive_trajectory_->Append(t1_, d1_);
+  massive_trajectory_->Append(t2_, d2_);
+  massive_trajectory_->Append(t3_, d3_);
+  massive_trajectory_->NewFork(t2_)->Append(t4_, d4_);
+  serialization::Trajectory reference_message;
+  massive_trajectory_->WriteToMessage(&reference_message);
+
+  not_null<std::unique_ptr<Trajectory<World>>> const deserialized_trajectory =
+      Trajectory<World>::ReadFromMessage(old_message, &massive_body_);
+  serialization::Trajectory message;
+  deserialized_trajectory->WriteToMessage(&message);
+  EXPECT_EQ(reference_message.SerializeAsString(), message.SerializeAsString());
 }
 
 TEST_F(TrajectoryDeathTest, DeleteForkError) {
@@ -496,9 +531,9 @@ TEST_F(TrajectoryTest, DeleteForkSuccess) {
   fork1->Append(t4_, d4_);
   massive_trajectory_->DeleteFork(&fork2);
   EXPECT_EQ(nullptr, fork2);
-  std::map<Instant, Position<World>> positions =
+  std::vector<std::pair<Instant, Position<World>>> positions =
       massive_trajectory_->Positions();
-  std::map<Instant, Velocity<World>> velocities =
+  std::vector<std::pair<Instant, Velocity<World>>> velocities =
       massive_trajectory_->Velocities();
   std::list<Instant> times = massive_trajectory_->Times();
   EXPECT_THAT(positions, ElementsAre(testing::Pair(t1_, q1_),
@@ -570,8 +605,10 @@ TEST_F(TrajectoryTest, ForgetAfterSuccess) {
   fork->Append(t4_, d4_);
 
   fork->ForgetAfter(t3_ + (t4_ - t3_) / 2);
-  std::map<Instant, Position<World>> positions = fork->Positions();
-  std::map<Instant, Velocity<World>> velocities = fork->Velocities();
+  std::vector<std::pair<Instant, Position<World>>> positions =
+      fork->Positions();
+  std::vector<std::pair<Instant, Velocity<World>>> velocities =
+      fork->Velocities();
   std::list<Instant> times = fork->Times();
   EXPECT_THAT(positions, ElementsAre(testing::Pair(t1_, q1_),
                                      testing::Pair(t2_, q2_),
@@ -615,6 +652,29 @@ TEST_F(TrajectoryTest, ForgetAfterSuccess) {
   // Don't use fork, it is dangling.
 }
 
+// The archived points are read transparently by the trajectory and its forks.
+TEST_F(TrajectoryTest, ArchiveBefore) {
+  int const size = 1500;
+  for (int i = 0; i < size; ++i) {
+    massive_trajectory_->Append(t0_ + i * Second, i % 2 == 0 ? d1_ : d2_);
+  }
+  not_null<Trajectory<World>*> const fork =
+      massive_trajectory_->NewFork(t0_ + 1200 * Second);
+  fork->Append(t0_ + size * Second, d3_);
+  massive_trajectory_->ArchiveBefore(t0_ + 1100 * Second, ".");
+
+  EXPECT_EQ(size + 1, static_cast<int>(fork->Times().size()));
+  int i = 0;
+  for (auto it = fork->first(); !it.at_end(); ++it, ++i) {
+    EXPECT_EQ(t0_ + i * Second, it.time());
+    EXPECT_EQ(i == size ? d3_ : i % 2 == 0 ? d1_ : d2_,
+              it.degrees_of_freedom());
+  }
+  massive_trajectory_->ForgetAfter(t0_ + 600 * Second);
+  EXPECT_EQ(601, static_cast<int>(massive_trajectory_->Times().size()));
+  EXPECT_EQ(t0_ + 600 * Second, massive_trajectory_->last().time());
+}
+
 TEST_F(TrajectoryDeathTest, ForgetBeforeError) {
   EXPECT_DEATH({
     massive_trajectory_->Append(t1_, d1_);
@@ -631,9 +691,9 @@ TEST_F(TrajectoryTest, ForgetBeforeSuccess) {
   fork->Append(t4_, d4_);
 
   massive_trajectory_->ForgetBefore(t1_ + (t2_ - t1_) / 2);
-  std::map<Instant, Position<World>> positions =
+  std::vector<std::pair<Instant, Position<World>>> positions =
       massive_trajectory_->Positions();
-  std::map<Instant, Velocity<World>> velocities =
+  std::vector<std::pair<Instant, Velocity<World>>> velocities =
       massive_trajectory_->Velocities();
   std::list<Instant> times = massive_trajectory_->Times();
   EXPECT_THAT(positions, ElementsAre(testing::Pair(t2_, q2_),
@@ -7,12 +7,20 @@
 #include <vector>
 
 #include "base/not_null.hpp"
+#include "geometry/affine_map.hpp"
+#include "geometry/named_quantities.hpp"
+#include "geometry/orthogonal_map.hpp"
 #include "physics/frame_field.hpp"
 #include "physics/trajectory.hpp"
+#include "quantities/quantities.hpp"
 
 namespace principia {
 
 using base::not_null;
+using geometry::AffineMap;
+using geometry::OrthogonalMap;
+using geometry::Position;
+using quantities::Length;
 
 namespace physics {
 
@@ -61,9 +69,24 @@ class Transforms {
   static not_null<std::unique_ptr<Transforms>> DummyForTesting();
 
   // Indicates that the given |trajectory| is cacheable (for all |Mobile|
-  // objects).  By default, lazy trajectories are not cacheable.
+  // objects), i.e., that it only changes by having points appended at its end
+  // or forgotten at its beginning.  By default, lazy trajectories are not
+  // cacheable.
   void set_cacheable(LazyTrajectory<FromFrame> const& trajectory);
 
+  // A function that returns the degrees of freedom of a reference |Mobile| at
+  // any time in the span of the trajectories that are transformed.
+  using Evaluator = std::function<DegreesOfFreedom<FromFrame>(
+                        Mobile const&, Instant const&)>;
+
+  // Indicates that, when transforming the given |trajectory|, the degrees of
+  // freedom of the reference |Mobile| objects are obtained from |evaluator|
+  // rather than from their own |trajectory|, which then need not have a point
+  // at each time of the transformed trajectories.  By default, the reference
+  // trajectories must have such points.
+  void set_evaluator(LazyTrajectory<FromFrame> const& trajectory,
+                     Evaluator const& evaluator);
+
   typename Trajectory<FromFrame>::template TransformingIterator<ThroughFrame>
   first(Mobile const& mobile,
         LazyTrajectory<FromFrame> const& from_trajectory);
@@ -76,6 +99,23 @@ class Transforms {
   typename Trajectory<ThroughFrame>:: template TransformingIterator<ToFrame>
   second(Trajectory<ThroughFrame> const& through_trajectory);
 
+  // Returns the positions of the points of |from_trajectory| at or after
+  // |time| transformed by |first|, in increasing order of time.  If
+  // |from_trajectory| is cacheable, the positions are kept from one call to
+  // the next for the same trajectory, and only the points that were appended
+  // to it in the meantime are transformed.  The result is invalidated by the
+  // next call.
+  std::vector<Position<ThroughFrame>> const& first_positions_on_or_after(
+      Mobile const& mobile,
+      LazyTrajectory<FromFrame> const& from_trajectory,
+      Instant const& time);
+
+  // The map applied by |second| to the positions.  Since the trajectory in
+  // |ToFrame| is computed using the current position of the reference, this
+  // map is the same for all the points of a trajectory.
+  AffineMap<ThroughFrame, ToFrame, Length, OrthogonalMap>
+  second_position_map() const;
+
   // The coordinate frame of |ThroughFrame|, expressed in the coordinates of
   // |ToFrame| at the current time.
   FrameField<ToFrame> coordinate_frame() const;
@@ -90,37 +130,42 @@ class Transforms {
                             DegreesOfFreedom<Frame1> const&,
                             not_null<Trajectory<Frame1> const*> const)>;
 
+  // The degrees of freedom at |t| of the |reference| used by |first_| to
+  // transform |from_trajectory|.
+  DegreesOfFreedom<FromFrame> ReferenceDegreesOfFreedom(
+      Mobile const& reference,
+      LazyTrajectory<FromFrame> const& from_trajectory,
+      Instant const& t) const;
+
   LazyTransform<FromFrame, ThroughFrame> first_;
-  typename Trajectory<ThroughFrame>::template Transform<ToFrame> second_;
 
-  // A simple cache with no eviction, which monitors the hit rate.
-  template<typename Frame1, typename Frame2>
-  class Cache {
-   public:
-    bool Lookup(not_null<Trajectory<Frame1> const*> const trajectory,
-                Instant const& time,
-                not_null<DegreesOfFreedom<Frame2>**> degrees_of_freedom);
-
-    void Insert(not_null<Trajectory<Frame1> const*> const trajectory,
-                Instant const& time,
-                DegreesOfFreedom<Frame2> const& degrees_of_freedom);
-
-   private:
-    std::map<std::pair<not_null<Trajectory<Frame1> const*>, Instant const>,
-             DegreesOfFreedom<Frame2>> map_;
-    std::map<not_null<Trajectory<Frame1> const*>, std::int64_t>
-        number_of_lookups_;
-    std::map<not_null<Trajectory<Frame1> const*>, std::int64_t> number_of_hits_;
+  // The map from which |second| transforms the positions and the velocities.
+  std::function<AffineMap<ThroughFrame, ToFrame, Length, OrthogonalMap>()>
+      second_position_map_;
+
+  // The positions transformed by |first_| for a cacheable trajectory, and
+  // enough information to detect where the trajectory has changed since they
+  // were computed.
+  struct CachedPositions {
+    std::vector<Instant> times;
+    std::vector<Position<ThroughFrame>> positions;
+    // The position of the last point in |FromFrame|, to detect that the
+    // trajectory was replaced rather than extended.
+    Position<FromFrame> last_from_position;
   };
 
   // Using a vector, not a set, because (1) this is small and (2) writing a
   // comparator or a hasher for |LazyTrajectory| is complicated.
   std::vector<LazyTrajectory<FromFrame>> cacheable_;
-
-  // A cache for the result of the |first_| transform.  This cache assumes that
-  // the iterator is never called with the same time but different degrees of
-  // freedom.
-  Cache<FromFrame, ThroughFrame> first_cache_;
+  std::vector<std::pair<LazyTrajectory<FromFrame>, Evaluator>> evaluators_;
+
+  // A cache with no eviction for the results of
+  // |first_positions_on_or_after|.
+  std::map<not_null<Trajectory<FromFrame> const*>, CachedPositions>
+      first_positions_cache_;
+  // The result of |first_positions_on_or_after| for the trajectories that are
+  // not cacheable.
+  std::vector<Position<ThroughFrame>> uncached_first_positions_;
 
   FrameField<ToFrame> coordinate_frame_;
 };
@@ -114,9 +114,8 @@ Transforms<Mobile, FromFrame, ThroughFrame, ToFrame>::BodyCentredNonRotating(
 
   transforms->coordinate_frame_ = CoordinateFrame<ToFrame>();
 
-  // From the perspective of the lambda the following variable is really |this|,
-  // hence the name.
-  not_null<Transforms*> that = transforms.get();
+  // The pointer remains valid when the |unique_ptr| is moved.
+  not_null<Transforms const*> const that = transforms.get();
   transforms->first_ =
       [&centre, that](
           LazyTrajectory<FromFrame> const& from_trajectory,
@@ -124,26 +123,8 @@ Transforms<Mobile, FromFrame, ThroughFrame, ToFrame>::BodyCentredNonRotating(
           DegreesOfFreedom<FromFrame> const& from_degrees_of_freedom,
           not_null<Trajectory<FromFrame> const*> const trajectory) ->
       DegreesOfFreedom<ThroughFrame> {
-    // First check if the result is cached.
-    bool const cacheable =
-        std::find(that->cacheable_.begin(),
-                  that->cacheable_.end(),
-                  from_trajectory) !=  that->cacheable_.end();
-    DegreesOfFreedom<ThroughFrame>* cached_through_degrees_of_freedom = nullptr;
-    if (cacheable &&
-        that->first_cache_.Lookup(trajectory, t,
-                                  &cached_through_degrees_of_freedom)) {
-      return *cached_through_degrees_of_freedom;
-    }
-
-    // on_or_after() is Ln(N), but it doesn't matter unless the map gets very
-    // big, in which case we'll have cache misses anyway.
-    TYPENAME Trajectory<FromFrame>::NativeIterator const centre_it =
-        (centre.*from_trajectory)().on_or_after(t);
-    CHECK_EQ(centre_it.time(), t)
-        << "Time " << t << " not in centre trajectory";
-    DegreesOfFreedom<FromFrame> const& centre_degrees_of_freedom =
-        centre_it.degrees_of_freedom();
+    DegreesOfFreedom<FromFrame> const centre_degrees_of_freedom =
+        that->ReferenceDegreesOfFreedom(centre, from_trajectory, t);
 
     AffineMap<FromFrame, ThroughFrame, Length, Identity> const position_map(
         centre_degrees_of_freedom.position(),
@@ -151,34 +132,18 @@ Transforms<Mobile, FromFrame, ThroughFrame, ToFrame>::BodyCentredNonRotating(
         Identity<FromFrame, ThroughFrame>());
     // TODO(phl): Should |velocity_map| be an affine map?
     Identity<FromFrame, ThroughFrame> const velocity_map;
-    DegreesOfFreedom<ThroughFrame> through_degrees_of_freedom =
-        {position_map(from_degrees_of_freedom.position()),
-         velocity_map(from_degrees_of_freedom.velocity() -
-                      centre_degrees_of_freedom.velocity())};
-
-    // Cache the result before returning it.
-    if (cacheable) {
-      that->first_cache_.Insert(trajectory, t, through_degrees_of_freedom);
-    }
-    return through_degrees_of_freedom;
+    return {position_map(from_degrees_of_freedom.position()),
+            velocity_map(from_degrees_of_freedom.velocity() -
+                         centre_degrees_of_freedom.velocity())};
   };
 
-  transforms->second_ =
-      [&centre, to_trajectory](
-          Instant const& t,
-          DegreesOfFreedom<ThroughFrame> const& through_degrees_of_freedom,
-          Trajectory<ThroughFrame> const* trajectory) ->
-      DegreesOfFreedom<ToFrame> {
+  transforms->second_position_map_ = [&centre, to_trajectory]() {
     DegreesOfFreedom<ToFrame> const& last_centre_degrees_of_freedom =
         (centre.*to_trajectory)().last().degrees_of_freedom();
-
-    AffineMap<ThroughFrame, ToFrame, Length, Identity> const position_map(
+    return AffineMap<ThroughFrame, ToFrame, Length, OrthogonalMap>(
         ThroughFrame::origin,
         last_centre_degrees_of_freedom.position(),
-        Identity<ThroughFrame, ToFrame>());
-    Identity<ThroughFrame, ToFrame> const velocity_map;
-    return {position_map(through_degrees_of_freedom.position()),
-            velocity_map(through_degrees_of_freedom.velocity())};
+        Identity<ThroughFrame, ToFrame>().Forget());
   };
 
   return transforms;
@@ -211,9 +176,7 @@ Transforms<Mobile, FromFrame, ThroughFrame, ToFrame>::BarycentricRotating(
                Rotation<ToFrame, ThroughFrame>::Identity();
   };
 
-  // From the perspective of the lambda the following variable is really |this|,
-  // hence the name.
-  not_null<Transforms*> that = transforms.get();
+  not_null<Transforms const*> const that = transforms.get();
   transforms->first_ =
       [&primary, &secondary, that](
           LazyTrajectory<FromFrame> const& from_trajectory,
@@ -221,32 +184,10 @@ Transforms<Mobile, FromFrame, ThroughFrame, ToFrame>::BarycentricRotating(
           DegreesOfFreedom<FromFrame> const& from_degrees_of_freedom,
           not_null<Trajectory<FromFrame> const*> const trajectory) ->
       DegreesOfFreedom<ThroughFrame> {
-    // First check if the result is cached.
-    bool const cacheable =
-        std::find(that->cacheable_.begin(),
-                  that->cacheable_.end(),
-                  from_trajectory) !=  that->cacheable_.end();
-    DegreesOfFreedom<ThroughFrame>* cached_through_degrees_of_freedom = nullptr;
-    if (cacheable &&
-        that->first_cache_.Lookup(trajectory, t,
-                                  &cached_through_degrees_of_freedom)) {
-      return *cached_through_degrees_of_freedom;
-    }
-
-    // |on_or_after()| is Ln(N).
-    TYPENAME Trajectory<FromFrame>::NativeIterator const primary_it =
-        (primary.*from_trajectory)().on_or_after(t);
-    CHECK_EQ(primary_it.time(), t)
-        << "Time " << t << " not in primary trajectory";
-    TYPENAME Trajectory<FromFrame>::NativeIterator secondary_it =
-        (secondary.*from_trajectory)().on_or_after(t);
-    CHECK_EQ(secondary_it.time(), t)
-        << "Time " << t << " not in secondary trajectory";
-
-    DegreesOfFreedom<FromFrame> const& primary_degrees_of_freedom =
-        primary_it.degrees_of_freedom();
-    DegreesOfFreedom<FromFrame> const& secondary_degrees_of_freedom =
-        secondary_it.degrees_of_freedom();
+    DegreesOfFreedom<FromFrame> const primary_degrees_of_freedom =
+        that->ReferenceDegreesOfFreedom(primary, from_trajectory, t);
+    DegreesOfFreedom<FromFrame> const secondary_degrees_of_freedom =
+        that->ReferenceDegreesOfFreedom(secondary, from_trajectory, t);
     DegreesOfFreedom<FromFrame> const barycentre_degrees_of_freedom =
         Barycentre<FromFrame, GravitationalParameter>(
             {primary_degrees_of_freedom,
@@ -274,27 +215,16 @@ Transforms<Mobile, FromFrame, ThroughFrame, ToFrame>::BarycentricRotating(
     // map.  Also, the filioque.
     Rotation<FromFrame, ThroughFrame> const& velocity_map =
         from_basis_of_barycentric_frame_to_standard_basis;
-    DegreesOfFreedom<ThroughFrame> through_degrees_of_freedom =
-        {position_map(from_degrees_of_freedom.position()),
-         velocity_map(from_degrees_of_freedom.velocity() -
-                      barycentre_degrees_of_freedom.velocity() -
-                        angular_frequency *
-                          (from_degrees_of_freedom.position() -
-                           barycentre_degrees_of_freedom.position()) / Radian)};
-
-    // Cache the result before returning it.
-    if (cacheable) {
-      that->first_cache_.Insert(trajectory, t, through_degrees_of_freedom);
-    }
-    return through_degrees_of_freedom;
+    return {position_map(from_degrees_of_freedom.position()),
+            velocity_map(from_degrees_of_freedom.velocity() -
+                         barycentre_degrees_of_freedom.velocity() -
+                           angular_frequency *
+                             (from_degrees_of_freedom.position() -
+                              barycentre_degrees_of_freedom.position()) /
+                                 Radian)};
   };
 
-  transforms->second_ =
-      [&primary, &secondary, to_trajectory](
-          Instant const& t,
-          DegreesOfFreedom<ThroughFrame> const& through_degrees_of_freedom,
-          Trajectory<ThroughFrame> const* trajectory) ->
-      DegreesOfFreedom<ToFrame> {
+  transforms->second_position_map_ = [&primary, &secondary, to_trajectory]() {
     Rotation<ThroughFrame, ToFrame>
         from_standard_basis_to_basis_of_last_barycentric_frame =
             Rotation<ThroughFrame, ToFrame>::Identity();
@@ -305,15 +235,10 @@ Transforms<Mobile, FromFrame, ThroughFrame, ToFrame>::BarycentricRotating(
         (secondary.*to_trajectory)(),
         &from_standard_basis_to_basis_of_last_barycentric_frame,
         &last_barycentre_degrees_of_freedom);
-
-    AffineMap<ThroughFrame, ToFrame, Length, Rotation> const position_map(
+    return AffineMap<ThroughFrame, ToFrame, Length, OrthogonalMap>(
         ThroughFrame::origin,
         last_barycentre_degrees_of_freedom.position(),
-        from_standard_basis_to_basis_of_last_barycentric_frame);
-    Rotation<ThroughFrame, ToFrame> const& velocity_map =
-        from_standard_basis_to_basis_of_last_barycentric_frame;
-    return {position_map(through_degrees_of_freedom.position()),
-            velocity_map(through_degrees_of_freedom.velocity())};
+        from_standard_basis_to_basis_of_last_barycentric_frame.Forget());
   };
 
   return transforms;
@@ -333,6 +258,14 @@ void Transforms<Mobile, FromFrame, ThroughFrame, ToFrame>::set_cacheable(
   cacheable_.push_back(trajectory);
 }
 
+template<typename Mobile,
+         typename FromFrame, typename ThroughFrame, typename ToFrame>
+void Transforms<Mobile, FromFrame, ThroughFrame, ToFrame>::set_evaluator(
+    LazyTrajectory<FromFrame> const& trajectory,
+    Evaluator const& evaluator) {
+  evaluators_.emplace_back(trajectory, evaluator);
+}
+
 template<typename Mobile,
          typename FromFrame, typename ThroughFrame, typename ToFrame>
 typename Trajectory<FromFrame>::template TransformingIterator<ThroughFrame>
@@ -361,7 +294,22 @@ template<typename Mobile,
 typename Trajectory<ThroughFrame>::template TransformingIterator<ToFrame>
 Transforms<Mobile, FromFrame, ThroughFrame, ToFrame>::second(
     Trajectory<ThroughFrame> const& through_trajectory) {
-  return through_trajectory.first_with_transform(second_);
+  // The map is evaluated for each point, like the |first_| transform, since
+  // the reference trajectories may change before the iterator is used.  The
+  // velocities are not translated.
+  auto const second_position_map = second_position_map_;
+  typename Trajectory<ThroughFrame>::template Transform<ToFrame> const second =
+      [second_position_map](
+          Instant const& t,
+          DegreesOfFreedom<ThroughFrame> const& through_degrees_of_freedom,
+          Trajectory<ThroughFrame> const* trajectory) ->
+      DegreesOfFreedom<ToFrame> {
+    AffineMap<ThroughFrame, ToFrame, Length, OrthogonalMap> const
+        position_map = second_position_map();
+    return {position_map(through_degrees_of_freedom.position()),
+            position_map.linear_map()(through_degrees_of_freedom.velocity())};
+  };
+  return through_trajectory.first_with_transform(second);
 }
 
 template<typename Mobile,
@@ -373,35 +321,103 @@ Transforms<Mobile, FromFrame, ThroughFrame, ToFrame>::coordinate_frame() const {
 
 template<typename Mobile,
          typename FromFrame, typename ThroughFrame, typename ToFrame>
-template<typename Frame1, typename Frame2>
-bool
-Transforms<Mobile, FromFrame, ThroughFrame, ToFrame>::Cache<Frame1, Frame2>::
-Lookup(not_null<Trajectory<Frame1> const*> const trajectory,
-       Instant const& time,
-       not_null<DegreesOfFreedom<Frame2>**> degrees_of_freedom) {
-  bool found = false;
-  ++number_of_lookups_[trajectory];
-  auto const it = map_.find(std::make_pair(trajectory, time));
-  if (it != map_.end()) {
-    ++number_of_hits_[trajectory];
-    *degrees_of_freedom = &it->second;
-    found = true;
+std::vector<Position<ThroughFrame>> const&
+Transforms<Mobile, FromFrame, ThroughFrame, ToFrame>::
+first_positions_on_or_after(Mobile const& mobile,
+                            LazyTrajectory<FromFrame> const& from_trajectory,
+                            Instant const& time) {
+  Trajectory<FromFrame> const& trajectory = (mobile.*from_trajectory)();
+  auto const transform = [this, &from_trajectory, &trajectory](
+      typename Trajectory<FromFrame>::NativeIterator const& it) {
+    return first_(from_trajectory,
+                  it.time(),
+                  it.degrees_of_freedom(),
+                  &trajectory).position();
+  };
+  auto it = trajectory.on_or_after(time);
+
+  bool const cacheable =
+      std::find(cacheable_.begin(),
+                cacheable_.end(),
+                from_trajectory) != cacheable_.end();
+  if (!cacheable) {
+    uncached_first_positions_.clear();
+    for (; !it.at_end(); ++it) {
+      uncached_first_positions_.push_back(transform(it));
+    }
+    return uncached_first_positions_;
+  }
+
+  CachedPositions& cached = first_positions_cache_[&trajectory];
+  if (it.at_end()) {
+    cached.times.clear();
+    cached.positions.clear();
+    return cached.positions;
+  }
+
+  // Drop the points that were forgotten, or that are before |time|.  If the
+  // trajectory now has points before the cached ones, or if the last cached
+  // point is not in the trajectory anymore, it was not just extended, and the
+  // cache is reset.
+  if (!cached.times.empty()) {
+    auto const first_kept = std::lower_bound(cached.times.begin(),
+                                             cached.times.end(),
+                                             it.time());
+    cached.positions.erase(
+        cached.positions.begin(),
+        cached.positions.begin() + (first_kept - cached.times.begin()));
+    cached.times.erase(cached.times.begin(), first_kept);
+  }
+  if (!cached.times.empty()) {
+    auto const last_cached_it = trajectory.on_or_after(cached.times.back());
+    if (cached.times.front() == it.time() &&
+        !last_cached_it.at_end() &&
+        last_cached_it.time() == cached.times.back() &&
+        last_cached_it.degrees_of_freedom().position() ==
+            cached.last_from_position) {
+      it = last_cached_it;
+      ++it;
+    } else {
+      cached.times.clear();
+      cached.positions.clear();
+    }
   }
-  VLOG_EVERY_N(1, 1000) << "Hit ratio for trajectory " << trajectory << " is "
-                        << static_cast<double>(number_of_hits_[trajectory]) /
-                           number_of_lookups_[trajectory];
-  return found;
+
+  // Transform the points that were appended.
+  for (; !it.at_end(); ++it) {
+    cached.times.push_back(it.time());
+    cached.positions.push_back(transform(it));
+    cached.last_from_position = it.degrees_of_freedom().position();
+  }
+  return cached.positions;
 }
 
 template<typename Mobile,
          typename FromFrame, typename ThroughFrame, typename ToFrame>
-template<typename Frame1, typename Frame2>
-void
-Transforms<Mobile, FromFrame, ThroughFrame, ToFrame>::Cache<Frame1, Frame2>::
-Insert(not_null<Trajectory<Frame1> const*> const trajectory,
-       Instant const& time,
-       DegreesOfFreedom<Frame2> const& degrees_of_freedom) {
-  map_.emplace(std::make_pair(trajectory, time), degrees_of_freedom);
+AffineMap<ThroughFrame, ToFrame, Length, OrthogonalMap>
+Transforms<Mobile, FromFrame, ThroughFrame, ToFrame>::
+second_position_map() const {
+  return second_position_map_();
+}
+
+template<typename Mobile,
+         typename FromFrame, typename ThroughFrame, typename ToFrame>
+DegreesOfFreedom<FromFrame>
+Transforms<Mobile, FromFrame, ThroughFrame, ToFrame>::
+ReferenceDegreesOfFreedom(Mobile const& reference,
+                          LazyTrajectory<FromFrame> const& from_trajectory,
+                          Instant const& t) const {
+  for (auto const& pair : evaluators_) {
+    if (pair.first == from_trajectory) {
+      return pair.second(reference, t);
+    }
+  }
+  // |on_or_after()| is Ln(N), but it doesn't matter unless the map gets very
+  // big, in which case we'll have cache misses anyway.
+  TYPENAME Trajectory<FromFrame>::NativeIterator const it =
+      (reference.*from_trajectory)().on_or_after(t);
+  CHECK_EQ(it.time(), t) << "Time " << t << " not in reference trajectory";
+  return it.degrees_of_freedom();
 }
 
 }  // namespace physics
@@ -1,6 +1,7 @@
 #include "physics/transforms.hpp"
 
 #include <limits>
+#include <vector>
 
 #include "geometry/frame.hpp"
 #include "base/not_null.hpp"
@@ -180,6 +181,114 @@ TEST_F(TransformsTest, BodyCentredNonRotating) {
             transforms->coordinate_frame()(To::origin).quaternion());
 }
 
+// The positions of a cacheable trajectory are only computed for the points
+// appended since the previous call, and follow the points that are forgotten.
+TEST_F(TransformsTest, FirstPositions) {
+  auto const transforms =
+      Transforms<Functors, From, Through, To>::BodyCentredNonRotating(
+          body1_fn_, &Functors::to_trajectory);
+  transforms->set_cacheable(&Functors::from_trajectory);
+  auto const expected_position = [](int const i) {
+    return Through::origin + Displacement<Through>({9 * i * SIUnit<Length>(),
+                                                    -22 * i * SIUnit<Length>(),
+                                                    27 * i * SIUnit<Length>()});
+  };
+
+  std::vector<Position<Through>> positions =
+      transforms->first_positions_on_or_after(
+          satellite_fn_,
+          &Functors::from_trajectory,
+          satellite_from_->first().time());
+  EXPECT_EQ(kNumberOfPoints, positions.size());
+  for (int i = 1; i <= kNumberOfPoints; ++i) {
+    EXPECT_EQ(expected_position(i), positions[i - 1]) << i;
+  }
+
+  int const n = kNumberOfPoints + 1;
+  body1_from_->Append(
+      Instant(n * SIUnit<Time>()),
+      DegreesOfFreedom<From>(
+          Position<From>(Displacement<From>({1 * n * SIUnit<Length>(),
+                                             2 * n * SIUnit<Length>(),
+                                             3 * n * SIUnit<Length>()})),
+          Velocity<From>()));
+  satellite_from_->Append(
+      Instant(n * SIUnit<Time>()),
+      DegreesOfFreedom<From>(
+          Position<From>(Displacement<From>({10 * n * SIUnit<Length>(),
+                                             -20 * n * SIUnit<Length>(),
+                                             30 * n * SIUnit<Length>()})),
+          Velocity<From>()));
+  satellite_from_->ForgetBefore(Instant(5 * SIUnit<Time>()));
+  positions = transforms->first_positions_on_or_after(
+                  satellite_fn_,
+                  &Functors::from_trajectory,
+                  satellite_from_->first().time());
+  EXPECT_EQ(n - 5, positions.size());
+  for (int i = 6; i <= n; ++i) {
+    EXPECT_EQ(expected_position(i), positions[i - 6]) << i;
+  }
+
+  // The result is the same if the trajectory is not cacheable.
+  auto const uncached_transforms =
+      Transforms<Functors, From, Through, To>::BodyCentredNonRotating(
+          body1_fn_, &Functors::to_trajectory);
+  EXPECT_EQ(positions,
+            uncached_transforms->first_positions_on_or_after(
+                satellite_fn_,
+                &Functors::from_trajectory,
+                satellite_from_->first().time()));
+
+  body1_to_->Append(
+      Instant(n * SIUnit<Time>()),
+      DegreesOfFreedom<To>(
+          Position<To>(Displacement<To>({3 * SIUnit<Length>(),
+                                         1 * SIUnit<Length>(),
+                                         2 * SIUnit<Length>()})),
+          Velocity<To>()));
+  EXPECT_EQ(To::origin + Displacement<To>({12 * SIUnit<Length>(),
+                                           -21 * SIUnit<Length>(),
+                                           29 * SIUnit<Length>()}),
+            transforms->second_position_map()(expected_position(1)));
+}
+
+// With an evaluator, the reference trajectory need not have points at the
+// times of the transformed trajectory.
+TEST_F(TransformsTest, Evaluator) {
+  auto const transforms =
+      Transforms<Functors, From, Through, To>::BodyCentredNonRotating(
+          body1_fn_, &Functors::to_trajectory);
+  // The degrees of freedom of |body1_from_| at all times.
+  transforms->set_evaluator(
+      &Functors::from_trajectory,
+      [](Functors const& functors, Instant const& t) -> DegreesOfFreedom<From> {
+        double const i = (t - Instant()) / SIUnit<Time>();
+        return DegreesOfFreedom<From>(
+                   Position<From>(
+                       Displacement<From>({1 * i * SIUnit<Length>(),
+                                           2 * i * SIUnit<Length>(),
+                                           3 * i * SIUnit<Length>()})),
+                   Velocity<From>({4 * i * SIUnit<Speed>(),
+                                   8 * i * SIUnit<Speed>(),
+                                   16 * i * SIUnit<Speed>()}));
+      });
+  body1_from_->ForgetBefore(body1_from_->last().time());
+
+  std::vector<Position<Through>> const& positions =
+      transforms->first_positions_on_or_after(
+          satellite_fn_,
+          &Functors::from_trajectory,
+          satellite_from_->first().time());
+  EXPECT_EQ(kNumberOfPoints, positions.size());
+  for (int i = 1; i <= kNumberOfPoints; ++i) {
+    EXPECT_EQ(Through::origin +
+                  Displacement<Through>({9 * i * SIUnit<Length>(),
+                                         -22 * i * SIUnit<Length>(),
+                                         27 * i * SIUnit<Length>()}),
+              positions[i - 1]) << i;
+  }
+}
+
 // Check that the computations we do match those done using Mathematica.
 TEST_F(TransformsTest, SatelliteBarycentricRotating) {
   auto const transforms =
@@ -248,6 +357,11 @@ TEST_F(TransformsTest, SatelliteBarycentricRotating) {
                      (72.4 + 352.0 / sqrt(105.0)) * i * SIUnit<Speed>(),
                      (144.8 - 176.0 / sqrt(105.0)) * i * SIUnit<Speed>()}),
                     1, 8)) << i;
+    EXPECT_THAT(transforms->second_position_map()(
+                    satellite_through.on_or_after(it.time()).
+                        degrees_of_freedom().position()) - To::origin,
+                AlmostEquals(degrees_of_freedom.position() - To::origin,
+                             0, 2)) << i;
   }
 }
 